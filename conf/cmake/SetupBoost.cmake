@@ -12,6 +12,7 @@ IF (Boost_FOUND)
     ENDIF(NOT BOOST_FILESYSTEM_FOUND)
 
     SET (BOOST_FILESYSTEM_LIB "boost_filesystem")
+    SET (BOOST_THREAD_LIB     "boost_thread")
     SET (BOOST_TEST_LIB       "boost_unit_test_framework")
 
     IF (WIN32)
@@ -38,6 +39,12 @@ IF (Boost_FOUND)
 		SET (BOOST_FILESYSTEM_LIB ${BOOST_FILESYSTEM_LIB_FILE})
 	ENDIF (BOOST_FILESYSTEM_LIB_FILE)
 
+	# look for the thread lib binary file 
+    FIND_FILE(BOOST_THREAD_LIB_FILE "libboost_thread-vc80-mt-gd-1_34_1.lib" ${Boost_LIBRARY_DIRS})
+	IF (BOOST_THREAD_LIB_FILE)
+		SET (BOOST_THREAD_LIB ${BOOST_THREAD_LIB_FILE})
+	ENDIF (BOOST_THREAD_LIB_FILE)
+
 	IF (NOT BOOST_TEST_LIB_FILE AND NOT BOOST_FILESYSTEM_LIB_FILE)
 		SET(Boost_FOUND 0)
 	ENDIF(NOT BOOST_TEST_LIB_FILE AND NOT BOOST_FILESYSTEM_LIB_FILE)
@@ -12,13 +12,18 @@
 #include <Core/Exceptions.h>
 #include <Logging/Logger.h>
 #include <Utils/Timer.h>
+#include <Utils/TaskScheduler.h>
+#include <Utils/Profiler.h>
 #include <math.h>
+#include <algorithm>
 #include <typeinfo>
 
 namespace OpenEngine {
 namespace Core {
 
 using OpenEngine::Utils::Timer;
+using OpenEngine::Utils::Profiler;
+using OpenEngine::Utils::ProfileScope;
 using namespace std;
 
 /**
@@ -28,7 +33,11 @@ using namespace std;
  * @see GameEngine::Instance()
  */
 GameEngine::GameEngine()
-    : running(false), tick(50) {
+    : running(false), tick(50), changed(true),
+      processTime(0), criticalPathTime(0),
+      lastProcessTime(0), lastCriticalPathTime(0),
+      frameTime(0), idle(false), idleTimeout(100000000), nextTick(0),
+      woken(false), nextFrame(0) {
 
 }
 
@@ -60,6 +69,25 @@ IGameEngine& GameEngine::Instance() {
  */
 void GameEngine::AddModule(IModule& module, const ProcessTick flag) {
     ((flag==TICK_DEPENDENT) ? dependent : independent).push_back(&module);
+    changed = true;
+}
+
+/**
+ * Add a module with dependencies to the engine.
+ * The module is processed on the task scheduler, in parallel with
+ * the modules of the same tick dependency it does not conflict
+ * with. The dependencies replace those given when the module was
+ * added before.
+ *
+ * @see ModuleDependencies
+ * @param module Reference of module to add
+ * @param flag Flag of the modules tick dependency
+ * @param dependencies Dependencies of the module
+ */
+void GameEngine::AddModule(IModule& module, const ProcessTick flag,
+                           const ModuleDependencies& dependencies) {
+    AddModule(module, flag);
+    this->dependencies[&module] = dependencies;
 }
 
 /**
@@ -71,18 +99,24 @@ void GameEngine::AddModule(IModule& module, const ProcessTick flag) {
  */
 void GameEngine::RemoveModule(IModule& module) {
     list<IModule*>::iterator itr;
+    bool found = false;
     for(itr=independent.begin(); itr!=independent.end(); ++itr){
         if( (*itr) == &module){
             independent.erase(itr);
-            return;
+            found = true;
+            break;
         }
     }
-    for(itr=dependent.begin(); itr!=dependent.end(); ++itr){
+    for(itr=dependent.begin(); itr!=dependent.end() && !found; ++itr){
         if( (*itr) == &module){
             dependent.erase(itr);
-            return;
+            break;
         }
     }
+    if (find(independent.begin(), independent.end(), &module) == independent.end() &&
+        find(dependent.begin(), dependent.end(), &module) == dependent.end())
+        dependencies.erase(&module);
+    changed = true;
 }
 
 /**
@@ -125,31 +159,43 @@ int GameEngine::GetNumberOfModules() {
 /**
  * Initialize all modules.
  * Calls the initialize function on every module in the engine.
+ * Each call is recorded as a zone by the profiler.
  *
  * @see IModule::Initialize()
  */
 void GameEngine::InitModules() {
     list<IModule*>::iterator itr;
-    for (itr=independent.begin(); itr != independent.end(); ++itr)
+    for (itr=independent.begin(); itr != independent.end(); ++itr) {
+        ProfileScope scope(Profiler::GetTypeName(typeid(**itr)), "Initialize");
         (*itr)->Initialize();
-    for (itr=dependent.begin(); itr != dependent.end(); ++itr)
+    }
+    for (itr=dependent.begin(); itr != dependent.end(); ++itr) {
+        ProfileScope scope(Profiler::GetTypeName(typeid(**itr)), "Initialize");
         (*itr)->Initialize();
+    }
 }
 
 /**
  * Deinitialize all modules.
  * Calls the deinitialize function on every module in the engine.
+ * Each call is recorded as a zone by the profiler.
  *
  * @see IModule::DeinitModules()
  */
 void GameEngine::DeinitModules() {
     list<IModule*>::iterator itr;
-    for (itr=independent.begin(); itr != independent.end(); ++itr)
+    for (itr=independent.begin(); itr != independent.end(); ++itr) {
+        ProfileScope scope(Profiler::GetTypeName(typeid(**itr)), "Deinitialize");
         (*itr)->Deinitialize();
-    for (itr=dependent.begin(); itr != dependent.end(); ++itr)
+    }
+    for (itr=dependent.begin(); itr != dependent.end(); ++itr) {
+        ProfileScope scope(Profiler::GetTypeName(typeid(**itr)), "Deinitialize");
         (*itr)->Deinitialize();
+    }
     independent.clear();
     dependent.clear();
+    dependencies.clear();
+    changed = true;
 }
 
 /**
@@ -158,36 +204,75 @@ void GameEngine::DeinitModules() {
  */
 void GameEngine::StartGameLoop() {
     list<IModule*>::iterator itr;
-    double time0;               // last time
-    double time1;               // current time
-    double timet;               // elapsed tick time
+    Timer::Nanoseconds time0;   // last time
+    Timer::Nanoseconds time1;   // current time
+    Timer::Nanoseconds timet;   // elapsed tick time
+    Timer::Nanoseconds tickt;   // tick time
+    Timer::Nanoseconds frame;   // time the next frame is due
     float delta;                // elapsed time since last independent run
     int loops;
+    bool first = true;          // first loop
 
-    // set starting times
-    time0 = timet = Timer::GetTime();
+    // set starting times, the modules get times in milliseconds
+    time0 = timet = frame = Timer::GetNanoseconds();
+    frameTimes.clear();
+    nextFrame = 0;
 
     while (running) {
 
+        // order the modules added or removed since the last loop
+        if (changed) BuildGraphs();
+        processTime = criticalPathTime = 0;
+
         // read elapsed time
-        time1 = Timer::GetTime();
+        time1 = Timer::GetNanoseconds();
+        tickt = (Timer::Nanoseconds) (tick * 1000000.0);
 
         // set the current elapsed time
-        delta = (float) (time1 - time0);
+        delta = (float) ((time1 - time0) / 1000000.0);
 
         // if the tick time has elapsed run the dependent modules
         loops = 0;
-        while ( (time1 - timet) > tick && loops < MAX_LOOPS ) {
+        while ( (time1 - timet) > tickt && loops < MAX_LOOPS ) {
             RunDependentModules(tick, 1);
-            timet += tick;      // add a tick to the elapsed tick time
+            timet += tickt;     // add a tick to the elapsed tick time
             ++loops;
         }
 
+        // only the dependent modules have ticks to keep while idle
+        {
+            boost::mutex::scoped_lock lock(mutex);
+            nextTick = dependent.empty() ? 0 : timet + tickt;
+        }
+
         // run the independent modules
-        RunIndependentModules(delta, min(1.0f, (float)(time1 - timet) / tick));
+        RunIndependentModules(delta, min(1.0f, (float)(time1 - timet) / tickt));
 
-        // update to the new last time
+        // update to the new last time, the first loop has no frame
+        // before it to time
+        if (!first) AddFrameTime(time1 - time0);
+        first = false;
         time0 = time1;
+
+        lastProcessTime = processTime;
+        lastCriticalPathTime = criticalPathTime;
+
+        // block until woken or the next tick when idle
+        WaitIdle();
+
+        // wait for the next frame when paced, frames are due at fixed
+        // times unless the loop falls a frame behind
+        Timer::Nanoseconds pace;
+        {
+            boost::mutex::scoped_lock lock(mutex);
+            pace = frameTime;
+        }
+        if (pace > 0) {
+            frame += pace;
+            Timer::Nanoseconds now = Timer::GetNanoseconds();
+            if (frame < now - pace) frame = now;
+            else Timer::WaitUntil(frame);
+        }
     }
 }
 
@@ -198,9 +283,7 @@ void GameEngine::StartGameLoop() {
  * @param percent Percentage of current tick frame.
  */
 void GameEngine::RunIndependentModules(const float delta, const float percent) {
-    list<IModule*>::iterator itr;
-    for (itr=independent.begin(); itr != independent.end(); ++itr)
-        (*itr)->Process(delta, percent);   
+    RunGraph(independentGraph, delta, percent);
 }
 
 /**
@@ -210,9 +293,153 @@ void GameEngine::RunIndependentModules(const float delta, const float percent) {
  * @param percent Percentage of current tick frame.
  */
 void GameEngine::RunDependentModules(const float delta, const float percent) {
-    list<IModule*>::iterator itr;
-    for (itr=dependent.begin(); itr != dependent.end(); ++itr)
-        (*itr)->Process(delta, percent);
+    RunGraph(dependentGraph, delta, percent);
+}
+
+/**
+ * Build the dependency graphs of the module lists.
+ *
+ * @throws Exception if the module dependencies form a cycle.
+ */
+void GameEngine::BuildGraphs() {
+    dependentGraph.Build(dependent, dependencies);
+    independentGraph.Build(independent, dependencies);
+    changed = false;
+}
+
+/**
+ * Process the modules of a graph and add its times to those of the
+ * loop. The dependent modules may run more than once in a loop, and
+ * their runs follow each other, so both times add up.
+ *
+ * @param graph Graph of the modules to run.
+ * @param delta Delta time.
+ * @param percent Percentage of current tick frame.
+ */
+void GameEngine::RunGraph(ModuleGraph& graph, const float delta, const float percent) {
+    graph.Run(graph.IsParallel() ? &GetTaskScheduler() : NULL, delta, percent);
+    processTime += graph.GetWork();
+    criticalPathTime += graph.GetCriticalPath();
+}
+
+/**
+ * Block the idle engine until it is woken, the next tick is due or
+ * the idle timeout has passed. A wake up during the loop, for
+ * instance by an event arriving while the modules were processed,
+ * ends the wait at once.
+ */
+void GameEngine::WaitIdle() {
+    Timer::Nanoseconds now = Timer::GetNanoseconds();
+    boost::mutex::scoped_lock lock(mutex);
+    if (idle) {
+        Timer::Nanoseconds until = now + idleTimeout;
+        if (nextTick > 0 && nextTick < until) until = nextTick;
+        while (!woken && running && now < until) {
+            wake.timed_wait(lock, boost::posix_time::microseconds((until - now) / 1000 + 1));
+            now = Timer::GetNanoseconds();
+        }
+    }
+    woken = false;
+}
+
+/**
+ * Add a frame time to the window of frame times.
+ *
+ * @param time Time since the start of the last loop.
+ */
+void GameEngine::AddFrameTime(const Timer::Nanoseconds time) {
+    boost::mutex::scoped_lock lock(mutex);
+    if (frameTimes.size() < FRAME_WINDOW) frameTimes.push_back(time);
+    else {
+        frameTimes[nextFrame] = time;
+        nextFrame = (nextFrame + 1) % FRAME_WINDOW;
+    }
+}
+
+/**
+ * Get the task scheduler of the engine.
+ * This is the default scheduler, also used by the resource loaders
+ * and the geometry builders.
+ *
+ * @return Task scheduler.
+ * @see TaskScheduler::GetDefault()
+ */
+TaskScheduler& GameEngine::GetTaskScheduler() {
+    return TaskScheduler::GetDefault();
+}
+
+/**
+ * @see IGameEngine::GetProcessTime()
+ */
+double GameEngine::GetProcessTime() {
+    return lastProcessTime;
+}
+
+/**
+ * @see IGameEngine::GetCriticalPathTime()
+ */
+double GameEngine::GetCriticalPathTime() {
+    return lastCriticalPathTime;
+}
+
+/**
+ * @see IGameEngine::SetFrameRate()
+ */
+void GameEngine::SetFrameRate(const float rate) {
+    boost::mutex::scoped_lock lock(mutex);
+    frameTime = (rate > 0) ? (Timer::Nanoseconds) (1000000000.0 / rate) : 0;
+}
+
+/**
+ * @see IGameEngine::GetFrameRate()
+ */
+float GameEngine::GetFrameRate() {
+    boost::mutex::scoped_lock lock(mutex);
+    return (frameTime > 0) ? (float) (1000000000.0 / frameTime) : 0;
+}
+
+/**
+ * @see IGameEngine::SetIdle()
+ */
+void GameEngine::SetIdle(const bool idle, const float timeout) {
+    boost::mutex::scoped_lock lock(mutex);
+    this->idle = idle;
+    idleTimeout = (Timer::Nanoseconds) (timeout * 1000000.0);
+}
+
+/**
+ * @see IGameEngine::Wake()
+ */
+void GameEngine::Wake() {
+    boost::mutex::scoped_lock lock(mutex);
+    woken = true;
+    wake.notify_all();
+}
+
+/**
+ * Get statistics of the time between the starts of the last
+ * loops. The window covers the last 120 loops of the engine.
+ *
+ * @see IGameEngine::GetFrameStatistics()
+ */
+IGameEngine::FrameStatistics GameEngine::GetFrameStatistics() {
+    boost::mutex::scoped_lock lock(mutex);
+    FrameStatistics stats;
+    stats.frames = frameTimes.size();
+    stats.average = stats.jitter = stats.min = stats.max = 0;
+    if (frameTimes.empty()) return stats;
+    double sum = 0, squares = 0;
+    stats.min = stats.max = frameTimes[0] / 1000000.0;
+    for (unsigned int i=0; i<frameTimes.size(); i++) {
+        double t = frameTimes[i] / 1000000.0;
+        sum += t;
+        squares += t * t;
+        stats.min = min(stats.min, t);
+        stats.max = max(stats.max, t);
+    }
+    stats.average = sum / stats.frames;
+    stats.jitter = sqrt(max(0.0, squares / stats.frames - stats.average * stats.average));
+    return stats;
 }
 
 float GameEngine::GetTickTime() {
@@ -292,6 +519,7 @@ void GameEngine::Start(IGameFactory* factory) {
  */
 void GameEngine::Stop() {
     running = false;
+    Wake();
 }
 
 } // NS Core
@@ -11,7 +11,12 @@
 #define _GAME_ENGINE_H_
 
 #include <Core/IGameEngine.h>
+#include <Core/ModuleGraph.h>
+#include <Utils/Timer.h>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition.hpp>
 #include <list>
+#include <map>
 #include <typeinfo>
 
 namespace OpenEngine {
@@ -19,6 +24,8 @@ namespace Core {
 
 using std::type_info;
 using std::list;
+using std::map;
+using OpenEngine::Utils::Timer;
 
 /**
  * Game Engine implementation.
@@ -32,7 +39,7 @@ class GameEngine : public IGameEngine {
 private:
 
     // Engine running flag
-    bool running;
+    volatile bool running;
 
     // Tick time for dependent modules
     float tick;
@@ -44,12 +51,44 @@ private:
     list<IModule*> dependent;
     list<IModule*> independent;
 
+    // Dependencies of the modules added with any, and the graphs of
+    // the module lists built from them
+    map<IModule*, ModuleDependencies> dependencies;
+    ModuleGraph dependentGraph;
+    ModuleGraph independentGraph;
+    bool changed;
+
+    // Process time and critical path of the current and last loop
+    double processTime, criticalPathTime;
+    double lastProcessTime, lastCriticalPathTime;
+
+    // Wake up of the idle engine and the frame time window, the mutex
+    // also guards the pacing below
+    boost::mutex mutex;
+    boost::condition wake;
+
+    // Frame pacing, zero frame time when uncapped, and the time of
+    // the next tick, zero without dependent modules
+    Timer::Nanoseconds frameTime;
+    bool idle;
+    Timer::Nanoseconds idleTimeout;
+    Timer::Nanoseconds nextTick;
+
+    bool woken;
+    static const unsigned int FRAME_WINDOW = 120;
+    vector<Timer::Nanoseconds> frameTimes;
+    unsigned int nextFrame;
+
     GameEngine();
     void InitModules();
     void DeinitModules();
     void StartGameLoop();
     void RunIndependentModules(const float delta, const float percent);
     void RunDependentModules(const float delta, const float percent);
+    void BuildGraphs();
+    void RunGraph(ModuleGraph& graph, const float delta, const float percent);
+    void WaitIdle();
+    void AddFrameTime(const Timer::Nanoseconds time);
 
 public:
 
@@ -60,6 +99,8 @@ public:
     void SetTickTime(const float time);
 
     void AddModule(IModule& module, const ProcessTick flag = TICK_INDEPENDENT);
+    void AddModule(IModule& module, const ProcessTick flag,
+                   const ModuleDependencies& dependencies);
     void RemoveModule(IModule& module);
 
     int GetNumberOfModules();
@@ -69,6 +110,17 @@ public:
     void Start(IGameFactory* factory);
     void Stop();
 
+    TaskScheduler& GetTaskScheduler();
+
+    double GetProcessTime();
+    double GetCriticalPathTime();
+
+    void SetFrameRate(const float rate);
+    float GetFrameRate();
+    void SetIdle(const bool idle, const float timeout = 100);
+    void Wake();
+    FrameStatistics GetFrameStatistics();
+
 };
 
 } // NS Core
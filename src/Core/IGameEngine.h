@@ -14,12 +14,19 @@
 #include <Core/IModule.h>
 
 namespace OpenEngine {
+
+namespace Utils {
+class TaskScheduler;
+}
+
 namespace Core {
 
 using OpenEngine::Core::IModule;
+using OpenEngine::Utils::TaskScheduler;
 
 // forward declarations
 class IGameFactory;
+class ModuleDependencies;
 
 /**
  * The Game Engine Interface.
@@ -57,6 +64,19 @@ public:
         TICK_DEPENDENT
     };
 
+    /**
+     * Frame time statistics over the last frames.
+     * Times are in milliseconds.
+     *
+     * @see GetFrameStatistics()
+     */
+    struct FrameStatistics {
+        unsigned int frames;    //!< frames measured
+        double average;         //!< average frame time
+        double jitter;          //!< standard deviation of the frame time
+        double min, max;        //!< shortest and longest frame time
+    };
+
     /**
      * Get game engine instance.
      *
@@ -93,6 +113,23 @@ public:
      */
     virtual void AddModule(IModule& module, const ProcessTick flag = TICK_INDEPENDENT) = 0;
 
+    /**
+     * Add module with dependencies.
+     * Modules added with dependencies are processed in parallel with
+     * the modules they do not conflict with, on the task scheduler
+     * of the engine. They must be safe to process on any thread, and
+     * not need the rendering context. Modules added without
+     * dependencies are processed on the main thread in the order
+     * they were added.
+     *
+     * @see ModuleDependencies
+     * @param module Module to add.
+     * @param flag Flag of the modules tick dependency.
+     * @param dependencies Dependencies of the module.
+     */
+    virtual void AddModule(IModule& module, const ProcessTick flag,
+                           const ModuleDependencies& dependencies) = 0;
+
     /**
      * Remove module
      *
@@ -135,6 +172,79 @@ public:
      */
     virtual void Stop() = 0;
 
+    /**
+     * Get the task scheduler of the engine.
+     * Modules can spawn parallel work on the scheduler instead of
+     * starting threads of their own. It is the scheduler the
+     * resource loaders and geometry builders use as well.
+     *
+     * @return Task scheduler.
+     */
+    virtual TaskScheduler& GetTaskScheduler() = 0;
+
+    /**
+     * Get the time spent processing modules in the last engine loop.
+     *
+     * @return Sum of the module process times in milliseconds.
+     */
+    virtual double GetProcessTime() = 0;
+
+    /**
+     * Get the critical path of the last engine loop: the time of the
+     * longest chain of modules depending on each other, which bounds
+     * the loop time however many threads process the modules.
+     *
+     * @return Critical path length in milliseconds.
+     */
+    virtual double GetCriticalPathTime() = 0;
+
+    /**
+     * Set the frame rate to pace the engine loop to.
+     * The engine waits after each loop until the next frame is due,
+     * sleeping most of the wait, so a capped engine does not keep a
+     * processor busy. Frames are scheduled at fixed times, so a late
+     * frame is followed by shorter ones.
+     *
+     * @param rate Frames per second, zero to run uncapped (default).
+     */
+    virtual void SetFrameRate(const float rate) = 0;
+
+    /**
+     * Get the frame rate the engine loop is paced to.
+     *
+     * @return Frames per second, zero if uncapped.
+     */
+    virtual float GetFrameRate() = 0;
+
+    /**
+     * Set the idle mode.
+     * An idle engine blocks after each loop until Wake() is called,
+     * the next tick of the dependent modules is due, or the timeout
+     * has passed. Modules that poll for input are only processed on
+     * wake ups, so the timeout bounds their latency unless their
+     * event source calls Wake() as events arrive. SDLInput does so
+     * where SDL pumps the events on a thread of its own.
+     *
+     * @param idle True to block between loops.
+     * @param timeout Longest time to block in milliseconds [optional].
+     */
+    virtual void SetIdle(const bool idle, const float timeout = 100) = 0;
+
+    /**
+     * Wake an idle engine to run a loop.
+     * May be called from any thread, for instance by an event source
+     * with new events.
+     */
+    virtual void Wake() = 0;
+
+    /**
+     * Get statistics of the time between the starts of the last
+     * loops, to validate the pacing of the engine.
+     *
+     * @return Frame time statistics.
+     */
+    virtual FrameStatistics GetFrameStatistics() = 0;
+
 };
 
 } // NS Core
@@ -0,0 +1,303 @@
+// Dependency graph of engine modules.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#include <Core/ModuleGraph.h>
+#include <Core/Exceptions.h>
+#include <Utils/Timer.h>
+#include <Utils/Profiler.h>
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+#include <algorithm>
+#include <exception>
+
+namespace OpenEngine {
+namespace Core {
+
+using OpenEngine::Utils::Timer;
+using OpenEngine::Utils::Profiler;
+using OpenEngine::Utils::ProfileScope;
+
+// yields of the calling thread without work before it sleeps
+static const unsigned int SPINS = 64;
+
+// modules accessed by a node, the node's own module is written
+struct Access {
+    vector<IModule*> reads;
+    vector<IModule*> writes;
+};
+
+static bool Shares(const vector<IModule*>& a, const vector<IModule*>& b) {
+    for (unsigned int i=0; i<a.size(); i++)
+        if (std::find(b.begin(), b.end(), a[i]) != b.end()) return true;
+    return false;
+}
+
+static bool Conflicts(const Access& a, const Access& b) {
+    return Shares(a.writes, b.writes)
+        || Shares(a.writes, b.reads)
+        || Shares(a.reads, b.writes);
+}
+
+/**
+ * Create an empty graph.
+ */
+ModuleGraph::ModuleGraph()
+    : parallel(false), remaining(0), failed(false), scheduler(NULL),
+      delta(0), percent(0), work(0), criticalPath(0) {}
+
+/**
+ * Build the graph of a list of modules.
+ * Modules in the list without an entry in the dependency map are
+ * serial. Dependencies on modules not in the list are ignored.
+ *
+ * @param modules Modules in the order they were added.
+ * @param dependencies Dependencies of the modules that have any.
+ * @throws Exception if the after constraints form a cycle.
+ */
+void ModuleGraph::Build(const list<IModule*>& modules,
+                        const map<IModule*, ModuleDependencies>& dependencies) {
+    const unsigned int n = modules.size();
+    nodes.clear();
+    order.clear();
+    parallel = false;
+    work = criticalPath = 0;
+
+    vector<Access> access(n);
+    vector<const ModuleDependencies*> deps(n);
+    list<IModule*>::const_iterator itr = modules.begin();
+    for (unsigned int i=0; i<n; i++, ++itr) {
+        Node node;
+        node.module = *itr;
+        node.name = Profiler::GetTypeName(typeid(**itr));
+        node.waiting = 0;
+        node.time = 0;
+        map<IModule*, ModuleDependencies>::const_iterator d = dependencies.find(*itr);
+        node.serial = (d == dependencies.end());
+        deps[i] = node.serial ? NULL : &d->second;
+        if (!node.serial) {
+            parallel = true;
+            access[i].reads.assign(d->second.reads.begin(), d->second.reads.end());
+            access[i].writes.assign(d->second.writes.begin(), d->second.writes.end());
+        }
+        access[i].writes.push_back(*itr);
+        nodes.push_back(node);
+    }
+
+    // conflicting modules run in the order they were added, after
+    // constraints may point either way
+    vector<bool> edge(n * n, false);
+    for (unsigned int j=0; j<n; j++) {
+        for (unsigned int i=0; i<j; i++)
+            if (nodes[i].serial || nodes[j].serial || Conflicts(access[i], access[j]))
+                edge[i * n + j] = true;
+        if (deps[j] == NULL) continue;
+        list<IModule*>::const_iterator a;
+        for (a=deps[j]->after.begin(); a!=deps[j]->after.end(); ++a)
+            for (unsigned int i=0; i<n; i++)
+                if (i != j && nodes[i].module == *a)
+                    edge[i * n + j] = true;
+    }
+    for (unsigned int i=0; i<n; i++)
+        for (unsigned int j=0; j<n; j++)
+            if (edge[i * n + j]) {
+                nodes[i].successors.push_back(j);
+                nodes[j].predecessors.push_back(i);
+            }
+
+    // topological order, taking the first added of the ready nodes
+    vector<unsigned int> waiting(n);
+    for (unsigned int i=0; i<n; i++)
+        waiting[i] = nodes[i].predecessors.size();
+    vector<bool> done(n, false);
+    while (order.size() < n) {
+        unsigned int next = n;
+        for (unsigned int i=0; i<n && next == n; i++)
+            if (!done[i] && waiting[i] == 0) next = i;
+        if (next == n) {
+            nodes.clear();
+            order.clear();
+            parallel = false;
+            throw Exception("Cyclic module dependencies.");
+        }
+        done[next] = true;
+        order.push_back(next);
+        for (unsigned int k=0; k<nodes[next].successors.size(); k++)
+            waiting[nodes[next].successors[k]]--;
+    }
+}
+
+/**
+ * Process the modules of the graph once.
+ * Without a scheduler, or without modules that have dependencies,
+ * the modules are processed one at a time in topological order on
+ * the calling thread. Otherwise the modules with dependencies are
+ * spawned on the scheduler as soon as their predecessors are done,
+ * while the calling thread processes the serial modules and helps
+ * with the tasks.
+ *
+ * An exception thrown by a module processed in parallel does not
+ * stop the other modules, and is thrown again as an Exception once
+ * all modules are done.
+ *
+ * @param scheduler Scheduler to process the modules on, or NULL.
+ * @param delta Delta time passed to the modules.
+ * @param percent Percentage of the tick frame passed to the modules.
+ */
+void ModuleGraph::Run(TaskScheduler* scheduler, const float delta, const float percent) {
+    if (scheduler == NULL || !parallel) {
+        for (unsigned int i=0; i<order.size(); i++) {
+            Node& node = nodes[order[i]];
+            ProfileScope scope(node.name, "Process");
+            double start = Timer::GetTime();
+            node.module->Process(delta, percent);
+            node.time = Timer::GetTime() - start;
+        }
+        Measure();
+        return;
+    }
+
+    this->scheduler = scheduler;
+    this->delta = delta;
+    this->percent = percent;
+    failed = false;
+    ready.clear();
+    remaining = nodes.size();
+    for (unsigned int i=0; i<nodes.size(); i++)
+        nodes[i].waiting = nodes[i].predecessors.size();
+    for (unsigned int i=0; i<order.size(); i++) {
+        unsigned int n = order[i];
+        if (nodes[n].waiting > 0) continue;
+        if (nodes[n].serial) ready.push_back(n);
+        else scheduler->Spawn(boost::bind(&ModuleGraph::Process, this, n), &group);
+    }
+
+    // the serial modules may need the calling thread, for instance
+    // for its rendering context, so they are processed here
+    for (unsigned int spins = 0;;) {
+        unsigned int next = nodes.size();
+        {
+            boost::mutex::scoped_lock lock(mutex);
+            // with nothing to do for a while, sleep until a module is
+            // done and leave the spawned ones to the workers
+            if (spins >= SPINS && ready.empty() && remaining > 0) {
+                progress.wait(lock);
+                spins = 0;
+            }
+            if (!ready.empty()) {
+                next = ready.front();
+                ready.pop_front();
+            } else if (remaining == 0) break;
+        }
+        if (next < nodes.size()) {
+            Process(next);
+            spins = 0;
+        } else if (scheduler->RunPending())
+            spins = 0;
+        else {
+            spins++;
+            boost::thread::yield();
+        }
+    }
+    scheduler->Wait(group);
+    Measure();
+    if (failed) throw Exception(failure);
+}
+
+/**
+ * Process a module and release its successors.
+ */
+void ModuleGraph::Process(const unsigned int n) {
+    Node& node = nodes[n];
+    double start = Timer::GetTime();
+    try {
+        ProfileScope scope(node.name, "Process");
+        node.module->Process(delta, percent);
+    } catch (std::exception& e) {
+        boost::mutex::scoped_lock lock(mutex);
+        if (!failed) failure = e.what();
+        failed = true;
+    } catch (...) {
+        boost::mutex::scoped_lock lock(mutex);
+        if (!failed) failure = "Unknown exception processing module.";
+        failed = true;
+    }
+    node.time = Timer::GetTime() - start;
+
+    vector<unsigned int> spawn;
+    {
+        boost::mutex::scoped_lock lock(mutex);
+        remaining--;
+        progress.notify_all();
+        for (unsigned int i=0; i<node.successors.size(); i++) {
+            unsigned int s = node.successors[i];
+            if (--nodes[s].waiting > 0) continue;
+            if (nodes[s].serial) ready.push_back(s);
+            else spawn.push_back(s);
+        }
+    }
+    for (unsigned int i=0; i<spawn.size(); i++)
+        scheduler->Spawn(boost::bind(&ModuleGraph::Process, this, spawn[i]), &group);
+}
+
+/**
+ * Sum up the work and the critical path of the last run.
+ */
+void ModuleGraph::Measure() {
+    vector<double> finish(nodes.size(), 0);
+    work = criticalPath = 0;
+    for (unsigned int i=0; i<order.size(); i++) {
+        const Node& node = nodes[order[i]];
+        double start = 0;
+        for (unsigned int k=0; k<node.predecessors.size(); k++)
+            start = std::max(start, finish[node.predecessors[k]]);
+        finish[order[i]] = start + node.time;
+        criticalPath = std::max(criticalPath, finish[order[i]]);
+        work += node.time;
+    }
+}
+
+/**
+ * Check if any module of the graph can be processed in parallel.
+ *
+ * @return True if some module has dependencies.
+ */
+bool ModuleGraph::IsParallel() const {
+    return parallel;
+}
+
+/**
+ * Get the number of modules in the graph.
+ *
+ * @return Number of modules.
+ */
+unsigned int ModuleGraph::Size() const {
+    return nodes.size();
+}
+
+/**
+ * Get the time spent in the modules in the last run.
+ *
+ * @return Sum of the process times in milliseconds.
+ */
+double ModuleGraph::GetWork() const {
+    return work;
+}
+
+/**
+ * Get the critical path of the last run: the time of the longest
+ * chain of modules depending on each other.
+ *
+ * @return Critical path length in milliseconds.
+ */
+double ModuleGraph::GetCriticalPath() const {
+    return criticalPath;
+}
+
+} // NS Core
+} // NS OpenEngine
@@ -0,0 +1,166 @@
+// Dependency graph of engine modules.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#ifndef _MODULE_GRAPH_H_
+#define _MODULE_GRAPH_H_
+
+#include <Core/IModule.h>
+#include <Utils/TaskScheduler.h>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition.hpp>
+#include <deque>
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace OpenEngine {
+namespace Core {
+
+using OpenEngine::Utils::TaskScheduler;
+using OpenEngine::Utils::TaskGroup;
+using std::deque;
+using std::list;
+using std::map;
+using std::string;
+using std::vector;
+
+/**
+ * Dependencies of an engine module.
+ *
+ * Declares which other modules a module reads from or writes to
+ * while processing, and which modules must be processed before it
+ * in the same frame. A module always writes to itself, so two
+ * modules reading the same module can run at the same time, while a
+ * module writing it runs alone, in the order the modules were added.
+ *
+ * @code
+ * engine.AddModule(physics, IGameEngine::TICK_INDEPENDENT,
+ *                  ModuleDependencies().Writes(world));
+ * engine.AddModule(sound, IGameEngine::TICK_INDEPENDENT,
+ *                  ModuleDependencies().Reads(world));
+ * engine.AddModule(ai, IGameEngine::TICK_INDEPENDENT,
+ *                  ModuleDependencies().Reads(world).After(input));
+ * @endcode
+ *
+ * @see IGameEngine::AddModule(IModule&, const ProcessTick, const ModuleDependencies&)
+ * @class ModuleDependencies ModuleGraph.h Core/ModuleGraph.h
+ */
+class ModuleDependencies {
+public:
+    list<IModule*> reads;       //!< modules read while processing
+    list<IModule*> writes;      //!< modules written while processing
+    list<IModule*> after;       //!< modules processed before this one
+
+    /**
+     * Declare that the module reads another module.
+     *
+     * @param module Module read.
+     * @return This, for chaining.
+     */
+    ModuleDependencies& Reads(IModule& module) {
+        reads.push_back(&module);
+        return *this;
+    }
+
+    /**
+     * Declare that the module writes another module.
+     *
+     * @param module Module written.
+     * @return This, for chaining.
+     */
+    ModuleDependencies& Writes(IModule& module) {
+        writes.push_back(&module);
+        return *this;
+    }
+
+    /**
+     * Declare that the module is processed after another module.
+     *
+     * @param module Module processed first.
+     * @return This, for chaining.
+     */
+    ModuleDependencies& After(IModule& module) {
+        after.push_back(&module);
+        return *this;
+    }
+};
+
+/**
+ * Dependency graph of engine modules.
+ *
+ * Orders a list of modules by their dependencies and processes the
+ * modules that do not depend on each other at the same time on a
+ * task scheduler.
+ *
+ * Modules without declared dependencies are serial: they depend on
+ * every module added before them and every module added after them
+ * depends on them, and they are always processed on the thread
+ * calling Run(). So a list of modules without dependencies runs in
+ * the order it was added, on the calling thread, like the engine
+ * always did.
+ *
+ * Run() measures the time spent in each module and reports the work,
+ * the sum of the times, and the critical path, the time of the
+ * longest chain of dependent modules. The critical path is the
+ * shortest time the modules can be processed in with unlimited
+ * threads.
+ *
+ * @class ModuleGraph ModuleGraph.h Core/ModuleGraph.h
+ */
+class ModuleGraph {
+private:
+    struct Node {
+        IModule* module;
+        string name;                        // zone name of the module
+        bool serial;                        // processed on the calling thread
+        vector<unsigned int> predecessors;
+        vector<unsigned int> successors;
+        unsigned int waiting;               // predecessors not yet processed
+        double time;                        // time of the last process
+    };
+
+    vector<Node> nodes;
+    vector<unsigned int> order;             // nodes in topological order
+    bool parallel;
+
+    boost::mutex mutex;                     // guards the members below
+    boost::condition progress;              // signaled when a node is done
+    deque<unsigned int> ready;              // serial nodes ready to run
+    unsigned int remaining;                 // nodes not yet processed
+    bool failed;
+    string failure;
+
+    // frame being processed
+    TaskScheduler* scheduler;
+    TaskGroup group;
+    float delta, percent;
+
+    double work, criticalPath;
+
+    void Process(const unsigned int node);
+    void Measure();
+
+public:
+    ModuleGraph();
+
+    void Build(const list<IModule*>& modules,
+               const map<IModule*, ModuleDependencies>& dependencies);
+    void Run(TaskScheduler* scheduler, const float delta, const float percent);
+
+    bool IsParallel() const;
+    unsigned int Size() const;
+    double GetWork() const;
+    double GetCriticalPath() const;
+};
+
+} // NS Core
+} // NS OpenEngine
+
+#endif // _MODULE_GRAPH_H_
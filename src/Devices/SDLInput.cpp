@@ -23,6 +23,22 @@
 namespace OpenEngine {
 namespace Devices {
 
+using OpenEngine::Core::IGameEngine;
+
+/**
+ * Event filter waking the engine.
+ * Called by SDL for each event added to the queue, on the event
+ * thread when SDL pumps events on a thread of its own, so an idle
+ * engine blocked in its wait runs a loop as soon as input arrives.
+ *
+ * @param event Event added to the queue.
+ * @return One to keep the event.
+ */
+static int WakeEngine(const SDL_Event* event) {
+    IGameEngine::Instance().Wake();
+    return 1;
+}
+
 /**
  * Class constructor.
  */
@@ -61,6 +77,7 @@ void SDLInput::Initialize() {
     // Check that SDL has been initialized (SDLFrame does it)
     if (!SDL_WasInit(SDL_INIT_VIDEO))
         logger.error << "SDL was not initialized" << logger.end;
+    SDL_SetEventFilter(&WakeEngine);
 }
 
 /**
@@ -77,7 +94,7 @@ void SDLInput::Process(const float deltaTime, const float percent) {
     while(SDL_PollEvent(&event) && (SDL_GetAppState() & SDL_APPINPUTFOCUS )) {
         switch (event.type) {
         case SDL_QUIT:
-            OpenEngine::Core::IGameEngine::Instance().Stop();
+            IGameEngine::Instance().Stop();
             break;
         case SDL_KEYDOWN:
         case SDL_KEYUP:
@@ -125,7 +142,7 @@ void SDLInput::Process(const float deltaTime, const float percent) {
  * @see IModule::Deinitialize()
  */
 void SDLInput::Deinitialize() {
-
+    SDL_SetEventFilter(NULL);
 }
 
 /**
@@ -231,6 +231,17 @@ bool Frustum::IsVisible(const Square& square) {
 //     return false;
 // }
 
+/**
+ * Test if a sphere is visible in the frustum.
+ * Clipping is not visualized for spheres.
+ *
+ * @param sphere Sphere to test for visibility.
+ * @return True if the sphere is inside or intersecting the frustum.
+ */
+bool Frustum::IsVisible(const Sphere& sphere) {
+    return sphere.Intersects(planes, 6);
+}
+
 /**
  * Test if a box is visible in the frustum.
  *
@@ -277,6 +288,46 @@ bool Frustum::IsVisible(const Box& box) {
     return v;
 }
 
+/**
+ * Test if an array of boxes is visible in the frustum.
+ * Gives the same result as testing each box by itself, but tests
+ * four boxes at a time when compiled with SSE. Clipping is not
+ * visualized for box arrays.
+ *
+ * @param boxes Boxes to test for visibility.
+ * @param visible Visibility mask, one bit per box.
+ * @see BoxArray
+ */
+void Frustum::IsVisible(const BoxArray& boxes, vector<unsigned int>& visible) {
+    boxes.Cull(planes, 6, visible);
+}
+
+/**
+ * Test if an array of spheres is visible in the frustum.
+ * Gives the same result as testing each sphere by itself, but tests
+ * four spheres at a time when compiled with SSE.
+ *
+ * @param spheres Spheres to test for visibility.
+ * @param visible Visibility mask, one bit per sphere.
+ * @see SphereArray
+ */
+void Frustum::IsVisible(const SphereArray& spheres, vector<unsigned int>& visible) {
+    spheres.Cull(planes, 6, visible);
+}
+
+/**
+ * Find the objects of an octree visible in the frustum.
+ * Sub trees entirely inside the frustum are reported without testing
+ * their objects. Clipping is not visualized for octrees.
+ *
+ * @param octree Octree to search.
+ * @param visible Vector to append the ids of the visible objects to.
+ * @see LooseOctree
+ */
+void Frustum::IsVisible(const LooseOctree& octree, vector<unsigned int>& visible) {
+    octree.Query(planes, 6, visible);
+}
+
 /**
  * Calculate the corners of the near clipping plane.
  *
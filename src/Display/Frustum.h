@@ -12,6 +12,9 @@
 
 #include <Display/IViewingVolumeDecorator.h>
 #include <Geometry/Plane.h>
+#include <Geometry/BoxArray.h>
+#include <Geometry/SphereArray.h>
+#include <Geometry/LooseOctree.h>
 #include <Renderers/IRenderNode.h>
 #include <list>
 
@@ -22,6 +25,7 @@ using namespace OpenEngine::Geometry;
 using namespace OpenEngine::Scene;
 using namespace OpenEngine::Renderers;
 using std::list;
+using std::vector;
 
 /**
  * Frustum viewing volume decorator.
@@ -98,7 +102,11 @@ public:
 
     // viewing volume clipping methods
     virtual bool IsVisible(const Square& square);
+    virtual bool IsVisible(const Sphere& sphere);
     virtual bool IsVisible(const Box& box);
+    void IsVisible(const BoxArray& boxes, vector<unsigned int>& visible);
+    void IsVisible(const SphereArray& spheres, vector<unsigned int>& visible);
+    void IsVisible(const LooseOctree& octree, vector<unsigned int>& visible);
 };
 
 } // NS Display
@@ -72,8 +72,11 @@ void SDLFrame::SetOptions(const FrameOption options) {
 }
 
 void SDLFrame::Initialize() {
-    // Initialize the video frame
-    if (SDL_Init(SDL_INIT_VIDEO) < 0 )
+    // Initialize the video frame, pumping the events on a thread of
+    // their own where SDL supports it, so input wakes an idle engine
+    // (see SDLInput)
+    if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_EVENTTHREAD) < 0 &&
+        SDL_Init(SDL_INIT_VIDEO) < 0)
         throw Exception("SDL_Init: " + string(SDL_GetError()));
 
     // Set SDL flags
@@ -0,0 +1,464 @@
+// Binary space partitioning tree over faces.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#include <Geometry/BSPTree.h>
+#include <Utils/TaskScheduler.h>
+#include <boost/bind.hpp>
+#include <algorithm>
+#include <cmath>
+
+namespace OpenEngine {
+namespace Geometry {
+
+using OpenEngine::Utils::TaskGroup;
+
+// number of splitting faces tried per node
+static const unsigned int CANDIDATES = 8;
+// number of fragments a candidate is scored against
+static const unsigned int SAMPLES = 64;
+// cost of a split relative to one fragment of imbalance
+static const int SPLIT_COST = 8;
+// smallest number of fragments built by a parallel job
+static const unsigned int MIN_JOB = 2048;
+
+// position of a fragment relative to a plane
+enum Side { COPLANAR, FRONT, BACK, SPANNING };
+
+// a subtree built by a task
+struct BSPTask {
+    vector<BSPTree::Fragment> input;
+    vector<BSPTree::Node> nodes;
+    vector<BSPTree::Fragment> fragments;
+    int parent;
+    bool front;
+};
+
+// builds a tree in depth first order without recursion. The
+// fragments of pending subtrees are kept in one work array as a
+// stack of ranges: a node writes the fragments behind and in front
+// of its plane above its own range, and the array is cut back to the
+// end of the next pending range when it is popped.
+class BSPBuilder {
+    struct Item {
+        unsigned int begin, end;
+        int parent;
+        bool front;
+    };
+
+    const vector<float>& planes;
+    const float epsilon;
+    vector<BSPTree::Fragment> work;
+    vector<unsigned char> sides;
+    vector<Item> items;
+
+public:
+    BSPBuilder(const vector<float>& planes, const float epsilon)
+        : planes(planes), epsilon(epsilon) {}
+
+    Side Classify(const BSPTree::Fragment& f, const unsigned int face, float dist[3]) {
+        // a face is in its own plane regardless of rounding
+        if (f.face == face) return COPLANAR;
+        const float* p = &planes[face * 4];
+        bool front = false, back = false;
+        for (int i=0; i<3; i++) {
+            dist[i] = p[0]*f.vert[i][0] + p[1]*f.vert[i][1] + p[2]*f.vert[i][2] + p[3];
+            if (dist[i] > epsilon) front = true;
+            else if (dist[i] < -epsilon) back = true;
+            else dist[i] = 0;
+        }
+        if (front && back) return SPANNING;
+        if (front) return FRONT;
+        if (back) return BACK;
+        return COPLANAR;
+    }
+
+    // clips a spanning fragment to the side of the plane given by
+    // sign and appends the one or two resulting fragments
+    void Clip(const BSPTree::Fragment& f, const float dist[3], const float sign) {
+        float vert[4][3], weight[4][3];
+        int n = 0;
+        for (int i=0; i<3; i++) {
+            int j = (i + 1) % 3;
+            float di = dist[i] * sign, dj = dist[j] * sign;
+            if (di >= 0) {
+                for (int k=0; k<3; k++) {
+                    vert[n][k] = f.vert[i][k];
+                    weight[n][k] = f.weight[i][k];
+                }
+                n++;
+            }
+            if ((di > 0 && dj < 0) || (di < 0 && dj > 0)) {
+                float t = di / (di - dj);
+                for (int k=0; k<3; k++) {
+                    vert[n][k] = f.vert[i][k] + (f.vert[j][k] - f.vert[i][k]) * t;
+                    weight[n][k] = f.weight[i][k] + (f.weight[j][k] - f.weight[i][k]) * t;
+                }
+                n++;
+            }
+        }
+        // fan triangulation of the clipped polygon
+        for (int t=1; t+1<n; t++) {
+            BSPTree::Fragment r;
+            int v[3] = { 0, t, t+1 };
+            for (int i=0; i<3; i++)
+                for (int k=0; k<3; k++) {
+                    r.vert[i][k] = vert[v[i]][k];
+                    r.weight[i][k] = weight[v[i]][k];
+                }
+            r.face = f.face;
+            work.push_back(r);
+        }
+    }
+
+    // picks the splitting face of a range among evenly spaced
+    // candidates, scored against evenly spaced samples
+    unsigned int Choose(const unsigned int begin, const unsigned int end) {
+        unsigned int size = end - begin;
+        unsigned int candidates = std::min(size, CANDIDATES);
+        unsigned int samples = std::min(size, SAMPLES);
+        unsigned int best = work[begin].face;
+        int bestScore = -1;
+        float dist[3];
+        for (unsigned int c=0; c<candidates; c++) {
+            unsigned int face = work[begin + c * size / candidates].face;
+            int front = 0, back = 0, spans = 0;
+            for (unsigned int s=0; s<samples; s++) {
+                switch (Classify(work[begin + s * size / samples], face, dist)) {
+                case FRONT:    front++; break;
+                case BACK:     back++;  break;
+                case SPANNING: spans++; break;
+                default: break;
+                }
+            }
+            int score = SPLIT_COST * spans + std::abs(front - back);
+            if (bestScore < 0 || score < bestScore) {
+                bestScore = score;
+                best = face;
+            }
+        }
+        return best;
+    }
+
+    // builds the tree of the input fragments. If tasks are given,
+    // subtrees of at most grain fragments are left to them.
+    void Build(vector<BSPTree::Fragment>& input, vector<BSPTree::Node>& nodes,
+               vector<BSPTree::Fragment>& out, const unsigned int grain,
+               vector<BSPTask>* tasks) {
+        work.clear();
+        work.reserve(2 * input.size());
+        work.insert(work.end(), input.begin(), input.end());
+        vector<BSPTree::Fragment>().swap(input);
+        Item root = { 0, (unsigned int)work.size(), -1, false };
+        items.push_back(root);
+
+        while (!items.empty()) {
+            Item item = items.back();
+            items.pop_back();
+            work.resize(item.end);
+
+            int index = nodes.size();
+            if (tasks != NULL && item.parent >= 0 && item.end - item.begin <= grain) {
+                BSPTask task;
+                task.parent = item.parent;
+                task.front = item.front;
+                tasks->push_back(task);
+                tasks->back().input.assign(work.begin() + item.begin,
+                                           work.begin() + item.end);
+                continue;
+            }
+            if (item.parent >= 0) {
+                if (item.front) nodes[item.parent].front = index;
+                else            nodes[item.parent].back = index;
+            }
+
+            unsigned int face = Choose(item.begin, item.end);
+            BSPTree::Node node;
+            for (int k=0; k<3; k++)
+                node.normal[k] = planes[face * 4 + k];
+            node.distance = planes[face * 4 + 3];
+            node.front = node.back = -1;
+            node.first = out.size();
+
+            // the fragments in the plane go to the node and those
+            // behind it to the work array
+            sides.resize(item.end - item.begin);
+            float dist[3];
+            for (unsigned int i=item.begin; i<item.end; i++) {
+                const BSPTree::Fragment f = work[i];
+                Side side = Classify(f, face, dist);
+                sides[i - item.begin] = side;
+                if (side == COPLANAR)  out.push_back(f);
+                else if (side == BACK) work.push_back(f);
+                else if (side == SPANNING) Clip(f, dist, -1);
+            }
+            unsigned int middle = work.size();
+            // then those in front of it
+            for (unsigned int i=item.begin; i<item.end; i++) {
+                const BSPTree::Fragment f = work[i];
+                Side side = (Side)sides[i - item.begin];
+                if (side == FRONT) work.push_back(f);
+                else if (side == SPANNING) {
+                    Classify(f, face, dist);
+                    Clip(f, dist, 1);
+                }
+            }
+            node.count = out.size() - node.first;
+            nodes.push_back(node);
+
+            if (middle > item.end) {
+                Item back = { item.end, middle, index, false };
+                items.push_back(back);
+            }
+            if (work.size() > middle) {
+                Item front = { middle, (unsigned int)work.size(), index, true };
+                items.push_back(front);
+            }
+        }
+    }
+};
+
+// builds the subtree of a task on a worker thread
+static void RunTask(BSPTask* task, const vector<float>* planes, const float epsilon) {
+    BSPBuilder builder(*planes, epsilon);
+    builder.Build(task->input, task->nodes, task->fragments, 0, NULL);
+}
+
+/**
+ * Create an empty tree.
+ */
+BSPTree::BSPTree() {}
+
+/**
+ * Reset the tree and make a fragment of each face.
+ */
+void BSPTree::Prepare(FaceSet& faceset, vector<Fragment>& input) {
+    Clear();
+    for (FaceList::iterator itr = faceset.begin(); itr != faceset.end(); itr++) {
+        Face& face = **itr;
+        if (!(face.hardNorm.GetLength() > 0)) continue;
+        Fragment f;
+        for (int i=0; i<3; i++)
+            for (int k=0; k<3; k++) {
+                f.vert[i][k] = face.vert[i].Get(k);
+                f.weight[i][k] = (i == k) ? 1 : 0;
+            }
+        f.face = faces.size();
+        input.push_back(f);
+        faces.push_back(*itr);
+        for (int k=0; k<3; k++) planes.push_back(face.hardNorm.Get(k));
+        planes.push_back(-(face.hardNorm * face.vert[0]));
+    }
+}
+
+/**
+ * Build the tree of a face set.
+ *
+ * @param faceset Faces to build the tree of.
+ * @param epsilon Width of the splitting planes [optional].
+ */
+void BSPTree::Build(FaceSet& faceset, const float epsilon) {
+    vector<Fragment> input;
+    Prepare(faceset, input);
+    BSPBuilder builder(planes, epsilon);
+    builder.Build(input, nodes, fragments, 0, NULL);
+}
+
+/**
+ * Build the tree on a task scheduler.
+ * The top of the tree is built on the calling thread until the
+ * subtrees are small enough to balance over the workers, then the
+ * front and back subtrees are built as tasks. The tree has the
+ * same shape and fragments as that of Build(FaceSet&), with the
+ * nodes stored in another order.
+ *
+ * @param faceset Faces to build the tree of.
+ * @param scheduler Scheduler to build the subtrees on.
+ * @param epsilon Width of the splitting planes [optional].
+ */
+void BSPTree::Build(FaceSet& faceset, TaskScheduler& scheduler, const float epsilon) {
+    vector<Fragment> input;
+    Prepare(faceset, input);
+    unsigned int grain = std::max(MIN_JOB, (unsigned int)input.size() /
+                                  (4 * scheduler.GetNumberOfWorkers()));
+    vector<BSPTask> tasks;
+    BSPBuilder builder(planes, epsilon);
+    builder.Build(input, nodes, fragments, grain, &tasks);
+    TaskGroup group;
+    for (unsigned int i=0; i<tasks.size(); i++)
+        scheduler.Spawn(boost::bind(&RunTask, &tasks[i], &planes, epsilon), &group);
+    scheduler.Wait(group);
+
+    // append the subtrees, offsetting their indices
+    for (unsigned int i=0; i<tasks.size(); i++) {
+        BSPTask& task = tasks[i];
+        int base = nodes.size();
+        unsigned int first = fragments.size();
+        for (unsigned int n=0; n<task.nodes.size(); n++) {
+            Node node = task.nodes[n];
+            if (node.front >= 0) node.front += base;
+            if (node.back >= 0) node.back += base;
+            node.first += first;
+            nodes.push_back(node);
+        }
+        fragments.insert(fragments.end(), task.fragments.begin(), task.fragments.end());
+        if (task.front) nodes[task.parent].front = base;
+        else            nodes[task.parent].back = base;
+        vector<Node>().swap(task.nodes);
+        vector<Fragment>().swap(task.fragments);
+    }
+}
+
+/**
+ * Remove all nodes and fragments.
+ */
+void BSPTree::Clear() {
+    nodes.clear();
+    fragments.clear();
+    faces.clear();
+    planes.clear();
+}
+
+/**
+ * Get the fragments ordered from back to front as seen from a point.
+ * Drawing the fragments in this order with the painter's algorithm
+ * gives correct visibility without a depth buffer. The fragments
+ * are appended by index.
+ *
+ * @param eye Point to view from.
+ * @param order Vector to append the fragment indices to.
+ */
+void BSPTree::GetBackToFront(const Vector<3,float> eye, vector<unsigned int>& order) const {
+    if (nodes.empty()) return;
+    // positive entries are nodes to visit, negative entries are the
+    // fragments of node -(entry + 1) to append
+    vector<int> stack;
+    stack.push_back(0);
+    while (!stack.empty()) {
+        int entry = stack.back();
+        stack.pop_back();
+        if (entry < 0) {
+            const Node& node = nodes[-(entry + 1)];
+            for (unsigned int i=0; i<node.count; i++)
+                order.push_back(node.first + i);
+            continue;
+        }
+        const Node& node = nodes[entry];
+        float d = node.normal[0] * eye.Get(0) + node.normal[1] * eye.Get(1) +
+            node.normal[2] * eye.Get(2) + node.distance;
+        int nearer = (d >= 0) ? node.front : node.back;
+        int farther = (d >= 0) ? node.back : node.front;
+        if (nearer >= 0) stack.push_back(nearer);
+        stack.push_back(-(entry + 1));
+        if (farther >= 0) stack.push_back(farther);
+    }
+}
+
+/**
+ * Get the face of a fragment.
+ * The face is the original face if it was never split, otherwise a
+ * new face with the attributes interpolated from the original.
+ *
+ * @param fragment Fragment index.
+ * @return Face of the fragment.
+ */
+FacePtr BSPTree::GetFace(const unsigned int fragment) const {
+    const Fragment& f = fragments[fragment];
+    const FacePtr& source = faces[f.face];
+    bool whole = true;
+    for (int i=0; i<3; i++)
+        for (int k=0; k<3; k++)
+            whole &= f.weight[i][k] == ((i == k) ? 1 : 0);
+    if (whole) return source;
+
+    FacePtr face(new Face(*source));
+    for (int i=0; i<3; i++) {
+        const float* w = f.weight[i];
+        face->vert[i] = Vector<3,float>(f.vert[i][0], f.vert[i][1], f.vert[i][2]);
+        face->norm[i] = source->norm[0] * w[0] + source->norm[1] * w[1] + source->norm[2] * w[2];
+        if (face->norm[i].GetLength() > 0) face->norm[i].Normalize();
+        face->texc[i] = source->texc[0] * w[0] + source->texc[1] * w[1] + source->texc[2] * w[2];
+        face->colr[i] = source->colr[0] * w[0] + source->colr[1] * w[1] + source->colr[2] * w[2];
+        face->tang[i] = source->tang[0] * w[0] + source->tang[1] * w[1] + source->tang[2] * w[2];
+        face->bino[i] = source->bino[0] * w[0] + source->bino[1] * w[1] + source->bino[2] * w[2];
+    }
+    return face;
+}
+
+/**
+ * Create a face set of all fragments in node order.
+ *
+ * @return Face set, owned by the caller.
+ */
+FaceSet* BSPTree::ToFaceSet() const {
+    FaceSet* set = new FaceSet();
+    for (unsigned int i=0; i<fragments.size(); i++)
+        set->Add(GetFace(i));
+    return set;
+}
+
+/**
+ * Get the nodes, the root first.
+ *
+ * @return Node array.
+ */
+const vector<BSPTree::Node>& BSPTree::GetNodes() const {
+    return nodes;
+}
+
+/**
+ * Get the fragments.
+ *
+ * @return Fragment array.
+ */
+const vector<BSPTree::Fragment>& BSPTree::GetFragments() const {
+    return fragments;
+}
+
+/**
+ * Get the number of nodes.
+ *
+ * @return Number of nodes.
+ */
+unsigned int BSPTree::GetNumberOfNodes() const {
+    return nodes.size();
+}
+
+/**
+ * Get the number of fragments.
+ *
+ * @return Number of fragments.
+ */
+unsigned int BSPTree::GetNumberOfFragments() const {
+    return fragments.size();
+}
+
+/**
+ * Get the depth of the tree, zero if empty.
+ *
+ * @return Number of nodes on the longest path from the root to a leaf.
+ */
+unsigned int BSPTree::GetDepth() const {
+    if (nodes.empty()) return 0;
+    vector<unsigned int> depths(nodes.size(), 0);
+    vector<int> stack(1, 0);
+    depths[0] = 1;
+    unsigned int depth = 0;
+    while (!stack.empty()) {
+        const Node& node = nodes[stack.back()];
+        unsigned int d = depths[stack.back()];
+        stack.pop_back();
+        depth = std::max(depth, d);
+        if (node.front >= 0) { depths[node.front] = d + 1; stack.push_back(node.front); }
+        if (node.back >= 0)  { depths[node.back] = d + 1;  stack.push_back(node.back); }
+    }
+    return depth;
+}
+
+} // NS Geometry
+} // NS OpenEngine
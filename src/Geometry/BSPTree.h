@@ -0,0 +1,110 @@
+// Binary space partitioning tree over faces.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#ifndef _BSP_TREE_H_
+#define _BSP_TREE_H_
+
+#include <Geometry/FaceSet.h>
+#include <vector>
+
+namespace OpenEngine {
+
+// forward declarations
+namespace Utils { class TaskScheduler; }
+
+namespace Geometry {
+
+using std::vector;
+using OpenEngine::Utils::TaskScheduler;
+
+/**
+ * Binary space partitioning tree over the faces of a face set.
+ *
+ * Each node splits space by the plane of one of its faces. The faces
+ * lying in the plane are kept in the node, faces in front of and
+ * behind the plane go to the two subtrees, and faces spanning the
+ * plane are split in pieces on each side, like FaceSet::Split does.
+ * The splitting face of a node is chosen among a few candidates by
+ * the number of splits it causes and the balance of the subtrees.
+ *
+ * @code
+ * BSPTree bsp;
+ * bsp.Build(faces, TaskScheduler::GetDefault());
+ * vector<unsigned int> order;
+ * bsp.GetBackToFront(eye, order);
+ * for (unsigned int i=0; i<order.size(); i++)
+ *     Draw(bsp.GetFace(order[i]));
+ * @endcode
+ *
+ * The pieces of the faces are stored as fragments, which hold the
+ * vertex positions and the barycentric weights of the vertices in
+ * the original face. Splitting a fragment is plain arithmetic into
+ * the builder's preallocated work array, so the build does not
+ * allocate per split and never copies a Face. The attributes of a
+ * split face are interpolated when it is requested by GetFace().
+ *
+ * Faces of zero area define no plane and are left out of the tree.
+ *
+ * @class BSPTree BSPTree.h Geometry/BSPTree.h
+ */
+class BSPTree {
+public:
+    /**
+     * Node of the tree.
+     * The plane satisfies normal * p + distance = 0, and the front
+     * side is the side the normal points to.
+     */
+    struct Node {
+        float normal[3];        //!< normal of the splitting plane
+        float distance;         //!< distance of the splitting plane
+        int front;              //!< front child, -1 for none
+        int back;               //!< back child, -1 for none
+        unsigned int first;     //!< first fragment in the plane
+        unsigned int count;     //!< number of fragments in the plane
+    };
+
+    /**
+     * Piece of a face.
+     */
+    struct Fragment {
+        float vert[3][3];       //!< vertex positions
+        float weight[3][3];     //!< weights of the face vertices per vertex
+        unsigned int face;      //!< index of the face
+    };
+
+private:
+    vector<Node> nodes;             //!< nodes, the root first
+    vector<Fragment> fragments;     //!< fragments in node order
+    vector<FacePtr> faces;          //!< the faces of the fragments
+    vector<float> planes;           //!< planes of the faces, four floats each
+
+    void Prepare(FaceSet& faceset, vector<Fragment>& input);
+
+public:
+    BSPTree();
+
+    void Build(FaceSet& faces, const float epsilon = EPS);
+    void Build(FaceSet& faces, TaskScheduler& scheduler, const float epsilon = EPS);
+    void Clear();
+
+    void GetBackToFront(const Vector<3,float> eye, vector<unsigned int>& order) const;
+    FacePtr GetFace(const unsigned int fragment) const;
+    FaceSet* ToFaceSet() const;
+
+    const vector<Node>& GetNodes() const;
+    const vector<Fragment>& GetFragments() const;
+    unsigned int GetNumberOfNodes() const;
+    unsigned int GetNumberOfFragments() const;
+    unsigned int GetDepth() const;
+};
+
+} // NS Geometry
+} // NS OpenEngine
+
+#endif // _BSP_TREE_H_
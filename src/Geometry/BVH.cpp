@@ -0,0 +1,727 @@
+// Bounding volume hierarchy over faces.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#include <Geometry/BVH.h>
+#include <Utils/TaskScheduler.h>
+#include <boost/bind.hpp>
+#include <algorithm>
+#include <cmath>
+
+namespace OpenEngine {
+namespace Geometry {
+
+using OpenEngine::Utils::TaskGroup;
+
+// number of bins per axis of the surface area heuristic
+static const int BINS = 16;
+// largest number of triangles in a leaf
+static const unsigned int MAX_LEAF = 8;
+// cost of visiting a node relative to intersecting a triangle
+static const float TRAVERSAL_COST = 1.0f;
+// below this depth ranges are split at the median only
+static const unsigned int MAX_DEPTH = 64;
+// depth of the traversal stacks, enough for any tree of MAX_DEPTH
+static const unsigned int STACK_SIZE = 2 * MAX_DEPTH + 2;
+// smallest number of triangles built by a parallel job
+static const unsigned int MIN_JOB = 4096;
+
+// bounds and centroid of a triangle during the build
+struct Primitive {
+    float min[3], max[3], center[3];
+};
+
+static void Grow(float min[3], float max[3], const float pmin[3], const float pmax[3]) {
+    for (int i=0; i<3; i++) {
+        if (pmin[i] < min[i]) min[i] = pmin[i];
+        if (pmax[i] > max[i]) max[i] = pmax[i];
+    }
+}
+
+static float Area(const float min[3], const float max[3]) {
+    float x = max[0] - min[0], y = max[1] - min[1], z = max[2] - min[2];
+    if (x < 0 || y < 0 || z < 0) return 0;
+    return 2 * (x*y + y*z + z*x);
+}
+
+// bin of a centroid along an axis
+struct InBin {
+    const vector<Primitive>& prims;
+    int axis, bin;
+    float min, scale;
+    InBin(const vector<Primitive>& prims, int axis, int bin, float min, float scale)
+        : prims(prims), axis(axis), bin(bin), min(min), scale(scale) {}
+    static int Of(float c, float min, float scale) {
+        int b = int((c - min) * scale);
+        return (b < 0) ? 0 : (b >= BINS) ? BINS-1 : b;
+    }
+    bool operator()(unsigned int i) const {
+        return Of(prims[i].center[axis], min, scale) <= bin;
+    }
+};
+
+// orders primitives by their centroid along an axis
+struct ByCenter {
+    const vector<Primitive>& prims;
+    int axis;
+    ByCenter(const vector<Primitive>& prims, int axis) : prims(prims), axis(axis) {}
+    bool operator()(unsigned int a, unsigned int b) const {
+        return prims[a].center[axis] < prims[b].center[axis];
+    }
+};
+
+// builds nodes over ranges of a shared primitive order. Ranges of
+// different subtrees never overlap, so subtrees can be built
+// concurrently into separate node arrays.
+class BVHBuilder {
+public:
+    // a subtree built by a task
+    struct Task {
+        unsigned int begin, end, depth;
+        vector<BVH::Node> nodes;
+    };
+
+private:
+    const vector<Primitive>& prims;
+    vector<unsigned int>& order;
+
+public:
+    BVHBuilder(const vector<Primitive>& prims, vector<unsigned int>& order)
+        : prims(prims), order(order) {}
+
+    // computes the bounds of a range and partitions it. Returns the
+    // first index of the right half, or begin if the range is a leaf.
+    unsigned int Split(unsigned int begin, unsigned int end,
+                       unsigned int depth, BVH::Node& node) {
+        float cmin[3], cmax[3];
+        for (int i=0; i<3; i++) {
+            node.min[i] = cmin[i] = FLT_MAX;
+            node.max[i] = cmax[i] = -FLT_MAX;
+        }
+        for (unsigned int i=begin; i<end; i++) {
+            const Primitive& p = prims[order[i]];
+            Grow(node.min, node.max, p.min, p.max);
+            Grow(cmin, cmax, p.center, p.center);
+        }
+        unsigned int count = end - begin;
+        if (count <= 2) return begin;
+
+        int axis = 0;
+        for (int i=1; i<3; i++)
+            if (cmax[i] - cmin[i] > cmax[axis] - cmin[axis]) axis = i;
+        // all centroids in one point, or a degenerate tree
+        if (!(cmax[axis] > cmin[axis]) || depth >= MAX_DEPTH)
+            return (count <= MAX_LEAF) ? begin : Median(begin, end, axis);
+
+        // sweep the bins of each axis for the cheapest split
+        float best = FLT_MAX;
+        int bestAxis = -1, bestBin = 0;
+        float scales[3];
+        for (int a=0; a<3; a++) {
+            float extent = cmax[a] - cmin[a];
+            if (!(extent > 0)) continue;
+            float scale = scales[a] = BINS / extent;
+            unsigned int counts[BINS] = {0};
+            float bmin[BINS][3], bmax[BINS][3];
+            for (int b=0; b<BINS; b++)
+                for (int i=0; i<3; i++) {
+                    bmin[b][i] = FLT_MAX;
+                    bmax[b][i] = -FLT_MAX;
+                }
+            for (unsigned int i=begin; i<end; i++) {
+                const Primitive& p = prims[order[i]];
+                int b = InBin::Of(p.center[a], cmin[a], scale);
+                counts[b]++;
+                Grow(bmin[b], bmax[b], p.min, p.max);
+            }
+            // costs of the right sides, then sweep from the left
+            float right[BINS];
+            float rmin[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+            float rmax[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+            unsigned int rcount = 0;
+            for (int b=BINS-1; b>0; b--) {
+                Grow(rmin, rmax, bmin[b], bmax[b]);
+                rcount += counts[b];
+                right[b] = Area(rmin, rmax) * rcount;
+            }
+            float lmin[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+            float lmax[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+            unsigned int lcount = 0;
+            for (int b=0; b<BINS-1; b++) {
+                Grow(lmin, lmax, bmin[b], bmax[b]);
+                lcount += counts[b];
+                if (lcount == 0 || lcount == count) continue;
+                float cost = Area(lmin, lmax) * lcount + right[b+1];
+                if (cost < best) {
+                    best = cost;
+                    bestAxis = a;
+                    bestBin = b;
+                }
+            }
+        }
+
+        float area = Area(node.min, node.max);
+        float cost = TRAVERSAL_COST + ((area > 0) ? best / area : count);
+        if (bestAxis < 0 || (cost >= count && count <= MAX_LEAF)) {
+            if (count <= MAX_LEAF) return begin;
+            return Median(begin, end, axis);
+        }
+        unsigned int* mid =
+            std::partition(&order[0] + begin, &order[0] + end,
+                           InBin(prims, bestAxis, bestBin,
+                                 cmin[bestAxis], scales[bestAxis]));
+        return mid - &order[0];
+    }
+
+    unsigned int Median(unsigned int begin, unsigned int end, int axis) {
+        unsigned int mid = begin + (end - begin) / 2;
+        std::nth_element(&order[0] + begin, &order[0] + mid, &order[0] + end,
+                         ByCenter(prims, axis));
+        return mid;
+    }
+
+    // builds the subtree of a range in depth first order
+    void Build(unsigned int begin, unsigned int end, unsigned int depth,
+               vector<BVH::Node>& nodes) {
+        unsigned int index = nodes.size();
+        BVH::Node node;
+        unsigned int mid = Split(begin, end, depth, node);
+        if (mid == begin) {
+            node.offset = begin;
+            node.count = end - begin;
+            nodes.push_back(node);
+            return;
+        }
+        node.count = 0;
+        nodes.push_back(node);
+        Build(begin, mid, depth+1, nodes);
+        nodes[index].offset = nodes.size() - index;
+        Build(mid, end, depth+1, nodes);
+    }
+
+    void Run(Task* task) {
+        Build(task->begin, task->end, task->depth, task->nodes);
+    }
+
+    // builds the top of the tree, leaving ranges of at most grain
+    // triangles to tasks. A task is recorded in the node array as an
+    // inner node with the task index in its offset, and a count of
+    // zero and an empty box.
+    void Top(unsigned int begin, unsigned int end, unsigned int depth,
+             unsigned int grain, vector<BVH::Node>& nodes, vector<Task>& tasks) {
+        BVH::Node node;
+        if (end - begin <= grain) {
+            Task task;
+            task.begin = begin;
+            task.end = end;
+            task.depth = depth;
+            node.offset = tasks.size();
+            node.count = 0;
+            node.min[0] = 1;
+            node.max[0] = 0;
+            tasks.push_back(task);
+            nodes.push_back(node);
+            return;
+        }
+        unsigned int mid = Split(begin, end, depth, node);
+        if (mid == begin) {
+            node.offset = begin;
+            node.count = end - begin;
+            nodes.push_back(node);
+            return;
+        }
+        node.count = 0;
+        nodes.push_back(node);
+        Top(begin, mid, depth+1, grain, nodes, tasks);
+        Top(mid, end, depth+1, grain, nodes, tasks);
+    }
+
+    // copies the top of the tree with the task subtrees in place,
+    // fixing the relative offsets. Returns the next top node.
+    static unsigned int Emit(const vector<BVH::Node>& top, unsigned int i,
+                             vector<Task>& tasks, vector<BVH::Node>& nodes) {
+        const BVH::Node& node = top[i];
+        if (node.count == 0 && node.min[0] > node.max[0]) {
+            Task& task = tasks[node.offset];
+            nodes.insert(nodes.end(), task.nodes.begin(), task.nodes.end());
+            vector<BVH::Node>().swap(task.nodes);
+            return i + 1;
+        }
+        unsigned int index = nodes.size();
+        nodes.push_back(node);
+        if (node.count > 0) return i + 1;
+        unsigned int next = Emit(top, i + 1, tasks, nodes);
+        nodes[index].offset = nodes.size() - index;
+        return Emit(top, next, tasks, nodes);
+    }
+};
+
+// copies the faces of a set and their bounds for the builder
+static void Prepare(FaceSet& faceset, vector<FacePtr>& faces,
+                    vector<Primitive>& prims, vector<unsigned int>& order) {
+    faces.reserve(faceset.Size());
+    for (FaceList::iterator itr = faceset.begin(); itr != faceset.end(); itr++)
+        faces.push_back(*itr);
+    prims.resize(faces.size());
+    order.resize(faces.size());
+    for (unsigned int i=0; i<faces.size(); i++) {
+        Primitive& p = prims[i];
+        const Vector<3,float>* v = faces[i]->vert;
+        for (int k=0; k<3; k++) {
+            p.min[k] = std::min(v[0].Get(k), std::min(v[1].Get(k), v[2].Get(k)));
+            p.max[k] = std::max(v[0].Get(k), std::max(v[1].Get(k), v[2].Get(k)));
+            p.center[k] = (p.min[k] + p.max[k]) * 0.5f;
+        }
+        order[i] = i;
+    }
+}
+
+// stores the faces and their vertices in leaf order
+static void Finish(const vector<unsigned int>& order, vector<FacePtr>& faces,
+                   vector<float>& triangles) {
+    vector<FacePtr> sorted(order.size());
+    triangles.resize(order.size() * 9);
+    for (unsigned int i=0; i<order.size(); i++) {
+        sorted[i] = faces[order[i]];
+        for (int v=0; v<3; v++)
+            for (int k=0; k<3; k++)
+                triangles[i*9 + v*3 + k] = sorted[i]->vert[v].Get(k);
+    }
+    faces.swap(sorted);
+}
+
+/**
+ * Create an empty hierarchy.
+ */
+BVH::BVH() {}
+
+/**
+ * Build the hierarchy over a face set.
+ *
+ * @param faceset Faces to build the hierarchy of.
+ */
+void BVH::Build(FaceSet& faceset) {
+    vector<Primitive> prims;
+    vector<unsigned int> order;
+    Clear();
+    Prepare(faceset, faces, prims, order);
+    if (faces.empty()) return;
+    BVHBuilder builder(prims, order);
+    builder.Build(0, order.size(), 0, nodes);
+    Finish(order, faces, triangles);
+}
+
+/**
+ * Build the hierarchy on a task scheduler.
+ * The top of the tree is split on the calling thread until the
+ * ranges are small enough to balance over the workers, then the
+ * subtrees of the ranges are built as tasks. The result is the
+ * same as that of Build(FaceSet&).
+ *
+ * @param faceset Faces to build the hierarchy of.
+ * @param scheduler Scheduler to build the subtrees on.
+ */
+void BVH::Build(FaceSet& faceset, TaskScheduler& scheduler) {
+    vector<Primitive> prims;
+    vector<unsigned int> order;
+    Clear();
+    Prepare(faceset, faces, prims, order);
+    if (faces.empty()) return;
+    BVHBuilder builder(prims, order);
+
+    unsigned int grain = std::max(MIN_JOB, (unsigned int)order.size() /
+                                  (4 * scheduler.GetNumberOfWorkers()));
+    vector<Node> top;
+    vector<BVHBuilder::Task> tasks;
+    builder.Top(0, order.size(), 0, grain, top, tasks);
+    if (tasks.size() == 1 && top.size() == 1)
+        builder.Build(0, order.size(), 0, nodes);
+    else {
+        TaskGroup group;
+        for (unsigned int i=0; i<tasks.size(); i++)
+            scheduler.Spawn(boost::bind(&BVHBuilder::Run, &builder, &tasks[i]), &group);
+        scheduler.Wait(group);
+        BVHBuilder::Emit(top, 0, tasks, nodes);
+    }
+    Finish(order, faces, triangles);
+}
+
+/**
+ * Remove all nodes and faces.
+ */
+void BVH::Clear() {
+    nodes.clear();
+    triangles.clear();
+    faces.clear();
+}
+
+// ray and box slab test, returns the entry distance or FLT_MAX
+static inline float RayBox(const BVH::Node& node, const float o[3],
+                           const float inv[3], const float tmax) {
+    float t0 = 0, t1 = tmax;
+    for (int i=0; i<3; i++) {
+        float a = (node.min[i] - o[i]) * inv[i];
+        float b = (node.max[i] - o[i]) * inv[i];
+        if (a > b) std::swap(a, b);
+        // comparisons written to ignore the NaN of a zero direction
+        // component on the slab plane
+        if (a > t0) t0 = a;
+        if (b < t1) t1 = b;
+        if (t0 > t1) return FLT_MAX;
+    }
+    return t0;
+}
+
+// Moller-Trumbore ray and triangle test, returns the ray parameter
+// of the hit or FLT_MAX
+static inline float RayTriangle(const float* tri, const float o[3], const float d[3]) {
+    float e1[3], e2[3], p[3], s[3], q[3];
+    for (int i=0; i<3; i++) {
+        e1[i] = tri[3+i] - tri[i];
+        e2[i] = tri[6+i] - tri[i];
+        s[i] = o[i] - tri[i];
+    }
+    p[0] = d[1]*e2[2] - d[2]*e2[1];
+    p[1] = d[2]*e2[0] - d[0]*e2[2];
+    p[2] = d[0]*e2[1] - d[1]*e2[0];
+    float det = e1[0]*p[0] + e1[1]*p[1] + e1[2]*p[2];
+    if (det == 0) return FLT_MAX;
+    float inv = 1 / det;
+    float u = (s[0]*p[0] + s[1]*p[1] + s[2]*p[2]) * inv;
+    if (u < 0 || u > 1) return FLT_MAX;
+    q[0] = s[1]*e1[2] - s[2]*e1[1];
+    q[1] = s[2]*e1[0] - s[0]*e1[2];
+    q[2] = s[0]*e1[1] - s[1]*e1[0];
+    float v = (d[0]*q[0] + d[1]*q[1] + d[2]*q[2]) * inv;
+    if (v < 0 || u + v > 1) return FLT_MAX;
+    float t = (e2[0]*q[0] + e2[1]*q[1] + e2[2]*q[2]) * inv;
+    return (t >= 0) ? t : FLT_MAX;
+}
+
+/**
+ * Find the nearest face hit by a ray.
+ * Children are visited nearest first and subtrees farther away than
+ * the nearest hit so far are skipped. The distance of the hit is the
+ * ray parameter, so it is measured in lengths of the direction.
+ *
+ * @param origin Origin of the ray.
+ * @param direction Direction of the ray, need not be normalized.
+ * @param hit Set to the nearest hit if any.
+ * @param maxDistance Largest ray parameter to consider [optional].
+ * @return True if a face is hit.
+ */
+bool BVH::Intersect(const Vector<3,float> origin, const Vector<3,float> direction,
+                    RayHit& hit, const float maxDistance) const {
+    if (nodes.empty()) return false;
+    float o[3], d[3], inv[3];
+    for (int i=0; i<3; i++) {
+        o[i] = origin.Get(i);
+        d[i] = direction.Get(i);
+        inv[i] = 1 / d[i];
+    }
+    float best = maxDistance;
+    int found = -1;
+    unsigned int stack[STACK_SIZE];
+    unsigned int top = 0;
+    if (RayBox(nodes[0], o, inv, best) != FLT_MAX) stack[top++] = 0;
+    while (top > 0) {
+        unsigned int i = stack[--top];
+        const Node& node = nodes[i];
+        if (node.count > 0) {
+            const float* tri = &triangles[node.offset * 9];
+            for (unsigned int k=0; k<node.count; k++, tri += 9) {
+                float t = RayTriangle(tri, o, d);
+                if (t <= best && t != FLT_MAX) {
+                    best = t;
+                    found = node.offset + k;
+                }
+            }
+            continue;
+        }
+        unsigned int l = i + 1, r = i + node.offset;
+        float tl = RayBox(nodes[l], o, inv, best);
+        float tr = RayBox(nodes[r], o, inv, best);
+        if (tl > tr) {
+            std::swap(l, r);
+            std::swap(tl, tr);
+        }
+        if (tr != FLT_MAX) stack[top++] = r;
+        if (tl != FLT_MAX) stack[top++] = l;
+    }
+    if (found < 0) return false;
+    hit.face = faces[found];
+    hit.distance = best;
+    hit.point = origin + direction * best;
+    return true;
+}
+
+/**
+ * Check if a ray hits any face.
+ * Stops at the first hit found, so it is cheaper than Intersect()
+ * for visibility and shadow tests.
+ *
+ * @param origin Origin of the ray.
+ * @param direction Direction of the ray, need not be normalized.
+ * @param maxDistance Largest ray parameter to consider [optional].
+ * @return True if a face is hit.
+ */
+bool BVH::IntersectsAny(const Vector<3,float> origin, const Vector<3,float> direction,
+                        const float maxDistance) const {
+    if (nodes.empty()) return false;
+    float o[3], d[3], inv[3];
+    for (int i=0; i<3; i++) {
+        o[i] = origin.Get(i);
+        d[i] = direction.Get(i);
+        inv[i] = 1 / d[i];
+    }
+    unsigned int stack[STACK_SIZE];
+    unsigned int top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        const Node& node = nodes[stack[--top]];
+        if (RayBox(node, o, inv, maxDistance) == FLT_MAX) continue;
+        if (node.count > 0) {
+            const float* tri = &triangles[node.offset * 9];
+            for (unsigned int k=0; k<node.count; k++, tri += 9) {
+                float t = RayTriangle(tri, o, d);
+                if (t <= maxDistance && t != FLT_MAX) return true;
+            }
+            continue;
+        }
+        unsigned int i = &node - &nodes[0];
+        stack[top++] = i + node.offset;
+        stack[top++] = i + 1;
+    }
+    return false;
+}
+
+// squared distance from a point to the closest point of a triangle,
+// see Ericson, Real-Time Collision Detection, 5.1.5
+static float TriangleDistance2(const float* tri, const float p[3]) {
+    float ab[3], ac[3], ap[3], c[3];
+    const float *a = tri, *b = tri + 3, *cc = tri + 6;
+    for (int i=0; i<3; i++) {
+        ab[i] = b[i] - a[i];
+        ac[i] = cc[i] - a[i];
+        ap[i] = p[i] - a[i];
+    }
+    float d1 = ab[0]*ap[0] + ab[1]*ap[1] + ab[2]*ap[2];
+    float d2 = ac[0]*ap[0] + ac[1]*ap[1] + ac[2]*ap[2];
+    float bp[3], cp[3];
+    for (int i=0; i<3; i++) {
+        bp[i] = p[i] - b[i];
+        cp[i] = p[i] - cc[i];
+    }
+    float d3 = ab[0]*bp[0] + ab[1]*bp[1] + ab[2]*bp[2];
+    float d4 = ac[0]*bp[0] + ac[1]*bp[1] + ac[2]*bp[2];
+    float d5 = ab[0]*cp[0] + ab[1]*cp[1] + ab[2]*cp[2];
+    float d6 = ac[0]*cp[0] + ac[1]*cp[1] + ac[2]*cp[2];
+    float vc = d1*d4 - d3*d2;
+    float vb = d5*d2 - d1*d6;
+    float va = d3*d6 - d5*d4;
+
+    if (d1 <= 0 && d2 <= 0)
+        for (int i=0; i<3; i++) c[i] = a[i];
+    else if (d3 >= 0 && d4 <= d3)
+        for (int i=0; i<3; i++) c[i] = b[i];
+    else if (d6 >= 0 && d5 <= d6)
+        for (int i=0; i<3; i++) c[i] = cc[i];
+    else if (vc <= 0 && d1 >= 0 && d3 <= 0) {
+        float v = d1 / (d1 - d3);
+        for (int i=0; i<3; i++) c[i] = a[i] + v * ab[i];
+    }
+    else if (vb <= 0 && d2 >= 0 && d6 <= 0) {
+        float w = d2 / (d2 - d6);
+        for (int i=0; i<3; i++) c[i] = a[i] + w * ac[i];
+    }
+    else if (va <= 0 && (d4 - d3) >= 0 && (d5 - d6) >= 0) {
+        float w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+        for (int i=0; i<3; i++) c[i] = b[i] + w * (cc[i] - b[i]);
+    }
+    else {
+        float denom = 1 / (va + vb + vc);
+        float v = vb * denom, w = vc * denom;
+        for (int i=0; i<3; i++) c[i] = a[i] + ab[i] * v + ac[i] * w;
+    }
+    float dist = 0;
+    for (int i=0; i<3; i++) dist += (p[i] - c[i]) * (p[i] - c[i]);
+    return dist;
+}
+
+/**
+ * Find the faces overlapping a sphere.
+ * A face overlaps if its closest point to the center of the sphere
+ * is within the radius. The faces are appended to the result.
+ *
+ * @param sphere Sphere to test.
+ * @param result Vector to append the overlapping faces to.
+ */
+void BVH::Overlaps(const Sphere& sphere, vector<FacePtr>& result) const {
+    if (nodes.empty()) return;
+    float c[3];
+    for (int i=0; i<3; i++) c[i] = sphere.GetCenter().Get(i);
+    float r2 = sphere.GetRadius() * sphere.GetRadius();
+    unsigned int stack[STACK_SIZE];
+    unsigned int top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        unsigned int i = stack[--top];
+        const Node& node = nodes[i];
+        float dist = 0;
+        for (int k=0; k<3; k++) {
+            float e = std::max(node.min[k] - c[k], std::max(c[k] - node.max[k], 0.0f));
+            dist += e * e;
+        }
+        if (dist > r2) continue;
+        if (node.count > 0) {
+            for (unsigned int k=0; k<node.count; k++)
+                if (TriangleDistance2(&triangles[(node.offset+k) * 9], c) <= r2)
+                    result.push_back(faces[node.offset + k]);
+            continue;
+        }
+        stack[top++] = i + node.offset;
+        stack[top++] = i + 1;
+    }
+}
+
+// separating axis test of a triangle relative to the box center
+// against a box of half size h, see Akenine-Moller, Fast 3D
+// Triangle-Box Overlap Testing
+static bool TriangleBox(const float* tri, const float c[3], const float h[3]) {
+    float v[3][3], e[3][3];
+    for (int j=0; j<3; j++)
+        for (int i=0; i<3; i++)
+            v[j][i] = tri[j*3 + i] - c[i];
+    for (int i=0; i<3; i++) {
+        e[0][i] = v[1][i] - v[0][i];
+        e[1][i] = v[2][i] - v[1][i];
+        e[2][i] = v[0][i] - v[2][i];
+    }
+    // the box axes
+    for (int i=0; i<3; i++) {
+        float mn = std::min(v[0][i], std::min(v[1][i], v[2][i]));
+        float mx = std::max(v[0][i], std::max(v[1][i], v[2][i]));
+        if (mn > h[i] || mx < -h[i]) return false;
+    }
+    // the cross products of the edges and the box axes
+    for (int j=0; j<3; j++)
+        for (int a=0; a<3; a++) {
+            // axis = unit(a) x e[j]
+            int a1 = (a+1) % 3, a2 = (a+2) % 3;
+            float axis[3];
+            axis[a] = 0;
+            axis[a1] = -e[j][a2];
+            axis[a2] = e[j][a1];
+            float p0 = v[0][a1]*axis[a1] + v[0][a2]*axis[a2];
+            float p1 = v[1][a1]*axis[a1] + v[1][a2]*axis[a2];
+            float p2 = v[2][a1]*axis[a1] + v[2][a2]*axis[a2];
+            float r = h[a1] * std::fabs(axis[a1]) + h[a2] * std::fabs(axis[a2]);
+            if (std::min(p0, std::min(p1, p2)) > r ||
+                std::max(p0, std::max(p1, p2)) < -r) return false;
+        }
+    // the triangle normal
+    float n[3];
+    n[0] = e[0][1]*e[1][2] - e[0][2]*e[1][1];
+    n[1] = e[0][2]*e[1][0] - e[0][0]*e[1][2];
+    n[2] = e[0][0]*e[1][1] - e[0][1]*e[1][0];
+    float d = n[0]*v[0][0] + n[1]*v[0][1] + n[2]*v[0][2];
+    float r = h[0]*std::fabs(n[0]) + h[1]*std::fabs(n[1]) + h[2]*std::fabs(n[2]);
+    return std::fabs(d) <= r;
+}
+
+/**
+ * Find the faces overlapping a box.
+ * The faces are appended to the result.
+ *
+ * @param box Box to test.
+ * @param result Vector to append the overlapping faces to.
+ */
+void BVH::Overlaps(const Box& box, vector<FacePtr>& result) const {
+    if (nodes.empty()) return;
+    float c[3], h[3];
+    Vector<3,float> center = box.GetCenter(), corner = box.GetCorner();
+    for (int i=0; i<3; i++) {
+        c[i] = center[i];
+        h[i] = std::fabs(corner[i]);
+    }
+    unsigned int stack[STACK_SIZE];
+    unsigned int top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        unsigned int i = stack[--top];
+        const Node& node = nodes[i];
+        bool overlap = true;
+        for (int k=0; k<3 && overlap; k++)
+            overlap = node.min[k] <= c[k] + h[k] && node.max[k] >= c[k] - h[k];
+        if (!overlap) continue;
+        if (node.count > 0) {
+            for (unsigned int k=0; k<node.count; k++)
+                if (TriangleBox(&triangles[(node.offset+k) * 9], c, h))
+                    result.push_back(faces[node.offset + k]);
+            continue;
+        }
+        stack[top++] = i + node.offset;
+        stack[top++] = i + 1;
+    }
+}
+
+/**
+ * Get the nodes in depth first order.
+ *
+ * @return Node array.
+ */
+const vector<BVH::Node>& BVH::GetNodes() const {
+    return nodes;
+}
+
+/**
+ * Get the number of nodes.
+ *
+ * @return Number of nodes.
+ */
+unsigned int BVH::GetNumberOfNodes() const {
+    return nodes.size();
+}
+
+/**
+ * Get the number of faces in the hierarchy.
+ *
+ * @return Number of faces.
+ */
+unsigned int BVH::GetNumberOfFaces() const {
+    return faces.size();
+}
+
+/**
+ * Get the depth of the tree, zero if empty.
+ *
+ * @return Number of nodes on the longest path from the root to a leaf.
+ */
+unsigned int BVH::GetDepth() const {
+    if (nodes.empty()) return 0;
+    unsigned int depth = 0;
+    unsigned int stack[STACK_SIZE][2];
+    unsigned int top = 0;
+    stack[top][0] = 0;
+    stack[top++][1] = 1;
+    while (top > 0) {
+        top--;
+        unsigned int i = stack[top][0], d = stack[top][1];
+        depth = std::max(depth, d);
+        const Node& node = nodes[i];
+        if (node.count > 0) continue;
+        stack[top][0] = i + node.offset;
+        stack[top++][1] = d + 1;
+        stack[top][0] = i + 1;
+        stack[top++][1] = d + 1;
+    }
+    return depth;
+}
+
+} // NS Geometry
+} // NS OpenEngine
@@ -0,0 +1,109 @@
+// Bounding volume hierarchy over faces.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#ifndef _BVH_H_
+#define _BVH_H_
+
+#include <Geometry/FaceSet.h>
+#include <Geometry/Box.h>
+#include <Geometry/Sphere.h>
+#include <vector>
+#include <cfloat>
+
+namespace OpenEngine {
+
+// forward declarations
+namespace Utils { class TaskScheduler; }
+
+namespace Geometry {
+
+using std::vector;
+using OpenEngine::Utils::TaskScheduler;
+
+/**
+ * Bounding volume hierarchy over the faces of a face set.
+ *
+ * The hierarchy is a binary tree of axis aligned boxes built top
+ * down with the binned surface area heuristic. It answers the
+ * queries needed for picking and collision: the nearest face hit by
+ * a ray, whether a ray hits any face at all, and the faces
+ * overlapping a sphere or a box.
+ *
+ * @code
+ * BVH bvh;
+ * bvh.Build(faces);
+ * BVH::RayHit hit;
+ * if (bvh.Intersect(origin, direction, hit))
+ *     logger.info << "hit at " << hit.point << logger.end;
+ * @endcode
+ *
+ * The nodes are stored in one array in depth first order, 32 bytes
+ * each. The left child of an inner node directly follows its parent
+ * and the right child is found at a relative offset. The triangles
+ * are copied into a flat array in leaf order, so a query never
+ * touches the faces themselves until it reports them.
+ *
+ * The hierarchy is a snapshot: changing the faces after the build
+ * does not update it.
+ *
+ * @class BVH BVH.h Geometry/BVH.h
+ */
+class BVH {
+public:
+    /**
+     * Node of the hierarchy.
+     * A leaf has a non zero count of triangles starting at offset,
+     * an inner node has a count of zero and its right child at
+     * offset nodes after itself.
+     */
+    struct Node {
+        float min[3];           //!< lower corner of the bounds
+        unsigned int offset;    //!< first triangle or right child offset
+        float max[3];           //!< upper corner of the bounds
+        unsigned int count;     //!< number of triangles, zero for inner nodes
+    };
+
+    /**
+     * Result of a ray query.
+     */
+    struct RayHit {
+        FacePtr face;           //!< the face hit
+        float distance;         //!< ray parameter of the hit point
+        Vector<3,float> point;  //!< the hit point
+    };
+
+private:
+    vector<Node> nodes;         //!< nodes in depth first order
+    vector<float> triangles;    //!< vertices of the triangles, nine floats each
+    vector<FacePtr> faces;      //!< faces in triangle order
+
+public:
+    BVH();
+
+    void Build(FaceSet& faces);
+    void Build(FaceSet& faces, TaskScheduler& scheduler);
+    void Clear();
+
+    bool Intersect(const Vector<3,float> origin, const Vector<3,float> direction,
+                   RayHit& hit, const float maxDistance = FLT_MAX) const;
+    bool IntersectsAny(const Vector<3,float> origin, const Vector<3,float> direction,
+                       const float maxDistance = FLT_MAX) const;
+    void Overlaps(const Sphere& sphere, vector<FacePtr>& result) const;
+    void Overlaps(const Box& box, vector<FacePtr>& result) const;
+
+    const vector<Node>& GetNodes() const;
+    unsigned int GetNumberOfNodes() const;
+    unsigned int GetNumberOfFaces() const;
+    unsigned int GetDepth() const;
+};
+
+} // NS Geometry
+} // NS OpenEngine
+
+#endif // _BVH_H_
@@ -47,7 +47,24 @@ Box::Box(FaceSet& faces) {
     center = (max - min) / 2 + min;
     // set corner vector
     corner = max - center;
-    // compute the corners
+    SetCorners();
+}
+
+/**
+ * Create a box from its center and corner.
+ *
+ * @param center Center of the box.
+ * @param corner Corner vector from the center, all components positive.
+ */
+Box::Box(const Vector<3,float> center, const Vector<3,float> corner)
+    : center(center), corner(corner) {
+    SetCorners();
+}
+
+/**
+ * Compute the absolute corners from the center and corner vector.
+ */
+void Box::SetCorners() {
     float x = corner[0];
     float y = corner[1];
     float z = corner[2];
@@ -122,6 +139,26 @@ Vector<3,float> Box::GetCorner(const bool signX, const bool signY, const bool si
     return corners[ signX*1 + signY*2 + signZ*4 ];
 }
 
+/**
+ * Get the axis aligned box bounding this box after a transformation.
+ * The transformation is in row vector convention, as used by the
+ * transformation nodes.
+ *
+ * @param m Transformation matrix.
+ * @return Transformed bounding box.
+ */
+Box Box::GetTransformed(Matrix<4,4,float> m) const {
+    Vector<3,float> c, e;
+    for (int j=0; j<3; j++) {
+        c[j] = m(3,j);
+        for (int i=0; i<3; i++) {
+            c[j] += center.Get(i) * m(i,j);
+            e[j] += corner.Get(i) * fabs(m(i,j));
+        }
+    }
+    return Box(c, e);
+}
+
 /**
  * Check if point is inside box.
  *
@@ -12,6 +12,7 @@
 
 #include <Geometry/FaceSet.h>
 #include <Geometry/BoundingGeometry.h>
+#include <Math/Matrix.h>
 #include <string>
 #include <vector>
 
@@ -19,6 +20,7 @@ namespace OpenEngine {
 namespace Geometry {
 
 using OpenEngine::Math::Vector;
+using OpenEngine::Math::Matrix;
 using std::vector;
 
 /**
@@ -36,15 +38,18 @@ private:
     Vector<3,float> corners[8]; //!< Box corners (absolute)
 
     void SetCorner(const bool x, const bool y, const bool z, Vector<3,float> c);
+    void SetCorners();
 
 public:
 
     explicit Box(FaceSet& faces);
+    Box(const Vector<3,float> center, const Vector<3,float> corner);
     
     Vector<3,float> GetCenter() const;
     Vector<3,float> GetCorner() const;
     Vector<3,float> GetCorner(const int index) const;
     Vector<3,float> GetCorner(const bool signX, const bool signY, const bool signZ) const;
+    Box GetTransformed(Matrix<4,4,float> m) const;
 
     bool Intersects(const Vector<3,float> point) const;
     bool Intersects(const Line line) const;
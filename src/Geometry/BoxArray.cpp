@@ -0,0 +1,160 @@
+// Array of boxes.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#include <Geometry/BoxArray.h>
+#include <Geometry/PlaneCuller.h>
+
+namespace OpenEngine {
+namespace Geometry {
+
+#ifdef OE_SSE
+// plane test of four boxes, see PlaneCuller
+struct BoxKernel {
+    enum { SETUP = 7, LOADS = 6 };
+    const BoxArray& boxes;
+
+    BoxKernel(const BoxArray& boxes) : boxes(boxes) {}
+
+    // the splatted normal and distance, and the sign bits flipping
+    // the extents to the corner farthest along the normal
+    static void Setup(const Plane& plane, __m128* s) {
+        const __m128 sign = _mm_set1_ps(-0.0f);
+        for (int i=0; i<3; i++) {
+            s[i] = _mm_set1_ps(plane.normal.Get(i));
+            s[4+i] = (plane.normal.Get(i) > 0) ? _mm_setzero_ps() : sign;
+        }
+        s[3] = _mm_set1_ps(plane.distance);
+    }
+
+    void Load(const unsigned int i, __m128* v) const {
+        v[0] = _mm_loadu_ps(&boxes.cx[i]);
+        v[1] = _mm_loadu_ps(&boxes.cy[i]);
+        v[2] = _mm_loadu_ps(&boxes.cz[i]);
+        v[3] = _mm_loadu_ps(&boxes.ex[i]);
+        v[4] = _mm_loadu_ps(&boxes.ey[i]);
+        v[5] = _mm_loadu_ps(&boxes.ez[i]);
+    }
+
+    static __m128 Outside(const __m128* v, const __m128* s) {
+        __m128 vx = _mm_add_ps(v[0], _mm_xor_ps(v[3], s[4]));
+        __m128 vy = _mm_add_ps(v[1], _mm_xor_ps(v[4], s[5]));
+        __m128 vz = _mm_add_ps(v[2], _mm_xor_ps(v[5], s[6]));
+        __m128 dist = _mm_mul_ps(vx, s[0]);
+        dist = _mm_add_ps(dist, _mm_mul_ps(vy, s[1]));
+        dist = _mm_add_ps(dist, _mm_mul_ps(vz, s[2]));
+        dist = _mm_add_ps(dist, s[3]);
+        return _mm_cmplt_ps(dist, _mm_setzero_ps());
+    }
+};
+#endif
+
+/**
+ * Add a box.
+ *
+ * @param box Box to add.
+ */
+void BoxArray::Add(const Box& box) {
+    Add(box.GetCenter(), box.GetCorner());
+}
+
+/**
+ * Add a box given by its center and extent.
+ *
+ * @param center Center of the box.
+ * @param extent Corner vector from the center, all components positive.
+ */
+void BoxArray::Add(const Vector<3,float> center, const Vector<3,float> extent) {
+    cx.push_back(center.Get(0));
+    cy.push_back(center.Get(1));
+    cz.push_back(center.Get(2));
+    ex.push_back(extent.Get(0));
+    ey.push_back(extent.Get(1));
+    ez.push_back(extent.Get(2));
+}
+
+/**
+ * Remove all boxes.
+ */
+void BoxArray::Clear() {
+    cx.clear(); cy.clear(); cz.clear();
+    ex.clear(); ey.clear(); ez.clear();
+}
+
+/**
+ * Get the number of boxes.
+ *
+ * @return Number of boxes.
+ */
+unsigned int BoxArray::Size() const {
+    return cx.size();
+}
+
+/**
+ * Test the boxes against a set of planes.
+ * A box is visible unless it is entirely behind one of the planes.
+ * Uses SSE if available, otherwise the same as CullScalar().
+ *
+ * @param planes Planes with normals pointing inwards.
+ * @param count Number of planes.
+ * @param visible Visibility mask, one bit per box.
+ */
+void BoxArray::Cull(Plane* const planes[], const unsigned int count,
+                    vector<unsigned int>& visible) const {
+#ifdef OE_SSE
+    const unsigned int size = Size();
+    visible.assign((size + 31) / 32, 0);
+
+    unsigned int i = PlaneCuller<BoxKernel>::Cull(BoxKernel(*this), size,
+                                                  planes, count, visible);
+    CullRange(planes, count, i, size, visible);
+#else
+    CullScalar(planes, count, visible);
+#endif
+}
+
+/**
+ * Test the boxes against a set of planes one box at a time.
+ *
+ * @see Cull()
+ * @param planes Planes with normals pointing inwards.
+ * @param count Number of planes.
+ * @param visible Visibility mask, one bit per box.
+ */
+void BoxArray::CullScalar(Plane* const planes[], const unsigned int count,
+                          vector<unsigned int>& visible) const {
+    visible.assign((Size() + 31) / 32, 0);
+    CullRange(planes, count, 0, Size(), visible);
+}
+
+/**
+ * Test a range of boxes one at a time and set their bits.
+ * The float operations are those of the SSE test in the same order.
+ */
+void BoxArray::CullRange(Plane* const planes[], const unsigned int count,
+                         const unsigned int begin, const unsigned int end,
+                         vector<unsigned int>& visible) const {
+    for (unsigned int i=begin; i<end; i++) {
+        bool inside = true;
+        for (unsigned int p=0; p<count && inside; p++) {
+            const Vector<3,float>& n = planes[p]->normal;
+            float x = cx[i] + ((n.Get(0) > 0) ? ex[i] : -ex[i]);
+            float y = cy[i] + ((n.Get(1) > 0) ? ey[i] : -ey[i]);
+            float z = cz[i] + ((n.Get(2) > 0) ? ez[i] : -ez[i]);
+            float dist = x * n.Get(0);
+            dist += y * n.Get(1);
+            dist += z * n.Get(2);
+            dist += planes[p]->distance;
+            inside = !(dist < 0);
+        }
+        if (inside) visible[i >> 5] |= 1u << (i & 31);
+    }
+}
+
+} // NS Geometry
+} // NS OpenEngine
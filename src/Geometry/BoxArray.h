@@ -0,0 +1,82 @@
+// Array of boxes.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#ifndef _BOX_ARRAY_H_
+#define _BOX_ARRAY_H_
+
+#include <Geometry/Box.h>
+#include <Geometry/Plane.h>
+#include <vector>
+
+namespace OpenEngine {
+namespace Geometry {
+
+using std::vector;
+
+/**
+ * Array of axis aligned boxes in structure of arrays layout.
+ *
+ * The centers and extents of the boxes are kept in one array per
+ * component, so that many boxes can be tested against a set of
+ * planes at once. The result of a test is a bit mask with one bit per
+ * box: bit i mod 32 of word i / 32 is set if box i is inside or
+ * intersecting all the planes.
+ *
+ * @code
+ * BoxArray boxes;
+ * boxes.Add(box);
+ * vector<unsigned int> visible;
+ * frustum.IsVisible(boxes, visible);
+ * if (BoxArray::IsSet(visible, 0)) ...
+ * @endcode
+ *
+ * The test picks the corner of each box farthest along the normal of
+ * each plane, exactly like Frustum::IsVisible(const Box&), four boxes
+ * at a time when compiled with SSE. The SSE and the scalar test
+ * perform the same float operations in the same order and give
+ * identical results.
+ *
+ * @class BoxArray BoxArray.h Geometry/BoxArray.h
+ */
+class BoxArray {
+public:
+    vector<float> cx, cy, cz;   //!< box centers
+    vector<float> ex, ey, ez;   //!< box extents (corner relative to center)
+
+    void Add(const Box& box);
+    void Add(const Vector<3,float> center, const Vector<3,float> extent);
+    void Clear();
+    unsigned int Size() const;
+
+    void Cull(Plane* const planes[], const unsigned int count,
+              vector<unsigned int>& visible) const;
+    void CullScalar(Plane* const planes[], const unsigned int count,
+                    vector<unsigned int>& visible) const;
+
+    /**
+     * Check the bit of a box in a visibility mask.
+     *
+     * @param mask Visibility mask.
+     * @param index Box index.
+     * @return True if the bit is set.
+     */
+    static bool IsSet(const vector<unsigned int>& mask, const unsigned int index) {
+        return (mask[index >> 5] >> (index & 31)) & 1;
+    }
+
+private:
+    void CullRange(Plane* const planes[], const unsigned int count,
+                   const unsigned int begin, const unsigned int end,
+                   vector<unsigned int>& visible) const;
+};
+
+} // NS Geometry
+} // NS OpenEngine
+
+#endif // _BOX_ARRAY_H_
@@ -10,6 +10,7 @@
 #include <Geometry/Face.h>
 #include <Logging/Logger.h>
 #include <math.h>
+#include <algorithm>
 #include <Meta/OpenGL.h>
 #include <Math/Math.h>
 
@@ -22,7 +23,7 @@ using namespace OpenEngine::Math;
 // Shared initialization code
 void Face::Init() {
     // Set white as default color
-    colr[0] = colr[1] = colr[2] = colr[3] = Vector<4,float>(1);
+    colr[0] = colr[1] = colr[2] = Vector<4,float>(1);
     // Calculate the face hard normal
     CalcHardNorm();
     // Calculate the binormals and tangents
@@ -97,6 +98,26 @@ Face::Face(const Face& face) {
     Copy(face);
 }
 
+/**
+ * Construct a face from a fragment.
+ * The resources are those of the face the fragment was cut from.
+ *
+ * @param fragment Fragment to copy
+ */
+Face::Face(const FaceFragment& fragment) {
+    Copy(*fragment.face);
+    for (int i=0; i<3; i++) {
+        vert[i] = fragment.vert[i];
+        norm[i] = fragment.norm[i];
+        texc[i] = fragment.texc[i];
+        colr[i] = fragment.colr[i];
+        tang[i] = fragment.tang[i];
+        bino[i] = fragment.bino[i];
+    }
+    hardNorm = fragment.hardNorm;
+    CalcHardNorm();
+}
+
 /**
  * Destructor.
  */
@@ -150,15 +171,16 @@ Vector<3,int> Face::ComparePosition(const FacePtr& face, const float epsilon) {
 }
 
 /**
- * Find the intersection of a line in the plane defined by the face.
- *
- * @todo Add errors for special cases
+ * Find the intersection of a line segment and the plane defined by
+ * the face.
  *
  * @param p1 First point of line.
  * @param p2 Second point of line.
- * @return Point of intersection or NULL if no intersection is found.
+ * @param point Set to the point of intersection if one is found.
+ * @return True if the segment intersects the plane.
  */
-Vector<3,float>* Face::PlaneIntersection(Vector<3,float> p1, Vector<3,float> p2) {
+bool Face::PlaneIntersection(const Vector<3,float> p1, const Vector<3,float> p2,
+                             Vector<3,float>& point) {
     // convert to doubles to preserve precision in calculations
     Vector<3,double> hn = hardNorm.ToDouble();
     Vector<3,double> d1 = p1.ToDouble();
@@ -167,41 +189,66 @@ Vector<3,float>* Face::PlaneIntersection(Vector<3,float> p1, Vector<3,float> p2)
     double a = hn * (d2 - d1);
     if (fabs(a) < EPS)
         // the line is parallel with the plane
-        return NULL;
+        return false;
 
     double s = (hn * (vert[0].ToDouble() - d1)) / a;
     if (s < 0 || s > 1) 
         // the line segment does not intersect between p1 and p2.
-        return NULL;
+        return false;
 
     // calculate the intersection
     Vector<3,double> tmp(d1 + ((d2-d1) * s));
+    point = tmp.ToFloat();
+    return true;
+}
 
-    // return as a float vector
-    return new Vector<3,float>(tmp.ToFloat());  
+/**
+ * Find the intersection of a line segment and the face.
+ *
+ * @param p1 First point of line
+ * @param p2 Second point of line
+ * @param point Set to the point of intersection if one is found.
+ * @return True if the segment intersects the face.
+ */
+bool Face::Intersection(const Vector<3,float> p1, const Vector<3,float> p2,
+                        Vector<3,float>& point) {
+    Vector<3,float> p;
+    if (!PlaneIntersection(p1, p2, p) || !Contains(p))
+        return false;
+    point = p;
+    return true;
+}
+
+/**
+ * Find the intersection of a line in the plane defined by the face.
+ *
+ * @deprecated Allocates the result, use the variant returning the
+ * point by reference.
+ *
+ * @param p1 First point of line.
+ * @param p2 Second point of line.
+ * @return Point of intersection or NULL if no intersection is found.
+ */
+Vector<3,float>* Face::PlaneIntersection(Vector<3,float> p1, Vector<3,float> p2) {
+    Vector<3,float> point;
+    if (!PlaneIntersection(p1, p2, point)) return NULL;
+    return new Vector<3,float>(point);
 }
 
 /**
  * Find the intersection of a line in the face.
  *
+ * @deprecated Allocates the result, use the variant returning the
+ * point by reference.
+ *
  * @param p1 First point of line
  * @param p2 Second point of line
  * @return Point of intersection or null if not intersecting.
  */
 Vector<3,float>* Face::Intersection(Vector<3,float> p1, Vector<3,float> p2) {
-    Vector<3,float>* intersectionPoint = PlaneIntersection(p1,p2);
-
-    // If not intersecting just return NULL
-    if (intersectionPoint == NULL)
-        return NULL;
-    
-    if (this->Contains(*intersectionPoint))
-        return intersectionPoint;
-
-    // If the intersection was not in the face itself delete the
-    // pointer and return null.
-    delete intersectionPoint;
-    return NULL;
+    Vector<3,float> point;
+    if (!Intersection(p1, p2, point)) return NULL;
+    return new Vector<3,float>(point);
 }
     
 /**  
@@ -393,5 +440,306 @@ std::string Face::ToString() {
     return str;
 }
 
+/**
+ * Split a face by the plane of this face.
+ *
+ * A face in front of, behind or in the plane is left as it is and
+ * only its position is returned. A face spanning the plane is cut in
+ * pieces that are written to the fragment arrays, so no memory is
+ * allocated. The pieces are the faces FaceSet::Split creates: their
+ * colors, tangents and binormals are those of the face, and pieces
+ * collapsed by the limited precision are left out.
+ *
+ * @note This algorithm is based on triangle::split in CTA page 393.
+ *
+ * @param face Face to split.
+ * @param front Set to the pieces in front of the plane.
+ * @param frontCount Set to the number of pieces in front.
+ * @param back Set to the pieces behind the plane.
+ * @param backCount Set to the number of pieces behind.
+ * @param epsilon Width of spanning plane [optional].
+ * @return Position of the face, SPLIT if pieces were written.
+ */
+Face::Position Face::Split(Face& face, FaceFragment front[2], unsigned int& frontCount,
+                           FaceFragment back[2], unsigned int& backCount,
+                           const float epsilon) {
+    frontCount = backCount = 0;
+    if (this == &face) return IN_PLANE;
+    int positions[3];
+    for (int i=0; i<3; i++)
+        positions[i] = ComparePointPlane(face.vert[i], epsilon);
+
+    switch (positions[0] + positions[1] + positions[2]) {
+    case -3:
+    case -2:
+        return BEHIND;
+    case 3:
+    case 2:
+        return IN_FRONT;
+    case 0:
+        if (positions[0] || positions[1] || positions[2]) {
+            // one point in plane and one on each side
+            // split the face in two
+            int pos = 0, neg = 0, piv = 0;
+            if (!positions[0]) {
+                piv = 0;
+                if (positions[1] > 0) { pos = 1; neg = 2; }
+                else { pos = 2; neg = 1; }
+            } else if (!positions[1]) {
+                piv = 1;
+                if (positions[0] > 0) { pos = 0; neg = 2; }
+                else { pos = 2; neg = 0; }
+            } else if (!positions[2]) {
+                piv = 2;
+                if (positions[1] > 0) { pos = 1; neg = 0; }
+                else { pos = 0; neg = 1; }
+            }
+            // compute intersection between the positive and
+            // negative points
+            Vector<3,float> fint = face.vert[piv];
+            PlaneIntersection(face.vert[pos], face.vert[neg], fint);
+
+            // if the vertex from the face equals the one we just
+            // found, the face is too small to split and we throw it
+            // away.
+            if (fint == face.vert[piv]) return SPLIT;
+
+            Vector<2,float> tint = face.SplitTexture(pos,neg,fint);
+            Vector<3,float> norm = face.norm[pos] + face.norm[neg];
+            norm.Normalize();
+            // face on positive side
+            FaceFragment& f1 = front[0];
+            f1.Set(face);
+            f1.vert[0] = face.vert[pos];
+            f1.vert[1] = fint;
+            f1.vert[2] = face.vert[piv];
+            f1.norm[0] = face.norm[pos];
+            f1.norm[1] = norm;
+            f1.norm[2] = face.norm[piv];
+            f1.texc[0] = face.texc[pos];
+            f1.texc[1] = tint;
+            f1.texc[2] = face.texc[piv];
+            // face on negative side
+            FaceFragment& b1 = back[0];
+            b1.Set(face);
+            b1.vert[0] = face.vert[neg];
+            b1.vert[1] = face.vert[piv];
+            b1.vert[2] = fint;
+            b1.norm[0] = face.norm[neg];
+            b1.norm[1] = face.norm[piv];
+            b1.norm[2] = norm;
+            b1.texc[0] = face.texc[neg];
+            b1.texc[1] = face.texc[piv];
+            b1.texc[2] = tint;
+            if (f1.Verify()) frontCount = 1;
+            if (b1.Verify()) backCount = 1;
+            return SPLIT;
+        }
+        // face is in the plane
+        return IN_PLANE;
+    case -1:
+        if (positions[0] == 0 || positions[1] == 0 || positions[2] == 0)
+            // two points must be zero, so the face is behind
+            return BEHIND;
+        else {
+            // one point is positive and two negative
+            int pos = 0, neg1 = 1, neg2 = 2;
+            if (positions[1] == 1) { pos=1; neg1=0; neg2=2; }
+            if (positions[2] == 1) { pos=2; neg1=0; neg2=1; }
+
+            Vector<3,float> fint1 = face.vert[neg1], fint2 = face.vert[neg2];
+            PlaneIntersection(face.vert[neg1], face.vert[pos], fint1);
+            PlaneIntersection(face.vert[neg2], face.vert[pos], fint2);
+
+            Vector<2,float> tint1 = face.SplitTexture(pos,neg1,fint1);
+            Vector<2,float> tint2 = face.SplitTexture(pos,neg2,fint2);
+            Vector<3,float> norm1 = face.norm[pos] + face.norm[neg1];
+            Vector<3,float> norm2 = face.norm[pos] + face.norm[neg2];
+            norm1.Normalize();
+            norm2.Normalize();
+
+            // (neg2, i1, neg1)
+            FaceFragment& b2 = back[0];
+            b2.Set(face);
+            b2.vert[0] = face.vert[neg2];
+            b2.vert[1] = fint1;
+            b2.vert[2] = face.vert[neg1];
+            b2.norm[0] = face.norm[neg2];
+            b2.norm[1] = norm1;
+            b2.norm[2] = face.norm[neg1];
+            b2.texc[0] = face.texc[neg2];
+            b2.texc[1] = tint1;
+            b2.texc[2] = face.texc[neg1];
+
+            // if the two intersection points are equal we have found
+            // a face that is very slim and therefor the intersection
+            // point on each line becomes the same due to our limited
+            // precision. In this case we choose to keep the one
+            // resulting back face and throw away the collapsed front
+            // face.
+            if (fint1 == fint2) {
+                if (b2.Verify()) backCount = 1;
+                else logger.warning << "Back face is invalid" << logger.end;
+                return SPLIT;
+            }
+
+            // front face (pos, i1, i2)
+            FaceFragment& f1 = front[0];
+            f1.Set(face);
+            f1.vert[0] = face.vert[pos];
+            f1.vert[1] = fint1;
+            f1.vert[2] = fint2;
+            f1.norm[0] = face.norm[pos];
+            f1.norm[1] = norm1;
+            f1.norm[2] = norm2;
+            f1.texc[0] = face.texc[pos];
+            f1.texc[1] = tint1;
+            f1.texc[2] = tint2;
+            // back face (neg2, i2, i1) goes first
+            FaceFragment& b1 = back[1];
+            b1.Set(face);
+            b1.vert[0] = face.vert[neg2];
+            b1.vert[1] = fint2;
+            b1.vert[2] = fint1;
+            b1.norm[0] = face.norm[neg2];
+            b1.norm[1] = norm2;
+            b1.norm[2] = norm1;
+            b1.texc[0] = face.texc[neg2];
+            b1.texc[1] = tint2;
+            b1.texc[2] = tint1;
+            std::swap(back[0], back[1]);
+
+            if (f1.Verify()) frontCount = 1;
+            else logger.warning << "f1 in case -1 is invalid after split, "
+                                << "a larger epsilon value might help." << logger.end;
+            if (back[0].Verify()) backCount++;
+            else logger.warning << "b1 in case -1 is invalid after split, "
+                                << "a larger epsilon value might help." << logger.end;
+            if (back[1].Verify()) {
+                if (backCount == 0) back[0] = back[1];
+                backCount++;
+            }
+            else logger.warning << "b2 in case -1 is invalid after split, "
+                                << "a larger epsilon value might help." << logger.end;
+            return SPLIT;
+        }
+    case 1:
+        if (positions[0] == 0 || positions[1] == 0 || positions[2] == 0)
+            // two points must be zero, so the face is in front
+            return IN_FRONT;
+        else {
+            // one point is negative and two positive
+            int pos1 = 1, pos2 = 2, neg = 0;
+            if (positions[1] == -1) { pos1=0; pos2=2; neg=1; }
+            if (positions[2] == -1) { pos1=0; pos2=1; neg=2; }
+
+            Vector<3,float> fint1 = face.vert[pos1], fint2 = face.vert[pos2];
+            PlaneIntersection(face.vert[pos1], face.vert[neg], fint1);
+            PlaneIntersection(face.vert[pos2], face.vert[neg], fint2);
+
+            Vector<2,float> tint1 = face.SplitTexture(pos1,neg,fint1);
+            Vector<2,float> tint2 = face.SplitTexture(pos2,neg,fint2);
+            Vector<3,float> norm1 = face.norm[pos1] + face.norm[neg];
+            Vector<3,float> norm2 = face.norm[pos2] + face.norm[neg];
+            norm1.Normalize();
+            norm2.Normalize();
+
+            // one of two front faces (pos1, i2, pos2)
+            FaceFragment& f2 = front[1];
+            f2.Set(face);
+            f2.vert[0] = face.vert[pos1];
+            f2.vert[1] = fint2;
+            f2.vert[2] = face.vert[pos2];
+            f2.norm[0] = face.norm[pos1];
+            f2.norm[1] = norm2;
+            f2.norm[2] = face.norm[pos2];
+            f2.texc[0] = face.texc[pos1];
+            f2.texc[1] = tint2;
+            f2.texc[2] = face.texc[pos2];
+
+            // check we don't collapse any edges when splitting
+            // symmetrical to the previous case (case -1).
+            if (fint1 == fint2) {
+                if (f2.Verify()) {
+                    front[0] = f2;
+                    frontCount = 1;
+                }
+                else logger.warning << "Front face is invalid" << logger.end;
+                return SPLIT;
+            }
+
+            // front face (pos1, i1, i2)
+            FaceFragment& f1 = front[0];
+            f1.Set(face);
+            f1.vert[0] = face.vert[pos1];
+            f1.vert[1] = fint1;
+            f1.vert[2] = fint2;
+            f1.norm[0] = face.norm[pos1];
+            f1.norm[1] = norm1;
+            f1.norm[2] = norm2;
+            f1.texc[0] = face.texc[pos1];
+            f1.texc[1] = tint1;
+            f1.texc[2] = tint2;
+            // back face (neg, i2, i1)
+            FaceFragment& b1 = back[0];
+            b1.Set(face);
+            b1.vert[0] = face.vert[neg];
+            b1.vert[1] = fint2;
+            b1.vert[2] = fint1;
+            b1.norm[0] = face.norm[neg];
+            b1.norm[1] = norm2;
+            b1.norm[2] = norm1;
+            b1.texc[0] = face.texc[neg];
+            b1.texc[1] = tint2;
+            b1.texc[2] = tint1;
+
+            if (front[0].Verify()) frontCount++;
+            else logger.warning << "f1 in case 1 is invalid after split, "
+                                << "a larger epsilon value might help." << logger.end;
+            if (front[1].Verify()) {
+                if (frontCount == 0) front[0] = front[1];
+                frontCount++;
+            }
+            else logger.warning << "f2 in case 1 is invalid after split, "
+                                << "a larger epsilon value might help." << logger.end;
+            if (b1.Verify()) backCount = 1;
+            else logger.warning << "b1 in case 1 is invalid after split, "
+                                << "a larger epsilon value might help." << logger.end;
+            return SPLIT;
+        }
+    }
+    return SPLIT;
+}
+
+/**
+ * Set the attributes of a fragment to those of a face.
+ *
+ * @param face Face to copy.
+ */
+void FaceFragment::Set(Face& face) {
+    for (int i=0; i<3; i++) {
+        vert[i] = face.vert[i];
+        norm[i] = face.norm[i];
+        texc[i] = face.texc[i];
+        colr[i] = face.colr[i];
+        tang[i] = face.tang[i];
+        bino[i] = face.bino[i];
+    }
+    hardNorm = face.hardNorm;
+    this->face = &face;
+}
+
+/**
+ * Verify that the fragment defines a plane.
+ *
+ * @see Face::Verify()
+ * @return True if the vertices differ.
+ */
+bool FaceFragment::Verify() const {
+    return !(vert[0] == vert[1] ||
+             vert[1] == vert[2] ||
+             vert[0] == vert[2]);
+}
+
 } // NS Geometry
 } // NS OpenEngine
@@ -27,6 +27,29 @@ class Face;
 //! Smart pointer to a face object.
 typedef boost::shared_ptr<Face> FacePtr;
 
+/**
+ * Piece of a split face.
+ * Holds the vertex attributes of the piece by value and refers to
+ * the face it was cut from for the resources, so it can be written
+ * without allocating. The face must outlive the fragment.
+ *
+ * @see Face::Split()
+ * @class FaceFragment Face.h Geometry/Face.h
+ */
+struct FaceFragment {
+    Vector<3,float> vert[3];    //!< vertex vectors
+    Vector<3,float> norm[3];    //!< normal vectors
+    Vector<2,float> texc[3];    //!< texture coordinates
+    Vector<4,float> colr[3];    //!< colors
+    Vector<3,float> tang[3];    //!< tangent
+    Vector<3,float> bino[3];    //!< binormal
+    Vector<3,float> hardNorm;   //!< normal of the face cut from
+    Face* face;                 //!< the face cut from
+
+    void Set(Face& face);
+    bool Verify() const;
+};
+
 /**
  * Face structure.
  * Face elements contained in a FaceSet group.
@@ -39,6 +62,12 @@ private:
     void Copy(const Face& face);
 
 public:
+    /**
+     * Position of a face relative to the plane of another face.
+     * @see Split()
+     */
+    enum Position { BEHIND = -1, IN_PLANE = 0, IN_FRONT = 1, SPLIT = 2 };
+
     Vector<3,float> vert[3];    //!< vertex vectors
     Vector<3,float> norm[3];    //!< normal vectors
     Vector<2,float> texc[3];    //!< texture coordinates
@@ -56,14 +85,22 @@ public:
 
     Face(const Face& face);
     explicit Face(const FacePtr& face);
+    explicit Face(const FaceFragment& fragment);
 
     ~Face();
 
 	int ComparePointPlane(const Vector<3,float>& point, const float epsilon = EPS);
 	Vector<3,int>    ComparePosition(const FacePtr& face, const float epsilon = EPS);
 
+    bool PlaneIntersection(const Vector<3,float> p1, const Vector<3,float> p2,
+                           Vector<3,float>& point);
+    bool Intersection(const Vector<3,float> p1, const Vector<3,float> p2,
+                      Vector<3,float>& point);
     Vector<3,float>* PlaneIntersection(Vector<3,float> p1, Vector<3,float> p2);
     Vector<3,float>* Intersection(Vector<3,float> p1, Vector<3,float> p2);
+    Position Split(Face& face, FaceFragment front[2], unsigned int& frontCount,
+                   FaceFragment back[2], unsigned int& backCount,
+                   const float epsilon = EPS);
     Vector<2,float>  SplitTexture(int p1, int p2, Vector<3,float> inter);
     bool Contains( Vector<3,float> point );
 
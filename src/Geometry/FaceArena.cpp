@@ -0,0 +1,111 @@
+// Storage for face fragments.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#include <Geometry/FaceArena.h>
+#include <Geometry/FaceSet.h>
+
+namespace OpenEngine {
+namespace Geometry {
+
+/**
+ * Create an arena.
+ *
+ * @param capacity Number of fragments to allocate up front [optional].
+ */
+FaceArena::FaceArena(const unsigned int capacity)
+    : fragments(capacity), size(0), growths(0) {}
+
+/**
+ * Allocate consecutive fragments.
+ * The arena grows by doubling if the fragments do not fit.
+ *
+ * @param count Number of fragments.
+ * @return The first fragment.
+ */
+FaceFragment* FaceArena::Allocate(const unsigned int count) {
+    if (size + count > fragments.size()) {
+        unsigned int capacity = fragments.size() * 2;
+        if (capacity < size + count) capacity = size + count;
+        if (capacity < 16) capacity = 16;
+        fragments.resize(capacity);
+        growths++;
+    }
+    FaceFragment* first = &fragments[size];
+    size += count;
+    return first;
+}
+
+/**
+ * Return the last fragments allocated, for when fewer were used than
+ * allocated.
+ *
+ * @param count Number of fragments to return.
+ */
+void FaceArena::Release(const unsigned int count) {
+    size -= (count < size) ? count : size;
+}
+
+/**
+ * Add a fragment covering a whole face.
+ *
+ * @param face Face to copy.
+ * @return The new fragment.
+ */
+FaceFragment& FaceArena::Add(Face& face) {
+    FaceFragment* fragment = Allocate(1);
+    fragment->Set(face);
+    return *fragment;
+}
+
+/**
+ * Remove all fragments, keeping the memory.
+ */
+void FaceArena::Clear() {
+    size = 0;
+}
+
+/**
+ * Get the number of fragments.
+ *
+ * @return Number of fragments.
+ */
+unsigned int FaceArena::Size() const {
+    return size;
+}
+
+/**
+ * Get the number of fragments that fit without growing.
+ *
+ * @return Capacity in fragments.
+ */
+unsigned int FaceArena::GetCapacity() const {
+    return fragments.size();
+}
+
+/**
+ * Get the number of times the arena has grown.
+ *
+ * @return Number of reallocations.
+ */
+unsigned int FaceArena::GetNumberOfGrowths() const {
+    return growths;
+}
+
+/**
+ * Add a face for each fragment to a face set.
+ *
+ * @param faces Face set to add to.
+ */
+void FaceArena::ToFaceSet(FaceSet& faces) const {
+    for (unsigned int i=0; i<size; i++)
+        faces.Add(FacePtr(new Face(fragments[i])));
+}
+
+} // NS Geometry
+} // NS OpenEngine
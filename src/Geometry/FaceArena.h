@@ -0,0 +1,77 @@
+// Storage for face fragments.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#ifndef _FACE_ARENA_H_
+#define _FACE_ARENA_H_
+
+#include <Geometry/Face.h>
+#include <vector>
+
+namespace OpenEngine {
+namespace Geometry {
+
+using std::vector;
+
+class FaceSet;
+
+/**
+ * Storage for face fragments.
+ *
+ * An arena hands out fragments from memory it keeps between uses.
+ * Clearing it keeps the memory, so splitting face sets over and over
+ * into the same arenas, as a BSP or CSG compiler does, only
+ * allocates until the arenas have grown to the largest result.
+ *
+ * @code
+ * FaceArena front(1024), span, back(1024);
+ * faces.Split(plane, front, span, back);
+ * for (unsigned int i=0; i<front.Size(); i++)
+ *     ... front[i].vert[0] ...
+ * front.Clear();
+ * @endcode
+ *
+ * Growing the arena moves the fragments, so references to them are
+ * only valid until the next Allocate() or Add().
+ *
+ * @class FaceArena FaceArena.h Geometry/FaceArena.h
+ */
+class FaceArena {
+private:
+    vector<FaceFragment> fragments;
+    unsigned int size;
+    unsigned int growths;
+
+public:
+    explicit FaceArena(const unsigned int capacity = 0);
+
+    FaceFragment* Allocate(const unsigned int count);
+    void Release(const unsigned int count);
+    FaceFragment& Add(Face& face);
+    void Clear();
+
+    unsigned int Size() const;
+    unsigned int GetCapacity() const;
+    unsigned int GetNumberOfGrowths() const;
+    void ToFaceSet(FaceSet& faces) const;
+
+    /**
+     * Get a fragment.
+     *
+     * @param index Fragment index.
+     * @return The fragment.
+     */
+    FaceFragment& operator[](const unsigned int index) {
+        return fragments[index];
+    }
+};
+
+} // NS Geometry
+} // NS OpenEngine
+
+#endif // _FACE_ARENA_H_
@@ -21,6 +21,8 @@ namespace Geometry {
 using std::list;
 using OpenEngine::Math::Vector;
 
+class FaceArena;
+
 /**
  * Face list type.
  * Used to ease on the STL syntax and hide the concrete 
@@ -58,6 +60,7 @@ public:
     void Empty();
     int  Size();
     void Split(FacePtr& plane, FaceSet& front, FaceSet& span, FaceSet& back, const float epsilon = EPS);
+    void Split(FacePtr& plane, FaceArena& front, FaceArena& span, FaceArena& back, const float epsilon = EPS);
     void Divide(FacePtr& plane, FaceSet& front, FaceSet& back, const float epsilon = EPS);
     void CalcTangentSpace();
 };
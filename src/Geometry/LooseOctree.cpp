@@ -0,0 +1,450 @@
+// Loose octree of boxes.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#include <Geometry/LooseOctree.h>
+#include <algorithm>
+#include <utility>
+#include <cmath>
+
+namespace OpenEngine {
+namespace Geometry {
+
+// deepest tree supported by the fixed size traversal stacks
+static const unsigned int MAX_DEPTH = 16;
+static const unsigned int STACK_SIZE = 8 * (MAX_DEPTH + 1);
+
+// the loose bounds of a node are twice the size of its cell
+static inline void LooseBounds(const LooseOctree::Node& node, float min[3], float max[3]) {
+    for (int k=0; k<3; k++) {
+        min[k] = node.center[k] - 2 * node.half;
+        max[k] = node.center[k] + 2 * node.half;
+    }
+}
+
+// position of a box relative to a set of planes: -1 outside, 0
+// intersecting and 1 inside
+static inline int Classify(Plane* const planes[], const unsigned int count,
+                           const float min[3], const float max[3]) {
+    int result = 1;
+    for (unsigned int p=0; p<count; p++) {
+        const Vector<3,float>& n = planes[p]->normal;
+        float far = planes[p]->distance, near = planes[p]->distance;
+        for (int k=0; k<3; k++) {
+            bool positive = n.Get(k) > 0;
+            far += n.Get(k) * (positive ? max[k] : min[k]);
+            near += n.Get(k) * (positive ? min[k] : max[k]);
+        }
+        if (far < 0) return -1;
+        if (near < 0) result = 0;
+    }
+    return result;
+}
+
+static inline float Distance2(const float c[3], const float min[3], const float max[3]) {
+    float dist = 0;
+    for (int k=0; k<3; k++) {
+        float e = std::max(min[k] - c[k], std::max(c[k] - max[k], 0.0f));
+        dist += e * e;
+    }
+    return dist;
+}
+
+static inline bool Overlaps(const float amin[3], const float amax[3],
+                            const float bmin[3], const float bmax[3]) {
+    return amin[0] <= bmax[0] && amax[0] >= bmin[0] &&
+        amin[1] <= bmax[1] && amax[1] >= bmin[1] &&
+        amin[2] <= bmax[2] && amax[2] >= bmin[2];
+}
+
+// ray and box slab test, returns the entry distance or FLT_MAX
+static inline float RayBox(const float o[3], const float inv[3], const float tmax,
+                           const float min[3], const float max[3]) {
+    float t0 = 0, t1 = tmax;
+    for (int k=0; k<3; k++) {
+        float a = (min[k] - o[k]) * inv[k];
+        float b = (max[k] - o[k]) * inv[k];
+        if (a > b) std::swap(a, b);
+        if (a > t0) t0 = a;
+        if (b < t1) t1 = b;
+        if (t0 > t1) return FLT_MAX;
+    }
+    return t0;
+}
+
+/**
+ * Create an empty octree.
+ * The depth is limited to 16.
+ *
+ * @param center Center of the root cell.
+ * @param halfSize Half the size of the root cell.
+ * @param maxDepth Depth of the smallest cells [optional].
+ */
+LooseOctree::LooseOctree(const Vector<3,float> center, const float halfSize,
+                         const unsigned int maxDepth)
+    : size(0), maxDepth(std::min(maxDepth, MAX_DEPTH)) {
+    Node root;
+    for (int k=0; k<3; k++) root.center[k] = center.Get(k);
+    root.half = halfSize;
+    root.parent = -1;
+    for (int i=0; i<8; i++) root.children[i] = -1;
+    root.first = -1;
+    root.count = 0;
+    root.depth = 0;
+    nodes.push_back(root);
+}
+
+void LooseOctree::Bounds(const Box& box, float min[3], float max[3]) {
+    Vector<3,float> c = box.GetCenter(), e = box.GetCorner();
+    for (int k=0; k<3; k++) {
+        min[k] = c[k] - fabs(e[k]);
+        max[k] = c[k] + fabs(e[k]);
+    }
+}
+
+/**
+ * Find the node for a box, creating the nodes on the way.
+ */
+int LooseOctree::Place(const float min[3], const float max[3]) {
+    float c[3], r = 0;
+    for (int k=0; k<3; k++) {
+        c[k] = (min[k] + max[k]) * 0.5f;
+        r = std::max(r, (max[k] - min[k]) * 0.5f);
+    }
+    int n = 0;
+    for (int k=0; k<3; k++)
+        if (!(fabs(c[k] - nodes[0].center[k]) <= nodes[0].half)) return 0;
+    while (nodes[n].depth < maxDepth) {
+        float h = nodes[n].half * 0.5f;
+        if (r > h) break;
+        int octant = 0;
+        for (int k=0; k<3; k++)
+            if (c[k] >= nodes[n].center[k]) octant |= 1 << k;
+        int child = nodes[n].children[octant];
+        if (child < 0) {
+            Node node;
+            for (int k=0; k<3; k++)
+                node.center[k] = nodes[n].center[k] + ((octant >> k) & 1 ? h : -h);
+            node.half = h;
+            node.parent = n;
+            for (int i=0; i<8; i++) node.children[i] = -1;
+            node.first = -1;
+            node.count = 0;
+            node.depth = nodes[n].depth + 1;
+            child = nodes.size();
+            nodes.push_back(node);
+            nodes[n].children[octant] = child;
+        }
+        n = child;
+    }
+    return n;
+}
+
+void LooseOctree::Link(const unsigned int id, const int node) {
+    Object& o = objects[id];
+    o.node = node;
+    o.prev = -1;
+    o.next = nodes[node].first;
+    if (o.next >= 0) objects[o.next].prev = id;
+    nodes[node].first = id;
+    for (int n=node; n>=0; n=nodes[n].parent)
+        nodes[n].count++;
+}
+
+void LooseOctree::Unlink(const unsigned int id) {
+    Object& o = objects[id];
+    if (o.prev >= 0) objects[o.prev].next = o.next;
+    else nodes[o.node].first = o.next;
+    if (o.next >= 0) objects[o.next].prev = o.prev;
+    for (int n=o.node; n>=0; n=nodes[n].parent)
+        nodes[n].count--;
+    o.node = -1;
+}
+
+/**
+ * Add an object.
+ *
+ * @param box Bounding box of the object.
+ * @return Id of the object.
+ */
+unsigned int LooseOctree::Add(const Box& box) {
+    unsigned int id;
+    if (free.empty()) {
+        id = objects.size();
+        objects.push_back(Object());
+    } else {
+        id = free.back();
+        free.pop_back();
+    }
+    Object& o = objects[id];
+    Bounds(box, o.min, o.max);
+    Link(id, Place(o.min, o.max));
+    size++;
+    return id;
+}
+
+/**
+ * Move an object.
+ * The object is relinked only if it no longer belongs in its node.
+ *
+ * @param id Id of the object.
+ * @param box New bounding box of the object.
+ */
+void LooseOctree::Update(const unsigned int id, const Box& box) {
+    float min[3], max[3];
+    Bounds(box, min, max);
+    int node = Place(min, max);
+    Object& o = objects[id];
+    for (int k=0; k<3; k++) {
+        o.min[k] = min[k];
+        o.max[k] = max[k];
+    }
+    if (node == o.node) return;
+    Unlink(id);
+    Link(id, node);
+}
+
+/**
+ * Remove an object.
+ * The id may be reused by a later Add().
+ *
+ * @param id Id of the object.
+ */
+void LooseOctree::Remove(const unsigned int id) {
+    Unlink(id);
+    free.push_back(id);
+    size--;
+}
+
+/**
+ * Remove all objects and nodes.
+ */
+void LooseOctree::Clear() {
+    nodes.resize(1);
+    Node& root = nodes[0];
+    for (int i=0; i<8; i++) root.children[i] = -1;
+    root.first = -1;
+    root.count = 0;
+    objects.clear();
+    free.clear();
+    size = 0;
+}
+
+/**
+ * Get the bounding box of an object.
+ *
+ * @param id Id of the object.
+ * @return Bounding box.
+ */
+Box LooseOctree::GetBox(const unsigned int id) const {
+    const Object& o = objects[id];
+    Vector<3,float> c, e;
+    for (int k=0; k<3; k++) {
+        c[k] = (o.min[k] + o.max[k]) * 0.5f;
+        e[k] = (o.max[k] - o.min[k]) * 0.5f;
+    }
+    return Box(c, e);
+}
+
+/**
+ * Get the depth of the node holding an object.
+ *
+ * @param id Id of the object.
+ * @return Depth, zero for the root.
+ */
+unsigned int LooseOctree::GetDepth(const unsigned int id) const {
+    return nodes[objects[id].node].depth;
+}
+
+/**
+ * Get the number of objects.
+ *
+ * @return Number of objects.
+ */
+unsigned int LooseOctree::Size() const {
+    return size;
+}
+
+/**
+ * Get the number of nodes.
+ * Nodes are created as objects need them and kept until Clear().
+ *
+ * @return Number of nodes.
+ */
+unsigned int LooseOctree::GetNumberOfNodes() const {
+    return nodes.size();
+}
+
+/**
+ * Get the nodes, the root first.
+ *
+ * @return Node array.
+ */
+const vector<LooseOctree::Node>& LooseOctree::GetNodes() const {
+    return nodes;
+}
+
+/**
+ * Append all objects of a sub tree.
+ */
+void LooseOctree::Collect(const int node, vector<unsigned int>& result) const {
+    int stack[STACK_SIZE];
+    unsigned int top = 0;
+    stack[top++] = node;
+    while (top > 0) {
+        const Node& n = nodes[stack[--top]];
+        for (int o=n.first; o>=0; o=objects[o].next)
+            result.push_back(o);
+        for (int i=0; i<8; i++)
+            if (n.children[i] >= 0 && nodes[n.children[i]].count > 0)
+                stack[top++] = n.children[i];
+    }
+}
+
+/**
+ * Find the objects inside or intersecting a set of planes.
+ * An object is found unless its box is entirely behind one of the
+ * planes, as by Frustum::IsVisible(const Box&). Sub trees entirely
+ * inside the planes are reported without testing their objects.
+ *
+ * @param planes Planes with normals pointing inwards.
+ * @param count Number of planes.
+ * @param result Vector to append the object ids to.
+ */
+void LooseOctree::Query(Plane* const planes[], const unsigned int count,
+                        vector<unsigned int>& result) const {
+    int stack[STACK_SIZE];
+    unsigned int top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        int i = stack[--top];
+        const Node& n = nodes[i];
+        if (n.count == 0) continue;
+        // objects outside the root cell are kept in the root, so the
+        // root has no bounds
+        if (i != 0) {
+            float min[3], max[3];
+            LooseBounds(n, min, max);
+            int c = Classify(planes, count, min, max);
+            if (c < 0) continue;
+            if (c > 0) {
+                Collect(i, result);
+                continue;
+            }
+        }
+        for (int o=n.first; o>=0; o=objects[o].next)
+            if (Classify(planes, count, objects[o].min, objects[o].max) >= 0)
+                result.push_back(o);
+        for (int c=0; c<8; c++)
+            if (n.children[c] >= 0) stack[top++] = n.children[c];
+    }
+}
+
+/**
+ * Find the objects overlapping a sphere.
+ *
+ * @param sphere Sphere to test.
+ * @param result Vector to append the object ids to.
+ */
+void LooseOctree::Query(const Sphere& sphere, vector<unsigned int>& result) const {
+    float c[3];
+    for (int k=0; k<3; k++) c[k] = sphere.GetCenter().Get(k);
+    float r2 = sphere.GetRadius() * sphere.GetRadius();
+    int stack[STACK_SIZE];
+    unsigned int top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        int i = stack[--top];
+        const Node& n = nodes[i];
+        if (n.count == 0) continue;
+        if (i != 0) {
+            float min[3], max[3];
+            LooseBounds(n, min, max);
+            if (Distance2(c, min, max) > r2) continue;
+        }
+        for (int o=n.first; o>=0; o=objects[o].next)
+            if (Distance2(c, objects[o].min, objects[o].max) <= r2)
+                result.push_back(o);
+        for (int k=0; k<8; k++)
+            if (n.children[k] >= 0) stack[top++] = n.children[k];
+    }
+}
+
+/**
+ * Find the objects overlapping a box.
+ *
+ * @param box Box to test.
+ * @param result Vector to append the object ids to.
+ */
+void LooseOctree::Query(const Box& box, vector<unsigned int>& result) const {
+    float bmin[3], bmax[3];
+    Bounds(box, bmin, bmax);
+    int stack[STACK_SIZE];
+    unsigned int top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        int i = stack[--top];
+        const Node& n = nodes[i];
+        if (n.count == 0) continue;
+        if (i != 0) {
+            float min[3], max[3];
+            LooseBounds(n, min, max);
+            if (!Overlaps(min, max, bmin, bmax)) continue;
+        }
+        for (int o=n.first; o>=0; o=objects[o].next)
+            if (Overlaps(objects[o].min, objects[o].max, bmin, bmax))
+                result.push_back(o);
+        for (int k=0; k<8; k++)
+            if (n.children[k] >= 0) stack[top++] = n.children[k];
+    }
+}
+
+/**
+ * Find the objects hit by a ray.
+ * The objects are appended nearest first by the distance at which
+ * the ray enters their boxes, measured in lengths of the direction.
+ *
+ * @param origin Origin of the ray.
+ * @param direction Direction of the ray, need not be normalized.
+ * @param result Vector to append the object ids to.
+ * @param maxDistance Largest ray parameter to consider [optional].
+ */
+void LooseOctree::Query(const Vector<3,float> origin, const Vector<3,float> direction,
+                        vector<unsigned int>& result, const float maxDistance) const {
+    float o[3], inv[3];
+    for (int k=0; k<3; k++) {
+        o[k] = origin.Get(k);
+        inv[k] = 1 / direction.Get(k);
+    }
+    vector<std::pair<float, unsigned int> > hits;
+    int stack[STACK_SIZE];
+    unsigned int top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        int i = stack[--top];
+        const Node& n = nodes[i];
+        if (n.count == 0) continue;
+        if (i != 0) {
+            float min[3], max[3];
+            LooseBounds(n, min, max);
+            if (RayBox(o, inv, maxDistance, min, max) == FLT_MAX) continue;
+        }
+        for (int b=n.first; b>=0; b=objects[b].next) {
+            float t = RayBox(o, inv, maxDistance, objects[b].min, objects[b].max);
+            if (t != FLT_MAX) hits.push_back(std::make_pair(t, (unsigned int)b));
+        }
+        for (int k=0; k<8; k++)
+            if (n.children[k] >= 0) stack[top++] = n.children[k];
+    }
+    std::sort(hits.begin(), hits.end());
+    for (unsigned int h=0; h<hits.size(); h++)
+        result.push_back(hits[h].second);
+}
+
+} // NS Geometry
+} // NS OpenEngine
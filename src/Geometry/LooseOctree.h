@@ -0,0 +1,112 @@
+// Loose octree of boxes.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#ifndef _LOOSE_OCTREE_H_
+#define _LOOSE_OCTREE_H_
+
+#include <Geometry/Box.h>
+#include <Geometry/Sphere.h>
+#include <Geometry/Plane.h>
+#include <vector>
+#include <cfloat>
+
+namespace OpenEngine {
+namespace Geometry {
+
+using std::vector;
+
+/**
+ * Loose octree of axis aligned boxes.
+ *
+ * The octree indexes objects by their bounding boxes for proximity
+ * queries. Each object is kept in a single node: the deepest node
+ * whose cell holds the center of the box and whose loose bounds,
+ * twice the size of the cell, hold the whole box. So the node of an
+ * object only depends on its size and center, and moving an object
+ * is a constant time relink at most.
+ *
+ * @code
+ * LooseOctree octree(Vector<3,float>(0.0f), 1000);
+ * unsigned int id = octree.Add(box);
+ * octree.Update(id, moved);
+ * vector<unsigned int> near;
+ * octree.Query(Sphere(position, 20), near);
+ * @endcode
+ *
+ * Objects are identified by the ids returned by Add(), which stay
+ * valid until removed. Ids of removed objects are reused. Objects
+ * with their center outside the root cell are kept in the root.
+ *
+ * The queries report the objects whose boxes overlap the query
+ * volume, so exact tests against the geometry of the objects are up
+ * to the caller.
+ *
+ * @class LooseOctree LooseOctree.h Geometry/LooseOctree.h
+ */
+class LooseOctree {
+public:
+    /**
+     * Node of the octree.
+     */
+    struct Node {
+        float center[3];        //!< center of the cell
+        float half;             //!< half the size of the cell
+        int parent;             //!< parent node, -1 for the root
+        int children[8];        //!< child nodes, -1 for none
+        int first;              //!< first object in the node, -1 for none
+        unsigned int count;     //!< number of objects in the sub tree
+        unsigned int depth;     //!< depth of the node, zero for the root
+    };
+
+private:
+    struct Object {
+        float min[3], max[3];   // bounds of the object
+        int node;               // node holding the object, -1 if removed
+        int next, prev;         // objects of the same node
+    };
+
+    vector<Node> nodes;
+    vector<Object> objects;
+    vector<unsigned int> free;
+    unsigned int size;
+    unsigned int maxDepth;
+
+    int Place(const float min[3], const float max[3]);
+    void Link(const unsigned int id, const int node);
+    void Unlink(const unsigned int id);
+    void Collect(const int node, vector<unsigned int>& result) const;
+    static void Bounds(const Box& box, float min[3], float max[3]);
+
+public:
+    LooseOctree(const Vector<3,float> center, const float halfSize,
+                const unsigned int maxDepth = 8);
+
+    unsigned int Add(const Box& box);
+    void Update(const unsigned int id, const Box& box);
+    void Remove(const unsigned int id);
+    void Clear();
+
+    Box GetBox(const unsigned int id) const;
+    unsigned int GetDepth(const unsigned int id) const;
+    unsigned int Size() const;
+    unsigned int GetNumberOfNodes() const;
+    const vector<Node>& GetNodes() const;
+
+    void Query(Plane* const planes[], const unsigned int count,
+               vector<unsigned int>& result) const;
+    void Query(const Sphere& sphere, vector<unsigned int>& result) const;
+    void Query(const Box& box, vector<unsigned int>& result) const;
+    void Query(const Vector<3,float> origin, const Vector<3,float> direction,
+               vector<unsigned int>& result, const float maxDistance = FLT_MAX) const;
+};
+
+} // NS Geometry
+} // NS OpenEngine
+
+#endif // _LOOSE_OCTREE_H_
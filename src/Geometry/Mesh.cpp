@@ -0,0 +1,262 @@
+// Indexed triangle mesh.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#include <Geometry/Mesh.h>
+#include <Geometry/FaceSet.h>
+#include <Geometry/Face.h>
+#include <cstring>
+
+namespace OpenEngine {
+namespace Geometry {
+
+using OpenEngine::Resources::ITextureResourcePtr;
+using OpenEngine::Resources::IShaderResourcePtr;
+
+// marks an empty slot in the weld table
+static const unsigned int NONE = 0xFFFFFFFF;
+
+// append the N components of a vector to a stream
+template <int N>
+static inline void Append(vector<float>& stream, const Vector<N,float>& v) {
+    for (int i=0; i<N; i++)
+        stream.push_back(v.Get(i));
+}
+
+// hash the bits of an attribute of vertex i
+static inline unsigned int HashStream(unsigned int h, const vector<float>& stream,
+                                      const unsigned int size, const unsigned int i) {
+    if (stream.empty()) return h;
+    const unsigned char* p = (const unsigned char*)&stream[size*i];
+    for (unsigned int k=0; k<size*sizeof(float); k++)
+        h = (h ^ p[k]) * 16777619u;
+    return h;
+}
+
+// are the attributes of vertex i and j bitwise equal
+static inline bool EqualStream(const vector<float>& stream, const unsigned int size,
+                               const unsigned int i, const unsigned int j) {
+    return stream.empty() ||
+        memcmp(&stream[size*i], &stream[size*j], size*sizeof(float)) == 0;
+}
+
+// move the attributes of vertex from to vertex to
+static inline void MoveStream(vector<float>& stream, const unsigned int size,
+                              const unsigned int from, const unsigned int to) {
+    if (stream.empty() || from == to) return;
+    memcpy(&stream[size*to], &stream[size*from], size*sizeof(float));
+}
+
+/**
+ * Create an empty mesh.
+ */
+Mesh::Mesh() {}
+
+/**
+ * Create a mesh from a face set.
+ * Each run of faces with the same texture and shader becomes a sub
+ * mesh, so the order of the faces is kept, and identical corners are
+ * welded into shared vertices.
+ *
+ * @param faces Face set to convert.
+ */
+Mesh::Mesh(FaceSet& faces) {
+    unsigned int n = faces.Size();
+    vertices.reserve(9*n);
+    normals.reserve(9*n);
+    texcoords.reserve(6*n);
+    colors.reserve(12*n);
+    tangents.reserve(9*n);
+    binormals.reserve(9*n);
+    indices.reserve(3*n);
+
+    bool white = true;
+    const Vector<4,float> one(1);
+    for (FaceList::iterator itr = faces.begin(); itr != faces.end(); itr++) {
+        Face& f = **itr;
+        for (int i=0; i<3; i++) {
+            indices.push_back(indices.size());
+            Append(vertices, f.vert[i]);
+            Append(normals, f.norm[i]);
+            Append(texcoords, f.texc[i]);
+            Append(colors, f.colr[i]);
+            Append(tangents, f.tang[i]);
+            Append(binormals, f.bino[i]);
+            white &= f.colr[i] == one;
+        }
+        AddSubMesh(indices.size() - 3, 3, f.texr, f.shad);
+    }
+    // white is the default color
+    if (white) vector<float>().swap(colors);
+    Weld();
+}
+
+/**
+ * Get the number of vertices.
+ *
+ * @return Number of vertices.
+ */
+unsigned int Mesh::GetNumberOfVertices() const {
+    return vertices.size() / 3;
+}
+
+/**
+ * Get the number of triangles.
+ *
+ * @return Number of triangles.
+ */
+unsigned int Mesh::GetNumberOfTriangles() const {
+    return indices.size() / 3;
+}
+
+/**
+ * Get the approximate memory used by the mesh.
+ *
+ * @return Size of the streams and index buffer in bytes.
+ */
+unsigned int Mesh::GetMemoryCost() const {
+    return sizeof(Mesh)
+        + (vertices.size() + normals.size() + texcoords.size() +
+           colors.size() + tangents.size() + binormals.size()) * sizeof(float)
+        + indices.size() * sizeof(unsigned int)
+        + subMeshes.size() * sizeof(SubMesh);
+}
+
+/**
+ * Add a range of indices using a material.
+ * The range is merged with the last sub mesh if it continues it with
+ * the same texture and shader.
+ *
+ * @param first First index of the range.
+ * @param count Number of indices in the range.
+ * @param texr Texture resource.
+ * @param shad Shader resource.
+ */
+void Mesh::AddSubMesh(unsigned int first, unsigned int count,
+                      ITextureResourcePtr texr, IShaderResourcePtr shad) {
+    if (!subMeshes.empty()) {
+        SubMesh& last = subMeshes.back();
+        if (last.first + last.count == first && last.texr == texr && last.shad == shad) {
+            last.count += count;
+            return;
+        }
+    }
+    SubMesh s;
+    s.first = first;
+    s.count = count;
+    s.texr = texr;
+    s.shad = shad;
+    subMeshes.push_back(s);
+}
+
+/**
+ * Merge vertices with identical attributes.
+ * Vertices are compared bitwise over all present streams. The first
+ * occurrence of each vertex is kept, so welding is deterministic, and
+ * the index buffer is updated to the shared vertices.
+ */
+void Mesh::Weld() {
+    unsigned int n = GetNumberOfVertices();
+    unsigned int size = 16;
+    while (size < 2*n) size *= 2;
+    vector<unsigned int> table(size, NONE);
+    vector<unsigned int> remap(n);
+
+    unsigned int count = 0;
+    for (unsigned int i=0; i<n; i++) {
+        unsigned int h = 2166136261u;
+        h = HashStream(h, vertices, 3, i);
+        h = HashStream(h, normals, 3, i);
+        h = HashStream(h, texcoords, 2, i);
+        h = HashStream(h, colors, 4, i);
+        h = HashStream(h, tangents, 3, i);
+        h = HashStream(h, binormals, 3, i);
+
+        // the welded vertices are compacted in front of i, so the
+        // table refers to their new positions
+        unsigned int slot = h & (size-1);
+        for (; table[slot] != NONE; slot = (slot+1) & (size-1)) {
+            unsigned int j = table[slot];
+            if (EqualStream(vertices, 3, i, j) && EqualStream(normals, 3, i, j) &&
+                EqualStream(texcoords, 2, i, j) && EqualStream(colors, 4, i, j) &&
+                EqualStream(tangents, 3, i, j) && EqualStream(binormals, 3, i, j))
+                break;
+        }
+        if (table[slot] != NONE) {
+            remap[i] = table[slot];
+            continue;
+        }
+        MoveStream(vertices, 3, i, count);
+        MoveStream(normals, 3, i, count);
+        MoveStream(texcoords, 2, i, count);
+        MoveStream(colors, 4, i, count);
+        MoveStream(tangents, 3, i, count);
+        MoveStream(binormals, 3, i, count);
+        table[slot] = count;
+        remap[i] = count++;
+    }
+
+    for (unsigned int i=0; i<indices.size(); i++)
+        indices[i] = remap[indices[i]];
+    vertices.resize(3*count);
+    normals.resize(3*count);
+    texcoords.resize(2*count);
+    if (!colors.empty())    colors.resize(4*count);
+    if (!tangents.empty())  tangents.resize(3*count);
+    if (!binormals.empty()) binormals.resize(3*count);
+}
+
+/**
+ * Create a face set from the mesh.
+ * The caller owns the returned face set.
+ *
+ * @return New face set with a face for each triangle.
+ */
+FaceSet* Mesh::ToFaceSet() const {
+    // faces are copied from a prototype to avoid the calculations
+    // done by the face constructors
+    const Face proto(Vector<3,float>(1,0,0), Vector<3,float>(0,1,0),
+                     Vector<3,float>(0,0,1));
+    FaceSet* faces = new FaceSet();
+    for (unsigned int s=0; s<subMeshes.size(); s++) {
+        const SubMesh& sub = subMeshes[s];
+        for (unsigned int t = sub.first; t < sub.first + sub.count; t += 3) {
+            FacePtr face(new Face(proto));
+            for (int i=0; i<3; i++) {
+                unsigned int v = indices[t+i];
+                face->vert[i] = Vector<3,float>(&vertices[3*v]);
+                face->norm[i] = Vector<3,float>(&normals[3*v]);
+                face->texc[i] = Vector<2,float>(&texcoords[2*v]);
+                if (!colors.empty())
+                    face->colr[i] = Vector<4,float>(&colors[4*v]);
+                if (!tangents.empty())
+                    face->tang[i] = Vector<3,float>(&tangents[3*v]);
+                if (!binormals.empty())
+                    face->bino[i] = Vector<3,float>(&binormals[3*v]);
+            }
+            if (tangents.empty() || binormals.empty())
+                face->CalcTangentSpace();
+
+            // the hard normal as calculated by Face::CalcHardNorm
+            // once the corners are ordered after the soft normals
+            Vector<3,double> v1 = face->vert[1].ToDouble() - face->vert[0].ToDouble();
+            Vector<3,double> v2 = face->vert[2].ToDouble() - face->vert[0].ToDouble();
+            Vector<3,double> h = v1 % v2;
+            if (!h.IsZero()) h.Normalize();
+            face->hardNorm = h.ToFloat();
+
+            face->texr = sub.texr;
+            face->shad = sub.shad;
+            faces->Add(face);
+        }
+    }
+    return faces;
+}
+
+} // NS Geometry
+} // NS OpenEngine
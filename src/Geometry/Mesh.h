@@ -0,0 +1,98 @@
+// Indexed triangle mesh.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#ifndef _MESH_H_
+#define _MESH_H_
+
+#include <Resources/ITextureResource.h>
+#include <Resources/IShaderResource.h>
+#include <boost/shared_ptr.hpp>
+#include <vector>
+
+namespace OpenEngine {
+namespace Geometry {
+
+using std::vector;
+
+// forward declaration
+class FaceSet;
+
+/**
+ * Range of triangles sharing a material.
+ *
+ * @class SubMesh Mesh.h Geometry/Mesh.h
+ */
+struct SubMesh {
+    unsigned int first;   //!< first index of the range
+    unsigned int count;   //!< number of indices in the range
+    OpenEngine::Resources::ITextureResourcePtr texr; //!< texture resource
+    OpenEngine::Resources::IShaderResourcePtr  shad; //!< shader resource
+
+    SubMesh() : first(0), count(0) {}
+};
+
+/**
+ * Indexed triangle mesh.
+ *
+ * The vertex attributes are stored as structure of arrays, one
+ * tightly packed float stream per attribute, and shared between the
+ * triangles through a 32-bit index buffer with three indices per
+ * triangle. The triangles are grouped in sub meshes, which are
+ * consecutive ranges of the index buffer using the same texture and
+ * shader.
+ *
+ * The position, normal and texture coordinate streams are always
+ * present. The color, tangent and binormal streams may be empty, in
+ * which case the Face defaults are used: white, and the tangent
+ * space calculated from the texture coordinates.
+ *
+ * Conversion from a FaceSet and back is lossless. Hard normals are
+ * not stored since they are defined by the triangle corners.
+ *
+ * @code
+ * Mesh mesh(*faces);           // weld the faces of a face set
+ * FaceSet* copy = mesh.ToFaceSet();
+ * @endcode
+ *
+ * @class Mesh Mesh.h Geometry/Mesh.h
+ */
+class Mesh {
+public:
+    vector<float> vertices;         //!< positions, 3 per vertex
+    vector<float> normals;          //!< normals, 3 per vertex
+    vector<float> texcoords;        //!< texture coordinates, 2 per vertex
+    vector<float> colors;           //!< colors, 4 per vertex or empty
+    vector<float> tangents;         //!< tangents, 3 per vertex or empty
+    vector<float> binormals;        //!< binormals, 3 per vertex or empty
+    vector<unsigned int> indices;   //!< index buffer, 3 per triangle
+    vector<SubMesh> subMeshes;      //!< material ranges of the indices
+
+    Mesh();
+    explicit Mesh(FaceSet& faces);
+
+    unsigned int GetNumberOfVertices() const;
+    unsigned int GetNumberOfTriangles() const;
+    unsigned int GetMemoryCost() const;
+
+    void AddSubMesh(unsigned int first, unsigned int count,
+                    OpenEngine::Resources::ITextureResourcePtr texr,
+                    OpenEngine::Resources::IShaderResourcePtr shad);
+    void Weld();
+    FaceSet* ToFaceSet() const;
+};
+
+/**
+ * Mesh smart pointer.
+ */
+typedef boost::shared_ptr<Mesh> MeshPtr;
+
+} // NS Geometry
+} // NS OpenEngine
+
+#endif // _MESH_H_
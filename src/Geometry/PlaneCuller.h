@@ -0,0 +1,101 @@
+// Plane test of shapes in structure of arrays layout.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#ifndef _PLANE_CULLER_H_
+#define _PLANE_CULLER_H_
+
+#include <Geometry/Plane.h>
+#include <Meta/SSE.h>
+#include <vector>
+
+namespace OpenEngine {
+namespace Geometry {
+
+using std::vector;
+
+#ifdef OE_SSE
+
+/**
+ * Plane test of shapes in structure of arrays layout, four shapes at
+ * a time with SSE.
+ *
+ * The loop over the shapes and planes, the plane setup and the
+ * visibility mask are shared, while the shape specific work is done
+ * by a kernel K providing:
+ *
+ * @code
+ * enum { SETUP = ..., LOADS = ... };    // vectors per plane and per shape
+ * static void Setup(const Plane& plane, __m128* setup);
+ * void Load(const unsigned int i, __m128* shape) const;
+ * static __m128 Outside(const __m128* shape, const __m128* setup);
+ * @endcode
+ *
+ * Outside() returns a mask of the four shapes entirely behind the
+ * plane. The setup of up to MAX_PLANES planes is kept on the stack,
+ * so culling against a frustum allocates nothing.
+ *
+ * @class PlaneCuller PlaneCuller.h Geometry/PlaneCuller.h
+ * @param K Shape kernel
+ */
+template <class K>
+class PlaneCuller {
+public:
+    //! Number of planes set up without allocating.
+    static const unsigned int MAX_PLANES = 8;
+
+    /**
+     * Test groups of four shapes against a set of planes and set the
+     * bits of the visible ones. The visibility mask must be cleared
+     * and large enough for the shapes. The shapes after the last
+     * whole group are left for the caller to test.
+     *
+     * @param kernel Shape kernel.
+     * @param size Number of shapes.
+     * @param planes Planes with normals pointing inwards.
+     * @param count Number of planes.
+     * @param visible Visibility mask, one bit per shape.
+     * @return Index of the first shape not tested.
+     */
+    static unsigned int Cull(const K& kernel, const unsigned int size,
+                             Plane* const planes[], const unsigned int count,
+                             vector<unsigned int>& visible) {
+        __m128 local[K::SETUP * MAX_PLANES];
+        __m128* setup = local;
+        if (count > MAX_PLANES)
+            setup = (__m128*)_mm_malloc(K::SETUP * count * sizeof(__m128), 16);
+        for (unsigned int p=0; p<count; p++)
+            K::Setup(*planes[p], setup + K::SETUP * p);
+
+        const __m128 zero = _mm_setzero_ps();
+        __m128 shape[K::LOADS];
+        unsigned int i = 0;
+        for (; i+4 <= size; i+=4) {
+            kernel.Load(i, shape);
+            __m128 outside = zero;
+            for (unsigned int p=0; p<count; p++)
+                outside = _mm_or_ps(outside, K::Outside(shape, setup + K::SETUP * p));
+            // groups of four never straddle a mask word
+            unsigned int bits = ~_mm_movemask_ps(outside) & 0xF;
+            visible[i >> 5] |= bits << (i & 31);
+        }
+
+        if (setup != local) _mm_free(setup);
+        return i;
+    }
+};
+
+template <class K>
+const unsigned int PlaneCuller<K>::MAX_PLANES;
+
+#endif // OE_SSE
+
+} // NS Geometry
+} // NS OpenEngine
+
+#endif // _PLANE_CULLER_H_
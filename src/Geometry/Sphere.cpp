@@ -11,7 +11,9 @@
 #include <Geometry/Face.h>
 #include <Geometry/Line.h>
 #include <Geometry/Plane.h>
+#include <Geometry/Box.h>
 #include <Logging/Logger.h>
+#include <cmath>
 
 namespace OpenEngine {
 namespace Geometry {
@@ -37,30 +39,83 @@ Sphere::Sphere(Vector<3,float> center, float diameter)
 }
 
 /**
- * Create a sphere with a volume defined by a set of faces.
+ * Create a sphere enclosing a set of faces.
  *
+ * @see Sphere(const vector<Vector<3,float> >&)
  * @param faces Face set to calculate volume from.
  */
 Sphere::Sphere(FaceSet& faces) {
-    Vector<3,float> max, min;
+    vector<Vector<3,float> > points;
+    points.reserve(faces.Size() * 3);
     FaceList::iterator itr;
-    for (itr = faces.begin(); itr != faces.end(); itr++) {
-        for (int i=0; i<3; i++) {
-            Vector<3,float> v = (*itr)->vert[i];
-            for (int j=0; j<3; j++)
-                if (v[j] < min[j]) min[j] = v[j];
-                else if (v[j] > max[j]) max[j] = v[j];
+    for (itr = faces.begin(); itr != faces.end(); itr++)
+        for (int i=0; i<3; i++)
+            points.push_back((*itr)->vert[i]);
+    Enclose(points);
+    if (diameter == 0)
+        throw Exception("Invalid volume -  radius of the sphere was zero");
+}
+
+/**
+ * Create a sphere enclosing a set of points.
+ * The sphere is found by Ritter's algorithm: the pair of points
+ * farthest apart along an axis is the initial diameter, and the
+ * sphere is grown to each point left outside it. The result is
+ * usually within a few percent of the smallest enclosing sphere, but
+ * up to a fourth larger for box like point sets, so the sphere
+ * around the center of the bounding box is used instead when it is
+ * smaller.
+ *
+ * @param points Points to enclose.
+ */
+Sphere::Sphere(const vector<Vector<3,float> >& points) {
+    Enclose(points);
+}
+
+void Sphere::Enclose(const vector<Vector<3,float> >& points) {
+    center = Vector<3,float>();
+    diameter = 0;
+    if (points.empty()) return;
+
+    // the points with the least and greatest coordinate on each axis
+    unsigned int lo[3] = {0, 0, 0}, hi[3] = {0, 0, 0};
+    for (unsigned int i=1; i<points.size(); i++)
+        for (int k=0; k<3; k++) {
+            if (points[i].Get(k) < points[lo[k]].Get(k)) lo[k] = i;
+            if (points[i].Get(k) > points[hi[k]].Get(k)) hi[k] = i;
+        }
+    Vector<3,float> box;
+    for (int k=0; k<3; k++)
+        box[k] = (points[lo[k]].Get(k) + points[hi[k]].Get(k)) * 0.5f;
+    float span = -1;
+    for (int k=0; k<3; k++) {
+        Vector<3,float> d = points[hi[k]] - points[lo[k]];
+        if (d * d > span) {
+            span = d * d;
+            center = (points[hi[k]] + points[lo[k]]) * 0.5f;
         }
     }
-    // set box center
-    center = (max - min) / 2 + min;
-    // set corner vector
-    Vector<3,float> corner = max - center;
+    float radius = sqrt(span) * 0.5f;
 
-    if (corner.IsZero())
-        throw Exception("Invalid volume -  radius of the sphere was zero");
-    else
-        diameter = corner.GetLength() / 2.0f;
+    // grow the sphere just enough to hold each point outside it, and
+    // find the radius of the sphere around the bounding box center
+    float boxRadius2 = 0;
+    for (unsigned int i=0; i<points.size(); i++) {
+        Vector<3,float> b = points[i] - box;
+        if (b * b > boxRadius2) boxRadius2 = b * b;
+        Vector<3,float> d = points[i] - center;
+        float dist2 = d * d;
+        if (dist2 <= radius * radius) continue;
+        float dist = sqrt(dist2);
+        float grown = (radius + dist) * 0.5f;
+        center += d * ((grown - radius) / dist);
+        radius = grown;
+    }
+    if (boxRadius2 < radius * radius) {
+        center = box;
+        radius = sqrt(boxRadius2);
+    }
+    diameter = radius * 2;
 }
 
 /**
@@ -120,29 +175,84 @@ void Sphere::SetRadius(const float r) {
 /**
  * Test if sphere contains a point.
  *
- * @todo Not implemented.
- *
  * @param point Point to test for containment.
+ * @return True if the point is inside or on the sphere.
  */
-bool Sphere::Intersects(const Vector<3,float> point) const { return false; }
+bool Sphere::Intersects(const Vector<3,float> point) const {
+    Vector<3,float> d = point - center;
+    float r = GetRadius();
+    return d * d <= r * r;
+}
 
 /**
- * Test if sphere intersects with a line.
- *
- * @todo Not implemented.
+ * Test if sphere intersects with a line segment.
  *
  * @param line Line to test for intersection.
+ * @return True if some point between the end points is inside the sphere.
  */
-bool Sphere::Intersects(const Line line) const { return false; }
+bool Sphere::Intersects(const Line line) const {
+    Vector<3,float> p = line.point1;
+    Vector<3,float> d = line.point2 - p;
+    // the point of the segment closest to the center
+    float t = 0, dd = d * d;
+    if (dd > 0) {
+        t = ((center - p) * d) / dd;
+        if (t < 0) t = 0;
+        else if (t > 1) t = 1;
+    }
+    return Intersects(p + d * t);
+}
 
 /**
  * Test if sphere intersects with a plane.
  *
- * @todo Not implemented.
+ * @param plane Plane to test for intersection, with a unit normal.
+ * @return True if the plane passes through the sphere.
+ */
+bool Sphere::Intersects(const Plane plane) const {
+    Vector<3,float> n = plane.normal;
+    return fabs(n * center + plane.distance) <= GetRadius();
+}
+
+/**
+ * Test if sphere intersects with a box.
  *
- * @param plane Plane to test for intersection.
+ * @param box Box to test for intersection.
+ * @return True if the box and the sphere overlap.
  */
-bool Sphere::Intersects(const Plane plane) const { return false; }
+bool Sphere::Intersects(const Box& box) const {
+    Vector<3,float> c = box.GetCenter(), e = box.GetCorner();
+    // squared distance from the center to the box
+    float dist = 0;
+    for (int k=0; k<3; k++) {
+        float d = fabs(center.Get(k) - c[k]) - fabs(e[k]);
+        if (d > 0) dist += d * d;
+    }
+    float r = GetRadius();
+    return dist <= r * r;
+}
+
+/**
+ * Test if sphere is inside or intersecting a set of planes, such as
+ * the planes of a frustum.
+ * The sphere is outside if it is entirely behind one of the planes.
+ *
+ * @param planes Planes with unit normals pointing inwards.
+ * @param count Number of planes.
+ * @return True unless the sphere is outside.
+ */
+bool Sphere::Intersects(Plane* const planes[], const unsigned int count) const {
+    const float r = GetRadius();
+    for (unsigned int p=0; p<count; p++) {
+        const Vector<3,float>& n = planes[p]->normal;
+        float dist = center.Get(0) * n.Get(0);
+        dist += center.Get(1) * n.Get(1);
+        dist += center.Get(2) * n.Get(2);
+        dist += planes[p]->distance;
+        if (dist < -r) return false;
+    }
+    return true;
+}
 
 } //NS Geometry
 } //NS OpenEngine
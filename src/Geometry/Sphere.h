@@ -13,14 +13,23 @@
 #include <Geometry/FaceSet.h>
 #include <Geometry/BoundingGeometry.h>
 #include <string>
+#include <vector>
 
 namespace OpenEngine {
 namespace Geometry {
 
 using OpenEngine::Math::Vector;
+using std::vector;
+
+class Box;
 
 /**
  * Bounding geometry sphere.
+ * Spheres are the cheapest volumes to test against planes, so they
+ * make a good first level reject before testing a box or the faces.
+ *
+ * The plane tests assume the plane normals have unit length, as
+ * those of a Frustum do.
  *
  * @class Sphere Sphere.h Geometry/Sphere.h
  */
@@ -32,12 +41,16 @@ private:
     Vector<3,float> center;
     float diameter;    
 
+    void Enclose(const vector<Vector<3,float> >& points);
+
 public:
     explicit Sphere();
 
     Sphere(Vector<3,float> center, float diameter);
 
     Sphere(FaceSet& faces);
+
+    explicit Sphere(const vector<Vector<3,float> >& points);
     
     void Move(Vector<3,float> dir);
 
@@ -56,6 +69,10 @@ public:
 
     bool Intersects(const Plane plane) const;
 
+    bool Intersects(const Box& box) const;
+
+    bool Intersects(Plane* const planes[], const unsigned int count) const;
+
 };
 
 } //NS Common
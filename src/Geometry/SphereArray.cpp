@@ -0,0 +1,147 @@
+// Array of spheres.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#include <Geometry/SphereArray.h>
+#include <Geometry/PlaneCuller.h>
+
+namespace OpenEngine {
+namespace Geometry {
+
+#ifdef OE_SSE
+// plane test of four spheres, see PlaneCuller
+struct SphereKernel {
+    enum { SETUP = 4, LOADS = 4 };
+    const SphereArray& spheres;
+
+    SphereKernel(const SphereArray& spheres) : spheres(spheres) {}
+
+    // the splatted normal and distance
+    static void Setup(const Plane& plane, __m128* s) {
+        for (int i=0; i<3; i++)
+            s[i] = _mm_set1_ps(plane.normal.Get(i));
+        s[3] = _mm_set1_ps(plane.distance);
+    }
+
+    // the center and the negated radius
+    void Load(const unsigned int i, __m128* v) const {
+        v[0] = _mm_loadu_ps(&spheres.cx[i]);
+        v[1] = _mm_loadu_ps(&spheres.cy[i]);
+        v[2] = _mm_loadu_ps(&spheres.cz[i]);
+        v[3] = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(&spheres.r[i]));
+    }
+
+    static __m128 Outside(const __m128* v, const __m128* s) {
+        __m128 dist = _mm_mul_ps(v[0], s[0]);
+        dist = _mm_add_ps(dist, _mm_mul_ps(v[1], s[1]));
+        dist = _mm_add_ps(dist, _mm_mul_ps(v[2], s[2]));
+        dist = _mm_add_ps(dist, s[3]);
+        return _mm_cmplt_ps(dist, v[3]);
+    }
+};
+#endif
+
+/**
+ * Add a sphere.
+ *
+ * @param sphere Sphere to add.
+ */
+void SphereArray::Add(const Sphere& sphere) {
+    Add(sphere.GetCenter(), sphere.GetRadius());
+}
+
+/**
+ * Add a sphere given by its center and radius.
+ *
+ * @param center Center of the sphere.
+ * @param radius Radius of the sphere.
+ */
+void SphereArray::Add(const Vector<3,float> center, const float radius) {
+    cx.push_back(center.Get(0));
+    cy.push_back(center.Get(1));
+    cz.push_back(center.Get(2));
+    r.push_back(radius);
+}
+
+/**
+ * Remove all spheres.
+ */
+void SphereArray::Clear() {
+    cx.clear(); cy.clear(); cz.clear();
+    r.clear();
+}
+
+/**
+ * Get the number of spheres.
+ *
+ * @return Number of spheres.
+ */
+unsigned int SphereArray::Size() const {
+    return cx.size();
+}
+
+/**
+ * Test the spheres against a set of planes.
+ * A sphere is visible unless it is entirely behind one of the planes.
+ * Uses SSE if available, otherwise the same as CullScalar().
+ *
+ * @param planes Planes with unit normals pointing inwards.
+ * @param count Number of planes.
+ * @param visible Visibility mask, one bit per sphere.
+ */
+void SphereArray::Cull(Plane* const planes[], const unsigned int count,
+                       vector<unsigned int>& visible) const {
+#ifdef OE_SSE
+    const unsigned int size = Size();
+    visible.assign((size + 31) / 32, 0);
+
+    unsigned int i = PlaneCuller<SphereKernel>::Cull(SphereKernel(*this), size,
+                                                     planes, count, visible);
+    CullRange(planes, count, i, size, visible);
+#else
+    CullScalar(planes, count, visible);
+#endif
+}
+
+/**
+ * Test the spheres against a set of planes one sphere at a time.
+ *
+ * @see Cull()
+ * @param planes Planes with unit normals pointing inwards.
+ * @param count Number of planes.
+ * @param visible Visibility mask, one bit per sphere.
+ */
+void SphereArray::CullScalar(Plane* const planes[], const unsigned int count,
+                             vector<unsigned int>& visible) const {
+    visible.assign((Size() + 31) / 32, 0);
+    CullRange(planes, count, 0, Size(), visible);
+}
+
+/**
+ * Test a range of spheres one at a time and set their bits.
+ * The float operations are those of the SSE test in the same order.
+ */
+void SphereArray::CullRange(Plane* const planes[], const unsigned int count,
+                            const unsigned int begin, const unsigned int end,
+                            vector<unsigned int>& visible) const {
+    for (unsigned int i=begin; i<end; i++) {
+        bool inside = true;
+        for (unsigned int p=0; p<count && inside; p++) {
+            const Vector<3,float>& n = planes[p]->normal;
+            float dist = cx[i] * n.Get(0);
+            dist += cy[i] * n.Get(1);
+            dist += cz[i] * n.Get(2);
+            dist += planes[p]->distance;
+            inside = !(dist < -r[i]);
+        }
+        if (inside) visible[i >> 5] |= 1u << (i & 31);
+    }
+}
+
+} // NS Geometry
+} // NS OpenEngine
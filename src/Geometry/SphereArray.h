@@ -0,0 +1,81 @@
+// Array of spheres.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#ifndef _SPHERE_ARRAY_H_
+#define _SPHERE_ARRAY_H_
+
+#include <Geometry/Sphere.h>
+#include <Geometry/Plane.h>
+#include <vector>
+
+namespace OpenEngine {
+namespace Geometry {
+
+using std::vector;
+
+/**
+ * Array of spheres in structure of arrays layout.
+ *
+ * The centers and radii of the spheres are kept in one array per
+ * component, so that many spheres can be tested against a set of
+ * planes at once. The result of a test is a bit mask with one bit
+ * per sphere, laid out as that of BoxArray.
+ *
+ * @code
+ * SphereArray spheres;
+ * spheres.Add(sphere);
+ * vector<unsigned int> visible;
+ * frustum.IsVisible(spheres, visible);
+ * if (SphereArray::IsSet(visible, 0)) ...
+ * @endcode
+ *
+ * A sphere is tested with one dot product per plane, exactly like
+ * Sphere::Intersects(Plane* const[], const unsigned int), four
+ * spheres at a time when compiled with SSE. The SSE and the scalar
+ * test perform the same float operations in the same order and give
+ * identical results. The planes must have unit normals.
+ *
+ * @class SphereArray SphereArray.h Geometry/SphereArray.h
+ */
+class SphereArray {
+public:
+    vector<float> cx, cy, cz;   //!< sphere centers
+    vector<float> r;            //!< sphere radii
+
+    void Add(const Sphere& sphere);
+    void Add(const Vector<3,float> center, const float radius);
+    void Clear();
+    unsigned int Size() const;
+
+    void Cull(Plane* const planes[], const unsigned int count,
+              vector<unsigned int>& visible) const;
+    void CullScalar(Plane* const planes[], const unsigned int count,
+                    vector<unsigned int>& visible) const;
+
+    /**
+     * Check the bit of a sphere in a visibility mask.
+     *
+     * @param mask Visibility mask.
+     * @param index Sphere index.
+     * @return True if the bit is set.
+     */
+    static bool IsSet(const vector<unsigned int>& mask, const unsigned int index) {
+        return (mask[index >> 5] >> (index & 31)) & 1;
+    }
+
+private:
+    void CullRange(Plane* const planes[], const unsigned int count,
+                   const unsigned int begin, const unsigned int end,
+                   vector<unsigned int>& visible) const;
+};
+
+} // NS Geometry
+} // NS OpenEngine
+
+#endif // _SPHERE_ARRAY_H_
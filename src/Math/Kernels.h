@@ -0,0 +1,151 @@
+// Math element kernels.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#ifndef _MATH_KERNELS_H_
+#define _MATH_KERNELS_H_
+
+#include <Meta/SSE.h>
+
+namespace OpenEngine {
+namespace Math {
+
+/**
+ * Storage layout of vector elements.
+ * SIZE is the number of stored elements. Vector<3,float> is padded
+ * to four elements when compiled with SSE if OE_PAD_VECTOR3 is
+ * defined.
+ *
+ * @class VectorLayout Kernels.h Math/Kernels.h
+ */
+template <int N, class T>
+struct VectorLayout {
+    enum { SIZE = N };
+};
+
+/**
+ * Element loops of the vector operations.
+ *
+ * @class GenericVectorKernel Kernels.h Math/Kernels.h
+ */
+template <int N, class T>
+struct GenericVectorKernel {
+    static void Add(const T* a, const T* b, T* r) {
+        for (int i=0; i<N; i++) r[i] = a[i] + b[i];
+    }
+    static void Sub(const T* a, const T* b, T* r) {
+        for (int i=0; i<N; i++) r[i] = a[i] - b[i];
+    }
+    static void Scale(const T* a, const T s, T* r) {
+        for (int i=0; i<N; i++) r[i] = a[i] * s;
+    }
+    static T Dot(const T* a, const T* b) {
+        T s = 0;
+        for (int i=0; i<N; i++) s += a[i] * b[i];
+        return s;
+    }
+};
+
+/**
+ * Element loops of the matrix operations.
+ *
+ * @class GenericMatrixKernel Kernels.h Math/Kernels.h
+ */
+template <int M, int N, class T>
+struct GenericMatrixKernel {
+    static void Multiply(const T a[M][N], const T b[N][M], T r[M][M]) {
+        for (int i=0; i<M; i++)
+            for (int j=0; j<M; j++) {
+                T s = 0;
+                for (int t=0; t<N; t++)
+                    s += a[i][t] * b[t][j];
+                r[i][j] = s;
+            }
+    }
+};
+
+/**
+ * Vector operations used by Vector.
+ * Specialized for the vector types supported by the SIMD
+ * instructions of the target.
+ *
+ * @class VectorKernel Kernels.h Math/Kernels.h
+ */
+template <int N, class T>
+struct VectorKernel : public GenericVectorKernel<N,T> {};
+
+/**
+ * Matrix operations used by Matrix.
+ * Specialized for the matrix types supported by the SIMD
+ * instructions of the target.
+ *
+ * @class MatrixKernel Kernels.h Math/Kernels.h
+ */
+template <int M, int N, class T>
+struct MatrixKernel : public GenericMatrixKernel<M,N,T> {};
+
+#ifdef OE_SSE
+
+#ifdef OE_PAD_VECTOR3
+template <>
+struct VectorLayout<3,float> {
+    enum { SIZE = 4 };
+};
+#endif
+
+/*
+ * The SSE kernels use unaligned loads and stores, so they also work
+ * on elements copied to memory of lesser alignment, and they sum the
+ * products in the order of the generic loops, so the results are
+ * identical to those of the generic kernels.
+ */
+
+template <>
+struct VectorKernel<4,float> {
+    static void Add(const float* a, const float* b, float* r) {
+        _mm_storeu_ps(r, _mm_add_ps(_mm_loadu_ps(a), _mm_loadu_ps(b)));
+    }
+    static void Sub(const float* a, const float* b, float* r) {
+        _mm_storeu_ps(r, _mm_sub_ps(_mm_loadu_ps(a), _mm_loadu_ps(b)));
+    }
+    static void Scale(const float* a, const float s, float* r) {
+        _mm_storeu_ps(r, _mm_mul_ps(_mm_loadu_ps(a), _mm_set1_ps(s)));
+    }
+    static float Dot(const float* a, const float* b) {
+        __m128 p = _mm_mul_ps(_mm_loadu_ps(a), _mm_loadu_ps(b));
+        __m128 s = _mm_add_ss(p, _mm_shuffle_ps(p, p, _MM_SHUFFLE(1,1,1,1)));
+        s = _mm_add_ss(s, _mm_movehl_ps(p, p));
+        s = _mm_add_ss(s, _mm_shuffle_ps(p, p, _MM_SHUFFLE(3,3,3,3)));
+        return _mm_cvtss_f32(s);
+    }
+};
+
+template <>
+struct MatrixKernel<4,4,float> {
+    static void Multiply(const float a[4][4], const float b[4][4], float r[4][4]) {
+        const __m128 b0 = _mm_loadu_ps(b[0]);
+        const __m128 b1 = _mm_loadu_ps(b[1]);
+        const __m128 b2 = _mm_loadu_ps(b[2]);
+        const __m128 b3 = _mm_loadu_ps(b[3]);
+        // each row of the result is a combination of the rows of b
+        for (int i=0; i<4; i++) {
+            __m128 s = _mm_mul_ps(_mm_set1_ps(a[i][0]), b0);
+            s = _mm_add_ps(s, _mm_mul_ps(_mm_set1_ps(a[i][1]), b1));
+            s = _mm_add_ps(s, _mm_mul_ps(_mm_set1_ps(a[i][2]), b2));
+            s = _mm_add_ps(s, _mm_mul_ps(_mm_set1_ps(a[i][3]), b3));
+            _mm_storeu_ps(r[i], s);
+        }
+    }
+};
+
+#endif // OE_SSE
+
+}  // NS Math
+}  // NS OpenEngine
+
+#endif // _MATH_KERNELS_H_
@@ -22,6 +22,10 @@ namespace Math {
 /**
  * Matrix.
  *
+ * Matrix multiplication is done by MatrixKernel, which uses SSE for
+ * Matrix<4,4,float> when available. The kernel loads the elements
+ * unaligned, so matrices need no particular alignment.
+ *
  * @class Matrix Matrix.h Math/Matrix.h
  * @param M Number of rows
  * @param N Number of columns
@@ -166,13 +170,7 @@ public:
      */
     const Matrix<M,M,T> operator*(const Matrix<N,M,T> m) {
         Matrix<M,M,T> r;
-        for (int i=0; i<M; i++) 
-            for (int j=0; j<M; j++) {
-                T s = 0;
-                for (int t=0; t<N; t++)
-                    s += elm[i][t] * m.elm[t][j];
-                r.elm[i][j] = s;
-            }
+        MatrixKernel<M,N,T>::Multiply(elm, m.elm, r.elm);
         return r;
     }
     /**
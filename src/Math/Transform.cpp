@@ -0,0 +1,69 @@
+// Batch transformations.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#include <Math/Transform.h>
+#include <Meta/SSE.h>
+
+namespace OpenEngine {
+namespace Math {
+
+/**
+ * Transform an array of points by a matrix.
+ * The points are row vectors with a fourth coordinate of one, so the
+ * translation in the last row of the matrix is applied. With and
+ * without SSE element j of a result is computed as
+ * ((x*m(0,j) + y*m(1,j)) + z*m(2,j)) + m(3,j). The input and output
+ * arrays may be the same.
+ *
+ * @code
+ * vector< Vector<3,float> > points;
+ * TransformPoints(node->GetWorldMatrix(), &points[0], &points[0], points.size());
+ * @endcode
+ *
+ * @param m Transformation matrix.
+ * @param in Points to transform.
+ * @param out Transformed points.
+ * @param count Number of points.
+ */
+void TransformPoints(Matrix<4,4,float> m, const Vector<3,float>* in,
+                     Vector<3,float>* out, const unsigned int count) {
+    float a[16];
+    m.ToArray(a);
+    // vectors hold their elements first, possibly followed by padding
+    const unsigned int stride = sizeof(Vector<3,float>) / sizeof(float);
+    const float* p = reinterpret_cast<const float*>(in);
+    float* q = reinterpret_cast<float*>(out);
+#ifdef OE_SSE
+    const __m128 r0 = _mm_loadu_ps(a);
+    const __m128 r1 = _mm_loadu_ps(a + 4);
+    const __m128 r2 = _mm_loadu_ps(a + 8);
+    const __m128 r3 = _mm_loadu_ps(a + 12);
+    for (unsigned int i=0; i<count; i++, p+=stride, q+=stride) {
+        __m128 s = _mm_mul_ps(_mm_set1_ps(p[0]), r0);
+        s = _mm_add_ps(s, _mm_mul_ps(_mm_set1_ps(p[1]), r1));
+        s = _mm_add_ps(s, _mm_mul_ps(_mm_set1_ps(p[2]), r2));
+        s = _mm_add_ps(s, r3);
+        _mm_storel_pi((__m64*)q, s);
+        _mm_store_ss(q + 2, _mm_movehl_ps(s, s));
+    }
+#else
+    for (unsigned int i=0; i<count; i++, p+=stride, q+=stride) {
+        float x = p[0], y = p[1], z = p[2];
+        for (int j=0; j<3; j++) {
+            float s = x * a[j];
+            s += y * a[4 + j];
+            s += z * a[8 + j];
+            q[j] = s + a[12 + j];
+        }
+    }
+#endif
+}
+
+}  // NS Math
+}  // NS OpenEngine
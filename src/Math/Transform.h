@@ -0,0 +1,25 @@
+// Batch transformations.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#ifndef _MATH_TRANSFORM_H_
+#define _MATH_TRANSFORM_H_
+
+#include <Math/Vector.h>
+#include <Math/Matrix.h>
+
+namespace OpenEngine {
+namespace Math {
+
+void TransformPoints(Matrix<4,4,float> m, const Vector<3,float>* in,
+                     Vector<3,float>* out, const unsigned int count);
+
+}  // NS Math
+}  // NS OpenEngine
+
+#endif // _MATH_TRANSFORM_H_
@@ -11,6 +11,7 @@
 #define _VECTOR_H_
 
 #include <Math/Exceptions.h>
+#include <Math/Kernels.h>
 
 #include <string>
 #include <sstream>
@@ -24,6 +25,11 @@ namespace Math {
 /**
  * Vector.
  *
+ * The element operations are done by VectorKernel, which uses SSE
+ * for Vector<4,float> when available. The kernels load the elements
+ * unaligned, so vectors need no particular alignment. With
+ * OE_PAD_VECTOR3 defined Vector<3,float> is padded to four elements.
+ *
  * @class Vector Vector.h Math/Vector.h
  * @param N Number of elements
  * @param T Type of elements
@@ -31,8 +37,14 @@ namespace Math {
 template <int N, class T>
 class Vector {
 private:
-    // vector elements
-    T elm[N];
+    // vector elements, padded as given by the layout
+    T elm[VectorLayout<N,T>::SIZE];
+
+    // zero the padding elements, if any
+    void ClearPadding() {
+        for (int i=N; i<VectorLayout<N,T>::SIZE; i++)
+            elm[i] = 0;
+    }
 
 public:
     /**
@@ -44,6 +56,7 @@ public:
     Vector() {
         for (int i=0; i<N; i++)
             elm[i] = 0;
+        ClearPadding();
     }
     /**
      * Create vector from scalar.
@@ -56,6 +69,7 @@ public:
     explicit Vector(const T s) {
         for (int i=0; i<N; i++)
             elm[i] = s;
+        ClearPadding();
     }
     /**
      * Copy constructor.
@@ -65,6 +79,7 @@ public:
     Vector(const Vector<N,T>& v) {
         for (int i=0;i<N;i++)
             elm[i] = v.elm[i];
+        ClearPadding();
     }
     /**
      * Create vector from array.
@@ -74,6 +89,7 @@ public:
     explicit Vector(const T a[N]) {
         for (int i=0; i<N; i++)
             elm[i] = a[i];
+        ClearPadding();
     }
     /**
      * Constructor for a 2 element vector.
@@ -88,6 +104,7 @@ public:
     Vector(const T x, const T y, const T z) {
         BOOST_STATIC_ASSERT(N==3);
         elm[0]=x; elm[1]=y; elm[2]=z;
+        ClearPadding();
     }
     /**
      * Constructor for a 4 element vector.
@@ -153,8 +170,7 @@ public:
      */
     const Vector<N,T> operator+(const Vector<N,T>& v) const {
         Vector<N,T> t;
-        for (int i=0; i<N; i++)
-            t[i] = elm[i] + v.elm[i];
+        VectorKernel<N,T>::Add(elm, v.elm, t.elm);
         return t;
     }
     /**
@@ -181,8 +197,7 @@ public:
      */
     const Vector<N,T> operator-(const Vector<N,T>& v) const {
         Vector<N,T> t;
-        for (int i=0; i<N; i++)
-            t[i] = elm[i] - v.elm[i];
+        VectorKernel<N,T>::Sub(elm, v.elm, t.elm);
         return t;
     }
     /**
@@ -194,8 +209,7 @@ public:
      */
     const Vector<N,T> operator*(const T s) const {
         Vector<N,T> v;
-        for (int i=0; i<N; i++)
-            v[i] = elm[i] * s;
+        VectorKernel<N,T>::Scale(elm, s, v.elm);
         return v;
     }
     /**
@@ -238,10 +252,7 @@ public:
      * @endcode
      */
     const T operator*(const Vector<N,T>& v) const {
-        T s = 0;
-        for (int i=0; i<N; i++)
-            s += elm[i] * v.elm[i];
-        return s;
+        return VectorKernel<N,T>::Dot(elm, v.elm);
     }
     /**
      * Cross/vector/outer product.
@@ -275,15 +286,13 @@ public:
      * Destructive vector addition.
      */
     void operator+=(const Vector<N,T>& v) {
-        for (int i=0; i<N; i++)
-            elm[i] += v.Get(i);
+        VectorKernel<N,T>::Add(elm, v.elm, elm);
     }
     /**
      * Destructive scalar multiplication.
      */
     void operator*=(const T s) {
-        for (int i=0; i<N; i++)
-            elm[i] *= s;
+        VectorKernel<N,T>::Scale(elm, s, elm);
     }
     /**
      * Destructive scalar subtraction.
@@ -0,0 +1,22 @@
+// Meta header for SSE intrinsics.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#ifndef _OPENENGINE_SSE_H_
+#define _OPENENGINE_SSE_H_
+
+// OE_SSE is defined when the compiler targets SSE. Define OE_NO_SSE
+// to build the scalar code paths only.
+#if !defined OE_NO_SSE
+  #if defined __SSE__ || defined _M_X64 || (defined _M_IX86_FP && _M_IX86_FP >= 1)
+    #define OE_SSE
+    #include <xmmintrin.h>
+  #endif
+#endif
+
+#endif // _OPENENGINE_SSE_H_
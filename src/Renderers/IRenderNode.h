@@ -21,6 +21,7 @@ namespace Renderers {
 using OpenEngine::Scene::SceneNode;
 using OpenEngine::Scene::ISceneNode;
 using OpenEngine::Scene::ISceneNodeVisitor;
+using OpenEngine::Math::Vector;
 
 /**
  * Render node.
@@ -33,6 +34,14 @@ using OpenEngine::Scene::ISceneNodeVisitor;
  * @see IRenderer
  */
 class IRenderNode : public SceneNode {
+protected:
+    /**
+     * Render nodes may draw anything, so they are never culled.
+     */
+    BoundsType ComputeBounds(Vector<3,float>& min, Vector<3,float>& max) {
+        return INFINITE_BOUNDS;
+    }
+
 public:
     /**
      * Apply the node, called by the renderer
@@ -0,0 +1,126 @@
+// Renderer without graphics output.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#include <Renderers/NullRenderer.h>
+#include <Renderers/IRenderingView.h>
+#include <Display/Viewport.h>
+#include <Display/IViewingVolume.h>
+
+namespace OpenEngine {
+namespace Renderers {
+
+using OpenEngine::Display::Viewport;
+using OpenEngine::Display::IViewingVolume;
+
+/**
+ * Create a null renderer.
+ */
+NullRenderer::NullRenderer() {
+    ResetCounters();
+}
+
+/**
+ * Null renderer destructor.
+ * Deletes all the attached rendering views.
+ */
+NullRenderer::~NullRenderer() {
+    list<IRenderingView*>::iterator itr;
+    for(itr=vRenderingView.begin(); itr!=vRenderingView.end(); ++itr)
+        delete *itr;
+    vRenderingView.clear();
+}
+
+void NullRenderer::Initialize() {}
+
+/**
+ * Render the scene in all rendering views.
+ */
+void NullRenderer::Process(const float deltaTime, const float percent) {
+    if (root == NULL) return;
+    list<IRenderingView*>::iterator itr;
+    for(itr=vRenderingView.begin(); itr!=vRenderingView.end(); ++itr) {
+        IViewingVolume* volume = (*itr)->GetViewport().GetViewingVolume();
+        if (volume != NULL) volume->SignalRendering(deltaTime);
+        (*itr)->Render(this, root);
+    }
+    frames++;
+}
+
+void NullRenderer::Deinitialize() {}
+
+bool NullRenderer::IsTypeOf(const std::type_info& inf) {
+    return ((typeid(NullRenderer) == inf) || IRenderer::IsTypeOf(inf));
+}
+
+/**
+ * Count a face.
+ */
+void NullRenderer::DrawFace(FacePtr face, Vector<3,float> color, float width) {
+    faces++;
+}
+
+/**
+ * Count a line.
+ */
+void NullRenderer::DrawLine(Line line, Vector<3,float> color, float width) {
+    lines++;
+}
+
+/**
+ * Count a point.
+ */
+void NullRenderer::DrawPoint(Vector<3,float> point, Vector<3,float> color , float size) {
+    points++;
+}
+
+/**
+ * Reset the frame, face, line and point counters.
+ */
+void NullRenderer::ResetCounters() {
+    frames = faces = lines = points = 0;
+}
+
+/**
+ * Get the number of processed frames.
+ *
+ * @return Number of frames.
+ */
+unsigned int NullRenderer::GetNumberOfFrames() {
+    return frames;
+}
+
+/**
+ * Get the number of faces drawn with DrawFace().
+ *
+ * @return Number of faces.
+ */
+unsigned int NullRenderer::GetNumberOfFaces() {
+    return faces;
+}
+
+/**
+ * Get the number of lines drawn with DrawLine().
+ *
+ * @return Number of lines.
+ */
+unsigned int NullRenderer::GetNumberOfLines() {
+    return lines;
+}
+
+/**
+ * Get the number of points drawn with DrawPoint().
+ *
+ * @return Number of points.
+ */
+unsigned int NullRenderer::GetNumberOfPoints() {
+    return points;
+}
+
+} // NS Renderers
+} // NS OpenEngine
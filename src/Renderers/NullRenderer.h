@@ -0,0 +1,60 @@
+// Renderer without graphics output.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#ifndef _NULL_RENDERER_H_
+#define _NULL_RENDERER_H_
+
+#include <Renderers/IRenderer.h>
+
+namespace OpenEngine {
+namespace Renderers {
+
+/**
+ * Renderer without graphics output.
+ *
+ * The null renderer drives its rendering views like the OpenGL
+ * renderer does, but never touches a graphics library, so it runs
+ * without a window or rendering context. Together with
+ * RecordingRenderingView it makes scene traversal and draw call
+ * preparation measurable and testable on machines without a display.
+ *
+ * Unlike the OpenGL renderer every rendering view is rendered, also
+ * those whose viewport has no viewing volume. Lines, points and faces
+ * drawn through the renderer are counted.
+ *
+ * @class NullRenderer NullRenderer.h Renderers/NullRenderer.h
+ */
+class NullRenderer : public IRenderer {
+private:
+    unsigned int frames, faces, lines, points;
+
+public:
+    NullRenderer();
+    ~NullRenderer();
+
+    void Initialize();
+    void Process(const float deltaTime, const float percent);
+    void Deinitialize();
+    bool IsTypeOf(const std::type_info& inf);
+
+    void DrawFace(FacePtr face, Vector<3,float> color, float width = 1);
+    void DrawLine(Line line, Vector<3,float> color, float width = 1);
+    void DrawPoint(Vector<3,float> point, Vector<3,float> color , float size = 1);
+
+    void ResetCounters();
+    unsigned int GetNumberOfFrames();
+    unsigned int GetNumberOfFaces();
+    unsigned int GetNumberOfLines();
+    unsigned int GetNumberOfPoints();
+};
+
+} // NS Renderers
+} // NS OpenEngine
+
+#endif // _NULL_RENDERER_H_
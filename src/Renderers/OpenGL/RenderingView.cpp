@@ -9,8 +9,6 @@
 
 #include <Renderers/OpenGL/RenderingView.h>
 #include <Renderers/OpenGL/Renderer.h>
-#include <Renderers/IRenderNode.h>
-#include <Scene/GeometryNode.h>
 #include <Scene/TransformationNode.h>
 #include <Resources/IShaderResource.h>
 #include <Meta/OpenGL.h>
@@ -30,152 +28,171 @@ using namespace OpenEngine::Resources;
  * @param viewport Viewport in which to render.
  */
 RenderingView::RenderingView(Viewport& viewport)
-    : IRenderingView(viewport),
-      renderer(NULL) {
-    RenderStateNode* renderStateNode = new RenderStateNode();
-    renderStateNode->AddOptions(RenderStateNode::RENDER_TEXTURES);
-    renderStateNode->AddOptions(RenderStateNode::RENDER_SHADERS);
-    renderStateNode->AddOptions(RenderStateNode::RENDER_BACKFACES);
-    stateStack.push_back(renderStateNode);
-}
+    : IRenderingView(viewport), QueuedRenderingView(viewport) {}
 
 /**
  * Rendering view destructor.
  */
-RenderingView::~RenderingView() {
-
-}
+RenderingView::~RenderingView() {}
 
 /**
- * Get the renderer that the view is processing for.
- *
- * @return Current renderer, NULL if no renderer processing is active.
+ * Delete the buffer objects of a batch.
  */
-IRenderer* RenderingView::GetRenderer() {
-    return renderer;
+RenderingView::GLBatch::~GLBatch() {
+    if (vbo != 0) glDeleteBuffers(1, &vbo);
+    if (ibo != 0) glDeleteBuffers(1, &ibo);
 }
 
 /**
- * Renderer the scene.
+ * Build the vertex batch of a face set and upload it to buffer
+ * objects if supported.
  *
- * @param renderer a Renderer
- * @param root The scene to be rendered
+ * @param faces Face set to build the batch from.
+ * @return New batch.
  */
-void RenderingView::Render(IRenderer* renderer, ISceneNode* root) {
-    this->renderer = renderer;
-    root->Accept(*this);
-    this->renderer = NULL;
+QueuedRenderingView::Batch* RenderingView::CreateBatch(FaceSet* faces) {
+    GLBatch* b = new GLBatch();
+    b->batch.Build(*faces);
+    if (GLEW_VERSION_1_5 && faces->Size() > 0) {
+        // upload the batch, the cpu side copy is no longer needed
+        // except for the runs
+        glGenBuffers(1, &b->vbo);
+        glBindBuffer(GL_ARRAY_BUFFER, b->vbo);
+        glBufferData(GL_ARRAY_BUFFER, b->batch.vertices.size() * sizeof(float),
+                     &b->batch.vertices[0], GL_STATIC_DRAW);
+        glGenBuffers(1, &b->ibo);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, b->ibo);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, b->batch.indices.size() * sizeof(unsigned int),
+                     &b->batch.indices[0], GL_STATIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        vector<float>().swap(b->batch.vertices);
+        vector<unsigned int>().swap(b->batch.indices);
+    }
+    return b;
 }
 
 /**
- * Process a rendering node.
+ * Push the transformation of a node on the modelview matrix, for
+ * geometry drawn in immediate mode and debug lines.
  *
- * @param node Rendering node to apply.
+ * @param node Transformation node.
  */
-void RenderingView::VisitRenderNode(IRenderNode* node) {
-    node->Apply(this);
+void RenderingView::PushTransformation(TransformationNode* node) {
+    Matrix<4,4,float> m = node->GetTransformationMatrix();
+    float f[16];
+    m.ToArray(f);
+    glPushMatrix();
+    glMultMatrixf(f);
 }
 
 /**
- * Process a render state node.
+ * Pop the transformation of a node.
  *
- * @param node Render state node to apply.
+ * @param node Transformation node.
  */
-void RenderingView::VisitRenderStateNode(RenderStateNode* node) {
-    stateStack.push_back(node);
-    node->VisitSubNodes(*this);
-    stateStack.pop_back();
+void RenderingView::PopTransformation(TransformationNode* node) {
+    glPopMatrix();
 }
 
-/**
- * Process a transformation node.
- *
- * @param node Transformation node to apply.
- */
-void RenderingView::VisitTransformationNode(TransformationNode* node) {
-    // push transformation matrix
-    Matrix<4,4,float> m = node->GetTransformationMatrix();
-    float f[16];
-    m.ToArray(f);
-    glPushMatrix();
-    glMultMatrixf(f);
-    // traverse sub nodes
-    node->VisitSubNodes(*this);
-    // pop transformation matrix
-    glPopMatrix();
+// check an option in a set of render state options
+static inline bool HasOption(unsigned int options, RenderStateNode::RenderStateOption o) {
+    return (options & o) == (unsigned int)o;
 }
 
 /**
- * Process a geometry node.
+ * Apply the polygon mode and face culling of a set of render state
+ * options.
  *
- * @param node Geometry node to render
+ * @param options Render state options.
  */
-void RenderingView::VisitGeometryNode(GeometryNode* node) {
-
-    if( IsOptionSet(RenderStateNode::RENDER_WIREFRAMED) ) {
+void RenderingView::ApplyOptions(unsigned int options) {
+    if( HasOption(options, RenderStateNode::RENDER_WIREFRAMED) ) {
         glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
     } else
         glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 
     // Enable back-face culling, only faces facing towards the view is rendered.
-    if( IsOptionSet(RenderStateNode::RENDER_BACKFACES) )
+    if( HasOption(options, RenderStateNode::RENDER_BACKFACES) )
         glDisable(GL_CULL_FACE);
     else
         glEnable(GL_CULL_FACE);
+    stats.stateChanges++;
+}
 
-    // Remember last bound texture and shader
-    int currentTexture = 0;
-    IShaderResourcePtr currentShader;
-    int binormalid = -1; 
-    int tangentid = -1;
-    FaceList::iterator itr;
-    FaceSet* faces = node->GetFaceSet();
-    if (faces == NULL) return;
-
-    // for each face ...
-    for (itr = faces->begin(); itr != faces->end(); itr++) {
-        FacePtr f = (*itr);
+/**
+ * Apply the texture and shader of a face or material run.
+ * Texture and shader changes are only issued to GL when they differ
+ * from the current state.
+ *
+ * @param texr Texture resource.
+ * @param shad Shader resource.
+ * @param options Render state options in effect.
+ * @param state Current material state.
+ */
+void RenderingView::ApplyMaterial(ITextureResourcePtr texr, IShaderResourcePtr shad,
+                                  unsigned int options, MaterialState& state) {
+    // check if shaders should be applied
+    if (Renderer::IsGLSLSupported()) {
+
+        // if the shader changes release the old shader
+        if (state.shader != NULL && state.shader != shad) {
+            state.shader->ReleaseShader();
+            state.shader.reset();
+            stats.shaderChanges++;
+        }
 
-        // check if shaders should be applied
-        if (Renderer::IsGLSLSupported()) {
+        // check if a shader shall be applied
+        if (HasOption(options, RenderStateNode::RENDER_SHADERS) &&
+            shad != NULL &&                 // and the shader is not null
+            state.shader != shad) {         // and the shader is different from the current
+            // get the bi-normal and tangent ids
+            state.binormalid = shad->GetAttributeID("binormal");
+            state.tangentid = shad->GetAttributeID("tangent");
+            shad->ApplyShader();
+            // set the current shader
+            state.shader = shad;
+            stats.shaderChanges++;
+        }
+    }
 
-            // if the shader changes release the old shader
-            if (currentShader != NULL && currentShader != f->shad) {
-                currentShader->ReleaseShader();
-                currentShader.reset();
-            }
+    // if a shader is in use reset the current texture,
+    // but dont disable in GL because the shader may use textures. 
+    if (state.shader != NULL) state.texture = 0;
 
-            // check if a shader shall be applied
-            if (IsOptionSet(RenderStateNode::RENDER_SHADERS) &&
-                f->shad != NULL &&              // and the shader is not null
-                currentShader != f->shad) {     // and the shader is different from the current
-                // get the bi-normal and tangent ids
-                binormalid = f->shad->GetAttributeID("binormal");
-                tangentid = f->shad->GetAttributeID("tangent");
-                f->shad->ApplyShader();
-                // set the current shader
-                currentShader = f->shad;
-            }
-        }
+    // if the face has no texture reset the current texture 
+    else if (texr == NULL) {
+        glBindTexture(GL_TEXTURE_2D, 0); // @todo, remove this if not needed, release texture
+        glDisable(GL_TEXTURE_2D);
+        state.texture = 0;
+    }
 
-        // if a shader is in use reset the current texture,
-        // but dont disable in GL because the shader may use textures. 
-        if (currentShader != NULL) currentTexture = 0;
+    // check if texture shall be applied
+    else if (HasOption(options, RenderStateNode::RENDER_TEXTURES) &&
+             state.texture != texr->GetID()) {  // and face texture is different then the current one
+        state.texture = texr->GetID();
+        glEnable(GL_TEXTURE_2D);
+        glBindTexture(GL_TEXTURE_2D, state.texture);
+        stats.textureChanges++;
+    }
+}
 
-        // if the face has no texture reset the current texture 
-        else if (f->texr == NULL) {
-            glBindTexture(GL_TEXTURE_2D, 0); // @todo, remove this if not needed, release texture
-            glDisable(GL_TEXTURE_2D);
-            currentTexture = 0;
-        }
+/**
+ * Draw a face set in immediate mode.
+ *
+ * @param faces Face set to draw.
+ */
+void RenderingView::RenderImmediate(FaceSet* faces) {
+    MaterialState state;
+    unsigned int options = stateStack.back()->GetOptions();
+    ApplyOptions(options);
 
-        // check if texture shall be applied
-        else if (IsOptionSet(RenderStateNode::RENDER_TEXTURES) &&
-            currentTexture != f->texr->GetID()) {  // and face texture is different then the current one
-            currentTexture = f->texr->GetID();
-            glEnable(GL_TEXTURE_2D);
-            glBindTexture(GL_TEXTURE_2D, currentTexture);
-        }
+    // for each face ...
+    for (FaceList::iterator itr = faces->begin(); itr != faces->end(); itr++) {
+        FacePtr f = (*itr);
+        ApplyMaterial(f->texr, f->shad, options, state);
+        stats.drawCalls++;
+        stats.triangles++;
 
         glBegin(GL_TRIANGLES);
         // for each vertex ...
@@ -188,44 +205,170 @@ void RenderingView::VisitGeometryNode(GeometryNode* node) {
             glColor4f (c[0],c[1],c[2],c[3]);
             glNormal3f(n[0],n[1],n[2]);
             // apply tangent and binormal per vertex for the shader to use
-            if (currentShader != NULL) {
-                if (binormalid != -1)
-                    currentShader->VertexAttribute(binormalid, f->bino[i]);
-                if (tangentid != -1)
-                    currentShader->VertexAttribute(tangentid, f->tang[i]);
+            if (state.shader != NULL) {
+                if (state.binormalid != -1)
+                    state.shader->VertexAttribute(state.binormalid, f->bino[i]);
+                if (state.tangentid != -1)
+                    state.shader->VertexAttribute(state.tangentid, f->tang[i]);
             }
 			glVertex3f(v[0],v[1],v[2]);
         }
         glEnd();
-
-        // Render normal if enabled
-        GLboolean c = glIsEnabled(GL_COLOR);
-        GLboolean l = glIsEnabled(GL_LIGHTING);
- 		glEnable(GL_COLOR);
-        glDisable(GL_LIGHTING);
-
-        if (IsOptionSet(RenderStateNode::RENDER_BINORMALS))
-            RenderBinormals(f);
-        if (IsOptionSet(RenderStateNode::RENDER_TANGENTS))
-            RenderTangents(f);
-        if (IsOptionSet(RenderStateNode::RENDER_NORMALS))
-            RenderNormals(f);
-        if (IsOptionSet(RenderStateNode::RENDER_HARD_NORMAL))
-            RenderHardNormal(f);
-        if (c) glEnable(GL_COLOR);
-        if (l) glEnable(GL_LIGHTING);
     }
 
     // last we release the final shader
-    if (currentShader != NULL)
-        currentShader->ReleaseShader();
-
+    if (state.shader != NULL)
+        state.shader->ReleaseShader();
     // disable textures if it has been enabled
     glDisable(GL_TEXTURE_2D);
 }
 
-bool RenderingView::IsOptionSet(RenderStateNode::RenderStateOption o) {
-    return stateStack.back()->IsOptionSet(o);
+// enable or disable a generic vertex attribute array for the
+// supported shading language version
+static void VertexAttribArray(int id, bool enable, const float* pointer) {
+    if (Renderer::GetGLSLVersion() == GLSL_20) {
+        if (enable) {
+            glVertexAttribPointer(id, 3, GL_FLOAT, GL_FALSE,
+                                  VertexBatch::STRIDE * sizeof(float), pointer);
+            glEnableVertexAttribArray(id);
+        } else
+            glDisableVertexAttribArray(id);
+    } else {
+        if (enable) {
+            glVertexAttribPointerARB(id, 3, GL_FLOAT, GL_FALSE,
+                                     VertexBatch::STRIDE * sizeof(float), pointer);
+            glEnableVertexAttribArrayARB(id);
+        } else
+            glDisableVertexAttribArrayARB(id);
+    }
+}
+
+/**
+ * Draw the sorted render queue.
+ * Buffers, render state options and model matrices are only changed
+ * between items that differ, and the material state is carried over
+ * from item to item.
+ */
+void RenderingView::ExecuteQueue() {
+    const GLsizei stride = VertexBatch::STRIDE * sizeof(float);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_NORMAL_ARRAY);
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+
+    MaterialState state;
+    const GLBatch* b = NULL;
+    const float* vertices = NULL;
+    const unsigned int* indices = NULL;
+    const RenderItem* last = NULL;
+    bool pushed = false;
+
+    const vector<RenderItem>& items = queue.GetItems();
+    for (unsigned int i=0; i<items.size(); i++) {
+        const RenderItem& item = items[i];
+
+        // bind the vertex data, offsets into the buffer objects or
+        // pointers to the client arrays
+        if (item.geometry != b) {
+            b = static_cast<const GLBatch*>((const Batch*)item.geometry);
+            if (b->vbo != 0) {
+                glBindBuffer(GL_ARRAY_BUFFER, b->vbo);
+                glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, b->ibo);
+                vertices = NULL;
+                indices = NULL;
+            } else {
+                if (GLEW_VERSION_1_5) {
+                    glBindBuffer(GL_ARRAY_BUFFER, 0);
+                    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+                }
+                vertices = &b->batch.vertices[0];
+                indices = &b->batch.indices[0];
+            }
+            glVertexPointer(3, GL_FLOAT, stride, vertices + VertexBatch::POSITION);
+            glNormalPointer(GL_FLOAT, stride, vertices + VertexBatch::NORMAL);
+            glTexCoordPointer(2, GL_FLOAT, stride, vertices + VertexBatch::TEXCOORD);
+            glColorPointer(4, GL_FLOAT, stride, vertices + VertexBatch::COLOR);
+            stats.bufferChanges++;
+        }
+
+        if (last == NULL || item.options != last->options)
+            ApplyOptions(item.options);
+
+        // the modelview matrix holds the view matrix after the traversal
+        if (last == NULL || item.transform != last->transform) {
+            if (pushed) glPopMatrix();
+            float f[16];
+            Matrix<4,4,float> m = queue.GetTransform(item.transform);
+            m.ToArray(f);
+            glPushMatrix();
+            glMultMatrixf(f);
+            pushed = true;
+            stats.transformChanges++;
+        }
+
+        ApplyMaterial(item.texr, item.shad, item.options, state);
+        // bind tangent and binormal arrays for the shader to use
+        bool attributes = state.shader != NULL;
+        if (attributes && state.binormalid != -1)
+            VertexAttribArray(state.binormalid, true, vertices + VertexBatch::BINORMAL);
+        if (attributes && state.tangentid != -1)
+            VertexAttribArray(state.tangentid, true, vertices + VertexBatch::TANGENT);
+
+        glDrawElements(GL_TRIANGLES, item.count, GL_UNSIGNED_INT, indices + item.first);
+        stats.drawCalls++;
+        stats.triangles += item.count / 3;
+
+        if (attributes && state.binormalid != -1)
+            VertexAttribArray(state.binormalid, false, NULL);
+        if (attributes && state.tangentid != -1)
+            VertexAttribArray(state.tangentid, false, NULL);
+        last = &item;
+    }
+
+    // last we release the final shader
+    if (state.shader != NULL)
+        state.shader->ReleaseShader();
+    if (pushed) glPopMatrix();
+
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glDisableClientState(GL_NORMAL_ARRAY);
+    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+    glDisableClientState(GL_COLOR_ARRAY);
+    if (GLEW_VERSION_1_5) {
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    }
+    glDisable(GL_TEXTURE_2D);
+}
+
+/**
+ * Draw the normals, hard normals, tangents and binormals of a face
+ * set if enabled by the render state.
+ *
+ * @param faces Face set to draw lines for.
+ */
+void RenderingView::RenderDebugLines(FaceSet* faces) {
+    bool binormals = IsOptionSet(RenderStateNode::RENDER_BINORMALS);
+    bool tangents  = IsOptionSet(RenderStateNode::RENDER_TANGENTS);
+    bool normals   = IsOptionSet(RenderStateNode::RENDER_NORMALS);
+    bool hardNorm  = IsOptionSet(RenderStateNode::RENDER_HARD_NORMAL);
+    if (!(binormals || tangents || normals || hardNorm)) return;
+
+    // Render normal if enabled
+    GLboolean c = glIsEnabled(GL_COLOR);
+    GLboolean l = glIsEnabled(GL_LIGHTING);
+    glEnable(GL_COLOR);
+    glDisable(GL_LIGHTING);
+
+    for (FaceList::iterator itr = faces->begin(); itr != faces->end(); itr++) {
+        FacePtr f = (*itr);
+        if (binormals) RenderBinormals(f);
+        if (tangents)  RenderTangents(f);
+        if (normals)   RenderNormals(f);
+        if (hardNorm)  RenderHardNormal(f);
+    }
+    if (c) glEnable(GL_COLOR);
+    if (l) glEnable(GL_LIGHTING);
 }
 
 void RenderingView::RenderNormals(FacePtr face) {
@@ -10,10 +10,9 @@
 #ifndef _OPENGL_RENDERING_VIEW_H_
 #define _OPENGL_RENDERING_VIEW_H_
 
-#include <Geometry/FaceSet.h>
-#include <Renderers/IRenderingView.h>
-#include <Renderers/RenderStateNode.h>
-#include <vector>
+#include <Renderers/QueuedRenderingView.h>
+#include <Resources/ITextureResource.h>
+#include <Resources/IShaderResource.h>
 
 namespace OpenEngine {
 namespace Renderers {
@@ -22,30 +21,61 @@ namespace OpenGL {
 using namespace OpenEngine::Renderers;
 using namespace OpenEngine::Scene;
 using namespace OpenEngine::Geometry;
+using OpenEngine::Resources::ITextureResourcePtr;
+using OpenEngine::Resources::IShaderResourcePtr;
 using namespace std;
 
 /**
  * Concrete RenderingView using OpenGL.
+ *
+ * The traversal, culling, vertex batches and render queue are those
+ * of QueuedRenderingView. The batch of a node is kept in vertex
+ * buffer objects, or client side vertex arrays if buffer objects are
+ * unsupported, and the sorted queue is drawn with one draw call per
+ * material run, issuing shader, texture and transformation changes
+ * only when the state actually changes. With batching disabled the
+ * faces are drawn in immediate mode. The work done for the last
+ * frame is available from GetStatistics().
+ *
+ * Batches not drawn for BATCH_LIFETIME frames are deleted, which
+ * frees the buffer objects of deleted nodes.
  */
-class RenderingView : virtual public IRenderingView {
-    IRenderer* renderer;
-    vector<RenderStateNode*> stateStack;
+class RenderingView : public QueuedRenderingView {
+    // vertex batch of a geometry node and its buffer objects
+    struct GLBatch : public Batch {
+        unsigned int vbo;       // vertex buffer, 0 if not used
+        unsigned int ibo;       // index buffer, 0 if not used
+        GLBatch() : vbo(0), ibo(0) {}
+        ~GLBatch();
+    };
+
+    // material state while drawing a node
+    struct MaterialState {
+        int texture;
+        IShaderResourcePtr shader;
+        int binormalid;
+        int tangentid;
+        MaterialState() : texture(0), binormalid(-1), tangentid(-1) {}
+    };
+
+    Batch* CreateBatch(FaceSet* faces);
+    void PushTransformation(TransformationNode* node);
+    void PopTransformation(TransformationNode* node);
+    void RenderImmediate(FaceSet* faces);
+    void RenderDebugLines(FaceSet* faces);
+    void ExecuteQueue();
+    void ApplyOptions(unsigned int options);
+    void ApplyMaterial(ITextureResourcePtr texr, IShaderResourcePtr shad,
+                       unsigned int options, MaterialState& state);
 
     void RenderBinormals(FacePtr face);
     void RenderTangents(FacePtr face);
     void RenderNormals(FacePtr face);
     void RenderHardNormal(FacePtr face);
     void RenderLine(Vector<3,float> vert, Vector<3,float> norm, Vector<3,float> color);
-    bool IsOptionSet(RenderStateNode::RenderStateOption o);
 public:
     RenderingView(Viewport& viewport);
     virtual ~RenderingView();
-    void VisitGeometryNode(GeometryNode* node);
-    void VisitTransformationNode(TransformationNode* node);
-    void VisitRenderStateNode(RenderStateNode* node);
-    void VisitRenderNode(IRenderNode* node);
-    void Render(IRenderer* renderer, ISceneNode* root);
-    IRenderer* GetRenderer();
 };
 
 } // NS OpenGL
@@ -0,0 +1,358 @@
+// Rendering view queuing batched geometry.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#include <Renderers/QueuedRenderingView.h>
+#include <Renderers/IRenderNode.h>
+#include <Scene/GeometryNode.h>
+#include <Scene/TransformationNode.h>
+#include <Display/IViewingVolume.h>
+#include <Geometry/Box.h>
+
+namespace OpenEngine {
+namespace Renderers {
+
+using OpenEngine::Display::IViewingVolume;
+using OpenEngine::Geometry::Box;
+
+const unsigned int QueuedRenderingView::BATCH_LIFETIME;
+
+/**
+ * Queued rendering view constructor.
+ *
+ * @param viewport Viewport in which to render.
+ */
+QueuedRenderingView::QueuedRenderingView(Viewport& viewport)
+    : IRenderingView(viewport),
+      renderer(NULL), batching(true), culling(true), frame(0), volume(NULL) {
+    RenderStateNode* renderStateNode = new RenderStateNode();
+    renderStateNode->AddOptions(RenderStateNode::RENDER_TEXTURES);
+    renderStateNode->AddOptions(RenderStateNode::RENDER_SHADERS);
+    renderStateNode->AddOptions(RenderStateNode::RENDER_BACKFACES);
+    stateStack.push_back(renderStateNode);
+}
+
+/**
+ * Queued rendering view destructor.
+ */
+QueuedRenderingView::~QueuedRenderingView() {
+    InvalidateBatches();
+    delete stateStack.front();
+}
+
+/**
+ * Get the renderer that the view is processing for.
+ *
+ * @return Current renderer, NULL if no renderer processing is active.
+ */
+IRenderer* QueuedRenderingView::GetRenderer() {
+    return renderer;
+}
+
+/**
+ * Render the scene.
+ * The batched geometry is queued during the traversal, and the
+ * queue is sorted and executed when the traversal is done.
+ *
+ * @param renderer a Renderer
+ * @param root The scene to be rendered
+ */
+void QueuedRenderingView::Render(IRenderer* renderer, ISceneNode* root) {
+    this->renderer = renderer;
+    queue.Clear();
+    stats = RenderStatistics();
+    volume = viewport.GetViewingVolume();
+    view = (volume != NULL) ? volume->GetViewMatrix() : Matrix<4,4,float>();
+    modelStack.clear();
+    modelStack.push_back(Matrix<4,4,float>());
+    transformStack.clear();
+    transformStack.push_back(-1);
+
+    root->Accept(*this);
+
+    // draw the batched geometry in state order
+    if (queue.Size() > 0) {
+        queue.Sort();
+        ExecuteQueue();
+    }
+    lastStats = stats;
+    volume = NULL;
+    this->renderer = NULL;
+
+    // look for batches of deleted nodes once per lifetime
+    if (++frame % BATCH_LIFETIME == 0)
+        DeleteUnusedBatches();
+}
+
+/**
+ * Process a rendering node.
+ *
+ * @param node Rendering node to apply.
+ */
+void QueuedRenderingView::VisitRenderNode(IRenderNode* node) {
+    node->Apply(this);
+}
+
+/**
+ * Process a scene node.
+ *
+ * @param node Scene node to traverse.
+ */
+void QueuedRenderingView::VisitSceneNode(SceneNode* node) {
+    if (IsCulled(node)) return;
+    node->VisitSubNodes(*this);
+}
+
+/**
+ * Process a render state node.
+ *
+ * @param node Render state node to apply.
+ */
+void QueuedRenderingView::VisitRenderStateNode(RenderStateNode* node) {
+    if (IsCulled(node)) return;
+    stateStack.push_back(node);
+    node->VisitSubNodes(*this);
+    stateStack.pop_back();
+}
+
+/**
+ * Process a transformation node.
+ *
+ * @param node Transformation node to apply.
+ */
+void QueuedRenderingView::VisitTransformationNode(TransformationNode* node) {
+    if (IsCulled(node)) return;
+    PushTransformation(node);
+    // keep the model matrix for the queued geometry, it is added to
+    // the queue when the first geometry below the node is queued
+    modelStack.push_back(node->GetWorldMatrix());
+    transformStack.push_back(-1);
+    node->VisitSubNodes(*this);
+    transformStack.pop_back();
+    modelStack.pop_back();
+    PopTransformation(node);
+}
+
+/**
+ * Process a geometry node.
+ *
+ * @param node Geometry node to render.
+ */
+void QueuedRenderingView::VisitGeometryNode(GeometryNode* node) {
+    FaceSet* faces = node->GetFaceSet();
+    if (faces == NULL || IsCulled(node)) return;
+    stats.visibleNodes++;
+
+    // batched geometry gets its render state when the queue is executed
+    if (batching)
+        QueueBatch(node, faces);
+    else
+        RenderImmediate(faces);
+    RenderDebugLines(faces);
+}
+
+/**
+ * Enter a transformation node during the traversal.
+ * Does nothing by default, the model matrices of the queued
+ * geometry are kept by the view.
+ *
+ * @param node Transformation node.
+ */
+void QueuedRenderingView::PushTransformation(TransformationNode* node) {}
+
+/**
+ * Leave a transformation node during the traversal.
+ *
+ * @param node Transformation node.
+ */
+void QueuedRenderingView::PopTransformation(TransformationNode* node) {}
+
+/**
+ * Enable or disable drawing from vertex batches.
+ * When disabled geometry is drawn in immediate mode.
+ *
+ * @param enabled True to draw from vertex batches.
+ */
+void QueuedRenderingView::SetBatching(bool enabled) {
+    batching = enabled;
+}
+
+/**
+ * Is geometry drawn from vertex batches.
+ *
+ * @return True if batching is enabled.
+ */
+bool QueuedRenderingView::IsBatching() {
+    return batching;
+}
+
+/**
+ * Enable or disable view frustum culling.
+ * When disabled all sub trees are drawn.
+ *
+ * @param enabled True to cull against the viewing volume.
+ */
+void QueuedRenderingView::SetCulling(bool enabled) {
+    culling = enabled;
+}
+
+/**
+ * Are sub trees culled against the viewing volume.
+ *
+ * @return True if culling is enabled.
+ */
+bool QueuedRenderingView::IsCulling() {
+    return culling;
+}
+
+/**
+ * Check if a sub tree is outside the viewing volume.
+ * The bounds of the node are relative to the current model matrix.
+ * Sub trees without bounds have nothing to draw and are skipped
+ * without being counted as culled.
+ *
+ * @param node Root of the sub tree.
+ * @return True if the sub tree should not be traversed.
+ */
+bool QueuedRenderingView::IsCulled(ISceneNode* node) {
+    if (!culling || volume == NULL) return false;
+    Vector<3,float> min, max;
+    ISceneNode::BoundsType type = node->GetBounds(min, max);
+    if (type == ISceneNode::INFINITE_BOUNDS) return false;
+    if (type == ISceneNode::NO_BOUNDS) return true;
+    Box box((max + min) / 2, (max - min) / 2);
+    if (volume->IsVisible(box.GetTransformed(modelStack.back())))
+        return false;
+    stats.culledNodes++;
+    return true;
+}
+
+/**
+ * Discard the vertex batch of a geometry node.
+ * The batch is rebuilt the next time the node is drawn.
+ *
+ * @param node Geometry node.
+ */
+void QueuedRenderingView::InvalidateBatch(GeometryNode* node) {
+    map<GeometryNode*, Batch*>::iterator itr = batches.find(node);
+    if (itr == batches.end()) return;
+    delete itr->second;
+    batches.erase(itr);
+}
+
+/**
+ * Discard all vertex batches.
+ */
+void QueuedRenderingView::InvalidateBatches() {
+    map<GeometryNode*, Batch*>::iterator itr;
+    for (itr = batches.begin(); itr != batches.end(); itr++)
+        delete itr->second;
+    batches.clear();
+}
+
+/**
+ * Get the number of cached vertex batches.
+ *
+ * @return Number of batches.
+ */
+unsigned int QueuedRenderingView::GetNumberOfBatches() {
+    return batches.size();
+}
+
+/**
+ * Get the counters of the last rendered frame.
+ *
+ * @return Statistics of the last frame.
+ */
+RenderStatistics QueuedRenderingView::GetStatistics() {
+    return lastStats;
+}
+
+/**
+ * Delete the batches not drawn for BATCH_LIFETIME frames.
+ */
+void QueuedRenderingView::DeleteUnusedBatches() {
+    map<GeometryNode*, Batch*>::iterator itr = batches.begin();
+    while (itr != batches.end()) {
+        if (frame - itr->second->frame >= BATCH_LIFETIME) {
+            delete itr->second;
+            batches.erase(itr++);
+        } else
+            itr++;
+    }
+}
+
+/**
+ * Build the vertex batch of a face set.
+ * Subclasses may return a subclass of Batch holding the resources
+ * of the batch, which are then freed by its destructor.
+ *
+ * @param faces Face set to build the batch from.
+ * @return New batch.
+ */
+QueuedRenderingView::Batch* QueuedRenderingView::CreateBatch(FaceSet* faces) {
+    Batch* b = new Batch();
+    b->batch.Build(*faces);
+    return b;
+}
+
+/**
+ * Get the vertex batch of a geometry node, building it when the
+ * node is drawn the first time, its face set has changed or the
+ * batch was built for an earlier node at the same address.
+ *
+ * @param node Geometry node.
+ * @param faces Face set of the node.
+ * @return Batch of the node.
+ */
+QueuedRenderingView::Batch* QueuedRenderingView::GetBatch(GeometryNode* node,
+                                                          FaceSet* faces) {
+    Batch*& b = batches[node];
+    if (b != NULL && b->version == node->GetVersion() && b->size == faces->Size()) {
+        b->frame = frame;
+        return b;
+    }
+    delete b;
+    b = CreateBatch(faces);
+    b->version = node->GetVersion();
+    b->size = faces->Size();
+    b->frame = frame;
+    return b;
+}
+
+/**
+ * Add the material runs of a geometry node to the render queue.
+ *
+ * @param node Geometry node the faces belong to.
+ * @param faces Face set to draw.
+ */
+void QueuedRenderingView::QueueBatch(GeometryNode* node, FaceSet* faces) {
+    Batch* b = GetBatch(node, faces);
+    if (b->batch.runs.empty()) return;
+
+    // all geometry below a transformation shares its model matrix
+    Matrix<4,4,float> model = modelStack.back();
+    if (transformStack.back() == -1)
+        transformStack.back() = queue.AddTransform(model);
+    // the view looks down the negative z-axis
+    Matrix<4,4,float> modelView = model * view;
+    float depth = -modelView(3,2);
+    unsigned int options = stateStack.back()->GetOptions();
+
+    vector<SubMesh>::iterator run;
+    for (run = b->batch.runs.begin(); run != b->batch.runs.end(); run++)
+        queue.Add(run->shad, run->texr, depth, transformStack.back(),
+                  b, run->first, run->count, options);
+}
+
+bool QueuedRenderingView::IsOptionSet(RenderStateNode::RenderStateOption o) {
+    return stateStack.back()->IsOptionSet(o);
+}
+
+} // NS Renderers
+} // NS OpenEngine
@@ -0,0 +1,128 @@
+// Rendering view queuing batched geometry.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#ifndef _QUEUED_RENDERING_VIEW_H_
+#define _QUEUED_RENDERING_VIEW_H_
+
+#include <Geometry/FaceSet.h>
+#include <Renderers/IRenderingView.h>
+#include <Renderers/RenderStateNode.h>
+#include <Renderers/VertexBatch.h>
+#include <Renderers/RenderQueue.h>
+#include <Display/IViewingVolume.h>
+#include <vector>
+#include <map>
+
+namespace OpenEngine {
+namespace Renderers {
+
+using OpenEngine::Scene::GeometryNode;
+using OpenEngine::Scene::TransformationNode;
+using OpenEngine::Scene::SceneNode;
+using OpenEngine::Display::IViewingVolume;
+using OpenEngine::Geometry::FaceSet;
+using OpenEngine::Geometry::FacePtr;
+using std::vector;
+using std::map;
+
+/**
+ * Rendering view queuing batched geometry.
+ *
+ * The view implements the scene traversal shared by the rendering
+ * views: render state and transformation stacks, view frustum
+ * culling, the vertex batch cache and the render queue. Subclasses
+ * only submit the work, by executing the sorted queue and by drawing
+ * geometry in immediate mode when batching is disabled.
+ *
+ * The batch of a geometry node is built the first time the node is
+ * drawn, see CreateBatch(). A batch is rebuilt when the face set of
+ * the node changes size or the version of the node changes, see
+ * GeometryNode::GetVersion(). Every BATCH_LIFETIME frames the batches
+ * not drawn for that many frames are deleted. Each material run of a
+ * batch is added to the queue together with the world matrix of its
+ * transformation node, and the queue is sorted and executed when the
+ * traversal is done.
+ *
+ * Sub trees whose bounds are outside the viewing volume of the
+ * viewport are culled during the traversal and not visited at all.
+ * The bounds of a node are transformed to world space by the model
+ * matrix of the enclosing transformation node and tested against the
+ * volume as a box. Nodes with infinite bounds, such as render nodes,
+ * are never culled.
+ *
+ * @class QueuedRenderingView QueuedRenderingView.h Renderers/QueuedRenderingView.h
+ */
+class QueuedRenderingView : virtual public IRenderingView {
+protected:
+    // vertex batch of a geometry node
+    struct Batch {
+        unsigned long version;  // version of the node when built
+        int size;               // size of the face set when built
+        unsigned int frame;     // frame the batch was last drawn in
+        VertexBatch batch;      // the vertex data
+        virtual ~Batch() {}
+    };
+
+    IRenderer* renderer;
+    vector<RenderStateNode*> stateStack;
+    bool batching;
+    bool culling;
+    RenderQueue queue;                      // batched draw items
+    RenderStatistics stats;                 // counters of the current frame
+
+    virtual Batch* CreateBatch(FaceSet* faces);
+    virtual void PushTransformation(TransformationNode* node);
+    virtual void PopTransformation(TransformationNode* node);
+    virtual void RenderImmediate(FaceSet* faces) = 0;
+    virtual void RenderDebugLines(FaceSet* faces) = 0;
+    virtual void ExecuteQueue() = 0;
+    bool IsOptionSet(RenderStateNode::RenderStateOption o);
+
+private:
+    map<GeometryNode*, Batch*> batches;
+    unsigned int frame;                     // frames rendered
+    IViewingVolume* volume;                 // viewing volume of the frame
+    Matrix<4,4,float> view;                 // view matrix of the frame
+    vector<Matrix<4,4,float> > modelStack;  // model matrices of the traversal
+    vector<int> transformStack;             // queue index of the model matrices
+    RenderStatistics lastStats;             // counters of the last frame
+
+    Batch* GetBatch(GeometryNode* node, FaceSet* faces);
+    void DeleteUnusedBatches();
+    void QueueBatch(GeometryNode* node, FaceSet* faces);
+    bool IsCulled(ISceneNode* node);
+
+public:
+    //! Frames a batch is kept without being drawn.
+    static const unsigned int BATCH_LIFETIME = 300;
+
+    QueuedRenderingView(Viewport& viewport);
+    virtual ~QueuedRenderingView();
+    void VisitSceneNode(SceneNode* node);
+    void VisitGeometryNode(GeometryNode* node);
+    void VisitTransformationNode(TransformationNode* node);
+    void VisitRenderStateNode(RenderStateNode* node);
+    void VisitRenderNode(IRenderNode* node);
+    void Render(IRenderer* renderer, ISceneNode* root);
+    IRenderer* GetRenderer();
+
+    void SetBatching(bool enabled);
+    bool IsBatching();
+    void SetCulling(bool enabled);
+    bool IsCulling();
+    void InvalidateBatch(GeometryNode* node);
+    void InvalidateBatches();
+    unsigned int GetNumberOfBatches();
+    RenderStatistics GetStatistics();
+};
+
+} // NS Renderers
+} // NS OpenEngine
+
+#endif // _QUEUED_RENDERING_VIEW_H_
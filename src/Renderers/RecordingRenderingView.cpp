@@ -0,0 +1,112 @@
+// Rendering view recording draw calls.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#include <Renderers/RecordingRenderingView.h>
+
+namespace OpenEngine {
+namespace Renderers {
+
+using OpenEngine::Geometry::FaceList;
+using OpenEngine::Geometry::Line;
+
+/**
+ * Recording rendering view constructor.
+ *
+ * @param viewport Viewport in which to render.
+ */
+RecordingRenderingView::RecordingRenderingView(Viewport& viewport)
+    : IRenderingView(viewport), QueuedRenderingView(viewport) {}
+
+/**
+ * Recording rendering view destructor.
+ */
+RecordingRenderingView::~RecordingRenderingView() {}
+
+/**
+ * Get the sorted render queue of the last recorded frame.
+ * The queue is empty if batching is disabled.
+ *
+ * @return Render queue.
+ */
+const RenderQueue& RecordingRenderingView::GetQueue() {
+    return queue;
+}
+
+/**
+ * Count a transformation change in immediate mode.
+ *
+ * @param node Transformation node.
+ */
+void RecordingRenderingView::PushTransformation(TransformationNode* node) {
+    if (!batching) stats.transformChanges++;
+}
+
+/**
+ * Record the sorted render queue.
+ * The statistics are the state changes between the items.
+ */
+void RecordingRenderingView::ExecuteQueue() {
+    RenderStatistics counted = queue.CountStateChanges();
+    counted.visibleNodes = stats.visibleNodes;
+    counted.culledNodes = stats.culledNodes;
+    stats = counted;
+}
+
+/**
+ * Record a face set drawn in immediate mode.
+ *
+ * @param faces Face set to record.
+ */
+void RecordingRenderingView::RenderImmediate(FaceSet* faces) {
+    stats.stateChanges++;
+    IShaderResourcePtr shad;
+    ITextureResourcePtr texr;
+    for (FaceList::iterator itr = faces->begin(); itr != faces->end(); itr++) {
+        FacePtr f = (*itr);
+        if (f->shad != shad) stats.shaderChanges++;
+        if (f->texr != texr) stats.textureChanges++;
+        shad = f->shad;
+        texr = f->texr;
+        stats.drawCalls++;
+        stats.triangles++;
+    }
+}
+
+/**
+ * Draw the debug lines of a face set through the renderer if enabled
+ * by the render state.
+ *
+ * @param faces Face set to draw lines for.
+ */
+void RecordingRenderingView::RenderDebugLines(FaceSet* faces) {
+    if (renderer == NULL) return;
+    bool binormals = IsOptionSet(RenderStateNode::RENDER_BINORMALS);
+    bool tangents  = IsOptionSet(RenderStateNode::RENDER_TANGENTS);
+    bool normals   = IsOptionSet(RenderStateNode::RENDER_NORMALS);
+    bool hardNorm  = IsOptionSet(RenderStateNode::RENDER_HARD_NORMAL);
+    if (!(binormals || tangents || normals || hardNorm)) return;
+
+    Vector<3,float> c(1,1,1);
+    for (FaceList::iterator itr = faces->begin(); itr != faces->end(); itr++) {
+        FacePtr f = (*itr);
+        for (int i=0; i<3; i++) {
+            Vector<3,float> v = f->vert[i];
+            if (binormals) renderer->DrawLine(Line(v, v + f->bino[i]), c, 1);
+            if (tangents)  renderer->DrawLine(Line(v, v + f->tang[i]), c, 1);
+            if (normals)   renderer->DrawLine(Line(v, v + f->norm[i]), c, 1);
+        }
+        if (hardNorm) {
+            Vector<3,float> v = (f->vert[0] + f->vert[1] + f->vert[2]) / 3;
+            renderer->DrawLine(Line(v, v + f->hardNorm), c, 1);
+        }
+    }
+}
+
+} // NS Renderers
+} // NS OpenEngine
@@ -0,0 +1,52 @@
+// Rendering view recording draw calls.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#ifndef _RECORDING_RENDERING_VIEW_H_
+#define _RECORDING_RENDERING_VIEW_H_
+
+#include <Renderers/QueuedRenderingView.h>
+
+namespace OpenEngine {
+namespace Renderers {
+
+/**
+ * Rendering view recording draw calls.
+ *
+ * The view shares the traversal, culling, vertex batches and render
+ * queue of the OpenGL rendering view, see QueuedRenderingView, but
+ * records the work instead of issuing it to a graphics library.
+ * After a frame the sorted queue and the statistics of the draw
+ * calls, state changes and triangles the frame would have issued are
+ * available.
+ *
+ * With batching, the statistics are the state changes between the
+ * sorted items as counted by RenderQueue::CountStateChanges(). With
+ * batching disabled every face counts as a draw call, material
+ * changes are counted between consecutive faces and every
+ * transformation node and geometry node counts as a transformation
+ * and render state change respectively. The visible and culled node
+ * counts are kept in both modes.
+ *
+ * @class RecordingRenderingView RecordingRenderingView.h Renderers/RecordingRenderingView.h
+ */
+class RecordingRenderingView : public QueuedRenderingView {
+    void PushTransformation(TransformationNode* node);
+    void RenderImmediate(FaceSet* faces);
+    void RenderDebugLines(FaceSet* faces);
+    void ExecuteQueue();
+public:
+    RecordingRenderingView(Viewport& viewport);
+    virtual ~RecordingRenderingView();
+    const RenderQueue& GetQueue();
+};
+
+} // NS Renderers
+} // NS OpenEngine
+
+#endif // _RECORDING_RENDERING_VIEW_H_
@@ -0,0 +1,203 @@
+// State sorted render queue.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#include <Renderers/RenderQueue.h>
+#include <algorithm>
+
+namespace OpenEngine {
+namespace Renderers {
+
+// largest value of a key field
+static const unsigned int FIELD_MAX = 0xFFFF;
+
+// sort items on their key only, stable sorting keeps the insertion
+// order of equal keys
+static bool CompareKeys(const RenderItem& a, const RenderItem& b) {
+    return a.key < b.key;
+}
+
+// number a resource in order of appearance, zero is no resource
+template <class T>
+static unsigned int GetId(map<T*, unsigned int>& ids, T* resource) {
+    if (resource == NULL) return 0;
+    typename map<T*, unsigned int>::iterator itr = ids.find(resource);
+    if (itr != ids.end()) return itr->second;
+    unsigned int id = ids.size() + 1;
+    ids[resource] = id;
+    return id;
+}
+
+/**
+ * Create an empty queue.
+ * The default depth range matches the clipping planes used by the
+ * OpenGL renderer.
+ */
+RenderQueue::RenderQueue() : nearDepth(10.0f), farDepth(33000.0f) {}
+
+/**
+ * Remove all items, transformations and resource numbers.
+ */
+void RenderQueue::Clear() {
+    items.clear();
+    transforms.clear();
+    shaderIds.clear();
+    textureIds.clear();
+}
+
+/**
+ * Set the depth range mapped to the depth buckets.
+ * Depths outside the range are clamped.
+ *
+ * @param nearDepth Depth of the first bucket.
+ * @param farDepth Depth of the last bucket.
+ */
+void RenderQueue::SetDepthRange(const float nearDepth, const float farDepth) {
+    this->nearDepth = nearDepth;
+    this->farDepth = farDepth;
+}
+
+/**
+ * Add a model transformation.
+ *
+ * @param m Model transformation matrix.
+ * @return Index of the transformation for use with Add().
+ */
+unsigned int RenderQueue::AddTransform(const Matrix<4,4,float>& m) {
+    transforms.push_back(m);
+    return transforms.size() - 1;
+}
+
+/**
+ * Add a draw item.
+ *
+ * @param shad Shader resource, may be null.
+ * @param texr Texture resource, may be null.
+ * @param depth View depth of the item.
+ * @param transform Index of the model transformation.
+ * @param geometry Identity of the vertex data.
+ * @param first First index of the range to draw.
+ * @param count Number of indices to draw.
+ * @param options Render state options of the item.
+ */
+void RenderQueue::Add(IShaderResourcePtr shad, ITextureResourcePtr texr, const float depth,
+                      const unsigned int transform, const void* geometry,
+                      const unsigned int first, const unsigned int count,
+                      const unsigned int options) {
+    RenderItem item;
+    item.shad = shad;
+    item.texr = texr;
+    item.depth = depth;
+    item.transform = transform;
+    item.geometry = geometry;
+    item.first = first;
+    item.count = count;
+    item.options = options;
+    item.key = MakeKey(GetId(shaderIds, shad.get()),
+                       GetId(textureIds, texr.get()),
+                       GetDepthBucket(depth),
+                       transform);
+    items.push_back(item);
+}
+
+/**
+ * Sort the items on their keys.
+ */
+void RenderQueue::Sort() {
+    std::stable_sort(items.begin(), items.end(), CompareKeys);
+}
+
+/**
+ * Get the number of items.
+ *
+ * @return Number of items.
+ */
+unsigned int RenderQueue::Size() const {
+    return items.size();
+}
+
+/**
+ * Get the items in queue order.
+ *
+ * @return Draw items.
+ */
+const vector<RenderItem>& RenderQueue::GetItems() const {
+    return items;
+}
+
+/**
+ * Get a model transformation.
+ *
+ * @param index Index returned by AddTransform().
+ * @return Model transformation matrix.
+ */
+const Matrix<4,4,float>& RenderQueue::GetTransform(const unsigned int index) const {
+    return transforms[index];
+}
+
+/**
+ * Get the depth bucket of a view depth.
+ *
+ * @param depth View depth.
+ * @return Bucket number, zero is nearest.
+ */
+unsigned int RenderQueue::GetDepthBucket(const float depth) const {
+    if (!(depth > nearDepth)) return 0;
+    if (depth >= farDepth) return FIELD_MAX;
+    return (unsigned int)((depth - nearDepth) / (farDepth - nearDepth) * FIELD_MAX);
+}
+
+/**
+ * Count the state changes needed to execute the items in the
+ * current order. Only changes between consecutive items are counted,
+ * the first item counts as a change of each state it sets.
+ *
+ * @return Statistics of the queue.
+ */
+RenderStatistics RenderQueue::CountStateChanges() const {
+    RenderStatistics stats;
+    const RenderItem* last = NULL;
+    for (unsigned int i=0; i<items.size(); i++) {
+        const RenderItem& item = items[i];
+        stats.drawCalls++;
+        stats.triangles += item.count / 3;
+        if (last == NULL ? item.shad != NULL : item.shad != last->shad)
+            stats.shaderChanges++;
+        if (last == NULL ? item.texr != NULL : item.texr != last->texr)
+            stats.textureChanges++;
+        if (last == NULL || item.transform != last->transform)
+            stats.transformChanges++;
+        if (last == NULL || item.geometry != last->geometry)
+            stats.bufferChanges++;
+        if (last != NULL && item.options != last->options)
+            stats.stateChanges++;
+        last = &item;
+    }
+    return stats;
+}
+
+/**
+ * Compose a sort key.
+ * Fields larger than 16 bits are clamped.
+ *
+ * @param shader Shader number.
+ * @param texture Texture number.
+ * @param depth Depth bucket.
+ * @param transform Transformation index.
+ * @return 64-bit sort key.
+ */
+boost::uint64_t RenderQueue::MakeKey(const unsigned int shader, const unsigned int texture,
+                                     const unsigned int depth, const unsigned int transform) {
+    return ((boost::uint64_t)std::min(shader,    FIELD_MAX) << 48) |
+           ((boost::uint64_t)std::min(texture,   FIELD_MAX) << 32) |
+           ((boost::uint64_t)std::min(depth,     FIELD_MAX) << 16) |
+            (boost::uint64_t)std::min(transform, FIELD_MAX);
+}
+
+} // NS Renderers
+} // NS OpenEngine
@@ -0,0 +1,130 @@
+// State sorted render queue.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#ifndef _RENDER_QUEUE_H_
+#define _RENDER_QUEUE_H_
+
+#include <Resources/ITextureResource.h>
+#include <Resources/IShaderResource.h>
+#include <Math/Matrix.h>
+#include <boost/cstdint.hpp>
+#include <vector>
+#include <map>
+
+namespace OpenEngine {
+namespace Renderers {
+
+using OpenEngine::Resources::ITextureResourcePtr;
+using OpenEngine::Resources::IShaderResourcePtr;
+using OpenEngine::Resources::ITextureResource;
+using OpenEngine::Resources::IShaderResource;
+using OpenEngine::Math::Matrix;
+using std::vector;
+using std::map;
+
+/**
+ * Counters of the work done to render a frame.
+ *
+ * @class RenderStatistics RenderQueue.h Renderers/RenderQueue.h
+ */
+struct RenderStatistics {
+    unsigned int drawCalls;         //!< number of draw calls
+    unsigned int triangles;         //!< number of triangles drawn
+    unsigned int shaderChanges;     //!< shaders applied or released
+    unsigned int textureChanges;    //!< textures bound
+    unsigned int transformChanges;  //!< model matrices loaded
+    unsigned int bufferChanges;     //!< vertex buffers bound
+    unsigned int stateChanges;      //!< render state options applied
+    unsigned int visibleNodes;      //!< geometry nodes drawn
+    unsigned int culledNodes;       //!< sub trees culled by the viewing volume
+
+    RenderStatistics()
+        : drawCalls(0), triangles(0), shaderChanges(0), textureChanges(0),
+          transformChanges(0), bufferChanges(0), stateChanges(0),
+          visibleNodes(0), culledNodes(0) {}
+};
+
+/**
+ * Draw item of a render queue.
+ * The geometry is opaque to the queue, it is whatever the executing
+ * rendering view uses to identify the vertex data, and the index
+ * range is a range of that geometry.
+ *
+ * @class RenderItem RenderQueue.h Renderers/RenderQueue.h
+ */
+struct RenderItem {
+    boost::uint64_t key;        //!< sort key
+    IShaderResourcePtr shad;    //!< shader resource
+    ITextureResourcePtr texr;   //!< texture resource
+    const void* geometry;       //!< vertex data identity
+    unsigned int first;         //!< first index
+    unsigned int count;         //!< number of indices
+    unsigned int transform;     //!< model transformation index
+    unsigned int options;       //!< render state options
+    float depth;                //!< view depth
+};
+
+/**
+ * State sorted render queue.
+ *
+ * A rendering view fills the queue with draw items while traversing
+ * the scene, sorts it and then executes the items in order. Each item
+ * gets a 64-bit sort key composed of, from the most significant bits,
+ *
+ * - 16 bits shader,
+ * - 16 bits texture,
+ * - 16 bits depth bucket (front to back),
+ * - 16 bits transformation,
+ *
+ * so items are grouped by shader, then by texture, and within a
+ * material drawn front to back. Shaders and textures are numbered in
+ * the order they are first added to the queue, which makes the order
+ * deterministic. Items with equal keys keep the order they were
+ * added in.
+ *
+ * The queue does not use the graphics library, so it can be filled,
+ * sorted and inspected without a rendering context.
+ *
+ * @class RenderQueue RenderQueue.h Renderers/RenderQueue.h
+ */
+class RenderQueue {
+private:
+    vector<RenderItem> items;
+    vector<Matrix<4,4,float> > transforms;
+    map<IShaderResource*, unsigned int> shaderIds;
+    map<ITextureResource*, unsigned int> textureIds;
+    float nearDepth, farDepth;
+
+public:
+    RenderQueue();
+
+    void Clear();
+    void SetDepthRange(const float nearDepth, const float farDepth);
+
+    unsigned int AddTransform(const Matrix<4,4,float>& m);
+    void Add(IShaderResourcePtr shad, ITextureResourcePtr texr, const float depth,
+             const unsigned int transform, const void* geometry,
+             const unsigned int first, const unsigned int count,
+             const unsigned int options = 0);
+    void Sort();
+
+    unsigned int Size() const;
+    const vector<RenderItem>& GetItems() const;
+    const Matrix<4,4,float>& GetTransform(const unsigned int index) const;
+    unsigned int GetDepthBucket(const float depth) const;
+    RenderStatistics CountStateChanges() const;
+
+    static boost::uint64_t MakeKey(const unsigned int shader, const unsigned int texture,
+                                   const unsigned int depth, const unsigned int transform);
+};
+
+} // NS Renderers
+} // NS OpenEngine
+
+#endif // _RENDER_QUEUE_H_
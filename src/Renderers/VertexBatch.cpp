@@ -0,0 +1,102 @@
+// Interleaved vertex batch.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#include <Renderers/VertexBatch.h>
+#include <Geometry/FaceSet.h>
+
+namespace OpenEngine {
+namespace Renderers {
+
+// copy an optional attribute stream into the interleaved vertex,
+// using the default value if the stream is empty
+static inline void Interleave(float* dest, const vector<float>& stream,
+                              const unsigned int size, const unsigned int i,
+                              const float value) {
+    for (unsigned int k=0; k<size; k++)
+        dest[k] = stream.empty() ? value : stream[size*i+k];
+}
+
+/**
+ * Create an empty batch.
+ */
+VertexBatch::VertexBatch() {}
+
+/**
+ * Build the batch from a face set.
+ * Identical corners are shared and every run of faces with the same
+ * texture and shader becomes a run of the batch.
+ *
+ * @param faces Face set to build from.
+ */
+void VertexBatch::Build(FaceSet& faces) {
+    Mesh mesh(faces);
+    Build(mesh);
+}
+
+/**
+ * Build the batch from a mesh.
+ * Missing colors default to white and missing tangents and binormals
+ * to zero.
+ *
+ * @param mesh Mesh to build from.
+ */
+void VertexBatch::Build(const Mesh& mesh) {
+    unsigned int n = mesh.GetNumberOfVertices();
+    vertices.resize(n * STRIDE);
+    for (unsigned int i=0; i<n; i++) {
+        float* v = &vertices[i * STRIDE];
+        Interleave(v + POSITION, mesh.vertices,  3, i, 0);
+        Interleave(v + NORMAL,   mesh.normals,   3, i, 0);
+        Interleave(v + TEXCOORD, mesh.texcoords, 2, i, 0);
+        Interleave(v + COLOR,    mesh.colors,    4, i, 1);
+        Interleave(v + TANGENT,  mesh.tangents,  3, i, 0);
+        Interleave(v + BINORMAL, mesh.binormals, 3, i, 0);
+    }
+    indices = mesh.indices;
+    runs = mesh.subMeshes;
+}
+
+/**
+ * Release the batch data.
+ */
+void VertexBatch::Clear() {
+    vector<float>().swap(vertices);
+    vector<unsigned int>().swap(indices);
+    runs.clear();
+}
+
+/**
+ * Get the number of vertices.
+ *
+ * @return Number of vertices.
+ */
+unsigned int VertexBatch::GetNumberOfVertices() const {
+    return vertices.size() / STRIDE;
+}
+
+/**
+ * Get the number of triangles.
+ *
+ * @return Number of triangles.
+ */
+unsigned int VertexBatch::GetNumberOfTriangles() const {
+    return indices.size() / 3;
+}
+
+/**
+ * Get the size of the vertex and index data.
+ *
+ * @return Size in bytes.
+ */
+unsigned int VertexBatch::GetSizeInBytes() const {
+    return vertices.size() * sizeof(float) + indices.size() * sizeof(unsigned int);
+}
+
+} // NS Renderers
+} // NS OpenEngine
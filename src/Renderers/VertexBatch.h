@@ -0,0 +1,72 @@
+// Interleaved vertex batch.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#ifndef _VERTEX_BATCH_H_
+#define _VERTEX_BATCH_H_
+
+#include <Geometry/Mesh.h>
+#include <vector>
+
+namespace OpenEngine {
+
+// forward declaration
+namespace Geometry { class FaceSet; }
+
+namespace Renderers {
+
+using OpenEngine::Geometry::FaceSet;
+using OpenEngine::Geometry::Mesh;
+using OpenEngine::Geometry::SubMesh;
+using std::vector;
+
+/**
+ * Interleaved vertex batch.
+ *
+ * A batch holds the vertices of a mesh interleaved in a single float
+ * array, an index buffer and the material runs of the indices, which
+ * is what a renderer needs to draw the mesh from vertex arrays or
+ * buffer objects with one draw call per run. Building a batch does
+ * not touch the graphics library, so batches can be built and
+ * inspected without a rendering context.
+ *
+ * Each vertex consists of STRIDE floats laid out as given by the
+ * offset constants: position, normal, texture coordinate, color,
+ * tangent and binormal.
+ *
+ * @class VertexBatch VertexBatch.h Renderers/VertexBatch.h
+ */
+class VertexBatch {
+public:
+    static const unsigned int POSITION = 0;   //!< offset of the position
+    static const unsigned int NORMAL   = 3;   //!< offset of the normal
+    static const unsigned int TEXCOORD = 6;   //!< offset of the texture coordinate
+    static const unsigned int COLOR    = 8;   //!< offset of the color
+    static const unsigned int TANGENT  = 12;  //!< offset of the tangent
+    static const unsigned int BINORMAL = 15;  //!< offset of the binormal
+    static const unsigned int STRIDE   = 18;  //!< floats per vertex
+
+    vector<float> vertices;         //!< interleaved vertices
+    vector<unsigned int> indices;   //!< index buffer, 3 per triangle
+    vector<SubMesh> runs;           //!< material runs of the indices
+
+    VertexBatch();
+
+    void Build(FaceSet& faces);
+    void Build(const Mesh& mesh);
+    void Clear();
+
+    unsigned int GetNumberOfVertices() const;
+    unsigned int GetNumberOfTriangles() const;
+    unsigned int GetSizeInBytes() const;
+};
+
+} // NS Renderers
+} // NS OpenEngine
+
+#endif // _VERTEX_BATCH_H_
@@ -11,6 +11,7 @@
 #define _I_MODEL_RESOURCE_H_
 
 #include <Resources/IResource.h>
+#include <Geometry/Mesh.h>
 
 // forward declaration
 namespace OpenEngine { namespace Geometry { class FaceSet; } }
@@ -19,6 +20,7 @@ namespace OpenEngine {
 namespace Resources {
 
 using OpenEngine::Geometry::FaceSet;
+using OpenEngine::Geometry::MeshPtr;
 
 /**
  * Model resource interface.
@@ -29,8 +31,16 @@ class IModelResource : public IResource {
 public:
     /**
      * Get the face set of the model.
+     * The face set belongs to the resource and is only valid while
+     * the resource is loaded.
      */
     virtual FaceSet* GetFaceSet() = 0;
+
+    /**
+     * Get the model as an indexed mesh.
+     * Models that do not provide a mesh return a null pointer.
+     */
+    virtual MeshPtr GetMesh() { return MeshPtr(); }
 };
 
 /**
@@ -41,6 +41,17 @@ public:
      * Unload the resource.
      */
 	virtual void Unload() = 0;
+
+    /**
+     * Get the memory cost of the resource.
+     * Used by the resource manager to keep its caches within their
+     * memory budgets. Resources that do not know their cost report
+     * zero and are never evicted to meet a budget.
+     *
+     * @return Approximate size in bytes of the loaded resource, zero
+     *         when unloaded.
+     */
+    virtual unsigned int GetMemoryCost() { return 0; }
     
     /**
      * Default destructor.
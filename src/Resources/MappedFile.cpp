@@ -0,0 +1,102 @@
+// Read only memory mapped file.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS) 
+// 
+// This program is free software; It is covered by the GNU General 
+// Public License version 2 or any later version. 
+// See the GNU General Public License for more details (see LICENSE). 
+//--------------------------------------------------------------------
+
+#include <Resources/MappedFile.h>
+#include <Resources/Exceptions.h>
+
+#if defined(_WIN32)
+    #include <Windows.h>
+#else
+    #include <sys/types.h>
+    #include <sys/stat.h>
+    #include <sys/mman.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+namespace OpenEngine {
+namespace Resources {
+
+/**
+ * Map a file into memory.
+ *
+ * @param filename File to map.
+ * @throws ResourceException if the file can not be mapped.
+ */
+MappedFile::MappedFile(string filename) : data(NULL), size(0) {
+#if defined(_WIN32)
+    file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                       OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        throw ResourceException("File not found: " + filename);
+    size = GetFileSize(file, NULL);
+    mapping = NULL;
+    if (size == 0) return;
+    mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapping != NULL)
+        data = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (data == NULL) {
+        if (mapping != NULL) CloseHandle(mapping);
+        CloseHandle(file);
+        throw ResourceException("Failed mapping file: " + filename);
+    }
+#else
+    file = open(filename.c_str(), O_RDONLY);
+    if (file < 0)
+        throw ResourceException("File not found: " + filename);
+    struct stat info;
+    if (fstat(file, &info) != 0) {
+        close(file);
+        throw ResourceException("Failed reading file size: " + filename);
+    }
+    size = info.st_size;
+    if (size == 0) return;
+    void* map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, file, 0);
+    if (map == MAP_FAILED) {
+        close(file);
+        throw ResourceException("Failed mapping file: " + filename);
+    }
+    data = (const char*)map;
+#endif
+}
+
+/**
+ * Unmap the file.
+ */
+MappedFile::~MappedFile() {
+#if defined(_WIN32)
+    if (data != NULL) UnmapViewOfFile(data);
+    if (mapping != NULL) CloseHandle(mapping);
+    CloseHandle(file);
+#else
+    if (data != NULL) munmap((void*)data, size);
+    close(file);
+#endif
+}
+
+/**
+ * Get the mapped file contents.
+ *
+ * @return Pointer to the file data, NULL for empty files.
+ */
+const char* MappedFile::GetData() {
+    return data;
+}
+
+/**
+ * Get the file size.
+ *
+ * @return File size in bytes.
+ */
+unsigned int MappedFile::GetSize() {
+    return size;
+}
+
+} // NS Resources
+} // NS OpenEngine
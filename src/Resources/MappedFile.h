@@ -0,0 +1,59 @@
+// Read only memory mapped file.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS) 
+// 
+// This program is free software; It is covered by the GNU General 
+// Public License version 2 or any later version. 
+// See the GNU General Public License for more details (see LICENSE). 
+//--------------------------------------------------------------------
+
+#ifndef _MAPPED_FILE_H_
+#define _MAPPED_FILE_H_
+
+#include <string>
+
+namespace OpenEngine {
+namespace Resources {
+
+using std::string;
+
+/**
+ * Read only memory mapped file.
+ * The file is mapped in the constructor and unmapped when the object
+ * is destroyed.
+ *
+ * @code
+ * MappedFile file("mesh.bin");
+ * const char* data = file.GetData();
+ * for (unsigned int i=0; i<file.GetSize(); i++) ...
+ * @endcode
+ *
+ * @class MappedFile MappedFile.h Resources/MappedFile.h
+ */
+class MappedFile {
+private:
+    const char* data;   //!< mapped memory
+    unsigned int size;  //!< size of the mapping
+#if defined(_WIN32)
+    void* file;         //!< file handle
+    void* mapping;      //!< file mapping handle
+#else
+    int file;           //!< file descriptor
+#endif
+
+    // disallow copying
+    MappedFile(const MappedFile&);
+    MappedFile& operator=(const MappedFile&);
+
+public:
+    MappedFile(string filename);
+    ~MappedFile();
+
+    const char* GetData();
+    unsigned int GetSize();
+};
+
+} // NS Resources
+} // NS OpenEngine
+
+#endif // _MAPPED_FILE_H_
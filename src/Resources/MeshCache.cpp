@@ -0,0 +1,332 @@
+// Binary mesh cache.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS) 
+// 
+// This program is free software; It is covered by the GNU General 
+// Public License version 2 or any later version. 
+// See the GNU General Public License for more details (see LICENSE). 
+//--------------------------------------------------------------------
+
+#include <Resources/MeshCache.h>
+#include <Resources/MappedFile.h>
+#include <Resources/Exceptions.h>
+#include <Logging/Logger.h>
+#include <Utils/Hash.h>
+
+#include <boost/filesystem/operations.hpp>
+#include <boost/filesystem/exception.hpp>
+#include <boost/detail/atomic_count.hpp>
+#include <boost/thread/thread.hpp>
+#include <fstream>
+#include <sstream>
+#include <cstring>
+
+#if defined(_WIN32)
+    #include <process.h>
+    #define getpid _getpid
+#else
+    #include <unistd.h>
+#endif
+
+namespace OpenEngine {
+namespace Resources {
+
+using OpenEngine::Utils::Hash;
+namespace fs = boost::filesystem;
+
+const unsigned int MeshData::NONE;
+
+bool   MeshCache::enabled = true;
+string MeshCache::directory = "";
+
+// file layout, all fields are 32 bit aligned
+static const char MAGIC[8] = "OEMESH";
+// version 2: polygons are fan triangulated
+// version 3: 64 bit source size and material library stamps
+static const unsigned int VERSION = 3;
+static const unsigned int ENDIANNESS = 0x01020304;
+
+// temporary files written so far by this process
+static boost::detail::atomic_count temporaries(0);
+
+struct MeshCacheHeader {
+    char magic[8];
+    unsigned int version;
+    unsigned int byteOrder;
+    double mtime;              //!< source modification time
+    unsigned long long size;   //!< source size
+    unsigned int vertices;     //!< number of vertex floats
+    unsigned int normals;      //!< number of normal floats
+    unsigned int texcoords;    //!< number of texture coordinate floats
+    unsigned int faces;        //!< number of faces
+    unsigned int materials;    //!< number of materials
+    unsigned int libraries;    //!< number of material libraries
+};
+
+// modification time and size of a file the mesh was parsed from
+struct MeshCacheStamp {
+    double mtime;
+    unsigned long long size;
+};
+
+static MeshCacheStamp GetStamp(const string& file) {
+    MeshCacheStamp stamp;
+    stamp.mtime = (double)fs::last_write_time(file);
+    stamp.size = fs::file_size(file);
+    return stamp;
+}
+
+/**
+ * Clear all arrays.
+ */
+void MeshData::Clear() {
+    vertices.clear();
+    normals.clear();
+    texcoords.clear();
+    indices.clear();
+    faceMaterials.clear();
+    materials.clear();
+    libraries.clear();
+}
+
+/**
+ * Enable or disable the mesh cache.
+ * The cache is enabled by default.
+ *
+ * @param enabled True to enable the cache.
+ */
+void MeshCache::SetEnabled(bool enabled) {
+    MeshCache::enabled = enabled;
+}
+
+/**
+ * Is the mesh cache enabled.
+ *
+ * @return True if enabled.
+ */
+bool MeshCache::IsEnabled() {
+    return enabled;
+}
+
+/**
+ * Set the directory to keep cache files in.
+ *
+ * @param directory Cache directory ending with a slash, or the empty
+ *                  string to keep cache files next to their source.
+ */
+void MeshCache::SetDirectory(string directory) {
+    MeshCache::directory = directory;
+}
+
+/**
+ * Get the cache file of a source file.
+ *
+ * @param source Source file path.
+ * @return Cache file path.
+ */
+string MeshCache::GetCacheFile(string source) {
+    if (directory.empty())
+        return source + ".mesh";
+    // files with equal names in different directories must not
+    // collide, so the file name is prefixed by the path hash
+    std::ostringstream name;
+    name << directory << std::hex << Hash<string>()(source) << "_";
+    size_t i = source.rfind('/');
+    name << (i == string::npos ? source : source.substr(i+1)) << ".mesh";
+    return name.str();
+}
+
+// helpers for reading from the mapped file
+static bool ReadBytes(const char*& pos, const char* end, void* dest, unsigned int bytes) {
+    if ((unsigned int)(end - pos) < bytes) return false;
+    memcpy(dest, pos, bytes);
+    pos += bytes;
+    return true;
+}
+
+static bool ReadString(const char*& pos, const char* end, string& str) {
+    unsigned int length;
+    if (!ReadBytes(pos, end, &length, sizeof(length))) return false;
+    unsigned int padded = (length + 3) & ~3;
+    if ((unsigned int)(end - pos) < padded) return false;
+    str.assign(pos, length);
+    pos += padded;
+    return true;
+}
+
+template <class T>
+static bool ReadArray(const char*& pos, const char* end, vector<T>& array, unsigned int count) {
+    if ((unsigned int)(end - pos) / sizeof(T) < count) return false;
+    const T* first = (const T*)pos;
+    array.assign(first, first + count);
+    pos += count * sizeof(T);
+    return true;
+}
+
+/**
+ * Read a cached mesh.
+ * The cache file is only used if it was written from the current
+ * version of the source file and its material libraries.
+ *
+ * @param source Source file path.
+ * @param mesh Mesh data to fill.
+ * @return True if a valid cache file was read.
+ */
+bool MeshCache::Read(string source, MeshData& mesh) {
+    if (!enabled) return false;
+    string cache = GetCacheFile(source);
+    try {
+        if (!fs::exists(cache)) return false;
+        MappedFile file(cache);
+        const char* pos = file.GetData();
+        const char* end = pos + file.GetSize();
+
+        MeshCacheHeader header;
+        MeshCacheStamp stamp = GetStamp(source);
+        string path;
+        if (!ReadBytes(pos, end, &header, sizeof(header)) ||
+            memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 ||
+            header.version != VERSION ||
+            header.byteOrder != ENDIANNESS ||
+            header.mtime != stamp.mtime ||
+            header.size != stamp.size ||
+            !ReadString(pos, end, path) || path != source)
+            return false;
+
+        // a changed or removed material library makes the material
+        // table out of date
+        vector<string> libraries(header.libraries);
+        for (unsigned int i=0; i<header.libraries; i++) {
+            MeshCacheStamp cached;
+            if (!ReadString(pos, end, libraries[i]) ||
+                !ReadBytes(pos, end, &cached, sizeof(cached)))
+                return false;
+            stamp = GetStamp(libraries[i]);
+            if (cached.mtime != stamp.mtime || cached.size != stamp.size)
+                return false;
+        }
+
+        mesh.Clear();
+        mesh.libraries.swap(libraries);
+        bool ok = 
+            ReadArray(pos, end, mesh.vertices, header.vertices) &&
+            ReadArray(pos, end, mesh.normals, header.normals) &&
+            ReadArray(pos, end, mesh.texcoords, header.texcoords) &&
+            ReadArray(pos, end, mesh.indices, header.faces * 9) &&
+            ReadArray(pos, end, mesh.faceMaterials, header.faces);
+        mesh.materials.resize(header.materials);
+        for (unsigned int i=0; ok && i<header.materials; i++)
+            ok = ReadString(pos, end, mesh.materials[i].directory) &&
+                ReadString(pos, end, mesh.materials[i].texture) &&
+                ReadString(pos, end, mesh.materials[i].shader);
+        if (!ok) {
+            logger.warning << "Truncated mesh cache file: " << cache << logger.end;
+            mesh.Clear();
+        }
+        return ok;
+    } catch (fs::filesystem_error& e) {
+        return false;
+    } catch (ResourceException& e) {
+        return false;
+    }
+}
+
+// helpers for writing the cache file
+static void WriteString(std::ofstream& out, const string& str) {
+    static const char padding[4] = {0, 0, 0, 0};
+    unsigned int length = str.size();
+    out.write((const char*)&length, sizeof(length));
+    out.write(str.data(), length);
+    out.write(padding, ((length + 3) & ~3) - length);
+}
+
+// temporary file next to the cache file, unique to the process,
+// thread and write, so concurrent writers never share one
+static string GetTemporaryFile(const string& cache) {
+    std::ostringstream name;
+    name << cache << "." << getpid()
+         << "." << boost::this_thread::get_id()
+         << "." << ++temporaries << ".tmp";
+    return name.str();
+}
+
+template <class T>
+static void WriteArray(std::ofstream& out, const vector<T>& array) {
+    if (!array.empty())
+        out.write((const char*)&array[0], array.size() * sizeof(T));
+}
+
+/**
+ * Write a mesh to the cache.
+ * The file is written under a temporary name unique to the writer
+ * and renamed over the cache file when complete, so concurrent
+ * readers never see a partial file and concurrent writers never
+ * write the same file.
+ *
+ * @param source Source file path.
+ * @param mesh Parsed mesh data.
+ * @return True if the cache file was written.
+ */
+bool MeshCache::Write(string source, const MeshData& mesh) {
+    if (!enabled) return false;
+    string cache = GetCacheFile(source);
+    string tmp = GetTemporaryFile(cache);
+    try {
+        MeshCacheHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = VERSION;
+        header.byteOrder = ENDIANNESS;
+        MeshCacheStamp stamp = GetStamp(source);
+        header.mtime = stamp.mtime;
+        header.size = stamp.size;
+        header.vertices = mesh.vertices.size();
+        header.normals = mesh.normals.size();
+        header.texcoords = mesh.texcoords.size();
+        header.faces = mesh.faceMaterials.size();
+        header.materials = mesh.materials.size();
+        header.libraries = mesh.libraries.size();
+        vector<MeshCacheStamp> stamps;
+        for (unsigned int i=0; i<mesh.libraries.size(); i++)
+            stamps.push_back(GetStamp(mesh.libraries[i]));
+
+        std::ofstream out(tmp.c_str(), std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            logger.warning << "Could not write mesh cache file: " << tmp << logger.end;
+            return false;
+        }
+        out.write((const char*)&header, sizeof(header));
+        WriteString(out, source);
+        for (unsigned int i=0; i<mesh.libraries.size(); i++) {
+            WriteString(out, mesh.libraries[i]);
+            out.write((const char*)&stamps[i], sizeof(stamps[i]));
+        }
+        WriteArray(out, mesh.vertices);
+        WriteArray(out, mesh.normals);
+        WriteArray(out, mesh.texcoords);
+        WriteArray(out, mesh.indices);
+        WriteArray(out, mesh.faceMaterials);
+        for (unsigned int i=0; i<mesh.materials.size(); i++) {
+            WriteString(out, mesh.materials[i].directory);
+            WriteString(out, mesh.materials[i].texture);
+            WriteString(out, mesh.materials[i].shader);
+        }
+        out.close();
+        if (out.fail()) {
+            fs::remove(tmp);
+            logger.warning << "Could not write mesh cache file: " << tmp << logger.end;
+            return false;
+        }
+        // replaces the cache file in one step
+        fs::rename(tmp, cache);
+        return true;
+    } catch (fs::filesystem_error& e) {
+        boost::system::error_code ignored;
+        fs::remove(tmp, ignored);
+        logger.warning << "Could not write mesh cache file: " << e.what() << logger.end;
+        return false;
+    }
+}
+
+} // NS Resources
+} // NS OpenEngine
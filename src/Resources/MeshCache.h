@@ -0,0 +1,91 @@
+// Binary mesh cache.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS) 
+// 
+// This program is free software; It is covered by the GNU General 
+// Public License version 2 or any later version. 
+// See the GNU General Public License for more details (see LICENSE). 
+//--------------------------------------------------------------------
+
+#ifndef _MESH_CACHE_H_
+#define _MESH_CACHE_H_
+
+#include <string>
+#include <vector>
+
+namespace OpenEngine {
+namespace Resources {
+
+using std::string;
+using std::vector;
+
+/**
+ * Material of a parsed mesh.
+ * Holds the resource file names, the resources are created when the
+ * mesh is turned into a face set.
+ */
+struct MeshMaterial {
+    string directory; //!< directory of the material file
+    string texture;   //!< texture file or empty
+    string shader;    //!< shader file or empty
+};
+
+/**
+ * Parsed mesh data.
+ * The attribute arrays are flat float arrays. Each face has nine
+ * zero based indices, vertex, texture coordinate and normal for each
+ * of its three corners, where NONE marks a missing attribute.
+ */
+struct MeshData {
+    //! Index of a missing attribute or material.
+    static const unsigned int NONE = 0xFFFFFFFF;
+
+    vector<float> vertices;            //!< 3 floats per vertex
+    vector<float> normals;             //!< 3 floats per normal
+    vector<float> texcoords;           //!< 2 floats per texture coordinate
+    vector<unsigned int> indices;      //!< 9 indices per face
+    vector<unsigned int> faceMaterials;//!< material index per face
+    vector<MeshMaterial> materials;    //!< material table
+    vector<string> libraries;          //!< material library files read
+
+    void Clear();
+};
+
+/**
+ * Binary mesh cache.
+ *
+ * Parsed meshes are stored in a compact binary file keyed on the
+ * path, modification time and size of the source file and of the
+ * material libraries it was parsed with. The cache
+ * file is memory mapped when read and its arrays are copied straight
+ * into the mesh data, so loading a cached mesh involves no text
+ * parsing, but the data is still copied once.
+ *
+ * By default the cache file is placed next to the source as
+ * "<source>.mesh". Use SetDirectory() to keep the cache files
+ * elsewhere, for instance when the data directory is read only.
+ *
+ * The files are written in native byte order and are rejected, and
+ * rewritten, on machines of a different byte order.
+ *
+ * @class MeshCache MeshCache.h Resources/MeshCache.h
+ */
+class MeshCache {
+private:
+    static bool enabled;
+    static string directory;
+
+public:
+    static void SetEnabled(bool enabled);
+    static bool IsEnabled();
+    static void SetDirectory(string directory);
+    static string GetCacheFile(string source);
+
+    static bool Read(string source, MeshData& mesh);
+    static bool Write(string source, const MeshData& mesh);
+};
+
+} // NS Resources
+} // NS OpenEngine
+
+#endif // _MESH_CACHE_H_
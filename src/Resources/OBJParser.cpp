@@ -0,0 +1,799 @@
+// Tokenizer based OBJ parser.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS) 
+// 
+// This program is free software; It is covered by the GNU General 
+// Public License version 2 or any later version. 
+// See the GNU General Public License for more details (see LICENSE). 
+//--------------------------------------------------------------------
+
+#include <Resources/OBJParser.h>
+#include <Resources/MappedFile.h>
+#include <Resources/File.h>
+#include <Logging/Logger.h>
+#include <Utils/Convert.h>
+#include <Utils/TaskScheduler.h>
+#include <boost/bind.hpp>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+
+namespace OpenEngine {
+namespace Resources {
+
+using OpenEngine::Utils::Convert;
+using OpenEngine::Utils::TaskScheduler;
+using OpenEngine::Utils::TaskGroup;
+
+// smallest chunk worth a thread of its own
+static const unsigned int MIN_CHUNK = 64 * 1024;
+
+// TOKENIZER
+
+// powers of ten exactly representable as floats
+static const float POW10[] = {
+    1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f
+};
+
+// largest integer below which all integers are exact floats
+static const double MAX_EXACT = 16777216.0;
+
+static inline bool IsBlank(const char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+static inline bool IsSpace(const char c) {
+    return IsBlank(c) || c == '\n';
+}
+
+static inline bool IsDigit(const char c) {
+    return c >= '0' && c <= '9';
+}
+
+/**
+ * Skip blanks and line continuations.
+ */
+static inline void SkipBlanks(const char*& pos, const char* end, int& line) {
+    while (pos < end) {
+        if (IsBlank(*pos))
+            pos++;
+        else if (*pos == '\\' && pos+1 < end && (pos[1] == '\n' || pos[1] == '\r')) {
+            pos++;
+            if (*pos == '\r') pos++;
+            if (pos < end && *pos == '\n') pos++;
+            line++;
+        } else
+            break;
+    }
+}
+
+/**
+ * Skip to the newline ending the current line.
+ */
+static inline void SkipLine(const char*& pos, const char* end) {
+    const char* nl = (const char*)memchr(pos, '\n', end - pos);
+    pos = nl ? nl : end;
+}
+
+/**
+ * Is the position at the end of the declaration.
+ */
+static inline bool AtLineEnd(const char* pos, const char* end) {
+    return pos >= end || *pos == '\n' || *pos == '#';
+}
+
+/**
+ * Read a token ending at a space.
+ */
+static inline string ReadToken(const char*& pos, const char* end) {
+    const char* start = pos;
+    while (pos < end && !IsSpace(*pos)) pos++;
+    return string(start, pos - start);
+}
+
+/**
+ * Parse a float.
+ * Decimal numbers whose digits form an integer of at most 2^24 and
+ * whose power of ten is at most 10^10 are exact floats on both sides
+ * of a single float multiplication or division, so the result is
+ * correctly rounded. Other numbers fall back to strtof, which gives
+ * the same result as sscanf("%f").
+ */
+static bool ParseFloat(const char*& pos, const char* end, float& value) {
+    const char* p = pos;
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) negative = *p++ == '-';
+
+    double mantissa = 0;
+    int exponent = 0, significant = 0;
+    bool exact = true, digits = false;
+    for (; p < end && IsDigit(*p); p++) {
+        digits = true;
+        if (significant < 15) {
+            mantissa = mantissa * 10 + (*p - '0');
+            if (mantissa != 0) significant++;
+        } else {
+            exponent++;
+            exact = false;
+        }
+    }
+    if (p < end && *p == '.') {
+        for (p++; p < end && IsDigit(*p); p++) {
+            digits = true;
+            if (significant < 15) {
+                mantissa = mantissa * 10 + (*p - '0');
+                exponent--;
+                if (mantissa != 0) significant++;
+            } else if (*p != '0')
+                exact = false;
+        }
+    }
+    if (!digits) return false;
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        p++;
+        bool negexp = false;
+        if (p < end && (*p == '-' || *p == '+')) negexp = *p++ == '-';
+        if (p == end || !IsDigit(*p)) return false;
+        int e = 0;
+        for (; p < end && IsDigit(*p); p++)
+            if (e < 10000) e = e * 10 + (*p - '0');
+        exponent += negexp ? -e : e;
+    }
+    if (p < end && !IsSpace(*p)) return false;
+
+    if (exact && mantissa <= MAX_EXACT && exponent >= -10 && exponent <= 10) {
+        float f = (float)mantissa;
+        f = exponent < 0 ? f / POW10[-exponent] : f * POW10[exponent];
+        value = negative ? -f : f;
+    } else {
+        // long or extreme numbers are left to the C library
+        char buf[64];
+        string str;
+        const char* number = buf;
+        unsigned int length = p - pos;
+        if (length < sizeof(buf)) {
+            memcpy(buf, pos, length);
+            buf[length] = '\0';
+        } else {
+            str.assign(pos, length);
+            number = str.c_str();
+        }
+        value = strtof(number, NULL);
+    }
+    pos = p;
+    return true;
+}
+
+/**
+ * Parse a signed integer.
+ *
+ * @return False if malformed or out of range.
+ */
+static inline bool ParseInt(const char*& pos, const char* end, int& value) {
+    const char* p = pos;
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) negative = *p++ == '-';
+    if (p == end || !IsDigit(*p)) return false;
+    int v = 0;
+    for (; p < end && IsDigit(*p); p++) {
+        int digit = *p - '0';
+        if (v > (INT_MAX - digit) / 10) return false;
+        v = v * 10 + digit;
+    }
+    value = negative ? -v : v;
+    pos = p;
+    return true;
+}
+
+/**
+ * Resolve an OBJ index, one based or negative relative to the end.
+ */
+static inline bool ResolveIndex(const int index, const unsigned int count, unsigned int& result) {
+    if (index > 0 && (unsigned int)index <= count)
+        result = index - 1;
+    else if (index < 0 && (unsigned int)-index <= count)
+        result = count + index;
+    else
+        return false;
+    return true;
+}
+
+static inline bool EqualVertices(const MeshData& mesh, unsigned int a, unsigned int b) {
+    return a == b || (mesh.vertices[3*a]   == mesh.vertices[3*b] &&
+                      mesh.vertices[3*a+1] == mesh.vertices[3*b+1] &&
+                      mesh.vertices[3*a+2] == mesh.vertices[3*b+2]);
+}
+
+/**
+ * Read the corners of a face declaration.
+ * The position is just after the "f" keyword. Each corner is stored
+ * as three raw OBJ indices, with zero for a missing index.
+ *
+ * @return False if the face declaration is malformed.
+ */
+static bool ReadCorners(const char*& pos, const char* end, int& line,
+                        vector<int>& corners) {
+    corners.clear();
+    for (;;) {
+        SkipBlanks(pos, end, line);
+        if (AtLineEnd(pos, end)) break;
+        // corner: v, v/t, v//n or v/t/n
+        int index[3] = { 0, 0, 0 };
+        for (int i=0; i<3; i++) {
+            if (i > 0) {
+                if (pos == end || *pos != '/') break;
+                pos++;
+                if (i == 1 && pos < end && *pos == '/') continue;
+            }
+            if (!ParseInt(pos, end, index[i]) || index[i] == 0) return false;
+        }
+        if (pos < end && !IsSpace(*pos)) return false;
+        corners.insert(corners.end(), index, index+3);
+    }
+    return corners.size() >= 9;
+}
+
+/**
+ * Resolve, validate and triangulate a face.
+ * The resulting triangles are appended to the index and material
+ * lists, problems are reported to the sink.
+ * The sink also provides the scratch vector for resolved indices.
+ *
+ * @param corners Raw corner indices as read by ReadCorners.
+ * @param count Number of vertices, texture coordinates and normals
+ *              declared before the face.
+ * @param mesh Mesh holding the vertex and normal data.
+ * @param material Material of the face.
+ */
+template <class S>
+static void AddFace(const vector<int>& corners, const unsigned int count[3],
+                    const MeshData& mesh, const unsigned int material,
+                    vector<unsigned int>& indices,
+                    vector<unsigned int>& faceMaterials, S& sink) {
+    unsigned int n = corners.size() / 3;
+    vector<unsigned int>& resolved = sink.resolved;
+    resolved.resize(corners.size());
+    for (unsigned int i=0; i<3*n; i++) {
+        if (corners[i] == 0)
+            resolved[i] = MeshData::NONE;
+        else if (!ResolveIndex(corners[i], count[i%3], resolved[i])) {
+            sink.Error("Face index out of range");
+            return;
+        }
+    }
+
+    // fan triangulation around the first corner
+    for (unsigned int i=1; i+1<n; i++) {
+        const unsigned int* c[3] = { &resolved[0], &resolved[3*i], &resolved[3*(i+1)] };
+        // test for valid face
+        if (EqualVertices(mesh, c[0][0], c[1][0]) ||
+            EqualVertices(mesh, c[1][0], c[2][0]) ||
+            EqualVertices(mesh, c[0][0], c[2][0])) {
+            sink.Error("Two or more vertices in face are equal");
+            continue;
+        }
+        // check against invalid normals
+        for (int j=0; j<3; j++) {
+            unsigned int k = c[j][2];
+            if (k != MeshData::NONE && mesh.normals[3*k] == 0 &&
+                mesh.normals[3*k+1] == 0 && mesh.normals[3*k+2] == 0)
+                sink.Error("norm["+Convert::int2string(j)+"] is the zero vector.");
+        }
+        for (int j=0; j<3; j++)
+            indices.insert(indices.end(), c[j], c[j]+3);
+        faceMaterials.push_back(material);
+    }
+}
+
+/**
+ * Tokenize OBJ data and pass the declarations to a sink.
+ * The sink receives vertex attributes, faces (as raw corners),
+ * material declarations and errors in file order.
+ *
+ * @param begin Start of the OBJ data.
+ * @param end End of the OBJ data.
+ * @param directory Directory material libraries are relative to.
+ * @param sink Receiver of the declarations.
+ */
+template <class S>
+static void Tokenize(const char* begin, const char* end,
+                     const string& directory, S& sink) {
+    float f[3];
+    int& line = sink.line;
+    for (const char* pos = begin; pos < end; pos++, line++) {
+        SkipBlanks(pos, end, line);
+        if (AtLineEnd(pos, end)) {
+            SkipLine(pos, end);
+            continue;
+        }
+
+        const char* key = pos;
+        while (pos < end && !IsSpace(*pos)) pos++;
+        unsigned int length = pos - key;
+        SkipBlanks(pos, end, line);
+
+        // vertex, texture coordinate and normal
+        if (key[0] == 'v' && (length == 1 ||
+                              (length == 2 && (key[1] == 't' || key[1] == 'n')))) {
+            const char type = length == 1 ? 'v' : key[1];
+            const int n = type == 't' ? 2 : 3;
+            bool valid = true;
+            for (int i=0; i<n && valid; i++) {
+                SkipBlanks(pos, end, line);
+                valid = ParseFloat(pos, end, f[i]);
+            }
+            // extra values (w coordinates, vertex colors) are ignored
+            if (!valid)
+                sink.Error(type == 'v' ? "Invalid vertex" :
+                           type == 't' ? "Invalid texture coordinate" : "Invalid vertex normal");
+            else if (type == 'v')
+                sink.vertices.insert(sink.vertices.end(), f, f+3);
+            else if (type == 't')
+                sink.texcoords.insert(sink.texcoords.end(), f, f+2);
+            else
+                sink.normals.insert(sink.normals.end(), f, f+3);
+        }
+
+        // face
+        else if (length == 1 && key[0] == 'f') {
+            if (!ReadCorners(pos, end, line, sink.corners))
+                sink.Error("Invalid face");
+            else
+                sink.Face();
+        }
+
+        // groups, smoothing groups and object names are ignored
+        else if (length == 1 && (key[0] == 'g' || key[0] == 's' || key[0] == 'o'))
+            ;
+
+        // material resources
+        else if (length == 6 && strncmp(key, "mtllib", 6) == 0) {
+            while (!AtLineEnd(pos, end)) {
+                sink.MaterialLibrary(directory + ReadToken(pos, end));
+                SkipBlanks(pos, end, line);
+            }
+        }
+
+        // material elements
+        else if (length == 6 && strncmp(key, "usemtl", 6) == 0)
+            sink.UseMaterial(ReadToken(pos, end));
+
+        // unsupported or invalid lines
+        else sink.Error("Unsupported OBJ declaration");
+
+        SkipLine(pos, end);
+    }
+}
+
+// SINKS
+
+/**
+ * Sink building the mesh directly.
+ */
+class OBJParser::SerialSink {
+public:
+    OBJParser& parser;
+    MeshData& mesh;
+    vector<float>& vertices;
+    vector<float>& texcoords;
+    vector<float>& normals;
+    vector<int> corners;
+    vector<unsigned int> resolved;
+    int line;
+
+    SerialSink(OBJParser& parser, MeshData& mesh)
+        : parser(parser), mesh(mesh), vertices(mesh.vertices),
+          texcoords(mesh.texcoords), normals(mesh.normals), line(1) {}
+
+    void Error(string msg) {
+        parser.line = line;
+        parser.Error(msg);
+    }
+
+    void Face() {
+        unsigned int count[3] = { (unsigned int)vertices.size() / 3,
+                                  (unsigned int)texcoords.size() / 2,
+                                  (unsigned int)normals.size() / 3 };
+        AddFace(corners, count, mesh, parser.material,
+                mesh.indices, mesh.faceMaterials, *this);
+    }
+
+    void MaterialLibrary(string mtlfile) {
+        parser.line = line;
+        parser.ParseMaterialFile(mtlfile, mesh);
+    }
+
+    void UseMaterial(string name) {
+        parser.line = line;
+        parser.UseMaterial(name);
+    }
+};
+
+/**
+ * Sink recording a chunk of the file.
+ * Line numbers and attribute counts are local to the chunk until the
+ * chunks are merged.
+ */
+class OBJParser::Chunk {
+public:
+    //! A face waiting for its indices to be resolved.
+    struct Polygon {
+        unsigned int first;     //!< first raw index
+        unsigned int size;      //!< number of raw indices
+        unsigned int count[3];  //!< local attribute counts
+        int line;               //!< local line number
+    };
+
+    //! A material declaration to replay in file order.
+    struct Statement {
+        unsigned int polygon;   //!< number of polygons before it
+        bool library;           //!< mtllib or usemtl
+        string name;            //!< file or material name
+        int line;               //!< local line number
+        unsigned int material;  //!< resolved material of usemtl
+    };
+
+    //! A buffered warning.
+    struct Message {
+        int line;
+        string text;
+    };
+
+    const char* begin;
+    const char* end;
+    string directory;
+    vector<float> vertices;
+    vector<float> texcoords;
+    vector<float> normals;
+    vector<int> corners;
+    vector<unsigned int> resolved;
+    vector<int> raw;
+    vector<Polygon> polygons;
+    vector<Statement> statements;
+    vector<Message> messages;
+    vector<unsigned int> indices;
+    vector<unsigned int> faceMaterials;
+    unsigned int base[3];       //!< attribute counts before the chunk
+    unsigned int material;      //!< material at the start of the chunk
+    const MeshData* mesh;       //!< merged mesh used when resolving
+    int first;                  //!< lines before the chunk
+    int line;                   //!< current local line
+
+    Chunk() : material(MeshData::NONE), mesh(NULL), first(0), line(0) {}
+
+    void Error(string msg) {
+        Message m;
+        m.line = line;
+        m.text = msg;
+        messages.push_back(m);
+    }
+
+    void Face() {
+        Polygon p;
+        p.first = raw.size();
+        p.size = corners.size();
+        p.count[0] = vertices.size() / 3;
+        p.count[1] = texcoords.size() / 2;
+        p.count[2] = normals.size() / 3;
+        p.line = line;
+        raw.insert(raw.end(), corners.begin(), corners.end());
+        polygons.push_back(p);
+    }
+
+    void MaterialLibrary(string mtlfile) {
+        AddStatement(true, mtlfile);
+    }
+
+    void UseMaterial(string name) {
+        AddStatement(false, name);
+    }
+
+    void AddStatement(bool library, string name) {
+        Statement s;
+        s.polygon = polygons.size();
+        s.library = library;
+        s.name = name;
+        s.line = line;
+        s.material = MeshData::NONE;
+        statements.push_back(s);
+    }
+
+    /**
+     * First pass: tokenize the chunk.
+     */
+    void Tokenize() {
+        Resources::Tokenize(begin, end, directory, *this);
+    }
+
+    /**
+     * Second pass: resolve the faces against the merged mesh.
+     */
+    void Resolve() {
+        messages.clear();
+        unsigned int mat = material;
+        unsigned int s = 0;
+        for (unsigned int i=0; i<polygons.size(); i++) {
+            const Polygon& p = polygons[i];
+            for (; s < statements.size() && statements[s].polygon <= i; s++)
+                if (!statements[s].library) mat = statements[s].material;
+            unsigned int count[3] = { base[0] + p.count[0],
+                                      base[1] + p.count[1],
+                                      base[2] + p.count[2] };
+            corners.assign(raw.begin() + p.first, raw.begin() + p.first + p.size);
+            line = p.line;
+            AddFace(corners, count, *mesh, mat, indices, faceMaterials, *this);
+        }
+        // release the raw data early
+        vector<int>().swap(raw);
+        vector<Polygon>().swap(polygons);
+    }
+};
+
+// PARSER
+
+/**
+ * Create a parser.
+ *
+ * @param file OBJ file path.
+ */
+OBJParser::OBJParser(string file)
+    : file(file), material(MeshData::NONE), line(0), threads(1) {}
+
+/**
+ * Set the number of threads used for parsing.
+ * One thread (the default) parses the data on the calling thread,
+ * more split it in as many chunks, parsed as tasks on the default
+ * task scheduler.
+ *
+ * @param threads Number of parser threads.
+ */
+void OBJParser::SetThreads(const unsigned int threads) {
+    this->threads = threads < 1 ? 1 : threads;
+}
+
+/**
+ * Get the number of threads used for parsing.
+ *
+ * @return Number of parser threads.
+ */
+unsigned int OBJParser::GetThreads() {
+    return threads;
+}
+
+/**
+ * Print out errors in the OBJ files.
+ */
+void OBJParser::Error(string msg) {
+    logger.warning << file << " line[" << line << "] " << msg << "." << logger.end;
+}
+
+/**
+ * Make a material of the material table the current material.
+ *
+ * @param name Material name.
+ */
+void OBJParser::UseMaterial(string name) {
+    map<string, unsigned int>::iterator mat = names.find(name);
+    if (mat == names.end()) {
+        material = MeshData::NONE;
+        Error("Material "+name+" is not defined in any material resources");
+    } else
+        material = mat->second;
+}
+
+/**
+ * Parse a material file.
+ * The found materials are added to the material table of the mesh.
+ * The textures and shaders are created when the mesh is built.
+ *
+ * @param mtlfile Material file path
+ * @param mesh Mesh to add the materials to
+ */
+void OBJParser::ParseMaterialFile(string mtlfile, MeshData& mesh) {
+    // set this file as the current file so errors are printed
+    // correctly
+    string objfile = file;
+    int objline = line;
+    file = mtlfile;
+    line = 1;
+
+    MappedFile map(mtlfile);
+    mesh.libraries.push_back(mtlfile);
+    const char* pos = map.GetData();
+    const char* end = pos + map.GetSize();
+    string directory = File::Parent(mtlfile);
+    MeshMaterial* m = NULL;
+
+    for (; pos < end; pos++, line++) {
+        SkipBlanks(pos, end, line);
+        string keyword = ReadToken(pos, end);
+        SkipBlanks(pos, end, line);
+        string value = AtLineEnd(pos, end) ? string() : ReadToken(pos, end);
+
+        // new material section
+        if (keyword == "newmtl") {
+            if (value.empty())
+                Error("Invalid newmtr declaration");
+            else {
+                // make a new material and add it to the material table
+                names[value] = mesh.materials.size();
+                mesh.materials.push_back(MeshMaterial());
+                m = &mesh.materials.back();
+                m->directory = directory;
+            }
+        }
+
+        // texture material
+        else if (keyword == "map_Kd") {
+            if (value.empty())
+                Error("Invalid map_Ka declaration");
+            else if (m == NULL || !m->texture.empty())
+                // texture set means we already set it and no newmtl has appeared since
+                Error("Multiple map_Kd sections appear before a newmtr declaration");
+            else
+                m->texture = value;
+        }
+
+        // shader material
+        else if (keyword == "shader") {
+            if (value.empty())
+                Error("Invalid shader declaration");
+            else if (m == NULL || !m->shader.empty())
+                // shader set means we already set it and no newmtl has appeared since
+                Error("Multiple shader sections appear before a newmtr declaration");
+            else
+                m->shader = value;
+        }
+
+        // we ignore all other sections in the material file
+        SkipLine(pos, end);
+    }
+    // reset file name to obj file
+    file = objfile;
+    line = objline;
+}
+
+/**
+ * Parse the OBJ file.
+ *
+ * @param mesh Mesh data to fill.
+ * @throws ResourceException if the file can not be read.
+ */
+void OBJParser::Parse(MeshData& mesh) {
+    MappedFile map(file);
+    Parse(map.GetData(), map.GetData() + map.GetSize(), mesh);
+}
+
+/**
+ * Parse OBJ data.
+ *
+ * @param begin Start of the OBJ data.
+ * @param end End of the OBJ data.
+ * @param mesh Mesh data to fill.
+ */
+void OBJParser::Parse(const char* begin, const char* end, MeshData& mesh) {
+    if (threads > 1 && (unsigned int)(end - begin) >= threads * MIN_CHUNK)
+        ParseParallel(begin, end, mesh);
+    else
+        ParseSerial(begin, end, mesh);
+}
+
+/**
+ * Parse OBJ data on the calling thread.
+ */
+void OBJParser::ParseSerial(const char* begin, const char* end, MeshData& mesh) {
+    SerialSink sink(*this, mesh);
+    Tokenize(begin, end, File::Parent(file), sink);
+}
+
+/**
+ * Parse OBJ data in line aligned chunks on the default scheduler.
+ *
+ * The chunks are first tokenized in parallel. The attribute data is
+ * then concatenated and the material declarations replayed in file
+ * order on the calling thread, after which the faces of the chunks
+ * are resolved in parallel and concatenated.
+ */
+void OBJParser::ParseParallel(const char* begin, const char* end, MeshData& mesh) {
+    // split at line ends that are not escaped by a continuation
+    vector<Chunk> chunks(threads);
+    const char* pos = begin;
+    for (unsigned int i=0; i<threads; i++) {
+        chunks[i].begin = pos;
+        chunks[i].directory = File::Parent(file);
+        if (i+1 < threads) {
+            const char* split = begin + (end - begin) * (i+1) / threads;
+            if (split < pos) split = pos;
+            for (;;) {
+                SkipLine(split, end);
+                if (split == end) break;
+                const char* prev = split;
+                if (prev > begin && prev[-1] == '\r') prev--;
+                if (prev > begin && prev[-1] == '\\') {
+                    split++;
+                    continue;
+                }
+                split++;
+                break;
+            }
+            pos = split;
+        } else
+            pos = end;
+        chunks[i].end = pos;
+    }
+
+    TaskScheduler& scheduler = TaskScheduler::GetDefault();
+    TaskGroup group;
+    for (unsigned int i=0; i<threads; i++)
+        scheduler.Spawn(boost::bind(&Chunk::Tokenize, &chunks[i]), &group);
+    scheduler.Wait(group);
+
+    // concatenate the attributes and replay the material declarations
+    unsigned int size[3] = { 0, 0, 0 };
+    for (unsigned int i=0; i<threads; i++) {
+        size[0] += chunks[i].vertices.size();
+        size[1] += chunks[i].texcoords.size();
+        size[2] += chunks[i].normals.size();
+    }
+    mesh.vertices.reserve(mesh.vertices.size() + size[0]);
+    mesh.texcoords.reserve(mesh.texcoords.size() + size[1]);
+    mesh.normals.reserve(mesh.normals.size() + size[2]);
+    int lines = 0;
+    for (unsigned int i=0; i<threads; i++) {
+        Chunk& c = chunks[i];
+        c.base[0] = mesh.vertices.size() / 3;
+        c.base[1] = mesh.texcoords.size() / 2;
+        c.base[2] = mesh.normals.size() / 3;
+        c.material = material;
+        c.mesh = &mesh;
+        for (unsigned int j=0; j<c.messages.size(); j++) {
+            line = lines + c.messages[j].line + 1;
+            Error(c.messages[j].text);
+        }
+        for (unsigned int j=0; j<c.statements.size(); j++) {
+            Chunk::Statement& s = c.statements[j];
+            line = lines + s.line + 1;
+            if (s.library)
+                ParseMaterialFile(s.name, mesh);
+            else {
+                UseMaterial(s.name);
+                s.material = material;
+            }
+        }
+        mesh.vertices.insert(mesh.vertices.end(), c.vertices.begin(), c.vertices.end());
+        mesh.texcoords.insert(mesh.texcoords.end(), c.texcoords.begin(), c.texcoords.end());
+        mesh.normals.insert(mesh.normals.end(), c.normals.begin(), c.normals.end());
+        vector<float>().swap(c.vertices);
+        vector<float>().swap(c.texcoords);
+        vector<float>().swap(c.normals);
+        c.first = lines;
+        lines += c.line;
+    }
+
+    // resolve the faces and concatenate them
+    for (unsigned int i=0; i<threads; i++)
+        scheduler.Spawn(boost::bind(&Chunk::Resolve, &chunks[i]), &group);
+    scheduler.Wait(group);
+
+    size[0] = size[1] = 0;
+    for (unsigned int i=0; i<threads; i++) {
+        size[0] += chunks[i].indices.size();
+        size[1] += chunks[i].faceMaterials.size();
+    }
+    mesh.indices.reserve(mesh.indices.size() + size[0]);
+    mesh.faceMaterials.reserve(mesh.faceMaterials.size() + size[1]);
+    for (unsigned int i=0; i<threads; i++) {
+        Chunk& c = chunks[i];
+        for (unsigned int j=0; j<c.messages.size(); j++) {
+            line = c.first + c.messages[j].line + 1;
+            Error(c.messages[j].text);
+        }
+        mesh.indices.insert(mesh.indices.end(), c.indices.begin(), c.indices.end());
+        mesh.faceMaterials.insert(mesh.faceMaterials.end(),
+                                  c.faceMaterials.begin(), c.faceMaterials.end());
+    }
+    line = lines;
+}
+
+} // NS Resources
+} // NS OpenEngine
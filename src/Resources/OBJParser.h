@@ -0,0 +1,78 @@
+// Tokenizer based OBJ parser.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS) 
+// 
+// This program is free software; It is covered by the GNU General 
+// Public License version 2 or any later version. 
+// See the GNU General Public License for more details (see LICENSE). 
+//--------------------------------------------------------------------
+
+#ifndef _OBJ_PARSER_H_
+#define _OBJ_PARSER_H_
+
+#include <Resources/MeshCache.h>
+#include <string>
+#include <vector>
+#include <map>
+
+namespace OpenEngine {
+namespace Resources {
+
+using std::string;
+using std::vector;
+using std::map;
+
+/**
+ * Tokenizer based OBJ parser.
+ *
+ * The whole file is memory mapped and tokenized in place, numbers
+ * are converted by hand written parsers and no temporary strings
+ * are built for the common declarations. Lines may be of any length
+ * and may be continued with a backslash. Polygons with more than
+ * three corners are triangulated as fans around their first corner.
+ * Negative (relative) indices are supported.
+ *
+ * Supported declarations are v, vt, vn, f, mtllib and usemtl. Groups,
+ * smoothing groups, object names and comments are ignored. Material
+ * files are parsed for newmtl, map_Kd and shader declarations.
+ *
+ * With more than one thread the data is split into line aligned
+ * chunks that are tokenized in parallel. Face indices are resolved
+ * once the attribute counts of all preceding chunks are known, and
+ * the material declarations are replayed in file order, so the mesh
+ * is identical to the one produced by a single thread. Warnings are
+ * reported in file order within each pass.
+ *
+ * @class OBJParser OBJParser.h Resources/OBJParser.h
+ */
+class OBJParser {
+private:
+    class SerialSink;
+    class Chunk;
+
+    string file;                     //!< file being parsed
+    map<string, unsigned int> names; //!< material name to index
+    unsigned int material;           //!< current material
+    int line;                        //!< current line number
+    unsigned int threads;            //!< number of parser threads
+
+    void Error(string msg);
+    void ParseMaterialFile(string file, MeshData& mesh);
+    void UseMaterial(string name);
+    void ParseSerial(const char* begin, const char* end, MeshData& mesh);
+    void ParseParallel(const char* begin, const char* end, MeshData& mesh);
+
+public:
+    OBJParser(string file);
+
+    void SetThreads(const unsigned int threads);
+    unsigned int GetThreads();
+
+    void Parse(MeshData& mesh);
+    void Parse(const char* begin, const char* end, MeshData& mesh);
+};
+
+} // NS Resources
+} // NS OpenEngine
+
+#endif // _OBJ_PARSER_H_
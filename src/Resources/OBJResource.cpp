@@ -10,6 +10,7 @@
 
 #include <Resources/OBJResource.h>
 #include <Resources/ResourceManager.h>
+#include <Resources/OBJParser.h>
 #include <Resources/File.h>
 #include <Logging/Logger.h>
 #include <Utils/Convert.h>
@@ -39,10 +40,12 @@ IModelResourcePtr OBJPlugin::CreateResource(string file) {
 
 // RESOURCE METHODS
 
+unsigned int OBJResource::threads = 1;
+
 /**
  * Resource constructor.
  */
-OBJResource::OBJResource(string file) : file(file), faces(NULL) {}
+OBJResource::OBJResource(string file) : file(file), faces(NULL), faceCost(0) {}
 
 /**
  * Resource destructor.
@@ -51,256 +54,244 @@ OBJResource::~OBJResource() {
     Unload();
 }
 
-/**
- * Helper function to print out errors in the OBJ files.
- */
-void OBJResource::Error(int line, string msg) {
-    logger.warning << file << " line[" << line << "] " << msg << "." << logger.end;
+// marks an empty slot in the corner table
+static const unsigned int EMPTY = 0xFFFFFFFF;
+
+// hash the vertex, texture coordinate and normal index of a corner
+static inline unsigned int HashCorner(const unsigned int* corner) {
+    unsigned int h = 2166136261u;
+    for (int k=0; k<3; k++)
+        h = (h ^ corner[k]) * 16777619u;
+    return h;
 }
 
 /**
- * Load a OBJ material file.
- * Parses the file and places the found textures and shaders in the
- * materials map.
- *
- * You may access the loaded materials from the private member as so:
- * @code
- * Material* m = materials["material_file_name.tga"]; 
- * m->texture; // contains the texture or NULL
- * m->shader;  // contains the shader or NULL
- * @endcode
+ * Build the indexed mesh from mesh data.
+ * Corners with the same vertex, texture coordinate and normal index
+ * share a mesh vertex. Creates the texture and shader resources of
+ * the material table.
  *
- * @param file Material file (just the file name, not the full path)
+ * @param data Parsed mesh data
+ * @return New mesh
  */
-void OBJResource::LoadMaterialFile(string file) {
-    // open the material file
-    ifstream* in = File::Open(file);
-
-    // set up working variables
-    Material* m = NULL;
-    char buf[255], tmp[255];
-    int line = 0;
-
-    // save the obj file and set this file as the current file so
-    // errors are printed correctly
-    string objfile = this->file;
-    string resource_dir = File::Parent(this->file);
-    this->file = file;
-
-    // for each line in the material file...
-    while (!in->eof()) {
-        line++;
-        in->getline(buf,255);
+MeshPtr OBJResource::Build(MeshData& data) {
+    // create the material resources
+    vector<ITextureResourcePtr> textures(data.materials.size());
+    vector<IShaderResourcePtr>  shaders(data.materials.size());
+    for (unsigned int i=0; i<data.materials.size(); i++) {
+        MeshMaterial& m = data.materials[i];
+        if (m.texture.empty() && m.shader.empty()) continue;
+        // we add the resource path to create the resources
+        if (! ResourceManager::IsInPath(m.directory)) {
+            ResourceManager::AppendPath(m.directory);
+        }
+        if (!m.texture.empty())
+            textures[i] = ResourceManager::CreateTexture(m.texture);
+        if (!m.shader.empty())
+            shaders[i] = ResourceManager::CreateShader(m.shader);
+    }
 
-        // new material section
-        if (string(buf,6) == "newmtl")
-            if (sscanf(buf, "newmtl %s", tmp) != 1)
-                Error(line, "Invalid newmtr declaration");
-            else {
-                // make a new material and add it to the material map
-                m = new Material();
-                materials.insert(make_pair(string(tmp), m));
+    // open addressed table from corner to mesh vertex
+    const unsigned int n = data.faceMaterials.size();
+    unsigned int size = 16;
+    while (size < 6*n) size *= 2;
+    vector<unsigned int> table(size, EMPTY);
+    vector<const unsigned int*> corners;
+    corners.reserve(3*n);
+
+    MeshPtr mesh = MeshPtr(new Mesh());
+    mesh->indices.reserve(3*n);
+    for (unsigned int i=0; i<n; i++) {
+        for (int j=0; j<3; j++) {
+            const unsigned int* corner = &data.indices[9*i + 3*j];
+            unsigned int slot = HashCorner(corner) & (size-1);
+            for (; table[slot] != EMPTY; slot = (slot+1) & (size-1)) {
+                const unsigned int* other = corners[table[slot]];
+                if (other[0] == corner[0] && other[1] == corner[1] && other[2] == corner[2])
+                    break;
             }
-
-        // texture material
-        else if (string(buf,6) == "map_Kd")
-            if (sscanf(buf, "map_Kd %s", tmp) != 1)
-                Error(line, "Invalid map_Ka declaration");
-            else if (m == NULL || m->texture != NULL)
-                // texture != NULL means we already set it and no newmtl has appeared since
-                Error(line, "Multiple map_Kd sections appear before a newmtr declaration");
-            else {
-                // we reset the resource path temporary to create the texture resource
-				if (! ResourceManager::IsInPath(resource_dir)) {
-					ResourceManager::AppendPath(resource_dir);
-				}
-                m->texture = ResourceManager::CreateTexture(string(tmp));
+            if (table[slot] == EMPTY) {
+                table[slot] = corners.size();
+                corners.push_back(corner);
             }
+            mesh->indices.push_back(table[slot]);
+        }
+        ITextureResourcePtr texr;
+        IShaderResourcePtr shad;
+        unsigned int material = data.faceMaterials[i];
+        if (material != MeshData::NONE) {
+            texr = textures[material];
+            shad = shaders[material];
+        }
+        mesh->AddSubMesh(3*i, 3, texr, shad);
+    }
 
-        // shader material
-        else if (string(buf,6) == "shader")
-            if (sscanf(buf, "shader %s", tmp) != 1)
-                Error(line, "Invalid shader declaration");
-            else if (m == NULL || m->shader != NULL)
-                // shader != NULL means we already set it and no newmtl has appeared since
-                Error(line, "Multiple shader sections appear before a newmtr declaration");
-            else {
-                // reset resource path temporary and create the shader resource
-				if (! ResourceManager::IsInPath(resource_dir)) {
-					ResourceManager::AppendPath(resource_dir);
-				}
-                m->shader = ResourceManager::CreateShader(string(tmp));
-            }
-        
-        // we ignore all other sections in the material file
+    // copy the attributes of the shared corners
+    const unsigned int vertices = corners.size();
+    mesh->vertices.resize(3*vertices);
+    mesh->normals.resize(3*vertices, 0.0f);
+    mesh->texcoords.resize(2*vertices, 0.0f);
+    for (unsigned int v=0; v<vertices; v++) {
+        const unsigned int* corner = corners[v];
+        for (int k=0; k<3; k++)
+            mesh->vertices[3*v+k] = data.vertices[3*corner[0]+k];
+        if (corner[1] != MeshData::NONE)
+            for (int k=0; k<2; k++)
+                mesh->texcoords[2*v+k] = data.texcoords[2*corner[1]+k];
+        if (corner[2] != MeshData::NONE)
+            for (int k=0; k<3; k++)
+                mesh->normals[3*v+k] = data.normals[3*corner[2]+k];
     }
-    // reset file name to obj file
-    this->file = objfile;
+    return mesh;
 }
 
+/**
+ * Build the face set from the indexed mesh.
+ * The faces are constructed from their corners and normals, so they
+ * are the faces the OBJ file defines.
+ *
+ * @return New face set with a face for each triangle.
+ */
+static FaceSet* BuildFaceSet(const Mesh& mesh) {
+    FaceSet* faces = new FaceSet();
+    for (unsigned int s=0; s<mesh.subMeshes.size(); s++) {
+        const SubMesh& sub = mesh.subMeshes[s];
+        for (unsigned int t = sub.first; t < sub.first + sub.count; t += 3) {
+            const unsigned int* index = &mesh.indices[t];
+            Vector<3,float> vert[3], norm[3];
+            for (int j=0; j<3; j++) {
+                vert[j] = Vector<3,float>(&mesh.vertices[3*index[j]]);
+                norm[j] = Vector<3,float>(&mesh.normals[3*index[j]]);
+            }
+            FacePtr face = FacePtr(new Face(vert[0], vert[1], vert[2],
+                                            norm[0], norm[1], norm[2]));
+            for (int j=0; j<3; j++)
+                face->texc[j] = Vector<2,float>(&mesh.texcoords[2*index[j]]);
+            face->texr = sub.texr;
+            face->shad = sub.shad;
+            faces->Add(face);
+        }
+    }
+    return faces;
+}
 
 /**
  * Load an OBJ 3d model file.
  *
- * This method parses the file given to the constructor and populates a
- * FaceSet with the data from the file that can be retrieved with
- * GetFaceSet().
+ * This method parses the file given to the constructor with the
+ * OBJParser and populates an indexed Mesh with the data from the
+ * file that can be retrieved with GetMesh(). A FaceSet is built from
+ * the mesh when GetFaceSet() is first called. The parsed model is
+ * read from the MeshCache if it holds
+ * the current version of the file, otherwise the file is parsed and
+ * the result written to the cache.
+ *
+ * Concurrent loads are serialized and only the first one reads the
+ * file. The mesh is built before it is published, so other threads
+ * never see a partly built mesh.
  *
  * @see Geometry::FaceSet
  * @see Geometry::Face
+ * @see Geometry::Mesh
+ * @see MeshCache
  */
 void OBJResource::Load() {
 
-    // check if we have loaded the resource
-    if (faces != NULL) return;
-
-    ifstream* in = File::Open(file);
-
-    // create a new face set
-    faces = new FaceSet();
-
-    // working variables
-    char buffer[255];
-    float f1, f2, f3;
-    int line = 0;
-    ITextureResourcePtr texr;
-    IShaderResourcePtr  shad;
-    vector< Vector<3,float> > vert, norm;
-    vector< Vector<2,float> > texc;
-
-    // for each line...
-    while (!in->eof()) {
-        in->getline(buffer, 255);
-        line++;
-
-        // ignored stuff
-        if (in->gcount() <= 2 || // short line
-            buffer[0] == ' ' || // empty lines
-            buffer[0] == '#' || // comments
-            buffer[0] == 'g' || // groups
-            buffer[0] == 's' ) continue;
-
-        // read vertex
-        else if (string(buffer,2) == "v ") {
-            if (sscanf(buffer, "v %f %f %f", &f1, &f2, &f3) == 3)
-                vert.push_back(Vector<3,float>(f1,f2,f3));
-            else
-                Error(line, "Invalid vertex");
-        }
-
-        // read texture
-        else if(string(buffer,2) == "vt") {
-			if (sscanf(buffer, "vt %f %f ",&f1, &f2) == 2)
-                texc.push_back(Vector<2,float>(f1,f2));
-			else
-                Error(line, "Invalid texture coordinate");
-        }
-
-        // read normals
-        else if (string(buffer,2) == "vn") {
-			if(sscanf(buffer, "vn %f %f %f", &f1, &f2, &f3) == 3)
-				norm.push_back(Vector<3,float>(f1,f2,f3));
-			else
-				Error(line, "Invalid vertex normal");
-        }
+    boost::mutex::scoped_lock load(loading);
 
-        // read faces
-        else if (string(buffer,2) == "f ") {
-            Vector<9,int> f(0);
-            //            int d1, d2, d3;
-            // test that the model is triangulated
-            char s1[255],s2[255],s3[255],s4[255];
-            if (sscanf(buffer, "f %s %s %s %s", s1,s2,s3,s4) != 3)
-                Error(line, "Face has not been triangulated");
-            else if ( !( sscanf(buffer, "f %d/%d/%d %d/%d/%d %d/%d/%d", &f[0],&f[1],&f[2],&f[3],&f[4],&f[5],&f[6],&f[7],&f[8]) == 9
-                 || sscanf(buffer, "f %d//%d %d//%d %d//%d", &f[0],&f[2],&f[3],&f[5],&f[6],&f[8]) == 6
-                 || sscanf(buffer, "f %d %d %d", &f[0],&f[3],&f[6]) == 3 ) ) 
-                Error(line, "Invalid face");
-            else {
-                // Create a new face with the loaded data
-                // We subtract one from all indexes so it corresponds
-                // to the correct index in the vectors.
-                FacePtr face = FacePtr(new Face(vert[f[0] - 1],
-                                                vert[f[3] - 1],
-                                                vert[f[6] - 1],
-                                                norm[f[2] - 1],
-                                                norm[f[5] - 1],
-                                                norm[f[8] - 1]));
-                face->texc[0] = texc[f[1] - 1];
-                face->texc[1] = texc[f[4] - 1];
-                face->texc[2] = texc[f[7] - 1];
-
-                // test for valid face
-                if (face->vert[0] == face->vert[1] || 
-                    face->vert[1] == face->vert[2] ||
-                    face->vert[0] == face->vert[2]) {
-                    Error(line, "Two or more vertices in face are equal");
-                    continue;
-                }
-
-                // check against invalid normals
-                for (int i=0; i<3; i++)
-                    if (face->norm[i].IsZero())
-                        Error(line, "norm["+Convert::int2string(i)+"] is the zero vector.");
-
-                // add resource pointers
-                face->texr = texr;
-                face->shad = shad;
-
-                // add the face to the FaceSet
-                faces->Add(face);
-            }
-        }
-
-        // material resources
-        else if (string(buffer,6) == "mtllib") {
-            string res;
-            std::stringstream ss(buffer+7);
-            while (ss >> res)
-                LoadMaterialFile(File::Parent(file) + res);
-        }
-
-        // material elements
-        else if (string(buffer,6) == "usemtl") {
-            char name[255];
-            sscanf(buffer, "usemtl %s", name);
-            map<string, Material*>::iterator mat;
-            mat = materials.find(name);
-            if (mat == materials.end()) {
-                texr.reset();
-                shad.reset();
-                Error(line, "Material "+string(name)+" is not defined in any material resources");
-            } else {
-                texr = mat->second->texture;
-                shad = mat->second->shader;
-            }
-        }
-
-        // unsupported or invalid lines
-        else Error(line, "Unsupported OBJ declaration");
+    // check if we have loaded the resource
+    {
+        boost::mutex::scoped_lock lock(mutex);
+        if (mesh) return;
     }
 
-    // close the file
-    in->close();
+    MeshData data;
+    if (!MeshCache::Read(file, data)) {
+        OBJParser parser(file);
+        parser.SetThreads(threads);
+        parser.Parse(data);
+        MeshCache::Write(file, data);
+    }
+    MeshPtr built = Build(data);
 
+    boost::mutex::scoped_lock lock(mutex);
+    mesh = built;
 }
 
 /**
  * Unload the resource.
- * Resets the face collection. Does not delete the face set.
+ * Releases the mesh and forgets the face set without deleting it,
+ * as the scene may still draw it. A face set returned by
+ * GetFaceSet() stays valid until its user deletes it.
  */
 void OBJResource::Unload() {
+    boost::mutex::scoped_lock lock(mutex);
     faces = NULL;
+    faceCost = 0;
+    mesh.reset();
+}
+
+/**
+ * Get the memory cost of the loaded face set and mesh.
+ *
+ * @return Approximate size of the model in bytes.
+ */
+unsigned int OBJResource::GetMemoryCost() {
+    boost::mutex::scoped_lock lock(mutex);
+    unsigned int cost = 0;
+    cost += faceCost;
+    if (mesh) cost += mesh->GetMemoryCost();
+    return cost;
 }
 
 /**
  * Get the face set for the loaded OBJ data.
+ * The face set is built from the mesh on the first call and the same
+ * face set is returned until the resource is unloaded. The resource
+ * never deletes it, it belongs to the scene it is used in.
  *
- * @return Face set
+ * @return Face set, or NULL if the resource is not loaded.
  */
 FaceSet* OBJResource::GetFaceSet() {
+    boost::mutex::scoped_lock lock(mutex);
+    if (faces == NULL && mesh) {
+        faces = BuildFaceSet(*mesh);
+        faceCost = faces->Size() * (sizeof(Face) + sizeof(FacePtr));
+    }
     return faces;
 }
 
+/**
+ * Get the indexed mesh for the loaded OBJ data.
+ * The corners of the mesh are in the order of the file.
+ *
+ * @return Mesh
+ */
+MeshPtr OBJResource::GetMesh() {
+    boost::mutex::scoped_lock lock(mutex);
+    return mesh;
+}
+
+/**
+ * Set the number of threads used to parse OBJ files.
+ * With more than one thread large files are split into chunks that
+ * are parsed in parallel. The result is the same as with a single
+ * thread, which is the default.
+ *
+ * @param threads Number of parser threads.
+ */
+void OBJResource::SetParserThreads(const unsigned int threads) {
+    OBJResource::threads = threads < 1 ? 1 : threads;
+}
+
+/**
+ * Get the number of threads used to parse OBJ files.
+ *
+ * @return Number of parser threads.
+ */
+unsigned int OBJResource::GetParserThreads() {
+    return threads;
+}
+
 } // NS Resources
 } // NS OpenEngine
@@ -14,7 +14,10 @@
 #include <Resources/IModelResource.h>
 #include <Resources/ITextureResource.h>
 #include <Resources/IShaderResource.h>
+#include <Resources/MeshCache.h>
 #include <Geometry/FaceSet.h>
+#include <Geometry/Mesh.h>
+#include <boost/thread/mutex.hpp>
 
 #include <string>
 #include <vector>
@@ -27,35 +30,43 @@ using namespace std;
 
 /**
  * OBJ-model resource.
+ * The parsed model is stored in the binary MeshCache, so only the
+ * first load of a model parses the OBJ text. Large files can be
+ * parsed on several threads, see SetParserThreads().
+ *
+ * The model is loaded as an indexed mesh with a sub mesh for each
+ * run of faces using the same material. The face set is built from
+ * the mesh the first time it is asked for, so models only drawn
+ * from the mesh never pay for it. Scene nodes keep the face set by a
+ * plain pointer, so the resource never deletes it, not even when it
+ * is unloaded or evicted from the resource cache.
  *
  * @class OBJResource OBJResource.h "OBJResource.h"
  */
 class OBJResource : public IModelResource {
 private:
-
-    // inner material structure
-    class Material {
-    public:
-        ITextureResourcePtr texture; //!< texture resource 
-        IShaderResourcePtr shader;   //!< shader resource 
-        Material() {}
-        ~Material() {}
-    };
-
     string file;                      //!< obj file path
-    FaceSet* faces;                   //!< the face set
-    map<string, Material*> materials; //!< resources material map
+    FaceSet* faces;                   //!< the face set, built on demand
+    unsigned int faceCost;            //!< memory cost of the face set
+    MeshPtr mesh;                     //!< the indexed mesh
+    boost::mutex mutex;               //!< guards the mesh and face set
+    boost::mutex loading;             //!< serializes loads
+    static unsigned int threads;      //!< number of parser threads
 
     // helper methods
-    void Error(int line, string msg);
-    void LoadMaterialFile(string file);
+    MeshPtr Build(MeshData& data);
 
 public:
     OBJResource(string file);
     ~OBJResource();
     void Load();
     void Unload();
+    unsigned int GetMemoryCost();
     FaceSet* GetFaceSet();
+    MeshPtr GetMesh();
+
+    static void SetParserThreads(const unsigned int threads);
+    static unsigned int GetParserThreads();
 };
 
 /**
@@ -0,0 +1,283 @@
+// Memory budgeted resource cache.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS) 
+// 
+// This program is free software; It is covered by the GNU General 
+// Public License version 2 or any later version. 
+// See the GNU General Public License for more details (see LICENSE). 
+//--------------------------------------------------------------------
+
+#ifndef _RESOURCE_CACHE_H_
+#define _RESOURCE_CACHE_H_
+
+#include <Utils/ConcurrentHashMap.h>
+#include <Utils/StringPool.h>
+#include <boost/shared_ptr.hpp>
+#include <boost/weak_ptr.hpp>
+#include <boost/detail/atomic_count.hpp>
+#include <boost/thread/mutex.hpp>
+#include <vector>
+
+namespace OpenEngine {
+namespace Resources {
+
+using OpenEngine::Utils::ConcurrentHashMap;
+using OpenEngine::Utils::StringPool;
+using std::vector;
+
+/**
+ * Resource cache counters.
+ * Used to tune the memory budgets of the resource caches.
+ */
+struct ResourceCacheStatistics {
+    unsigned long hits;      //!< lookups that found a cached resource
+    unsigned long misses;    //!< lookups that did not
+    unsigned long evictions; //!< resources evicted to meet the budget
+    unsigned long entries;   //!< resources currently cached
+    unsigned long bytes;     //!< memory cost of the cached resources
+    unsigned long budget;    //!< memory budget, zero if unlimited
+};
+
+/**
+ * Memory budgeted resource cache.
+ *
+ * Resources are looked up in a ConcurrentHashMap keyed on interned
+ * file names, so a lookup hashes and compares a pointer. When a budget is set, Evict() reclaims memory using
+ * the CLOCK approximation of LRU: each lookup marks the resource as
+ * referenced and the clock hand clears the marks as it sweeps, so
+ * resources not looked up during a full sweep are evicted first.
+ * Only resources referenced by nothing but the cache are evicted.
+ * Data a resource hands out by plain pointer, such as the face set
+ * of a model, is not reference counted, so resources must not delete
+ * it when they are unloaded.
+ *
+ * The memory cost of a resource is measured when it is cached and
+ * measured again by Evict(), a few resources per call, so the cost
+ * of resources loaded or unloaded after they were cached is
+ * accounted for without querying every resource on every call.
+ *
+ * @class ResourceCache ResourceCache.h Resources/ResourceCache.h
+ * @param T Resource interface type
+ */
+template <class T>
+class ResourceCache {
+public:
+    //! Resource smart pointer type.
+    typedef boost::shared_ptr<T> ResourcePtr;
+    //! Interned file name.
+    typedef StringPool::Handle Name;
+
+    //! Number of resources measured by each call to Evict().
+    static const unsigned int MEASURES = 8;
+
+private:
+    struct Slot {
+        Name name;
+        boost::weak_ptr<T> resource;
+        unsigned long cost;                     // cost when last measured
+        boost::detail::atomic_count lookups;    // lookups so far
+        long swept;                             // lookups when last swept
+        Slot(Name name, ResourcePtr resource)
+            : name(name), resource(resource), cost(0), lookups(0), swept(-1) {}
+    };
+    typedef boost::shared_ptr<Slot> SlotPtr;
+
+    // the map holds the only reference the cache has to a resource,
+    // so a resource is unused when its map entry is unique
+    struct Entry {
+        ResourcePtr resource;
+        SlotPtr slot;
+    };
+
+    ConcurrentHashMap<Name, Entry> entries;
+
+    boost::mutex mutex;    //!< guards the clock and the budget
+    vector<SlotPtr> clock; //!< all slots in insertion order
+    unsigned int hand;     //!< clock hand
+    unsigned int measure;  //!< next slot to measure
+    unsigned long budget;  //!< memory budget in bytes, 0 is unlimited
+    unsigned long bytes;   //!< sum of the measured costs
+
+    boost::detail::atomic_count hits, misses, evictions;
+
+    static bool IsUnused(const Entry& entry) {
+        return entry.resource.unique();
+    }
+
+    // must be called with the mutex held
+    void Measure(Slot& slot) {
+        ResourcePtr resource = slot.resource.lock();
+        unsigned long cost = resource ? resource->GetMemoryCost() : 0;
+        bytes = bytes - slot.cost + cost;
+        slot.cost = cost;
+    }
+
+    // must be called with the mutex held
+    void Remove(unsigned int i) {
+        bytes -= clock[i]->cost;
+        clock[i] = clock.back();
+        clock.pop_back();
+        ++evictions;
+    }
+
+    // disallow copying
+    ResourceCache(const ResourceCache&);
+    ResourceCache& operator=(const ResourceCache&);
+
+public:
+    ResourceCache()
+        : hand(0), measure(0), budget(0), bytes(0), hits(0), misses(0), evictions(0) {}
+
+    /**
+     * Look up a resource.
+     *
+     * @param name Interned file name.
+     * @param resource Set to the cached resource if found.
+     * @return True if the resource was cached.
+     */
+    bool Find(Name name, ResourcePtr& resource) {
+        // the entry is copied with its shard locked, so an eviction
+        // either sees this reference or removes the entry first
+        Entry entry;
+        if (!entries.Find(name, entry)) {
+            ++misses;
+            return false;
+        }
+        ++hits;
+        ++entry.slot->lookups;
+        resource = entry.resource;
+        return true;
+    }
+
+    /**
+     * Insert a resource unless one is already cached under the name.
+     * Does not evict, call Evict() to enforce the budget.
+     *
+     * @param name Interned file name.
+     * @param resource Resource to insert.
+     * @return The resource cached under the name.
+     */
+    ResourcePtr Insert(Name name, ResourcePtr resource) {
+        Entry entry;
+        entry.resource = resource;
+        entry.slot = SlotPtr(new Slot(name, resource));
+        Entry stored = entries.Insert(name, entry);
+        if (stored.slot != entry.slot)
+            return stored.resource;
+        boost::mutex::scoped_lock lock(mutex);
+        clock.push_back(entry.slot);
+        Measure(*entry.slot);
+        return resource;
+    }
+
+    /**
+     * Replace the resource cached under a name, or insert it if none
+     * is. Users of the replaced resource keep it, later lookups find
+     * the new one. Does not evict.
+     *
+     * @param name Interned file name.
+     * @param resource Resource to cache.
+     */
+    void Replace(Name name, ResourcePtr resource) {
+        // with the mutex held the entry can not be evicted between
+        // the lookup and the replacement
+        boost::mutex::scoped_lock lock(mutex);
+        Entry entry;
+        entry.resource = resource;
+        if (entries.Find(name, entry)) {
+            entry.resource = resource;
+            entry.slot->resource = resource;
+            entries.Set(name, entry);
+        } else {
+            entry.slot = SlotPtr(new Slot(name, resource));
+            entries.Set(name, entry);
+            clock.push_back(entry.slot);
+        }
+        Measure(*entry.slot);
+    }
+
+    /**
+     * Evict unused resources until the cache is within its budget.
+     * Measures the cost of a few resources, then sweeps the clock
+     * only while the measured cost exceeds the budget.
+     *
+     * @return Number of resources evicted.
+     */
+    unsigned int Evict() {
+        boost::mutex::scoped_lock lock(mutex);
+        for (unsigned int i=0; i<MEASURES && i<clock.size(); i++) {
+            if (measure >= clock.size()) measure = 0;
+            Measure(*clock[measure++]);
+        }
+        if (budget == 0) return 0;
+
+        // two full sweeps clear all reference marks, so stop if
+        // nothing more can be evicted after that
+        unsigned int evicted = 0;
+        unsigned int visits = 2 * clock.size();
+        while (bytes > budget && visits > 0 && !clock.empty()) {
+            visits--;
+            if (hand >= clock.size()) hand = 0;
+            Slot& slot = *clock[hand];
+            long lookups = slot.lookups;
+            if (lookups != slot.swept) {
+                slot.swept = lookups;
+                hand++;
+                continue;
+            }
+            Measure(slot);
+            if (entries.EraseIf(slot.name, &IsUnused)) {
+                Remove(hand);
+                evicted++;
+            } else
+                hand++;
+        }
+        return evicted;
+    }
+
+    /**
+     * Set the memory budget.
+     *
+     * @param bytes Budget in bytes, zero for unlimited.
+     */
+    void SetBudget(const unsigned long bytes) {
+        boost::mutex::scoped_lock lock(mutex);
+        budget = bytes;
+    }
+
+    /**
+     * Get the cache counters.
+     * The memory cost is the sum of the costs last measured.
+     *
+     * @return Cache statistics.
+     */
+    ResourceCacheStatistics GetStatistics() {
+        boost::mutex::scoped_lock lock(mutex);
+        ResourceCacheStatistics stats;
+        stats.hits = hits;
+        stats.misses = misses;
+        stats.evictions = evictions;
+        stats.entries = clock.size();
+        stats.bytes = bytes;
+        stats.budget = budget;
+        return stats;
+    }
+
+    /**
+     * Remove all resources.
+     * The counters are left untouched.
+     */
+    void Clear() {
+        boost::mutex::scoped_lock lock(mutex);
+        entries.Clear();
+        clock.clear();
+        hand = 0;
+        measure = 0;
+        bytes = 0;
+    }
+};
+
+} // NS Resources
+} // NS OpenEngine
+
+#endif // _RESOURCE_CACHE_H_
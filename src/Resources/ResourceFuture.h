@@ -0,0 +1,171 @@
+// Handle to a resource being loaded in the background.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#ifndef _RESOURCE_FUTURE_H_
+#define _RESOURCE_FUTURE_H_
+
+#include <Resources/Exceptions.h>
+#include <EventSystem/Event.h>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition.hpp>
+#include <string>
+
+namespace OpenEngine {
+namespace Resources {
+
+using OpenEngine::EventSystem::Event;
+using std::string;
+
+// forward declaration
+class ResourceManager;
+
+/**
+ * Handle to a resource being loaded in the background.
+ *
+ * A future goes through three states. It is created \a pending by
+ * one of the asynchronous create methods on the ResourceManager.
+ * When a worker thread has created and loaded the resource it
+ * becomes \a loaded (or \a failed). Finally the resource is \a
+ * published on the engine thread by ResourceManager::Publish(), at
+ * which point it is inserted in the resource cache and the
+ * LoadedEvent is notified.
+ *
+ * @code
+ * IModelResourceFuturePtr f = ResourceManager::CreateModelAsync("box.obj");
+ * // ... later, on the engine thread
+ * if (f->IsReady()) node->SetFaceSet(f->Get()->GetFaceSet());
+ * @endcode
+ *
+ * @class ResourceFuture ResourceFuture.h Resources/ResourceFuture.h
+ * @param T Resource interface type
+ */
+template <class T>
+class ResourceFuture {
+    friend class ResourceManager;
+
+public:
+    //! Resource smart pointer type.
+    typedef boost::shared_ptr<T> ResourcePtr;
+
+private:
+    enum State { PENDING, LOADED, PUBLISHED, FAILED };
+
+    boost::mutex mutex;         //!< guards the state
+    boost::condition done;      //!< signaled on load completion
+    State state;                //!< current state
+    ResourcePtr resource;       //!< the resource when loaded
+    string error;               //!< error message when failed
+
+    void SetLoaded(ResourcePtr res) {
+        boost::mutex::scoped_lock lock(mutex);
+        resource = res;
+        state = LOADED;
+        done.notify_all();
+    }
+
+    void SetFailed(string msg) {
+        boost::mutex::scoped_lock lock(mutex);
+        error = msg;
+        state = FAILED;
+        done.notify_all();
+    }
+
+    void SetPublished(ResourcePtr res) {
+        {
+            boost::mutex::scoped_lock lock(mutex);
+            resource = res;
+            state = PUBLISHED;
+        }
+        LoadedEvent.Notify(res);
+    }
+
+public:
+
+    /**
+     * Event notified on the engine thread when the resource has
+     * been published. It is not notified if the load failed.
+     */
+    Event<ResourcePtr> LoadedEvent;
+
+    /**
+     * Create a pending future.
+     */
+    ResourceFuture() : state(PENDING) {}
+
+    /**
+     * Create a future for an already published resource.
+     * Used for resources that are found in the cache.
+     *
+     * @param res Loaded resource.
+     */
+    explicit ResourceFuture(ResourcePtr res) : state(PUBLISHED), resource(res) {}
+
+    /**
+     * Has the resource been loaded by a worker thread.
+     * A loaded resource may still be awaiting publication.
+     *
+     * @return True if the resource is loaded or published.
+     */
+    bool IsLoaded() {
+        boost::mutex::scoped_lock lock(mutex);
+        return state == LOADED || state == PUBLISHED;
+    }
+
+    /**
+     * Has the resource been published on the engine thread.
+     *
+     * @return True if the resource is published.
+     */
+    bool IsReady() {
+        boost::mutex::scoped_lock lock(mutex);
+        return state == PUBLISHED;
+    }
+
+    /**
+     * Did loading the resource fail.
+     *
+     * @return True if loading failed.
+     */
+    bool IsFailed() {
+        boost::mutex::scoped_lock lock(mutex);
+        return state == FAILED;
+    }
+
+    /**
+     * Block until the worker thread has finished with the resource.
+     * This does not wait for publication.
+     */
+    void Wait() {
+        boost::mutex::scoped_lock lock(mutex);
+        while (state == PENDING)
+            done.wait(lock);
+    }
+
+    /**
+     * Get the resource.
+     * Blocks until the resource is loaded. The returned resource is
+     * fully loaded even if it has not been published yet.
+     *
+     * @return Resource pointer.
+     * @throws ResourceException if loading failed.
+     */
+    ResourcePtr Get() {
+        Wait();
+        boost::mutex::scoped_lock lock(mutex);
+        if (state == FAILED)
+            throw ResourceException(error);
+        return resource;
+    }
+};
+
+} // NS Resources
+} // NS OpenEngine
+
+#endif // _RESOURCE_FUTURE_H_
@@ -17,35 +17,45 @@
 #include <Resources/File.h>
 #include <Logging/Logger.h>
 #include <Utils/Convert.h>
+#include <boost/bind.hpp>
 
 namespace OpenEngine {
 namespace Resources {
 
 using OpenEngine::Utils::Convert;
+using OpenEngine::Utils::TaskScheduler;
 namespace fs = boost::filesystem;
 
 // initialization of static members
+StringPool ResourceManager::names;
 list<string> ResourceManager::paths = list<string>();
-map<string, string> ResourceManager::pathcache = map<string, string>();
+ConcurrentHashMap<StringPool::Handle, string> ResourceManager::pathcache;
 
-map<string, ITextureResourcePtr> ResourceManager::textures = map<string, ITextureResourcePtr>();
+ResourceCache<ITextureResource> ResourceManager::textures;
 vector<ITextureResourcePlugin*>  ResourceManager::texturePlugins = vector<ITextureResourcePlugin*>();
 
-map<string, IModelResourcePtr>   ResourceManager::models   = map<string, IModelResourcePtr>();
+ResourceCache<IModelResource>   ResourceManager::models;
 vector<IModelResourcePlugin*>	 ResourceManager::modelPlugins	 = vector<IModelResourcePlugin*>();
 
-map<string, IShaderResourcePtr>  ResourceManager::shaders  = map<string, IShaderResourcePtr>();
+ResourceCache<IShaderResource>  ResourceManager::shaders;
 vector<IShaderResourcePlugin*>	 ResourceManager::shaderPlugins	 = vector<IShaderResourcePlugin*>();
 
 vector<IScriptResourcePlugin*>   ResourceManager::scriptPlugins = vector<IScriptResourcePlugin*>();
 vector<IScriptModule*>           ResourceManager::scriptModules = vector<IScriptModule*>();
 
+boost::mutex ResourceManager::mutex;
+TaskGroup    ResourceManager::loads;
+
+boost::mutex ResourceManager::publishMutex;
+list<boost::function<void ()> > ResourceManager::publishQueue = list<boost::function<void ()> >();
+
 /** 
  * Append given path to the global path list
  * 
  * @param str File path to append
  */
 void ResourceManager::AppendPath(string str) {
+    boost::mutex::scoped_lock lock(mutex);
     paths.push_back(str);
 }
 
@@ -55,6 +65,7 @@ void ResourceManager::AppendPath(string str) {
  * @param str File path to prepend
  */
 void ResourceManager::PrependPath(string str) {
+    boost::mutex::scoped_lock lock(mutex);
 	paths.push_front(str);
 }
 
@@ -66,6 +77,7 @@ void ResourceManager::PrependPath(string str) {
  * @return If the given path is already added
  */
 bool ResourceManager::IsInPath(string p) {
+    boost::mutex::scoped_lock lock(mutex);
 	list<string>::iterator itr;
 	for (itr = paths.begin(); itr != paths.end() ; itr++) {
 		if ((*itr) == p) {
@@ -83,31 +95,48 @@ bool ResourceManager::IsInPath(string p) {
  * @return The complete file path or the empty string if file is not found in path
  */
 string ResourceManager::FindFileInPath(string file) { 
+    return FindFile(names.Intern(file));
+}
+
+/**
+ * Find an interned file name in the search paths.
+ *
+ * @param file Interned file name to find in path
+ *
+ * @return The complete file path or the empty string if file is not found in path
+ */
+string ResourceManager::FindFile(Name file) {
 	// looking in path cache for file -> fullpath
-	map<string, string>::iterator thefile = pathcache.find(file);
-	if (thefile != pathcache.end())
-        return thefile->second;
+    string fullpath;
+    if (pathcache.Find(file, fullpath))
+        return fullpath;
+
+    // copy the search path so the file system is not queried while
+    // holding the lock
+    list<string> search;
+    {
+        boost::mutex::scoped_lock lock(mutex);
+        search = paths;
+    }
 
 	// file not found in cache, looking it up!
 	list<string> possibles;
-	for (list<string>::iterator itr = paths.begin(); itr != paths.end(); itr++) {
-		string p = (*itr) + file;
+	for (list<string>::iterator itr = search.begin(); itr != search.end(); itr++) {
+		string p = (*itr) + *file;
 		if (fs::exists(p)) {
 			possibles.push_back(p);
 		}
 	}
 
 	if (possibles.size() == 1) {
-		pathcache[file] = *possibles.begin();
-		return *possibles.begin();
+		return pathcache.Insert(file, *possibles.begin());
 	} else if (possibles.size() > 1) {
 		string s = *possibles.begin();
-		logger.warning << "Found more then one file matching the name given: " << file << logger.end;
+		logger.warning << "Found more then one file matching the name given: " << *file << logger.end;
 		for (list<string>::iterator itr = possibles.begin(); itr != possibles.end(); itr++) {
 			logger.warning << (*itr) << logger.end;
 		}
-		pathcache[file] = s;
-		return s;
+		return pathcache.Insert(file, s);
 	} 
 	return "";
 }
@@ -169,9 +198,10 @@ void ResourceManager::AddScriptModule(IScriptModule* module) {
  */
 ITextureResourcePtr ResourceManager::CreateTexture(const string filename) {
     // check if the texture has previously been requested
-	map<string, ITextureResourcePtr>::iterator tex = textures.find(filename);
-	if (tex != textures.end())
-        return tex->second;
+    ITextureResourcePtr texture;
+    Name name = names.Intern(filename);
+    if (textures.Find(name, texture))
+        return texture;
 
     // get the file extension
     string ext = Convert::ToLower(File::Extension(filename));
@@ -184,12 +214,15 @@ ITextureResourcePtr ResourceManager::CreateTexture(const string filename) {
 	
     // load the resource
 	if (plugin != texturePlugins.end()) {
-		string fullname = FindFileInPath(filename);
-		ITextureResourcePtr texture = (*plugin)->CreateResource(fullname);
-        textures[filename] = texture;
+		string fullname = FindFile(name);
+		texture = (*plugin)->CreateResource(fullname);
+        // another thread may have created it in the mean time
+        texture = textures.Insert(name, texture);
+        textures.Evict();
         return texture;
-    } else
+    } else {
         logger.warning << "Plugin for ." << ext << " not found." << logger.end;
+    }
 
 	throw ResourceException("Unsupported file format: " + filename);
 }
@@ -203,9 +236,10 @@ ITextureResourcePtr ResourceManager::CreateTexture(const string filename) {
  */
 IModelResourcePtr ResourceManager::CreateModel(const string filename) {
     // check if the model has previously been requested
-	map<string, IModelResourcePtr>::iterator res = models.find(filename);
-	if(res != models.end())
-  		return res->second;
+    IModelResourcePtr model;
+    Name name = names.Intern(filename);
+    if (models.Find(name, model))
+        return model;
 
     // get the file extension
     string ext = Convert::ToLower(File::Extension(filename));
@@ -218,12 +252,15 @@ IModelResourcePtr ResourceManager::CreateModel(const string filename) {
 	
 	// load the resource
 	if (plugin != modelPlugins.end()) {
-		string fullname = FindFileInPath(filename);
-		IModelResourcePtr model = (*plugin)->CreateResource(fullname);
-        models[filename] = model;
+		string fullname = FindFile(name);
+		model = (*plugin)->CreateResource(fullname);
+        // another thread may have created it in the mean time
+        model = models.Insert(name, model);
+        models.Evict();
         return model;
-    } else
+    } else {
         logger.warning << "Plugin for ." << ext << " not found." << logger.end;
+    }
 
     throw ResourceException("Unsupported file format: " + filename);
 }
@@ -237,9 +274,10 @@ IModelResourcePtr ResourceManager::CreateModel(const string filename) {
  */
 IShaderResourcePtr ResourceManager::CreateShader(const string filename) {
     // check if the shader has previously been requested
- 	map<string, IShaderResourcePtr>::iterator res = shaders.find(filename);
- 	if (res != shaders.end())
-   		return res->second;
+    IShaderResourcePtr shader;
+    Name name = names.Intern(filename);
+    if (shaders.Find(name, shader))
+        return shader;
 
     // get the file extension
     string ext = Convert::ToLower(File::Extension(filename));
@@ -252,12 +290,15 @@ IShaderResourcePtr ResourceManager::CreateShader(const string filename) {
 
     // load the resource
 	if (plugin != shaderPlugins.end()) {
-		string fullname = FindFileInPath(filename);
-		IShaderResourcePtr shader = (*plugin)->CreateResource(fullname);
-        shaders[filename] = shader;
+		string fullname = FindFile(name);
+		shader = (*plugin)->CreateResource(fullname);
+        // another thread may have created it in the mean time
+        shader = shaders.Insert(name, shader);
+        shaders.Evict();
         return shader;
-    } else
+    } else {
         logger.warning << "Plugin for ." << ext << " not found." << logger.end;
+    }
 
     throw ResourceException("Unsupported shader format: " + filename);
 }
@@ -307,19 +348,254 @@ vector<IScriptModule*> ResourceManager::GetScriptModules(const string language)
 	return modules;
 }
 
+/**
+ * Create and load a resource on a scheduler thread.
+ * On completion the publication of the resource is queued for the
+ * engine thread.
+ *
+ * @param plugin Plug-in to create the resource with.
+ * @param filename Interned resource file as given by the user.
+ * @param future Future to complete.
+ * @param cache Resource cache to publish in.
+ */
+template <class T, class P>
+void ResourceManager::LoadAsync(P* plugin, Name filename,
+                                boost::shared_ptr<ResourceFuture<T> > future,
+                                ResourceCache<T>* cache) {
+    boost::shared_ptr<T> resource;
+    string error;
+    try {
+        string fullname = FindFile(filename);
+        resource = plugin->CreateResource(fullname);
+        resource->Load();
+    } catch (std::exception& e) {
+        error = e.what();
+    } catch (...) {
+        error = "Unknown error while loading: " + *filename;
+    }
+    // complete the future and queue its publication atomically, so
+    // a Publish() following Wait() always sees the load
+    boost::mutex::scoped_lock lock(publishMutex);
+    if (error.empty())
+        future->SetLoaded(resource);
+    else
+        future->SetFailed(error);
+    publishQueue.push_back(boost::bind(&ResourceManager::PublishAsync<T>,
+                                       filename, future, cache));
+}
+
+/**
+ * Publish a background loaded resource.
+ * Called on the engine thread from Publish().
+ *
+ * @param filename Interned resource file as given by the user.
+ * @param future Completed future.
+ * @param cache Resource cache to publish in.
+ */
+template <class T>
+void ResourceManager::PublishAsync(Name filename,
+                                   boost::shared_ptr<ResourceFuture<T> > future,
+                                   ResourceCache<T>* cache) {
+    if (future->IsFailed()) {
+        logger.warning << "Background load failed: " << future->error << logger.end;
+        return;
+    }
+    // a resource created synchronously while we were loading may not
+    // be loaded, so the loaded one replaces it in the cache. Its users
+    // keep it, and nothing is loaded on the engine thread.
+    boost::shared_ptr<T> resource = future->Get();
+    if (cache->Insert(filename, resource) != resource)
+        cache->Replace(filename, resource);
+    cache->Evict();
+    future->SetPublished(resource);
+}
+
+/**
+ * Create a texture resource object in the background.
+ * The texture file is located, created and loaded on a scheduler
+ * thread.
+ *
+ * @param filename Texture file
+ * @return Future of the texture resource
+ * @throws ResourceException if the texture format is unsupported
+ */
+ITextureResourceFuturePtr ResourceManager::CreateTextureAsync(const string filename) {
+    // check if the texture has previously been requested
+    ITextureResourcePtr texture;
+    Name name = names.Intern(filename);
+    if (textures.Find(name, texture))
+        return ITextureResourceFuturePtr(new ResourceFuture<ITextureResource>(texture));
+
+    // get the file extension
+    string ext = Convert::ToLower(File::Extension(filename));
+	vector<ITextureResourcePlugin*>::iterator plugin;
+	for (plugin = texturePlugins.begin(); plugin != texturePlugins.end() ; plugin++) {
+		if ((*plugin)->AcceptsExtension(ext)) {
+			break;
+		}
+	}
+
+    // queue the resource for loading
+	if (plugin != texturePlugins.end()) {
+        ITextureResourceFuturePtr future(new ResourceFuture<ITextureResource>());
+        TaskScheduler::GetDefault().Spawn(
+            boost::bind(&ResourceManager::LoadAsync<ITextureResource,ITextureResourcePlugin>,
+                        *plugin, name, future, &textures), &loads);
+        return future;
+    } else {
+        logger.warning << "Plugin for ." << ext << " not found." << logger.end;
+    }
+
+	throw ResourceException("Unsupported file format: " + filename);
+}
+
+/**
+ * Create a model resource object in the background.
+ * The model file is located, created and loaded on a scheduler
+ * thread.
+ *
+ * @param filename Model file
+ * @return Future of the model resource
+ * @throws ResourceException if the model format is unsupported
+ */
+IModelResourceFuturePtr ResourceManager::CreateModelAsync(const string filename) {
+    // check if the model has previously been requested
+    IModelResourcePtr model;
+    Name name = names.Intern(filename);
+    if (models.Find(name, model))
+        return IModelResourceFuturePtr(new ResourceFuture<IModelResource>(model));
+
+    // get the file extension
+    string ext = Convert::ToLower(File::Extension(filename));
+	vector<IModelResourcePlugin*>::iterator plugin;
+	for (plugin = modelPlugins.begin(); plugin != modelPlugins.end() ; plugin++) {
+		if ((*plugin)->AcceptsExtension(ext)) {
+			break;
+		}
+	}
+
+    // queue the resource for loading
+	if (plugin != modelPlugins.end()) {
+        IModelResourceFuturePtr future(new ResourceFuture<IModelResource>());
+        TaskScheduler::GetDefault().Spawn(
+            boost::bind(&ResourceManager::LoadAsync<IModelResource,IModelResourcePlugin>,
+                        *plugin, name, future, &models), &loads);
+        return future;
+    } else {
+        logger.warning << "Plugin for ." << ext << " not found." << logger.end;
+    }
+
+    throw ResourceException("Unsupported file format: " + filename);
+}
+
+/**
+ * Publish resources loaded in the background.
+ * Completed background loads are inserted in the resource cache and
+ * their futures notified. Must be called on the engine thread, which
+ * is done every frame by the ResourcePublisher module.
+ *
+ * @return Number of completed loads processed.
+ */
+unsigned int ResourceManager::Publish() {
+    list<boost::function<void ()> > queue;
+    {
+        boost::mutex::scoped_lock lock(publishMutex);
+        queue.swap(publishQueue);
+    }
+    list<boost::function<void ()> >::iterator itr;
+    for (itr = queue.begin(); itr != queue.end(); itr++)
+        (*itr)();
+    return queue.size();
+}
+
+/**
+ * Set the memory budget of the texture cache.
+ *
+ * @param bytes Budget in bytes, zero for unlimited.
+ */
+void ResourceManager::SetTextureBudget(const unsigned long bytes) {
+    textures.SetBudget(bytes);
+}
+
+/**
+ * Set the memory budget of the model cache.
+ *
+ * @param bytes Budget in bytes, zero for unlimited.
+ */
+void ResourceManager::SetModelBudget(const unsigned long bytes) {
+    models.SetBudget(bytes);
+}
+
+/**
+ * Set the memory budget of the shader cache.
+ *
+ * @param bytes Budget in bytes, zero for unlimited.
+ */
+void ResourceManager::SetShaderBudget(const unsigned long bytes) {
+    shaders.SetBudget(bytes);
+}
+
+/**
+ * Evict unused resources from caches exceeding their budget.
+ * Resources are only evicted when nothing but the cache refers to
+ * them, so this is done every frame by the ResourcePublisher module
+ * to reclaim resources released since they were cached.
+ *
+ * @return Number of resources evicted.
+ */
+unsigned int ResourceManager::Evict() {
+    return textures.Evict() + models.Evict() + shaders.Evict();
+}
+
+/**
+ * Get the texture cache counters.
+ *
+ * @return Texture cache statistics.
+ */
+ResourceCacheStatistics ResourceManager::GetTextureStatistics() {
+    return textures.GetStatistics();
+}
+
+/**
+ * Get the model cache counters.
+ *
+ * @return Model cache statistics.
+ */
+ResourceCacheStatistics ResourceManager::GetModelStatistics() {
+    return models.GetStatistics();
+}
+
+/**
+ * Get the shader cache counters.
+ *
+ * @return Shader cache statistics.
+ */
+ResourceCacheStatistics ResourceManager::GetShaderStatistics() {
+    return shaders.GetStatistics();
+}
 
 /**
  * Shutdown the resource manager.
- * Flushes the resource object lists.
+ * Waits for the pending background loads, drops their publication
+ * and flushes the resource object lists and the path cache.
  */
 void ResourceManager::Shutdown() {
-    textures.clear();
+    // finish pending background loads and drop their publication
+    if (!loads.IsDone())
+        TaskScheduler::GetDefault().Wait(loads);
+    {
+        boost::mutex::scoped_lock lock(publishMutex);
+        publishQueue.clear();
+    }
+    pathcache.Clear();
+
+    textures.Clear();
 	texturePlugins.clear();
 
-    models.clear();
+    models.Clear();
 	modelPlugins.clear();
 
-    shaders.clear();
+    shaders.Clear();
 	shaderPlugins.clear();
 
 	scriptPlugins.clear();
@@ -14,6 +14,13 @@
 #include <Resources/IModelResource.h>
 #include <Resources/IShaderResource.h>
 #include <Resources/IScriptResource.h>
+#include <Resources/ResourceFuture.h>
+#include <Resources/ResourceCache.h>
+#include <Utils/ConcurrentHashMap.h>
+#include <Utils/StringPool.h>
+#include <Utils/TaskScheduler.h>
+#include <boost/function.hpp>
+#include <boost/thread/mutex.hpp>
 #include <string>
 #include <map>
 #include <vector>
@@ -24,29 +31,72 @@ namespace OpenEngine {
 namespace Resources {
 
 using namespace std;
+using OpenEngine::Utils::TaskGroup;
+using OpenEngine::Utils::ConcurrentHashMap;
+using OpenEngine::Utils::StringPool;
+
+//! Future of a texture resource.
+typedef boost::shared_ptr<ResourceFuture<ITextureResource> > ITextureResourceFuturePtr;
+//! Future of a model resource.
+typedef boost::shared_ptr<ResourceFuture<IModelResource> >   IModelResourceFuturePtr;
 
 /**
  * Resource manager.
  *
+ * Resources can be created synchronously with the Create methods or
+ * in the background with the CreateAsync methods. Background loads
+ * are created and loaded as tasks on the default task scheduler,
+ * shared with the engine modules, and published
+ * to the resource cache when Publish() is called on the engine
+ * thread (see ResourcePublisher).
+ *
+ * The resource caches are sharded hash maps keyed on interned file
+ * names, so any number of threads may look up and create resources
+ * concurrently. Each cache can be given a memory budget, in which
+ * case resources no longer used outside the cache are evicted, least
+ * recently used first, when the budget is exceeded (see
+ * ResourceCache).
+ *
  * @class ResourceManager ResourceManager.h Resources/ResourceManager.h
  */
 class ResourceManager {
 private:
+    typedef StringPool::Handle Name;
+
+    // file names are interned once per call, the caches are keyed
+    // on the handles
+    static StringPool names;
     static list<string> paths;
-	static map<string, string> pathcache;
+    static ConcurrentHashMap<Name, string> pathcache;
 
     static vector<ITextureResourcePlugin*>  texturePlugins;
-    static map<string, ITextureResourcePtr> textures;
+    static ResourceCache<ITextureResource> textures;
 
     static vector<IModelResourcePlugin*>    modelPlugins;
-    static map<string, IModelResourcePtr>   models;
+    static ResourceCache<IModelResource>   models;
 
     static vector<IShaderResourcePlugin*>   shaderPlugins;
-    static map<string, IShaderResourcePtr>  shaders;
+    static ResourceCache<IShaderResource>  shaders;
 
 	static vector<IScriptResourcePlugin*>   scriptPlugins;
 	static vector<IScriptModule*>           scriptModules;
 
+    static boost::mutex mutex;          // guards paths
+    static TaskGroup loads;             // background loads not yet done
+
+    static boost::mutex publishMutex;   // guards the publish queue
+    static list<boost::function<void ()> > publishQueue;
+
+    template <class T, class P>
+    static void LoadAsync(P* plugin, Name filename,
+                          boost::shared_ptr<ResourceFuture<T> > future,
+                          ResourceCache<T>* cache);
+    template <class T>
+    static void PublishAsync(Name filename,
+                             boost::shared_ptr<ResourceFuture<T> > future,
+                             ResourceCache<T>* cache);
+    static string FindFile(Name file);
+
 public:
     static void AppendPath(string);
     static void PrependPath(string);
@@ -65,6 +115,18 @@ public:
 	static IScriptResourcePtr CreateScript(const string language);
 	static vector<IScriptModule*> GetScriptModules(const string language);
 
+    static ITextureResourceFuturePtr CreateTextureAsync(const string filename);
+    static IModelResourceFuturePtr   CreateModelAsync(const string filename);
+    static unsigned int Publish();
+
+    static void SetTextureBudget(const unsigned long bytes);
+    static void SetModelBudget(const unsigned long bytes);
+    static void SetShaderBudget(const unsigned long bytes);
+    static unsigned int Evict();
+    static ResourceCacheStatistics GetTextureStatistics();
+    static ResourceCacheStatistics GetModelStatistics();
+    static ResourceCacheStatistics GetShaderStatistics();
+
 	static void Shutdown();
 };
 
@@ -0,0 +1,36 @@
+// Resource publisher module.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS) 
+// 
+// This program is free software; It is covered by the GNU General 
+// Public License version 2 or any later version. 
+// See the GNU General Public License for more details (see LICENSE). 
+//--------------------------------------------------------------------
+
+#include <Resources/ResourcePublisher.h>
+#include <Resources/ResourceManager.h>
+
+namespace OpenEngine {
+namespace Resources {
+
+    ResourcePublisher::ResourcePublisher() {}
+
+    bool ResourcePublisher::IsTypeOf(const std::type_info& inf) { 
+        return typeid(ResourcePublisher) == inf;
+    }
+
+    void ResourcePublisher::Initialize() {
+        ResourceManager::Publish();
+    }
+
+    void ResourcePublisher::Process(const float deltaTime, const float percent) {
+        ResourceManager::Publish();
+        ResourceManager::Evict();
+    }
+
+    void ResourcePublisher::Deinitialize() {
+        ResourceManager::Publish();
+    }
+
+} // NS Resources
+} // NS OpenEngine
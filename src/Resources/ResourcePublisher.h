@@ -0,0 +1,45 @@
+// Resource publisher module.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS) 
+// 
+// This program is free software; It is covered by the GNU General 
+// Public License version 2 or any later version. 
+// See the GNU General Public License for more details (see LICENSE). 
+//--------------------------------------------------------------------
+
+#ifndef _RESOURCE_PUBLISHER_H_
+#define _RESOURCE_PUBLISHER_H_
+
+#include <Core/IModule.h>
+
+namespace OpenEngine {
+namespace Resources {
+
+using namespace OpenEngine::Core;
+
+/**
+ * Resource publisher module.
+ * Publishes resources loaded in the background by the
+ * ResourceManager once every frame. Add it to the engine to have
+ * futures from the CreateAsync methods complete on the engine
+ * thread. It also evicts resources released since they were cached
+ * from caches exceeding their memory budget.
+ *
+ * @class ResourcePublisher ResourcePublisher.h Resources/ResourcePublisher.h
+ */
+class ResourcePublisher : public IModule {
+public:
+    ResourcePublisher();
+
+    // IModule methods
+    bool IsTypeOf(const std::type_info& inf);
+    void Initialize();
+    void Process(const float deltaTime, const float percent);
+    void Deinitialize();
+
+};
+
+} // NS Resources
+} // NS OpenEngine
+
+#endif // _RESOURCE_PUBLISHER_H_
@@ -107,6 +107,11 @@ void TGAResource::Unload() {
     }
 }
 
+unsigned int TGAResource::GetMemoryCost() {
+    if (!loaded) return 0;
+    return width * height * (depth/8);
+}
+
 int TGAResource::GetID(){
     return id;
 }
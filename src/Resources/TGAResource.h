@@ -49,6 +49,7 @@ public:
     // resource methods
     void Load();
     void Unload();
+    unsigned int GetMemoryCost();
 
     // texture resource methods
 	int GetID();
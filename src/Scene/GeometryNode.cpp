@@ -10,14 +10,20 @@
 #include <Scene/GeometryNode.h>
 #include <Scene/TransformationNode.h>
 #include <Logging/Logger.h>
+#include <boost/detail/atomic_count.hpp>
 
 namespace OpenEngine {
 namespace Scene {
 
-    GeometryNode::GeometryNode() : faces(NULL) {
+    using OpenEngine::Geometry::FaceList;
+
+    // last version given to a node
+    static boost::detail::atomic_count versions(0);
+
+    GeometryNode::GeometryNode() : faces(NULL), version(++versions) {
     }
 
-    GeometryNode::GeometryNode(FaceSet* faces) : faces(faces) {
+    GeometryNode::GeometryNode(FaceSet* faces) : faces(faces), version(++versions) {
     }
     
     GeometryNode::~GeometryNode() {
@@ -29,6 +35,39 @@ namespace Scene {
 
     void GeometryNode::SetFaceSet(FaceSet* faces){
         this->faces = faces;
+        Changed();
+    }
+
+    void GeometryNode::Changed() {
+        version = ++versions;
+        InvalidateBounds();
+    }
+
+    unsigned long GeometryNode::GetVersion() {
+        return version;
+    }
+
+    /**
+     * Compute the bounding box of the face set merged with the
+     * bounds of the sub nodes.
+     */
+    ISceneNode::BoundsType GeometryNode::ComputeBounds(Vector<3,float>& min, Vector<3,float>& max) {
+        BoundsType type = SceneNode::ComputeBounds(min, max);
+        if (faces == NULL || faces->Size() == 0) return type;
+
+        FaceList::iterator itr = faces->begin();
+        Vector<3,float> fmin((*itr)->vert[0]);
+        Vector<3,float> fmax(fmin);
+        for (; itr != faces->end(); itr++) {
+            for (int i=0; i<3; i++) {
+                Vector<3,float>& v = (*itr)->vert[i];
+                for (int j=0; j<3; j++) {
+                    if (v[j] < fmin[j]) fmin[j] = v[j];
+                    if (v[j] > fmax[j]) fmax[j] = v[j];
+                }
+            }
+        }
+        return MergeBounds(type, min, max, FINITE_BOUNDS, fmin, fmax);
     }
 
     void GeometryNode::Accept(ISceneNodeVisitor& v) {
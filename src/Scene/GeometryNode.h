@@ -26,12 +26,23 @@ using OpenEngine::Math::Quaternion;
 /**
  * Geometry node.
  * Acts as a simple node wrapping a face set.
+ * The bounds of the node are the bounding box of the face set. Faces
+ * modified in place require a call to Changed().
+ *
+ * Each node has a version that changes whenever its face set is set
+ * or changed, and that no other node ever had, so data cached for a
+ * node, such as a vertex batch, can be checked against the node it
+ * was built for even if the node was deleted and its address reused.
  *
  * @class GeometryNode GeometryNode.h Scene/GeometryNode.h
  */
 class GeometryNode : public SceneNode {
 private:
     FaceSet* faces;
+    unsigned long version;
+
+protected:
+    BoundsType ComputeBounds(Vector<3,float>& min, Vector<3,float>& max);
 
 public:
     /**
@@ -65,6 +76,23 @@ public:
      */
     void SetFaceSet(FaceSet* faces);
 
+    /**
+     * Mark the faces of the node changed in place.
+     * Gives the node a new version and invalidates its bounds, so
+     * batches and bounds built from the old faces are rebuilt.
+     * InvalidateBounds() alone leaves the batches as they are.
+     */
+    void Changed();
+
+    /**
+     * Get the version of the node.
+     * Changes when the face set is set or changed, and is unique
+     * among all nodes.
+     *
+     * @return Version of the node.
+     */
+    unsigned long GetVersion();
+
     /**
      * Accept a visitor.
      *
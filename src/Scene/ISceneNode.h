@@ -10,6 +10,7 @@
 #ifndef _INTERFACE_SCENE_NODE_H_
 #define _INTERFACE_SCENE_NODE_H_
 
+#include <Math/Vector.h>
 #include <list>
 
 namespace OpenEngine {
@@ -19,6 +20,7 @@ namespace Scene {
 class ISceneNodeVisitor;
 
 using std::list;
+using OpenEngine::Math::Vector;
 
 /**
  * Scene node interface.
@@ -42,6 +44,13 @@ public:
     //! List of sub nodes
     list<ISceneNode*> subNodes;
 
+    //! Kinds of bounds of a sub tree
+    enum BoundsType {
+        NO_BOUNDS,      //!< nothing is drawn in the sub tree
+        FINITE_BOUNDS,  //!< the sub tree is bounded by a box
+        INFINITE_BOUNDS //!< the extent of the sub tree is unknown
+    };
+
     /**
      * Default constructor.
      */      
@@ -97,6 +106,25 @@ public:
      */
     virtual void Accept(ISceneNodeVisitor& visitor) = 0;
 
+    /**
+     * Get the axis aligned bounds of the sub tree.
+     * The bounds are in the coordinate system the node is placed in,
+     * so they include the transformation of a transformation node.
+     * The min and max corners are only set for finite bounds.
+     *
+     * @param min Minimum corner of the bounds.
+     * @param max Maximum corner of the bounds.
+     * @return Kind of bounds.
+     */
+    virtual BoundsType GetBounds(Vector<3,float>& min, Vector<3,float>& max) = 0;
+
+    /**
+     * Mark the bounds of the node and all its parents out of date.
+     * Must be called when the geometry below the node is changed
+     * without the scene knowing, like modifying a face set in place.
+     */
+    virtual void InvalidateBounds() = 0;
+
 };
 
 } // NS Scene
@@ -9,12 +9,13 @@
 
 #include <Scene/SceneNode.h>
 #include <Scene/ISceneNodeVisitor.h>
+#include <Scene/TransformationNode.h>
 #include <Logging/Logger.h>
 
 namespace OpenEngine {
 namespace Scene {
 
-SceneNode::SceneNode() {
+SceneNode::SceneNode() : boundsType(NO_BOUNDS), boundsDirty(true) {
     parent = NULL;
 }
 
@@ -30,7 +31,7 @@ ISceneNode* SceneNode::GetParent() {
 }
 
 void SceneNode::SetParent(ISceneNode* node) {
-    if(parent!=NULL)
+    if(parent!=NULL && node!=NULL)
         logger.warning << "parent overwrited" << logger.end;
     parent = node;
 }
@@ -45,10 +46,94 @@ void SceneNode::AddNode(ISceneNode* sub) {
     if (sub == NULL) return;
     subNodes.push_back(sub);
     sub->SetParent(this);
+    // the sub tree now has new parenting transformations
+    TransformationNode::InvalidateWorld(sub);
+    InvalidateBounds();
 }
 
 void SceneNode::RemoveNode(ISceneNode* sub) {
     subNodes.remove(sub);
+    if (sub != NULL && sub->GetParent() == this) {
+        // the detached sub tree must not reach back into this tree,
+        // and has lost its parenting transformations
+        sub->SetParent(NULL);
+        TransformationNode::InvalidateWorld(sub);
+    }
+    InvalidateBounds();
+}
+
+/**
+ * Get the bounds of the sub tree, recomputing them if out of date.
+ *
+ * @see ISceneNode::GetBounds()
+ */
+ISceneNode::BoundsType SceneNode::GetBounds(Vector<3,float>& min, Vector<3,float>& max) {
+    if (boundsDirty) {
+        boundsType = ComputeBounds(boundsMin, boundsMax);
+        boundsDirty = false;
+    }
+    min = boundsMin;
+    max = boundsMax;
+    return boundsType;
+}
+
+/**
+ * Mark the bounds of the node and its parents out of date.
+ * The parents of a node with out of date bounds are already out of
+ * date, so the walk stops there.
+ */
+void SceneNode::InvalidateBounds() {
+    if (boundsDirty) return;
+    boundsDirty = true;
+    if (parent != NULL) parent->InvalidateBounds();
+}
+
+/**
+ * Compute the bounds of the sub tree.
+ * The default bounds are the union of the bounds of the sub nodes.
+ *
+ * @param min Minimum corner of the bounds.
+ * @param max Maximum corner of the bounds.
+ * @return Kind of bounds.
+ */
+ISceneNode::BoundsType SceneNode::ComputeBounds(Vector<3,float>& min, Vector<3,float>& max) {
+    BoundsType type = NO_BOUNDS;
+    Vector<3,float> smin, smax;
+    list<ISceneNode*>::iterator itr;
+    for (itr = subNodes.begin(); itr != subNodes.end() && type != INFINITE_BOUNDS; itr++) {
+        BoundsType t = (*itr)->GetBounds(smin, smax);
+        type = MergeBounds(type, min, max, t, smin, smax);
+    }
+    return type;
+}
+
+/**
+ * Merge bounds into other bounds.
+ * Infinite bounds absorb everything and no bounds absorb nothing.
+ *
+ * @param a Kind of the bounds to merge into.
+ * @param min Minimum corner of the bounds to merge into.
+ * @param max Maximum corner of the bounds to merge into.
+ * @param b Kind of the bounds to merge.
+ * @param bmin Minimum corner of the bounds to merge.
+ * @param bmax Maximum corner of the bounds to merge.
+ * @return Kind of the merged bounds.
+ */
+ISceneNode::BoundsType SceneNode::MergeBounds(BoundsType a, Vector<3,float>& min, Vector<3,float>& max,
+                                              BoundsType b, const Vector<3,float>& bmin,
+                                              const Vector<3,float>& bmax) {
+    if (a == INFINITE_BOUNDS || b == NO_BOUNDS) return a;
+    if (b == INFINITE_BOUNDS) return b;
+    if (a == NO_BOUNDS) {
+        min = bmin;
+        max = bmax;
+        return FINITE_BOUNDS;
+    }
+    for (int i=0; i<3; i++) {
+        if (bmin.Get(i) < min[i]) min[i] = bmin.Get(i);
+        if (bmax.Get(i) > max[i]) max[i] = bmax.Get(i);
+    }
+    return FINITE_BOUNDS;
 }
 
 } // NS Scene
@@ -19,9 +19,25 @@ namespace Scene {
 /**
  * Base class for scene nodes.
  *
+ * Scene nodes cache the bounds of their sub tree, which are the union
+ * of the bounds of the sub nodes unless a node type computes its own.
+ * Adding or removing sub nodes invalidates the bounds of the node and
+ * its parents.
+ *
  * @class SceneNode SceneNode.h Scene/SceneNode.h
  */
 class SceneNode : public ISceneNode {
+private:
+    Vector<3,float> boundsMin, boundsMax;   //!< cached bounds
+    BoundsType boundsType;                  //!< kind of cached bounds
+    bool boundsDirty;                       //!< cached bounds out of date
+
+protected:
+    virtual BoundsType ComputeBounds(Vector<3,float>& min, Vector<3,float>& max);
+    static BoundsType MergeBounds(BoundsType a, Vector<3,float>& min, Vector<3,float>& max,
+                                  BoundsType b, const Vector<3,float>& bmin,
+                                  const Vector<3,float>& bmax);
+
 public:
     SceneNode();
     virtual ~SceneNode();
@@ -31,6 +47,8 @@ public:
     void RemoveNode(ISceneNode* sub);
     void VisitSubNodes(ISceneNodeVisitor& visitor);
     void Accept(ISceneNodeVisitor& visitor);
+    BoundsType GetBounds(Vector<3,float>& min, Vector<3,float>& max);
+    void InvalidateBounds();
 };
 
 } // NS Scene
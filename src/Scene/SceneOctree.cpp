@@ -0,0 +1,281 @@
+// Spatial index of the geometry nodes of a scene.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#include <Scene/SceneOctree.h>
+#include <Scene/ISceneNodeVisitor.h>
+#include <Scene/GeometryNode.h>
+#include <Scene/TransformationNode.h>
+
+namespace OpenEngine {
+namespace Scene {
+
+static bool Equals(Matrix<4,4,float>& a, Matrix<4,4,float>& b) {
+    for (int i=0; i<4; i++)
+        for (int j=0; j<4; j++)
+            if (a(i,j) != b(i,j)) return false;
+    return true;
+}
+
+// adds the geometry nodes of a scene to an index, grouped by the
+// nearest transformation node above them
+class SceneOctreeBuilder : public ISceneNodeVisitor {
+private:
+    SceneOctree& index;
+    unsigned int group;
+
+public:
+    SceneOctreeBuilder(SceneOctree& index) : index(index), group(0) {}
+
+    void VisitTransformationNode(TransformationNode* node) {
+        SceneOctree::Group g;
+        g.transformation = node;
+        g.world = node->GetWorldMatrix();
+        g.dirty = false;
+        index.groups.push_back(g);
+        unsigned int parent = group;
+        group = index.groups.size() - 1;
+        if (node->GetTransformStore() != NULL)
+            index.polled.push_back(group);
+        else
+            index.Bind(node, group);
+        node->VisitSubNodes(*this);
+        group = parent;
+    }
+
+    void VisitGeometryNode(GeometryNode* node) {
+        Vector<3,float> min, max;
+        if (node->GetBounds(min, max) == ISceneNode::FINITE_BOUNDS) {
+            Box local((min + max) * 0.5f, (max - min) * 0.5f);
+            SceneOctree::Group& g = index.groups[group];
+            unsigned int id = index.octree.Add(local.GetTransformed(g.world));
+            g.objects.push_back(id);
+            index.nodes.push_back(node);
+            index.bounds.push_back(local);
+        }
+        node->VisitSubNodes(*this);
+    }
+};
+
+/**
+ * Create an empty index.
+ * The root cell should cover the scene; nodes outside it are still
+ * found, but not as fast.
+ *
+ * @param center Center of the root cell.
+ * @param halfSize Half the size of the root cell.
+ * @param maxDepth Depth of the smallest cells [optional].
+ */
+SceneOctree::SceneOctree(const Vector<3,float> center, const float halfSize,
+                         const unsigned int maxDepth)
+    : octree(center, halfSize, maxDepth) {}
+
+/**
+ * Destructor, releases the transformation nodes of the index.
+ */
+SceneOctree::~SceneOctree() {
+    Clear();
+}
+
+/**
+ * Index the geometry nodes of a scene, replacing the current content.
+ *
+ * @param root Root of the scene.
+ */
+void SceneOctree::Build(ISceneNode* root) {
+    Clear();
+    Group g;
+    g.transformation = NULL;
+    g.dirty = false;
+    groups.push_back(g);
+    SceneOctreeBuilder builder(*this);
+    root->Accept(builder);
+}
+
+/**
+ * Relocate the geometry nodes below transformation nodes that have
+ * moved since the last update.
+ *
+ * @return Number of geometry nodes relocated.
+ */
+unsigned int SceneOctree::Update() {
+    unsigned int moved = 0;
+    for (unsigned int i=0; i<dirty.size(); i++) {
+        Group& g = groups[dirty[i]];
+        g.dirty = false;
+        if (g.transformation == NULL) continue;
+        moved += Relocate(g);
+    }
+    dirty.clear();
+    for (unsigned int i=0; i<polled.size(); i++) {
+        Group& g = groups[polled[i]];
+        if (g.transformation == NULL) continue;
+        moved += Relocate(g);
+    }
+    return moved;
+}
+
+/**
+ * Relocate the nodes of a group if its world matrix has changed.
+ * Reading the world matrix cleans it, so the transformation node
+ * tells the index again the next time it moves.
+ *
+ * @param g Group to relocate.
+ * @return Number of geometry nodes relocated.
+ */
+unsigned int SceneOctree::Relocate(Group& g) {
+    Matrix<4,4,float> world = g.transformation->GetWorldMatrix();
+    if (Equals(world, g.world)) return 0;
+    g.world = world;
+    for (unsigned int j=0; j<g.objects.size(); j++) {
+        unsigned int id = g.objects[j];
+        octree.Update(id, bounds[id].GetTransformed(world));
+    }
+    return g.objects.size();
+}
+
+/**
+ * Mark a group moved, called by its transformation node.
+ *
+ * @param group Group of the transformation node.
+ */
+void SceneOctree::Invalidate(const unsigned int group) {
+    Group& g = groups[group];
+    if (g.dirty) return;
+    g.dirty = true;
+    dirty.push_back(group);
+}
+
+/**
+ * Have a transformation node tell the index when it moves. Reading
+ * the world matrix when the group was added left it clean, so the
+ * node tells the next time it is invalidated.
+ *
+ * @param node Transformation node of the group.
+ * @param group Group of the transformation node.
+ */
+void SceneOctree::Bind(TransformationNode* node, const unsigned int group) {
+    if (node->index != NULL) node->index->Unbind(node->group);
+    node->index = this;
+    node->group = group;
+}
+
+/**
+ * Forget the transformation node of a group, called when the node is
+ * destroyed or indexed by another index.
+ *
+ * @param group Group of the transformation node.
+ */
+void SceneOctree::Unbind(const unsigned int group) {
+    groups[group].transformation = NULL;
+}
+
+/**
+ * Remove all nodes from the index.
+ */
+void SceneOctree::Clear() {
+    for (unsigned int i=0; i<groups.size(); i++) {
+        TransformationNode* node = groups[i].transformation;
+        if (node != NULL && node->index == this) node->index = NULL;
+    }
+    octree.Clear();
+    groups.clear();
+    dirty.clear();
+    polled.clear();
+    nodes.clear();
+    bounds.clear();
+}
+
+/**
+ * Get the octree of the index.
+ * The octree ids are mapped to nodes by GetNode().
+ *
+ * @return Octree of the world space bounds.
+ */
+const LooseOctree& SceneOctree::GetOctree() const {
+    return octree;
+}
+
+/**
+ * Get the geometry node of an octree id.
+ *
+ * @param id Id of the node in the octree.
+ * @return Geometry node.
+ */
+GeometryNode* SceneOctree::GetNode(const unsigned int id) const {
+    return nodes[id];
+}
+
+/**
+ * Get the number of indexed nodes.
+ *
+ * @return Number of geometry nodes.
+ */
+unsigned int SceneOctree::Size() const {
+    return nodes.size();
+}
+
+void SceneOctree::Collect(vector<GeometryNode*>& result) {
+    for (unsigned int i=0; i<ids.size(); i++)
+        result.push_back(nodes[ids[i]]);
+    ids.clear();
+}
+
+/**
+ * Find the nodes whose world bounds are inside or intersect a set
+ * of planes.
+ *
+ * @param planes Planes with normals pointing inwards.
+ * @param count Number of planes.
+ * @param result Vector to append the nodes to.
+ * @see LooseOctree::Query(Plane* const[], const unsigned int, vector<unsigned int>&)
+ */
+void SceneOctree::Query(Plane* const planes[], const unsigned int count,
+                        vector<GeometryNode*>& result) {
+    octree.Query(planes, count, ids);
+    Collect(result);
+}
+
+/**
+ * Find the nodes whose world bounds overlap a sphere.
+ *
+ * @param sphere Sphere in world coordinates.
+ * @param result Vector to append the nodes to.
+ */
+void SceneOctree::Query(const Sphere& sphere, vector<GeometryNode*>& result) {
+    octree.Query(sphere, ids);
+    Collect(result);
+}
+
+/**
+ * Find the nodes whose world bounds overlap a box.
+ *
+ * @param box Box in world coordinates.
+ * @param result Vector to append the nodes to.
+ */
+void SceneOctree::Query(const Box& box, vector<GeometryNode*>& result) {
+    octree.Query(box, ids);
+    Collect(result);
+}
+
+/**
+ * Find the nodes whose world bounds are hit by a ray, nearest first.
+ *
+ * @param origin Origin of the ray.
+ * @param direction Direction of the ray.
+ * @param result Vector to append the nodes to.
+ * @param maxDistance Largest ray parameter to consider [optional].
+ */
+void SceneOctree::Query(const Vector<3,float> origin, const Vector<3,float> direction,
+                        vector<GeometryNode*>& result, const float maxDistance) {
+    octree.Query(origin, direction, ids, maxDistance);
+    Collect(result);
+}
+
+} // NS Scene
+} // NS OpenEngine
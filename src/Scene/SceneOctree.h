@@ -0,0 +1,114 @@
+// Spatial index of the geometry nodes of a scene.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#ifndef _SCENE_OCTREE_H_
+#define _SCENE_OCTREE_H_
+
+#include <Geometry/LooseOctree.h>
+#include <Math/Matrix.h>
+#include <vector>
+
+namespace OpenEngine {
+namespace Scene {
+
+class ISceneNode;
+class GeometryNode;
+class TransformationNode;
+
+using OpenEngine::Geometry::LooseOctree;
+using OpenEngine::Geometry::Box;
+using OpenEngine::Geometry::Sphere;
+using OpenEngine::Geometry::Plane;
+using OpenEngine::Math::Matrix;
+using OpenEngine::Math::Vector;
+using std::vector;
+
+/**
+ * Spatial index of the geometry nodes of a scene.
+ *
+ * The index keeps the world space bounds of every geometry node with
+ * finite bounds in a LooseOctree, so finding the nodes near a point
+ * or inside a volume does not walk the scene graph.
+ *
+ * @code
+ * SceneOctree index(Vector<3,float>(0.0f), 1000);
+ * index.Build(root);
+ * vector<GeometryNode*> near;
+ * index.Query(Sphere(player, 50), near);
+ * node->Move(0,1,0);
+ * index.Update();         // relocate the nodes below moved transformations
+ * @endcode
+ *
+ * The geometry nodes are grouped by the nearest transformation node
+ * above them. The transformation nodes tell the index when their
+ * world transformation becomes dirty, and Update() relocates the
+ * nodes of those groups only, so it costs an octree update per moved
+ * geometry node however large the scene is. Transformation nodes
+ * bound to a TransformStore get their world transformation from the
+ * store, so their groups are compared with the store on every
+ * Update() instead. A transformation node is indexed by one index at
+ * a time, the last one built.
+ *
+ * The local bounds of the nodes and the structure of the scene are
+ * captured when the index is built, so the index must be rebuilt
+ * when nodes are added or removed, or their faces change.
+ *
+ * @class SceneOctree SceneOctree.h Scene/SceneOctree.h
+ */
+class SceneOctree {
+private:
+    struct Group {
+        TransformationNode* transformation; // null for the scene root
+        Matrix<4,4,float> world;            // world matrix when indexed
+        vector<unsigned int> objects;       // octree ids of the nodes
+        bool dirty;                         // in the dirty list
+    };
+
+    LooseOctree octree;
+    vector<Group> groups;
+    vector<unsigned int> dirty;             // groups invalidated since the update
+    vector<unsigned int> polled;            // groups bound to a store
+    vector<GeometryNode*> nodes;            // node of each octree id
+    vector<Box> bounds;                     // local bounds of each id
+    vector<unsigned int> ids;
+
+    void Collect(vector<GeometryNode*>& result);
+    unsigned int Relocate(Group& g);
+    void Bind(TransformationNode* node, const unsigned int group);
+    void Invalidate(const unsigned int group);
+    void Unbind(const unsigned int group);
+
+    friend class SceneOctreeBuilder;
+    friend class TransformationNode;
+
+public:
+    SceneOctree(const Vector<3,float> center, const float halfSize,
+                const unsigned int maxDepth = 8);
+    ~SceneOctree();
+
+    void Build(ISceneNode* root);
+    unsigned int Update();
+    void Clear();
+
+    const LooseOctree& GetOctree() const;
+    GeometryNode* GetNode(const unsigned int id) const;
+    unsigned int Size() const;
+
+    void Query(Plane* const planes[], const unsigned int count,
+               vector<GeometryNode*>& result);
+    void Query(const Sphere& sphere, vector<GeometryNode*>& result);
+    void Query(const Box& box, vector<GeometryNode*>& result);
+    void Query(const Vector<3,float> origin, const Vector<3,float> direction,
+               vector<GeometryNode*>& result, const float maxDistance = FLT_MAX);
+};
+
+} // NS Scene
+} // NS OpenEngine
+
+#endif // _SCENE_OCTREE_H_
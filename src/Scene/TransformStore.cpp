@@ -0,0 +1,311 @@
+// Flat transformation hierarchy.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#include <Scene/TransformStore.h>
+#include <Scene/TransformationNode.h>
+#include <Utils/TaskScheduler.h>
+#include <boost/bind.hpp>
+#include <algorithm>
+
+namespace OpenEngine {
+namespace Scene {
+
+using OpenEngine::Utils::TaskGroup;
+
+// smallest number of transformations updated by a parallel job
+static const unsigned int MIN_RANGE = 1024;
+
+// adds the transformation nodes of a scene to a store in depth first
+// order, keeping track of the handle of the nearest parent
+class StoreBuilder : public ISceneNodeVisitor {
+    TransformStore& store;
+    int parent;
+public:
+    StoreBuilder(TransformStore& store) : store(store), parent(-1) {}
+    void VisitTransformationNode(TransformationNode* node) {
+        int previous = parent;
+        parent = store.Add(parent, node->GetTransformationMatrix(), node);
+        node->VisitSubNodes(*this);
+        parent = previous;
+    }
+};
+
+/**
+ * Create an empty store.
+ */
+TransformStore::TransformStore() : sorted(true), outdated(false) {}
+
+/**
+ * Destructor.
+ * Bound transformation nodes are released from the store.
+ */
+TransformStore::~TransformStore() {
+    Clear();
+}
+
+/**
+ * Build the store from a scene.
+ * All transformation nodes of the scene are added and bound to the
+ * store, and the store is sorted.
+ *
+ * @param root Root of the scene.
+ */
+void TransformStore::Build(ISceneNode* root) {
+    Clear();
+    StoreBuilder builder(*this);
+    root->Accept(builder);
+    Sort();
+}
+
+/**
+ * Remove all transformations and release the bound nodes.
+ */
+void TransformStore::Clear() {
+    for (unsigned int i=0; i<nodes.size(); i++)
+        if (nodes[i] != NULL) nodes[i]->store = NULL;
+    parents.clear();
+    depths.clear();
+    locals.clear();
+    worlds.clear();
+    dirty.clear();
+    changed.clear();
+    handles.clear();
+    indices.clear();
+    nodes.clear();
+    levels.clear();
+    sorted = true;
+    outdated = false;
+}
+
+/**
+ * Add a transformation.
+ * If a node is given it is bound to the new transformation.
+ *
+ * @param parent Handle of the parent transformation, -1 for none.
+ * @param local Local transformation matrix.
+ * @param node Transformation node to bind [optional].
+ * @return Handle of the transformation.
+ */
+unsigned int TransformStore::Add(const int parent, const Matrix<4,4,float> local,
+                                 TransformationNode* node) {
+    unsigned int index = parents.size();
+    unsigned int handle = nodes.size();
+    int p = (parent < 0) ? -1 : (int)indices[parent];
+    unsigned int depth = (p < 0) ? 0 : depths[p] + 1;
+
+    // a new transformation keeps the order sorted if it is not
+    // shallower than the last one
+    if (sorted && index > 0 && depth < depths[index-1])
+        sorted = false;
+    if (sorted && depth == levels.size())
+        levels.push_back(index);
+
+    parents.push_back(p);
+    depths.push_back(depth);
+    locals.push_back(local);
+    worlds.push_back(local);
+    dirty.push_back(1);
+    changed.push_back(0);
+    handles.push_back(handle);
+    indices.push_back(index);
+    nodes.push_back(node);
+    if (node != NULL) {
+        node->store = this;
+        node->handle = handle;
+    }
+    outdated = true;
+    return handle;
+}
+
+/**
+ * Order the transformations by depth.
+ * Transformations of the same depth keep their relative order, and
+ * handles stay valid.
+ */
+void TransformStore::Sort() {
+    if (sorted) return;
+    unsigned int size = parents.size();
+
+    // count the transformations of each depth
+    levels.clear();
+    for (unsigned int i=0; i<size; i++) {
+        if (depths[i] >= levels.size()) levels.resize(depths[i] + 1, 0);
+        levels[depths[i]]++;
+    }
+    unsigned int first = 0;
+    for (unsigned int d=0; d<levels.size(); d++) {
+        unsigned int count = levels[d];
+        levels[d] = first;
+        first += count;
+    }
+
+    // new index of each transformation
+    vector<unsigned int> order(size);
+    vector<unsigned int> next(levels);
+    for (unsigned int i=0; i<size; i++)
+        order[i] = next[depths[i]]++;
+
+    vector<int> p(size);
+    vector<unsigned int> d(size), h(size);
+    vector<Matrix<4,4,float> > l(size), w(size);
+    vector<char> ds(size), cs(size);
+    for (unsigned int i=0; i<size; i++) {
+        unsigned int j = order[i];
+        p[j] = (parents[i] < 0) ? -1 : (int)order[parents[i]];
+        d[j] = depths[i];
+        l[j] = locals[i];
+        w[j] = worlds[i];
+        ds[j] = dirty[i];
+        cs[j] = changed[i];
+        h[j] = handles[i];
+        indices[handles[i]] = j;
+    }
+    parents.swap(p);
+    depths.swap(d);
+    locals.swap(l);
+    worlds.swap(w);
+    dirty.swap(ds);
+    changed.swap(cs);
+    handles.swap(h);
+    sorted = true;
+}
+
+/**
+ * Update the world matrices of a range of transformations.
+ * The parents of the range must be up to date.
+ */
+void TransformStore::UpdateRange(const unsigned int begin, const unsigned int end) {
+    for (unsigned int i=begin; i<end; i++) {
+        int p = parents[i];
+        bool c = dirty[i] || (p >= 0 && changed[p]);
+        if (c) {
+            if (p < 0) worlds[i] = locals[i];
+            else       worlds[i] = locals[i] * worlds[p];
+        }
+        changed[i] = c;
+        dirty[i] = 0;
+    }
+}
+
+/**
+ * Update the world matrices in a single pass.
+ * Only transformations whose local matrix or any ancestor changed
+ * since the last update are recomputed.
+ */
+void TransformStore::Update() {
+    UpdateRange(0, parents.size());
+    outdated = false;
+}
+
+/**
+ * Update the world matrices on a task scheduler.
+ * The store is sorted if needed, and the depth levels are updated
+ * in turn, each split in ranges processed as tasks.
+ *
+ * @param scheduler Scheduler to process the ranges on.
+ */
+void TransformStore::Update(TaskScheduler& scheduler) {
+    Sort();
+    unsigned int workers = scheduler.GetNumberOfWorkers();
+    for (unsigned int d=0; d<levels.size(); d++) {
+        unsigned int begin = levels[d];
+        unsigned int end = (d+1 < levels.size()) ? levels[d+1] : parents.size();
+        unsigned int jobs = std::min(workers, (end - begin) / MIN_RANGE);
+        if (jobs <= 1) {
+            UpdateRange(begin, end);
+            continue;
+        }
+        TaskGroup group;
+        for (unsigned int j=0; j<jobs; j++)
+            scheduler.Spawn(boost::bind(&TransformStore::UpdateRange, this,
+                                        begin + (end - begin) * j / jobs,
+                                        begin + (end - begin) * (j+1) / jobs),
+                            &group);
+        scheduler.Wait(group);
+    }
+    outdated = false;
+}
+
+/**
+ * Set the local matrix of a transformation.
+ *
+ * @param handle Transformation handle.
+ * @param local Local transformation matrix.
+ */
+void TransformStore::SetLocal(const unsigned int handle, const Matrix<4,4,float> local) {
+    unsigned int i = indices[handle];
+    locals[i] = local;
+    dirty[i] = 1;
+    outdated = true;
+}
+
+/**
+ * Get the local matrix of a transformation.
+ *
+ * @param handle Transformation handle.
+ * @return Local transformation matrix.
+ */
+Matrix<4,4,float> TransformStore::GetLocal(const unsigned int handle) {
+    return locals[indices[handle]];
+}
+
+/**
+ * Get the world matrix of a transformation.
+ * The store is updated first if any local matrix has changed.
+ *
+ * @param handle Transformation handle.
+ * @return World transformation matrix.
+ */
+Matrix<4,4,float> TransformStore::GetWorld(const unsigned int handle) {
+    if (outdated) Update();
+    return worlds[indices[handle]];
+}
+
+/**
+ * Get the parent of a transformation.
+ *
+ * @param handle Transformation handle.
+ * @return Handle of the parent, -1 for none.
+ */
+int TransformStore::GetParent(const unsigned int handle) {
+    int p = parents[indices[handle]];
+    return (p < 0) ? -1 : (int)handles[p];
+}
+
+/**
+ * Release the node bound to a transformation.
+ * The transformation remains in the store.
+ *
+ * @param handle Transformation handle.
+ */
+void TransformStore::Unbind(const unsigned int handle) {
+    if (nodes[handle] != NULL) nodes[handle]->store = NULL;
+    nodes[handle] = NULL;
+}
+
+/**
+ * Get the number of transformations.
+ *
+ * @return Number of transformations.
+ */
+unsigned int TransformStore::Size() {
+    return parents.size();
+}
+
+/**
+ * Check if the transformations are ordered by depth.
+ *
+ * @return True if sorted.
+ */
+bool TransformStore::IsSorted() {
+    return sorted;
+}
+
+} // NS Scene
+} // NS OpenEngine
@@ -0,0 +1,107 @@
+// Flat transformation hierarchy.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#ifndef _TRANSFORM_STORE_H_
+#define _TRANSFORM_STORE_H_
+
+#include <Math/Matrix.h>
+#include <vector>
+
+namespace OpenEngine {
+
+// forward declarations
+namespace Utils { class TaskScheduler; }
+
+namespace Scene {
+
+class ISceneNode;
+class TransformationNode;
+
+using OpenEngine::Math::Matrix;
+using OpenEngine::Utils::TaskScheduler;
+using std::vector;
+
+/**
+ * Flat transformation hierarchy.
+ *
+ * The store keeps the parent index, local matrix and world matrix of
+ * every transformation in contiguous arrays ordered so that parents
+ * come before their children. World matrices are updated in a single
+ * linear pass over the arrays, only recomputing the transformations
+ * whose local matrix or parent changed. When sorted, the
+ * transformations are ordered by depth, so each depth level is a
+ * contiguous range that can be updated in parallel.
+ *
+ * Transformations are identified by handles that stay valid when the
+ * store is sorted. A store built from a scene binds the
+ * transformation nodes of the scene to their handles: changes to a
+ * bound node are written to the store, and the world matrix of a
+ * bound node is read from it.
+ *
+ * @code
+ * TransformStore store;
+ * store.Build(root);      // bind all transformation nodes of root
+ * node->Move(0,1,0);      // writes the local matrix to the store
+ * store.Update(TaskScheduler::GetDefault()); // update level by level
+ * @endcode
+ *
+ * The structure of the scene is captured when the store is built, so
+ * the store must be rebuilt when transformation nodes are added,
+ * removed or moved in the scene.
+ *
+ * @class TransformStore TransformStore.h Scene/TransformStore.h
+ */
+class TransformStore {
+private:
+    // per transformation data in update order
+    vector<int> parents;                    // parent index, -1 for roots
+    vector<unsigned int> depths;            // number of ancestors
+    vector<Matrix<4,4,float> > locals;      // local matrices
+    vector<Matrix<4,4,float> > worlds;      // world matrices
+    vector<char> dirty;                     // local changed since update
+    vector<char> changed;                   // world changed by update
+    vector<unsigned int> handles;           // handle of each index
+
+    // per handle data
+    vector<unsigned int> indices;           // index of each handle
+    vector<TransformationNode*> nodes;      // bound nodes
+
+    vector<unsigned int> levels;            // first index of each depth
+    bool sorted;                            // ordered by depth
+    bool outdated;                          // some local has changed
+
+    void UpdateRange(const unsigned int begin, const unsigned int end);
+
+public:
+    TransformStore();
+    ~TransformStore();
+
+    void Build(ISceneNode* root);
+    void Clear();
+
+    unsigned int Add(const int parent, const Matrix<4,4,float> local,
+                     TransformationNode* node = NULL);
+    void Sort();
+    void Update();
+    void Update(TaskScheduler& scheduler);
+
+    void SetLocal(const unsigned int handle, const Matrix<4,4,float> local);
+    Matrix<4,4,float> GetLocal(const unsigned int handle);
+    Matrix<4,4,float> GetWorld(const unsigned int handle);
+    int GetParent(const unsigned int handle);
+    void Unbind(const unsigned int handle);
+
+    unsigned int Size();
+    bool IsSorted();
+};
+
+} // NS Scene
+} // NS OpenEngine
+
+#endif // _TRANSFORM_STORE_H_
@@ -8,15 +8,33 @@
 //--------------------------------------------------------------------
 
 #include <Scene/TransformationNode.h>
+#include <Scene/TransformStore.h>
+#include <Scene/SceneOctree.h>
+#include <Geometry/Box.h>
 
 namespace OpenEngine {
 namespace Scene {
 
+    // marks the world transformations of all transformation nodes in
+    // a sub tree dirty, invalidated nodes invalidate their own sub
+    // nodes
+    class WorldInvalidator : public ISceneNodeVisitor {
+    public:
+        void VisitTransformationNode(TransformationNode* node) {
+            node->InvalidateWorld();
+        }
+    };
+
     //! Empty constructor.
-    TransformationNode::TransformationNode() {}
+    TransformationNode::TransformationNode()
+        : localDirty(true), worldDirty(true), parentTransformation(NULL),
+          store(NULL), handle(0), index(NULL), group(0) {}
 
-    //! Empty destructor.
-    TransformationNode::~TransformationNode() {}
+    //! Destructor, releases the node from its store and index.
+    TransformationNode::~TransformationNode() {
+        if (store != NULL) store->Unbind(handle);
+        if (index != NULL) index->Unbind(group);
+    }
 
     //! Accept of visitors
     void TransformationNode::Accept(ISceneNodeVisitor& v) { 
@@ -35,6 +53,7 @@ namespace Scene {
     void TransformationNode::Move(float x, float y, float z) {
         // add the rotation of v around the current quaternion to the position
         position += rotation.RotateVector(Vector<3,float>(x,y,z)); 
+        Changed();
     }
 
     /**
@@ -52,6 +71,7 @@ namespace Scene {
         q.Normalize();
         // apply the accumulated rotation
         rotation = rotation * q;
+        Changed();
     }
 
     /**
@@ -69,23 +89,141 @@ namespace Scene {
                             0.0f, 0.0f, z,    0.0f,
                             0.0f, 0.0f, 0.0f, 1.0f);
         scale = scale * s;
+        Changed();
     }
 
 
+    /**
+     * Mark the node changed, invalidating the cached matrices and
+     * updating the store if bound.
+     */
+    void TransformationNode::Changed() {
+        localDirty = true;
+        InvalidateWorld();
+        InvalidateBounds();
+        if (store != NULL) store->SetLocal(handle, GetTransformationMatrix());
+    }
+
     /**
      * Get matrix representation of the transformation.
+     * The matrix is cached until the node is changed.
      *
      * @return Transformation matrix
      */
     Matrix<4,4,float> TransformationNode::GetTransformationMatrix() {
-        // get the rotation from the quaternion
-        Matrix<4,4,float> m = rotation.GetMatrix().GetExpanded();
-        m.Transpose();
-        // write in the positional information
-        m(3,0) = position[0];
-        m(3,1) = position[1];
-        m(3,2) = position[2];
-        return scale * m;
+        if (localDirty) {
+            // get the rotation from the quaternion
+            Matrix<4,4,float> m = rotation.GetMatrix().GetExpanded();
+            m.Transpose();
+            // write in the positional information
+            m(3,0) = position[0];
+            m(3,1) = position[1];
+            m(3,2) = position[2];
+            local = scale * m;
+            localDirty = false;
+        }
+        return local;
+    }
+
+    /**
+     * Get the world transformation matrix.
+     * The world transformation is the transformation of the node
+     * followed by the transformations of all the parenting
+     * transformation nodes. It is cached until the node or one of
+     * the parenting transformation nodes is changed. The world
+     * transformation of a node bound to a store is read from the
+     * store.
+     *
+     * @return World transformation matrix
+     */
+    Matrix<4,4,float> TransformationNode::GetWorldMatrix() {
+        if (store != NULL) return store->GetWorld(handle);
+        if (worldDirty) UpdateWorld();
+        return world;
+    }
+
+    /**
+     * Get the store the node is bound to.
+     *
+     * @return Transformation store, NULL if not bound.
+     */
+    TransformStore* TransformationNode::GetTransformStore() {
+        return store;
+    }
+
+    /**
+     * Recompute the cached world transformation and accumulated
+     * position and rotation from the nearest parenting transformation
+     * node, updating it first if needed.
+     */
+    void TransformationNode::UpdateWorld() {
+        // find the nearest transformation node above this one
+        parentTransformation = NULL;
+        DefaultVisitNode(this);
+        TransformationNode* parent = parentTransformation;
+        parentTransformation = NULL;
+
+        if (parent == NULL) {
+            world = GetTransformationMatrix();
+            accPosition = position;
+            accRotation = rotation;
+        } else {
+            if (parent->worldDirty) parent->UpdateWorld();
+            world = GetTransformationMatrix() * parent->world;
+            accPosition = parent->accRotation.RotateVector(position) + parent->accPosition;
+            accRotation = parent->accRotation * rotation;
+        }
+        worldDirty = false;
+    }
+
+    /**
+     * Check if the cached world transformation is out of date.
+     *
+     * @return True if the world transformation must be recomputed.
+     */
+    bool TransformationNode::IsWorldDirty() {
+        return worldDirty;
+    }
+
+    /**
+     * Mark the world transformation of this node and all the
+     * transformation nodes below it dirty.
+     * Nodes already dirty are skipped, as all transformation nodes
+     * below a dirty node are dirty. The index of the node, if any,
+     * is told that the node moved.
+     */
+    void TransformationNode::InvalidateWorld() {
+        if (worldDirty) return;
+        worldDirty = true;
+        if (index != NULL) index->Invalidate(group);
+        WorldInvalidator invalidator;
+        VisitSubNodes(invalidator);
+    }
+
+    /**
+     * Mark the world transformations of all transformation nodes in a
+     * sub tree dirty.
+     * Must be called when a sub tree is moved in the scene.
+     *
+     * @param node Root of the sub tree.
+     */
+    void TransformationNode::InvalidateWorld(ISceneNode* node) {
+        WorldInvalidator invalidator;
+        node->Accept(invalidator);
+    }
+
+    /**
+     * Compute the bounds of the sub nodes transformed by this node.
+     * The result bounds the transformed box of the sub nodes.
+     */
+    ISceneNode::BoundsType TransformationNode::ComputeBounds(Vector<3,float>& min, Vector<3,float>& max) {
+        BoundsType type = SceneNode::ComputeBounds(min, max);
+        if (type != FINITE_BOUNDS) return type;
+        Geometry::Box box((max + min) / 2, (max - min) / 2);
+        Geometry::Box t = box.GetTransformed(GetTransformationMatrix());
+        min = t.GetCenter() - t.GetCorner();
+        max = t.GetCenter() + t.GetCorner();
+        return type;
     }
 
     /**
@@ -104,6 +242,7 @@ namespace Scene {
      */
     void TransformationNode::SetPosition(Vector<3,float> position) {
         this->position = position;
+        Changed();
     }
 
     /**
@@ -131,6 +270,7 @@ namespace Scene {
      */
     void TransformationNode::SetRotation(Quaternion<float> rotation) {
         this->rotation = rotation;
+        Changed();
     }
 
     /**
@@ -140,6 +280,7 @@ namespace Scene {
      */
     void TransformationNode::SetScale(Matrix<4,4,float> scale) {
         this->scale = scale;
+        Changed();
     }
 
     /**
@@ -156,34 +297,29 @@ namespace Scene {
     }
 
     /**
-     * Visit transformations to collect position and rotation
-     * information.
+     * Visit the nearest parenting transformation node.
+     * The traversal stops at the node, which is recorded as the
+     * parent transformation.
      *
-     * @param node Self or parenting transformation node.
+     * @param node Parenting transformation node.
      */
     void TransformationNode::VisitTransformationNode(TransformationNode* node) {
-        node->GetAccumulatedTranformations(&accPosition, &accRotation);
-        DefaultVisitNode(node);
+        parentTransformation = node;
     }
 
     /**
-     * Get the accumulated position.
-     * Get the position by traversing upwards in the scene tree
-     * accumulating the position of all the nodes in the chain.
+     * Get the accumulated position and rotation.
+     * The position and rotation of all the transformation nodes in
+     * the parenting chain are accumulated with those of this node.
+     * The scaling is not included.
      *
-     * @return Accumulated position vector.
+     * @param position Accumulated position vector.
+     * @param rotation Accumulated rotation.
      */
     void TransformationNode::GetAccumulatedTranformations(Vector<3,float>* position, Quaternion<float>* rotation) {
-        // reset the accumulators
-        accPosition = Vector<3,float>();
-        accRotation = Quaternion<float>();
-
-        // get the accumulators from the parenting chain
-        DefaultVisitNode(this);
-
-        // write the result added to this nodes values to the parameters
-        *position = accRotation.RotateVector(this->position) + accPosition;
-        *rotation = accRotation * this->rotation;
+        if (worldDirty) UpdateWorld();
+        *position = accPosition;
+        *rotation = accRotation;
     }
 
 
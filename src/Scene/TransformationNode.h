@@ -24,6 +24,9 @@ using OpenEngine::Math::Vector;
 using OpenEngine::Math::Matrix;
 using OpenEngine::Math::Quaternion;
 
+class TransformStore;
+class SceneOctree;
+
 /**
  * Transformation node.
  * When inserted in the scene graph, all successive nodes
@@ -32,6 +35,23 @@ using OpenEngine::Math::Quaternion;
  * scene graph, who is responsible for applying the
  * rotation and positioning.
  *
+ * The local transformation matrix and the world transformation,
+ * accumulated from the transformation nodes above the node, are
+ * cached. Changing a node marks its local matrix dirty and the world
+ * transformations of the node and all transformation nodes below it
+ * dirty, and the matrices are recomputed when asked for, so
+ * unchanged parts of the scene cost nothing to query. Adding a sub
+ * tree to a scene node marks the world transformations of the sub
+ * tree dirty as well.
+ *
+ * A node can be bound to a TransformStore, which then holds the
+ * world transformation of the node. Changes to a bound node are
+ * written to the store.
+ *
+ * A SceneOctree indexing the geometry below a node is told when the
+ * world transformation of the node becomes dirty, so the index only
+ * relocates the geometry that moved.
+ *
  * @class TransformationNode TransformationNode.h Scene/TransformationNode.h
  */
 class TransformationNode : public SceneNode, public ISceneNodeVisitor {
@@ -44,20 +64,56 @@ private:
     //! current absolute position vector
     Vector<3,float> position;
     
-    //! accumulated rotation from collection traversal
+    //! cached accumulated rotation of the parenting chain
     Quaternion<float> accRotation;
 
-    //! accumulated position from collection traversal
+    //! cached accumulated position of the parenting chain
     Vector<3,float> accPosition;
 
     //! current scaling factor
     Matrix<4,4,float> scale;
 
+    //! cached local transformation matrix
+    Matrix<4,4,float> local;
+
+    //! cached world transformation matrix
+    Matrix<4,4,float> world;
+
+    //! local matrix needs to be recomputed
+    bool localDirty;
+
+    //! world transformation needs to be recomputed
+    bool worldDirty;
+
+    //! nearest parenting transformation node found by traversal
+    TransformationNode* parentTransformation;
+
+    //! store the node is bound to, null if none
+    TransformStore* store;
+
+    //! handle of the node in the store
+    unsigned int handle;
+
+    //! index of the geometry below the node, null if none
+    SceneOctree* index;
+
+    //! group of the node in the index
+    unsigned int group;
+
+    void UpdateWorld();
+    void Changed();
+
+    friend class TransformStore;
+    friend class SceneOctree;
+
 protected:
 
     //! overwritten visiting method
     virtual void DefaultVisitNode(ISceneNode* node);
 
+    //! bounds of the sub nodes in the parent coordinate system
+    BoundsType ComputeBounds(Vector<3,float>& min, Vector<3,float>& max);
+
 public:
     
     // constructor / destructor
@@ -83,8 +139,15 @@ public:
     Quaternion<float> GetRotation();
     Matrix<4,4,float> GetScale();
     Matrix<4,4,float> GetTransformationMatrix();
+    Matrix<4,4,float> GetWorldMatrix();
     void GetAccumulatedTranformations(Vector<3,float>* position, Quaternion<float>* rotation);
 
+    bool IsWorldDirty();
+    void InvalidateWorld();
+    static void InvalidateWorld(ISceneNode* node);
+
+    TransformStore* GetTransformStore();
+
 };
 
 } // NS Scene
@@ -0,0 +1,262 @@
+// Sharded hash map safe for concurrent use.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS) 
+// 
+// This program is free software; It is covered by the GNU General 
+// Public License version 2 or any later version. 
+// See the GNU General Public License for more details (see LICENSE). 
+//--------------------------------------------------------------------
+
+#ifndef _CONCURRENT_HASH_MAP_H_
+#define _CONCURRENT_HASH_MAP_H_
+
+#include <Utils/Hash.h>
+#include <boost/thread/mutex.hpp>
+#include <algorithm>
+#include <vector>
+#include <list>
+#include <utility>
+
+namespace OpenEngine {
+namespace Utils {
+
+using std::vector;
+using std::list;
+using std::pair;
+using std::make_pair;
+
+/**
+ * Sharded hash map safe for concurrent use.
+ *
+ * The map is split into a fixed number of shards each guarded by
+ * its own mutex, so threads working on different keys rarely
+ * contend. Each shard is a chained hash table that grows when its
+ * load factor exceeds two.
+ *
+ * Values are returned by copy, which makes the map suited for
+ * smart pointers and other small values.
+ *
+ * @code
+ * ConcurrentHashMap<string, ITextureResourcePtr> cache;
+ * ITextureResourcePtr tex;
+ * if (!cache.Find("wall.tga", tex))
+ *     tex = cache.Insert("wall.tga", CreateTheTexture());
+ * @endcode
+ *
+ * @class ConcurrentHashMap ConcurrentHashMap.h Utils/ConcurrentHashMap.h
+ * @param K Key type
+ * @param V Value type
+ * @param H Hash function object, defaults to Hash<K>
+ */
+template <class K, class V, class H = Hash<K> >
+class ConcurrentHashMap {
+public:
+    //! Number of shards, must be a power of two.
+    static const unsigned int SHARDS = 16;
+
+private:
+    typedef list<pair<K,V> > Bucket;
+
+    struct Shard {
+        boost::mutex mutex;
+        vector<Bucket> buckets;
+        unsigned int size;
+        Shard() : buckets(8), size(0) {}
+    };
+
+    Shard shards[SHARDS];
+    H hash;
+
+    // the low bits select the shard, the rest select the bucket
+    Shard& GetShard(const unsigned int h) {
+        return shards[h & (SHARDS-1)];
+    }
+
+    static Bucket& GetBucket(Shard& shard, const unsigned int h) {
+        return shard.buckets[(h / SHARDS) % shard.buckets.size()];
+    }
+
+    // must be called with the shard mutex held
+    void Grow(Shard& shard) {
+        vector<Bucket> old(shard.buckets.size() * 2);
+        old.swap(shard.buckets);
+        for (typename vector<Bucket>::iterator b = old.begin(); b != old.end(); b++) {
+            for (typename Bucket::iterator e = b->begin(); e != b->end(); e++) {
+                Bucket& dest = GetBucket(shard, hash(e->first));
+                dest.push_back(*e);
+            }
+        }
+    }
+
+    // disallow copying
+    ConcurrentHashMap(const ConcurrentHashMap&);
+    ConcurrentHashMap& operator=(const ConcurrentHashMap&);
+
+public:
+    ConcurrentHashMap() {}
+
+    /**
+     * Look up a key.
+     *
+     * @param key Key to look up.
+     * @param value Set to the value of the key if found.
+     * @return True if the key was found.
+     */
+    bool Find(const K& key, V& value) {
+        unsigned int h = hash(key);
+        Shard& shard = GetShard(h);
+        boost::mutex::scoped_lock lock(shard.mutex);
+        Bucket& bucket = GetBucket(shard, h);
+        for (typename Bucket::iterator e = bucket.begin(); e != bucket.end(); e++) {
+            if (e->first == key) {
+                value = e->second;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * Insert a value unless the key is already present.
+     * When several threads insert the same key only the first value
+     * is stored and all of them get the stored value back.
+     *
+     * @param key Key to insert.
+     * @param value Value to insert.
+     * @return The value stored for the key.
+     */
+    V Insert(const K& key, const V& value) {
+        unsigned int h = hash(key);
+        Shard& shard = GetShard(h);
+        boost::mutex::scoped_lock lock(shard.mutex);
+        Bucket& bucket = GetBucket(shard, h);
+        for (typename Bucket::iterator e = bucket.begin(); e != bucket.end(); e++)
+            if (e->first == key) return e->second;
+        bucket.push_back(make_pair(key, value));
+        if (++shard.size > shard.buckets.size() * 2)
+            Grow(shard);
+        return value;
+    }
+
+    /**
+     * Insert or replace the value of a key.
+     *
+     * @param key Key to set.
+     * @param value New value.
+     */
+    void Set(const K& key, const V& value) {
+        unsigned int h = hash(key);
+        Shard& shard = GetShard(h);
+        boost::mutex::scoped_lock lock(shard.mutex);
+        Bucket& bucket = GetBucket(shard, h);
+        for (typename Bucket::iterator e = bucket.begin(); e != bucket.end(); e++) {
+            if (e->first == key) {
+                e->second = value;
+                return;
+            }
+        }
+        bucket.push_back(make_pair(key, value));
+        if (++shard.size > shard.buckets.size() * 2)
+            Grow(shard);
+    }
+
+    /**
+     * Remove a key.
+     *
+     * @param key Key to remove.
+     * @return True if the key was present.
+     */
+    bool Erase(const K& key) {
+        unsigned int h = hash(key);
+        Shard& shard = GetShard(h);
+        boost::mutex::scoped_lock lock(shard.mutex);
+        Bucket& bucket = GetBucket(shard, h);
+        for (typename Bucket::iterator e = bucket.begin(); e != bucket.end(); e++) {
+            if (e->first == key) {
+                bucket.erase(e);
+                shard.size--;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * Remove a key if its value satisfies a predicate.
+     * The predicate is called with the shard locked, so no other
+     * thread can look up or change the value while it is tested. The
+     * removed value is destroyed after the shard is unlocked.
+     *
+     * @param key Key to remove.
+     * @param predicate Function object taking the value.
+     * @return True if the key was removed.
+     */
+    template <class P>
+    bool EraseIf(const K& key, P predicate) {
+        unsigned int h = hash(key);
+        Shard& shard = GetShard(h);
+        V removed = V();
+        boost::mutex::scoped_lock lock(shard.mutex);
+        Bucket& bucket = GetBucket(shard, h);
+        for (typename Bucket::iterator e = bucket.begin(); e != bucket.end(); e++) {
+            if (e->first == key) {
+                if (!predicate(e->second)) return false;
+                std::swap(removed, e->second);
+                bucket.erase(e);
+                shard.size--;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * Remove all keys.
+     */
+    void Clear() {
+        for (unsigned int i=0; i<SHARDS; i++) {
+            boost::mutex::scoped_lock lock(shards[i].mutex);
+            shards[i].buckets = vector<Bucket>(8);
+            shards[i].size = 0;
+        }
+    }
+
+    /**
+     * Get the number of keys.
+     * The result is only a snapshot if other threads modify the map.
+     *
+     * @return Number of keys.
+     */
+    unsigned int Size() {
+        unsigned int size = 0;
+        for (unsigned int i=0; i<SHARDS; i++) {
+            boost::mutex::scoped_lock lock(shards[i].mutex);
+            size += shards[i].size;
+        }
+        return size;
+    }
+
+    /**
+     * Collect all values.
+     * The shards are visited one at a time, so the result is only a
+     * snapshot if other threads modify the map.
+     *
+     * @param values Vector the values are appended to.
+     */
+    void Values(vector<V>& values) {
+        for (unsigned int i=0; i<SHARDS; i++) {
+            boost::mutex::scoped_lock lock(shards[i].mutex);
+            typename vector<Bucket>::iterator b;
+            for (b = shards[i].buckets.begin(); b != shards[i].buckets.end(); b++) {
+                typename Bucket::iterator e;
+                for (e = b->begin(); e != b->end(); e++)
+                    values.push_back(e->second);
+            }
+        }
+    }
+};
+
+} // NS Utils
+} // NS OpenEngine
+
+#endif // _CONCURRENT_HASH_MAP_H_
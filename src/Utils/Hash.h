@@ -0,0 +1,68 @@
+// Hash function objects.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS) 
+// 
+// This program is free software; It is covered by the GNU General 
+// Public License version 2 or any later version. 
+// See the GNU General Public License for more details (see LICENSE). 
+//--------------------------------------------------------------------
+
+#ifndef _HASH_H_
+#define _HASH_H_
+
+#include <string>
+#include <cstddef>
+
+namespace OpenEngine {
+namespace Utils {
+
+using std::string;
+
+/**
+ * Hash function object.
+ * Only specializations are defined, for strings, pointers and
+ * unsigned integers.
+ *
+ * @class Hash Hash.h Utils/Hash.h
+ * @param T Type to hash
+ */
+template <class T> struct Hash;
+
+/**
+ * String hash (32 bit FNV-1a).
+ */
+template <> struct Hash<string> {
+    unsigned int operator()(const string& s) const {
+        unsigned int h = 2166136261u;
+        for (string::size_type i=0; i<s.size(); i++) {
+            h ^= (unsigned char)s[i];
+            h *= 16777619u;
+        }
+        return h;
+    }
+};
+
+/**
+ * Unsigned integer hash (multiplicative, mixes high bits down).
+ */
+template <> struct Hash<unsigned int> {
+    unsigned int operator()(unsigned int i) const {
+        i *= 2654435761u;
+        return i ^ (i >> 16);
+    }
+};
+
+/**
+ * Pointer hash.
+ */
+template <class T> struct Hash<T*> {
+    unsigned int operator()(T* p) const {
+        // drop the alignment bits before mixing
+        return Hash<unsigned int>()((unsigned int)((std::size_t)p >> 3));
+    }
+};
+
+} // NS Utils
+} // NS OpenEngine
+
+#endif // _HASH_H_
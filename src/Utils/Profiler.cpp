@@ -0,0 +1,298 @@
+// Hierarchical zone profiler.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#include <Utils/Profiler.h>
+#include <Utils/StringPool.h>
+#include <Utils/Timer.h>
+#include <Core/Exceptions.h>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/tss.hpp>
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#if defined(__GNUC__)
+    #include <cxxabi.h>
+#endif
+
+namespace OpenEngine {
+namespace Utils {
+
+using OpenEngine::Core::Exception;
+using std::map;
+using std::pair;
+
+typedef StringPool::Handle Handle;
+
+// durations of the last samples of a zone
+struct Samples {
+    vector<double> values;
+    unsigned int next;          // oldest value once the window is full
+    unsigned int total;
+    Samples() : next(0), total(0) {}
+};
+
+// zone recorded for the trace
+struct Event {
+    Handle name;
+    Handle path;
+    Handle category;
+    unsigned int thread;
+    double start, duration;
+};
+
+// zone begun on a thread and not yet ended
+struct Frame {
+    Handle name;
+    Handle path;
+    Handle category;
+    double start;
+};
+
+struct ThreadState {
+    unsigned int id;
+    vector<Frame> stack;
+};
+
+static boost::mutex mutex;                  // guards the members below
+static StringPool pool;
+static map<pair<Handle, Handle>, Samples> zones;
+static vector<Event> events;
+static unsigned int nextEvent = 0;          // oldest event once full
+static unsigned int window = 120;
+static unsigned int capacity = 0;
+static unsigned int threads = 0;
+static double origin = 0;
+static boost::thread_specific_ptr<ThreadState> state;
+
+volatile bool Profiler::enabled = false;
+
+static bool ByPath(const Profiler::ZoneStatistics& a, const Profiler::ZoneStatistics& b) {
+    if (a.path != b.path) return a.path < b.path;
+    return a.category < b.category;
+}
+
+static void WriteString(std::ostream& out, const string& str) {
+    out << '"';
+    for (unsigned int i=0; i<str.size(); i++) {
+        char c = str[i];
+        if (c == '"' || c == '\\') out << '\\' << c;
+        else if ((unsigned char)c < 0x20) {
+            char buf[8];
+            sprintf(buf, "\\u%04x", (unsigned char)c);
+            out << buf;
+        }
+        else out << c;
+    }
+    out << '"';
+}
+
+/**
+ * Start recording zones.
+ * Zones recorded before are cleared.
+ *
+ * @param window Number of samples per zone the statistics cover
+ * [optional].
+ * @param events Number of zones kept for the trace, zero for no
+ * trace [optional].
+ */
+void Profiler::Enable(const unsigned int window, const unsigned int events) {
+    boost::mutex::scoped_lock lock(mutex);
+    Utils::window = (window > 0) ? window : 1;
+    capacity = events;
+    zones.clear();
+    Utils::events.clear();
+    Utils::events.reserve(capacity);
+    nextEvent = 0;
+    origin = Timer::GetTime();
+    enabled = true;
+}
+
+/**
+ * Stop recording zones.
+ * The zones recorded are kept, and zones begun while enabled are
+ * still recorded when they end.
+ */
+void Profiler::Disable() {
+    enabled = false;
+}
+
+/**
+ * Clear the recorded zones.
+ */
+void Profiler::Clear() {
+    boost::mutex::scoped_lock lock(mutex);
+    zones.clear();
+    events.clear();
+    nextEvent = 0;
+}
+
+/**
+ * Begin a zone on the calling thread.
+ * Must be matched by a call to End() on the same thread; use a
+ * ProfileScope to have it done when leaving a scope.
+ *
+ * @param name Name of the zone.
+ * @param category Category of the zone [optional].
+ */
+void Profiler::Begin(const char* name, const char* category) {
+    Begin(string(name), category);
+}
+
+/**
+ * Begin a zone on the calling thread.
+ *
+ * @param name Name of the zone.
+ * @param category Category of the zone [optional].
+ */
+void Profiler::Begin(const string& name, const char* category) {
+    ThreadState* t = state.get();
+    if (t == NULL) {
+        t = new ThreadState();
+        {
+            boost::mutex::scoped_lock lock(mutex);
+            t->id = threads++;
+        }
+        state.reset(t);
+    }
+    Frame f;
+    f.name = pool.Intern(name);
+    f.category = pool.Intern(category);
+    if (t->stack.empty()) f.path = f.name;
+    else f.path = pool.Intern(*t->stack.back().path + "/" + name);
+    t->stack.push_back(f);
+    // read the time last, so the above is not counted
+    t->stack.back().start = Timer::GetTime();
+}
+
+/**
+ * End the innermost zone of the calling thread.
+ */
+void Profiler::End() {
+    double end = Timer::GetTime();
+    ThreadState* t = state.get();
+    if (t == NULL || t->stack.empty()) return;
+    Frame f = t->stack.back();
+    t->stack.pop_back();
+    double duration = end - f.start;
+
+    boost::mutex::scoped_lock lock(mutex);
+    Samples& s = zones[std::make_pair(f.path, f.category)];
+    if (s.values.size() < window) s.values.push_back(duration);
+    else {
+        s.values[s.next] = duration;
+        s.next = (s.next + 1) % window;
+    }
+    s.total++;
+    if (capacity == 0) return;
+    Event e;
+    e.name = f.name;
+    e.path = f.path;
+    e.category = f.category;
+    e.thread = t->id;
+    e.start = f.start - origin;
+    e.duration = duration;
+    if (events.size() < capacity) events.push_back(e);
+    else {
+        events[nextEvent] = e;
+        nextEvent = (nextEvent + 1) % capacity;
+    }
+}
+
+/**
+ * Get the statistics of the recorded zones, ordered by path.
+ *
+ * @param zones Vector to append the statistics to.
+ */
+void Profiler::GetStatistics(vector<ZoneStatistics>& zones) {
+    vector<ZoneStatistics> result;
+    {
+        boost::mutex::scoped_lock lock(mutex);
+        map<pair<Handle, Handle>, Samples>::iterator itr;
+        for (itr=Utils::zones.begin(); itr!=Utils::zones.end(); ++itr) {
+            vector<double> values = itr->second.values;
+            sort(values.begin(), values.end());
+            ZoneStatistics z;
+            z.path = *itr->first.first;
+            z.category = *itr->first.second;
+            z.count = values.size();
+            z.total = itr->second.total;
+            z.min = values.front();
+            z.max = values.back();
+            z.p95 = values[(unsigned int)ceil(values.size() * 0.95) - 1];
+            double sum = 0;
+            for (unsigned int i=0; i<values.size(); i++)
+                sum += values[i];
+            z.average = sum / values.size();
+            result.push_back(z);
+        }
+    }
+    sort(result.begin(), result.end(), ByPath);
+    zones.insert(zones.end(), result.begin(), result.end());
+}
+
+/**
+ * Write the zones kept for the trace as Chrome trace event JSON,
+ * which chrome://tracing and other trace viewers can load.
+ *
+ * @param file Name of the file to write.
+ * @throws Exception if the file cannot be written.
+ */
+void Profiler::WriteTrace(const string& file) {
+    vector<Event> trace;
+    {
+        boost::mutex::scoped_lock lock(mutex);
+        trace.insert(trace.end(), events.begin() + nextEvent, events.end());
+        trace.insert(trace.end(), events.begin(), events.begin() + nextEvent);
+    }
+    std::ofstream out(file.c_str());
+    if (!out) throw Exception("Could not open trace file: " + file);
+    out << "{\"traceEvents\":[";
+    char buf[64];
+    for (unsigned int i=0; i<trace.size(); i++) {
+        const Event& e = trace[i];
+        out << (i == 0 ? "\n" : ",\n") << "{\"name\":";
+        WriteString(out, *e.name);
+        out << ",\"cat\":";
+        WriteString(out, *e.category);
+        // times in microseconds
+        sprintf(buf, ",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f",
+                e.thread, e.start * 1000.0, e.duration * 1000.0);
+        out << buf << ",\"args\":{\"path\":";
+        WriteString(out, *e.path);
+        out << "}}";
+    }
+    out << "\n]}\n";
+    if (!out) throw Exception("Could not write trace file: " + file);
+}
+
+/**
+ * Get a readable name of a type, for naming zones after classes.
+ *
+ * @param type Type info as returned by typeid.
+ * @return Name of the type.
+ */
+string Profiler::GetTypeName(const std::type_info& type) {
+#if defined(__GNUC__)
+    int status = 0;
+    char* name = abi::__cxa_demangle(type.name(), NULL, NULL, &status);
+    if (status == 0 && name != NULL) {
+        string result(name);
+        free(name);
+        return result;
+    }
+#endif
+    return type.name();
+}
+
+} // NS Utils
+} // NS OpenEngine
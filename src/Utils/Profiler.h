@@ -0,0 +1,144 @@
+// Hierarchical zone profiler.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#ifndef _PROFILER_H_
+#define _PROFILER_H_
+
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+namespace OpenEngine {
+namespace Utils {
+
+using std::string;
+using std::vector;
+
+/**
+ * Hierarchical zone profiler.
+ *
+ * A zone is a named span of time on a thread. Zones begun inside
+ * another zone on the same thread are nested in it, and are told
+ * apart by their path, the names of the enclosing zones and their
+ * own joined by slashes. The profiler keeps the durations of the
+ * last samples of each zone, and the last zones recorded by all
+ * threads for a trace.
+ *
+ * The engine records the Initialize, Process and Deinitialize calls
+ * of every module. Other code records zones with a ProfileScope:
+ *
+ * @code
+ * void Renderer::Process(const float deltaTime, const float percent) {
+ *     ProfileScope scope("Render");
+ *     ...
+ * }
+ *
+ * Profiler::Enable();
+ * // run some frames
+ * vector<Profiler::ZoneStatistics> zones;
+ * Profiler::GetStatistics(zones);
+ * Profiler::WriteTrace("trace.json");  // open in chrome://tracing
+ * @endcode
+ *
+ * When the profiler is disabled a ProfileScope costs a test of a
+ * flag, and nothing is recorded.
+ *
+ * @class Profiler Profiler.h Utils/Profiler.h
+ */
+class Profiler {
+public:
+    /**
+     * Statistics of a zone over the samples in the window.
+     * Times are in milliseconds.
+     */
+    struct ZoneStatistics {
+        string path;                //!< names of the zone and its parents
+        string category;            //!< category of the zone
+        unsigned int count;         //!< samples in the window
+        unsigned int total;         //!< samples since enabled or cleared
+        double min, average, p95, max;
+    };
+
+private:
+    static volatile bool enabled;
+
+public:
+    static void Enable(const unsigned int window = 120,
+                       const unsigned int events = 1 << 16);
+    static void Disable();
+    static void Clear();
+
+    /**
+     * Check if the profiler records zones.
+     *
+     * @return True if enabled.
+     */
+    static bool IsEnabled() { return enabled; }
+
+    static void Begin(const char* name, const char* category = "zone");
+    static void Begin(const string& name, const char* category = "zone");
+    static void End();
+
+    static void GetStatistics(vector<ZoneStatistics>& zones);
+    static void WriteTrace(const string& file);
+
+    static string GetTypeName(const std::type_info& type);
+};
+
+/**
+ * Zone recorded for the lifetime of the scope.
+ * The zone is only recorded if the profiler was enabled when the
+ * scope was created.
+ *
+ * @see Profiler
+ * @class ProfileScope Profiler.h Utils/Profiler.h
+ */
+class ProfileScope {
+private:
+    bool active;
+
+    // disallow copying
+    ProfileScope(const ProfileScope&);
+    ProfileScope& operator=(const ProfileScope&);
+
+public:
+    /**
+     * Begin a zone.
+     *
+     * @param name Name of the zone.
+     * @param category Category of the zone [optional].
+     */
+    explicit ProfileScope(const char* name, const char* category = "zone")
+        : active(Profiler::IsEnabled()) {
+        if (active) Profiler::Begin(name, category);
+    }
+
+    /**
+     * Begin a zone.
+     *
+     * @param name Name of the zone.
+     * @param category Category of the zone [optional].
+     */
+    explicit ProfileScope(const string& name, const char* category = "zone")
+        : active(Profiler::IsEnabled()) {
+        if (active) Profiler::Begin(name, category);
+    }
+
+    /**
+     * End the zone.
+     */
+    ~ProfileScope() {
+        if (active) Profiler::End();
+    }
+};
+
+} // NS Utils
+} // NS OpenEngine
+
+#endif // _PROFILER_H_
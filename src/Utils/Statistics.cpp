@@ -8,6 +8,7 @@
 //--------------------------------------------------------------------
 
 #include <Utils/Statistics.h>
+#include <Utils/Profiler.h>
 #include <Logging/Logger.h>
 
 namespace OpenEngine {
@@ -17,7 +18,7 @@ using namespace OpenEngine::Logging;
 
     Statistics::Statistics(float interval)
         : interval(interval),
-          elapsed(0),
+          start(Timer::GetNanoseconds()),
           frames(0) {}
 
     bool Statistics::IsTypeOf(const std::type_info& inf) { 
@@ -25,15 +26,26 @@ using namespace OpenEngine::Logging;
     }
 
     void Statistics::Initialize() {
-        
+        start = Timer::GetNanoseconds();
+        frames = 0;
     }
 
     void Statistics::Process(const float deltaTime, const float percent) {
-        elapsed += deltaTime;
         frames += 1;
+        Timer::Nanoseconds now = Timer::GetNanoseconds();
+        float elapsed = (float) ((now - start) / 1000000.0);
         if (elapsed > interval) {
             logger.info << "FPS: " << frames * 1000 / elapsed << logger.end;
-            elapsed = 0;
+            if (Profiler::IsEnabled()) {
+                vector<Profiler::ZoneStatistics> zones;
+                Profiler::GetStatistics(zones);
+                for (unsigned int i=0; i<zones.size(); i++)
+                    logger.info << zones[i].category << " " << zones[i].path
+                                << ": avg " << zones[i].average
+                                << " p95 " << zones[i].p95
+                                << " max " << zones[i].max << " ms" << logger.end;
+            }
+            start = now;
             frames = 0;
         }
     }
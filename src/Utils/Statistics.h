@@ -11,6 +11,7 @@
 #define _STATISTICS_H_
 
 #include <Core/IModule.h>
+#include <Utils/Timer.h>
 
 namespace OpenEngine {
 namespace Utils {
@@ -20,13 +21,17 @@ using namespace OpenEngine::Core;
 /**
  * Statistics module.
  * Collects statistical information and prints them to the logger info
- * stream at a given interval.
+ * stream at a given interval. The frame rate is measured on the
+ * monotonic clock, not summed from the delta times of the engine.
+ * When the Profiler is enabled the statistics of its zones are
+ * printed as well.
  *
  * @class Statistics Statistics.h Utils/Statistics.h
  */
 class Statistics : public IModule {
 private:
-    float interval, elapsed;
+    float interval;
+    Timer::Nanoseconds start;   // start of the interval
     int frames;
     
 public:
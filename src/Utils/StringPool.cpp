@@ -0,0 +1,62 @@
+// Pool of interned strings.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS) 
+// 
+// This program is free software; It is covered by the GNU General 
+// Public License version 2 or any later version. 
+// See the GNU General Public License for more details (see LICENSE). 
+//--------------------------------------------------------------------
+
+#include <Utils/StringPool.h>
+
+namespace OpenEngine {
+namespace Utils {
+
+/**
+ * Create an empty pool.
+ */
+StringPool::StringPool() {}
+
+/**
+ * Destroy the pool.
+ * All handles from the pool become invalid.
+ */
+StringPool::~StringPool() {
+    // the handles are owned by the pool, collect them through the
+    // interning map before releasing them
+    vector<Handle> handles;
+    strings.Values(handles);
+    for (vector<Handle>::iterator itr = handles.begin(); itr != handles.end(); itr++)
+        delete *itr;
+}
+
+/**
+ * Intern a string.
+ *
+ * @param str String to intern.
+ * @return Handle shared by all strings equal to str.
+ */
+StringPool::Handle StringPool::Intern(const string& str) {
+    Handle handle;
+    if (strings.Find(str, handle))
+        return handle;
+    // another thread may intern the same string concurrently, in
+    // which case the first insert wins
+    Handle created = new string(str);
+    handle = strings.Insert(str, created);
+    if (handle != created)
+        delete created;
+    return handle;
+}
+
+/**
+ * Get the number of interned strings.
+ *
+ * @return Number of strings in the pool.
+ */
+unsigned int StringPool::Size() {
+    return strings.Size();
+}
+
+} // NS Utils
+} // NS OpenEngine
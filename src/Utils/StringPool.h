@@ -0,0 +1,60 @@
+// Pool of interned strings.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS) 
+// 
+// This program is free software; It is covered by the GNU General 
+// Public License version 2 or any later version. 
+// See the GNU General Public License for more details (see LICENSE). 
+//--------------------------------------------------------------------
+
+#ifndef _STRING_POOL_H_
+#define _STRING_POOL_H_
+
+#include <Utils/ConcurrentHashMap.h>
+#include <string>
+
+namespace OpenEngine {
+namespace Utils {
+
+using std::string;
+
+/**
+ * Pool of interned strings.
+ * Interning a string returns a handle that is identical for all
+ * equal strings, so interned strings can be compared and hashed by
+ * pointer. The pool is safe for concurrent use and handles stay
+ * valid until the pool is destroyed.
+ *
+ * @code
+ * StringPool pool;
+ * StringPool::Handle a = pool.Intern("box.obj");
+ * StringPool::Handle b = pool.Intern(string("box") + ".obj");
+ * // a == b and *a == "box.obj"
+ * @endcode
+ *
+ * @class StringPool StringPool.h Utils/StringPool.h
+ */
+class StringPool {
+public:
+    //! Handle of an interned string.
+    typedef const string* Handle;
+
+private:
+    ConcurrentHashMap<string, Handle> strings;
+
+    // disallow copying
+    StringPool(const StringPool&);
+    StringPool& operator=(const StringPool&);
+
+public:
+    StringPool();
+    ~StringPool();
+
+    Handle Intern(const string& str);
+    unsigned int Size();
+};
+
+} // NS Utils
+} // NS OpenEngine
+
+#endif // _STRING_POOL_H_
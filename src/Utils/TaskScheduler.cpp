@@ -0,0 +1,288 @@
+// Work stealing task scheduler.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#include <Utils/TaskScheduler.h>
+#include <Logging/Logger.h>
+#include <boost/bind.hpp>
+#include <boost/thread/once.hpp>
+#include <exception>
+
+namespace OpenEngine {
+namespace Utils {
+
+// yields of a waiting thread without tasks before it sleeps
+static const unsigned int SPINS = 64;
+
+static TaskScheduler* defaultScheduler = NULL;
+static boost::once_flag defaultOnce = BOOST_ONCE_INIT;
+
+static void CreateDefault() {
+    static TaskScheduler scheduler;
+    defaultScheduler = &scheduler;
+}
+
+/**
+ * Create a group without tasks.
+ */
+TaskGroup::TaskGroup() : pending(0) {}
+
+/**
+ * Check if all tasks spawned into the group have run.
+ *
+ * @return True if no tasks are pending.
+ */
+bool TaskGroup::IsDone() {
+    boost::mutex::scoped_lock lock(mutex);
+    return pending == 0;
+}
+
+/**
+ * Create a scheduler and start its worker threads.
+ *
+ * @param workers Number of worker threads, zero for one per
+ * hardware thread [optional].
+ */
+TaskScheduler::TaskScheduler(const unsigned int workers)
+    : current(&TaskScheduler::Keep), sleepers(0), waiters(0), running(true) {
+    unsigned int count = workers;
+    if (count == 0) count = boost::thread::hardware_concurrency();
+    if (count == 0) count = 1;
+    for (unsigned int i=0; i<=count; i++) {
+        this->workers.push_back(new Worker());
+        this->workers.back()->seed = i * 2654435761u + 1;
+    }
+    for (unsigned int i=0; i<count; i++)
+        threads.create_thread(boost::bind(&TaskScheduler::Work, this, this->workers[i]));
+}
+
+/**
+ * Destroy the scheduler.
+ * Tasks already spawned are run before the worker threads are
+ * joined.
+ */
+TaskScheduler::~TaskScheduler() {
+    {
+        boost::mutex::scoped_lock lock(sleep);
+        running = false;
+        wake.notify_all();
+    }
+    threads.join_all();
+    for (unsigned int i=0; i<workers.size(); i++)
+        delete workers[i];
+}
+
+/**
+ * Spawn a task.
+ *
+ * @param job Job to run on a worker thread.
+ * @param group Group to add the task to [optional].
+ * @param after Group to wait for before running the task, must not
+ * be the group of the task [optional].
+ */
+void TaskScheduler::Spawn(Job job, TaskGroup* group, TaskGroup* after) {
+    Task* task = new Task();
+    task->job = job;
+    task->group = group;
+    if (group != NULL) {
+        boost::mutex::scoped_lock lock(group->mutex);
+        group->pending++;
+    }
+    if (after != NULL) {
+        boost::mutex::scoped_lock lock(after->mutex);
+        if (after->pending > 0) {
+            after->dependents.push_back(task);
+            return;
+        }
+    }
+    Push(task);
+}
+
+/**
+ * Wait for the tasks of a group to run.
+ * The waiting thread runs pending tasks, of any group, until the
+ * group is done. When no task is pending it yields for a while, and
+ * then sleeps until a task is spawned or a group is done.
+ *
+ * @param group Group to wait for.
+ */
+void TaskScheduler::Wait(TaskGroup& group) {
+    Worker* self = current.get();
+    unsigned int spins = 0;
+    while (!group.IsDone()) {
+        Task* task = Find(self);
+        if (task != NULL) {
+            Run(task);
+            spins = 0;
+        } else if (spins < SPINS) {
+            spins++;
+            boost::thread::yield();
+        } else {
+            boost::mutex::scoped_lock lock(sleep);
+            task = Find(self);
+            if (task == NULL && !group.IsDone()) {
+                sleepers++;
+                waiters++;
+                wake.wait(lock);
+                sleepers--;
+                waiters--;
+            }
+            lock.unlock();
+            if (task != NULL) Run(task);
+        }
+    }
+}
+
+/**
+ * Run a pending task on the calling thread, if there is one.
+ * Lets a thread waiting for something other than a group help with
+ * the tasks in the meantime.
+ *
+ * @return True if a task was run.
+ */
+bool TaskScheduler::RunPending() {
+    Task* task = Find(current.get());
+    if (task == NULL) return false;
+    Run(task);
+    return true;
+}
+
+/**
+ * Get the number of worker threads.
+ *
+ * @return Number of workers.
+ */
+unsigned int TaskScheduler::GetNumberOfWorkers() {
+    return workers.size() - 1;
+}
+
+/**
+ * Get the scheduler shared by the engine and the libraries.
+ * It is created on first use with a worker per hardware thread, and
+ * destroyed at exit.
+ *
+ * @return Default task scheduler.
+ */
+TaskScheduler& TaskScheduler::GetDefault() {
+    boost::call_once(&CreateDefault, defaultOnce);
+    return *defaultScheduler;
+}
+
+/**
+ * Queue a task on the deque of the calling worker, or the shared
+ * deque if called from another thread, and wake a sleeping worker.
+ */
+void TaskScheduler::Push(Task* task) {
+    Worker* w = current.get();
+    if (w == NULL) w = workers.back();
+    {
+        boost::mutex::scoped_lock lock(w->mutex);
+        w->tasks.push_back(task);
+    }
+    // a thread going to sleep looks for tasks once more with the
+    // sleep lock held, so it either finds this one or is woken
+    boost::mutex::scoped_lock lock(sleep);
+    if (sleepers > 0) wake.notify_one();
+}
+
+/**
+ * Take the newest task of the own deque, or steal the oldest of
+ * another deque starting at a random victim. Other threads own the
+ * shared deque, so that a thread waiting for the tasks it spawned
+ * runs those first, like a worker does.
+ */
+TaskScheduler::Task* TaskScheduler::Find(Worker* self) {
+    Worker* own = (self != NULL) ? self : workers.back();
+    {
+        boost::mutex::scoped_lock lock(own->mutex);
+        if (!own->tasks.empty()) {
+            Task* task = own->tasks.back();
+            own->tasks.pop_back();
+            return task;
+        }
+    }
+    const unsigned int n = workers.size();
+    unsigned int start = 0;
+    if (self != NULL) {
+        self->seed = self->seed * 1664525 + 1013904223;
+        start = (self->seed >> 16) % n;
+    }
+    for (unsigned int i=0; i<n; i++) {
+        Worker* victim = workers[(start + i) % n];
+        if (victim == own) continue;
+        boost::mutex::scoped_lock lock(victim->mutex);
+        if (!victim->tasks.empty()) {
+            Task* task = victim->tasks.front();
+            victim->tasks.pop_front();
+            return task;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Run a task, then release the tasks depending on its group if it
+ * was the last pending one.
+ */
+void TaskScheduler::Run(Task* task) {
+    try {
+        task->job();
+    } catch (std::exception& e) {
+        logger.error << "Uncaught exception in task: " << e.what() << logger.end;
+    } catch (...) {
+        logger.error << "Uncaught exception in task." << logger.end;
+    }
+    TaskGroup* group = task->group;
+    delete task;
+    if (group == NULL) return;
+    vector<Task*> ready;
+    bool done;
+    {
+        boost::mutex::scoped_lock lock(group->mutex);
+        done = (--group->pending == 0);
+        if (done) ready.swap(group->dependents);
+    }
+    // the group may be gone once it is done, so only the released
+    // tasks are touched from here
+    for (unsigned int i=0; i<ready.size(); i++)
+        Push(ready[i]);
+    if (done) {
+        boost::mutex::scoped_lock lock(sleep);
+        if (waiters > 0) wake.notify_all();
+    }
+}
+
+/**
+ * Thread exit cleanup of the worker pointer. The workers are owned by
+ * the scheduler, not the threads.
+ */
+void TaskScheduler::Keep(Worker* worker) {}
+
+/**
+ * Worker thread main loop.
+ */
+void TaskScheduler::Work(Worker* self) {
+    current.reset(self);
+    for (;;) {
+        Task* task = Find(self);
+        if (task == NULL) {
+            boost::mutex::scoped_lock lock(sleep);
+            task = Find(self);
+            if (task == NULL && !running) return;
+            if (task == NULL) {
+                sleepers++;
+                wake.wait(lock);
+                sleepers--;
+            }
+        }
+        if (task != NULL) Run(task);
+    }
+}
+
+} // NS Utils
+} // NS OpenEngine
@@ -0,0 +1,145 @@
+// Work stealing task scheduler.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#ifndef _TASK_SCHEDULER_H_
+#define _TASK_SCHEDULER_H_
+
+#include <boost/function.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition.hpp>
+#include <boost/thread/tss.hpp>
+#include <deque>
+#include <vector>
+
+namespace OpenEngine {
+namespace Utils {
+
+using std::deque;
+using std::vector;
+
+class TaskGroup;
+
+/**
+ * Work stealing task scheduler.
+ *
+ * Tasks are nullary function objects run by a fixed number of worker
+ * threads. Each worker has its own deque of tasks: tasks spawned by
+ * a task go to the deque of its worker, which runs them newest
+ * first, and idle workers steal the oldest tasks of the others.
+ * Tasks spawned from other threads go to a shared deque that those
+ * threads run newest first while waiting, and all workers steal
+ * from. So recursively split work stays on one thread until another
+ * runs dry, and only then is it shared.
+ *
+ * @code
+ * TaskScheduler scheduler;
+ * TaskGroup loads, builds;
+ * scheduler.Spawn(boost::bind(&Load, a), &loads);
+ * scheduler.Spawn(boost::bind(&Load, b), &loads);
+ * // runs when both loads are done
+ * scheduler.Spawn(boost::bind(&Build, a, b), &builds, &loads);
+ * scheduler.Wait(builds);
+ * @endcode
+ *
+ * A task can spawn tasks and wait for them: Wait() runs pending
+ * tasks on the waiting thread until the group is done, so waiting
+ * neither blocks a worker nor deadlocks. When there is nothing to
+ * run the waiting thread yields for a while and then sleeps until a
+ * task is spawned or a group is done.
+ *
+ * The engine and the libraries share one scheduler, GetDefault(), so
+ * that parallel loads, builds and modules do not compete with each
+ * other's threads for the cores.
+ *
+ * Tasks must not throw. Exceptions escaping a task are caught and
+ * logged, and the task counts as done.
+ *
+ * @class TaskScheduler TaskScheduler.h Utils/TaskScheduler.h
+ */
+class TaskScheduler {
+public:
+    //! Job type run by the scheduler.
+    typedef boost::function<void ()> Job;
+
+private:
+    struct Task {
+        Job job;
+        TaskGroup* group;
+    };
+
+    // deque of a worker, padded to keep the workers off each
+    // other's cache lines
+    struct Worker {
+        boost::mutex mutex;
+        deque<Task*> tasks;
+        unsigned int seed;
+        char padding[64];
+    };
+
+    vector<Worker*> workers;                    //!< the last is shared
+    boost::thread_group threads;                //!< the worker threads
+    boost::thread_specific_ptr<Worker> current; //!< worker of a thread
+    boost::mutex sleep;                         //!< guards the members below
+    boost::condition wake;                      //!< signaled on spawns
+    unsigned int sleepers;                      //!< threads sleeping
+    unsigned int waiters;                       //!< sleepers waiting for a group
+    bool running;                               //!< false when shutting down
+
+    void Work(Worker* self);
+    void Push(Task* task);
+    Task* Find(Worker* self);
+    void Run(Task* task);
+    static void Keep(Worker* worker);
+
+    friend class TaskGroup;
+
+public:
+    explicit TaskScheduler(const unsigned int workers = 0);
+    ~TaskScheduler();
+
+    void Spawn(Job job, TaskGroup* group = NULL, TaskGroup* after = NULL);
+    void Wait(TaskGroup& group);
+    bool RunPending();
+
+    unsigned int GetNumberOfWorkers();
+
+    static TaskScheduler& GetDefault();
+};
+
+/**
+ * Group of tasks to wait for or depend on.
+ *
+ * A group counts the tasks spawned into it that have not yet run. A
+ * task spawned after a group waits until the group has no pending
+ * tasks, so the dependency covers the tasks spawned into the group
+ * before the dependent task. Groups can be reused once done, and
+ * must not be destroyed while they have pending or dependent tasks.
+ *
+ * @see TaskScheduler
+ * @class TaskGroup TaskScheduler.h Utils/TaskScheduler.h
+ */
+class TaskGroup {
+private:
+    boost::mutex mutex;                             //!< guards the members below
+    unsigned int pending;                           //!< tasks not yet run
+    vector<TaskScheduler::Task*> dependents;        //!< tasks waiting for the group
+
+    friend class TaskScheduler;
+
+public:
+    TaskGroup();
+
+    bool IsDone();
+};
+
+} // NS Utils
+} // NS OpenEngine
+
+#endif // _TASK_SCHEDULER_H_
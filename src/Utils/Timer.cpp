@@ -10,6 +10,7 @@
 #include <Utils/Timer.h>
 
 #include <Core/Exceptions.h>
+#include <boost/thread/thread.hpp>
 #include <stdio.h>
 
 #if defined(_WIN32)
@@ -18,8 +19,12 @@
     #include <time.h>
 #endif
 
-#if defined(linux) || defined(__APPLE__)
-    #include <sys/time.h>
+#if defined(linux)
+    #include <time.h>
+#endif
+
+#if defined(__APPLE__)
+    #include <mach/mach_time.h>
 #endif
 
 namespace OpenEngine {
@@ -27,21 +32,76 @@ namespace Utils {
 
 using OpenEngine::Core::Exception;
 
+// cycles per nanosecond, measured on first use
+static volatile double cyclesPerNanosecond = 0;
+
+// how late a sleep may wake, and bounds for the estimate
+static volatile Timer::Nanoseconds slack = 1000000;
+static const Timer::Nanoseconds MIN_SLACK = 50000;
+static const Timer::Nanoseconds MAX_SLACK = 4000000;
+
 double Timer::GetTime() {
+    return GetNanoseconds() / 1000000.0;
+}
+
+Timer::Nanoseconds Timer::GetNanoseconds() {
 #if defined(_WIN32)
     LARGE_INTEGER ticksPerSecond, tick;
     if (!QueryPerformanceFrequency(&ticksPerSecond))
         throw Exception("no go QueryPerformance not present");
     if (!QueryPerformanceCounter(&tick))
         throw Exception("no go counter not installed");  
-    return ((double)tick.QuadPart/(double)ticksPerSecond.QuadPart)*1000.0;
+    // split the conversion so the multiplication does not overflow
+    Nanoseconds seconds = tick.QuadPart / ticksPerSecond.QuadPart;
+    Nanoseconds rest = tick.QuadPart % ticksPerSecond.QuadPart;
+    return seconds * 1000000000LL + rest * 1000000000LL / ticksPerSecond.QuadPart;
+#endif
+
+#if defined(linux)
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1000000000LL + t.tv_nsec;
+#endif
+
+#if defined(__APPLE__)
+    static mach_timebase_info_data_t timebase;
+    if (timebase.denom == 0) mach_timebase_info(&timebase);
+    return mach_absolute_time() * timebase.numer / timebase.denom;
 #endif
+}
+
+void Timer::WaitUntil(const Nanoseconds deadline) {
+    Nanoseconds now = GetNanoseconds();
+    while (deadline - now > slack) {
+        Nanoseconds target = deadline - slack;
+        boost::this_thread::sleep(boost::posix_time::microseconds((target - now) / 1000));
+        now = GetNanoseconds();
+        // follow late wake ups at once and early ones slowly
+        Nanoseconds late = now - target;
+        if (late > slack) slack = (late < MAX_SLACK) ? late : MAX_SLACK;
+        else slack -= (slack - ((late > MIN_SLACK) ? late : MIN_SLACK)) / 8;
+    }
+    while (now < deadline) {
+        boost::this_thread::yield();
+        now = GetNanoseconds();
+    }
+}
+
+double Timer::GetCyclesPerNanosecond() {
+    if (cyclesPerNanosecond == 0) {
+        Nanoseconds t0 = GetNanoseconds();
+        Cycles c0 = GetCycles();
+        Nanoseconds t1;
+        do t1 = GetNanoseconds();
+        while (t1 - t0 < 10000000);
+        Cycles c1 = GetCycles();
+        cyclesPerNanosecond = (double)(c1 - c0) / (t1 - t0);
+    }
+    return cyclesPerNanosecond;
+}
 
-#if defined(linux) || defined(__APPLE__)
-  struct timeval t;
-  gettimeofday( &t, NULL );
-  return ( t.tv_sec * 1000.0 + t.tv_usec / 1000.0 );
-#endif  
+Timer::Nanoseconds Timer::ToNanoseconds(const Cycles cycles) {
+    return (Nanoseconds)(cycles / GetCyclesPerNanosecond());
 }
 
 std::string Timer::GetDateTime() {
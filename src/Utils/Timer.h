@@ -12,6 +12,10 @@
 
 #include <string>
 
+#if defined(_MSC_VER)
+    #include <intrin.h>
+#endif
+
 namespace OpenEngine {
 namespace Utils {
 
@@ -20,19 +24,88 @@ using std::string;
 /**
  * Platform independent timer.
  *
+ * All times are read from a monotonic clock, so they never jump when
+ * the system clock is adjusted. Times have an arbitrary origin and
+ * are only meaningful relative to each other.
+ *
  * @class Timer Timer.h Utils/Timer.h
  */
 class Timer {
 public:
- 
+    //! Time in nanoseconds, signed so times can be subtracted.
+    typedef long long Nanoseconds;
+
+    //! Count of the processor cycle counter.
+    typedef unsigned long long Cycles;
+
     /**
      * Get a time reference.
      * Is comparible to the GetTickCount() from the Windows API.
      *
-     * @return Time count
+     * @return Time in milliseconds
      */
     static double GetTime();
 
+    /**
+     * Read the monotonic clock.
+     * Uses clock_gettime(CLOCK_MONOTONIC) on Linux, the mach
+     * absolute time on Mac OS X and the performance counter on
+     * Windows.
+     *
+     * @return Time in nanoseconds
+     */
+    static Nanoseconds GetNanoseconds();
+
+    /**
+     * Wait until the monotonic clock reaches a deadline.
+     * The thread sleeps until shortly before the deadline and yields
+     * for the rest, so it wakes on time without spinning the whole
+     * wait. The time left for yielding follows how late the system
+     * sleep wakes up.
+     *
+     * @param deadline Time to wait for, as from GetNanoseconds().
+     */
+    static void WaitUntil(const Nanoseconds deadline);
+
+    /**
+     * Read the processor cycle counter.
+     * Much cheaper than reading the clock, but the count is only
+     * comparable on the same core, and may not run at a constant
+     * rate on old processors. Use it for short spans of code that
+     * do not block, and GetNanoseconds() for anything else.
+     * Falls back to GetNanoseconds() where there is no counter.
+     *
+     * @return Cycle count
+     */
+    static Cycles GetCycles() {
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+        unsigned int low, high;
+        __asm__ __volatile__ ("rdtsc" : "=a" (low), "=d" (high));
+        return ((Cycles)high << 32) | low;
+#elif defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+        return __rdtsc();
+#else
+        return GetNanoseconds();
+#endif
+    }
+
+    /**
+     * Get the rate of the cycle counter.
+     * The rate is measured against the clock the first time it is
+     * asked for, which takes about ten milliseconds.
+     *
+     * @return Cycles per nanosecond
+     */
+    static double GetCyclesPerNanosecond();
+
+    /**
+     * Convert a number of cycles to nanoseconds.
+     *
+     * @param cycles Cycle count
+     * @return Time in nanoseconds
+     */
+    static Nanoseconds ToNanoseconds(const Cycles cycles);
+
     /**
      * Get a timestamp as string.
      *
@@ -42,6 +115,49 @@ public:
 
 };
 
+/**
+ * Cycle counter scope timer.
+ * Adds the cycles spent in a scope to a counter, at the cost of two
+ * reads of the cycle counter.
+ *
+ * @code
+ * Timer::Cycles sorting = 0;
+ * for (...) {
+ *     ScopeTimer timer(sorting);
+ *     Sort(...);
+ * }
+ * logger.info << Timer::ToNanoseconds(sorting) << " ns sorting" << logger.end;
+ * @endcode
+ *
+ * @see Timer::GetCycles()
+ * @class ScopeTimer Timer.h Utils/Timer.h
+ */
+class ScopeTimer {
+private:
+    Timer::Cycles& total;
+    Timer::Cycles start;
+
+    // disallow copying
+    ScopeTimer(const ScopeTimer&);
+    ScopeTimer& operator=(const ScopeTimer&);
+
+public:
+    /**
+     * Start timing.
+     *
+     * @param total Counter to add the cycles to.
+     */
+    explicit ScopeTimer(Timer::Cycles& total)
+        : total(total), start(Timer::GetCycles()) {}
+
+    /**
+     * Add the cycles since the start to the counter.
+     */
+    ~ScopeTimer() {
+        total += Timer::GetCycles() - start;
+    }
+};
+
 } //NS Utils
 } //NS OpenEngine
 
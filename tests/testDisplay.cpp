@@ -17,6 +17,13 @@
 
 // include display system
 #include <Display/IFrame.h>
+#include <Display/ViewingVolume.h>
+#include <Display/Frustum.h>
+#include <Geometry/BoxArray.h>
+#include <Geometry/SphereArray.h>
+#include <Logging/Logger.h>
+#include <Utils/Timer.h>
+#include <cstdlib>
 
 namespace OpenEngine {
 namespace Tests {
@@ -24,6 +31,8 @@ namespace Tests {
 using namespace std;
 using namespace OpenEngine::Core;
 using namespace OpenEngine::Display;
+using namespace OpenEngine::Geometry;
+using OpenEngine::Utils::Timer;
 
 void testFrame() {
     // module to test frame after engine start
@@ -65,6 +74,169 @@ void testFrame() {
     engine.Start(GetTestFactory());
 }
 
+// fill a box array and a list with the same random boxes
+static void randomBoxes(BoxArray& boxes, vector<Box>& list, unsigned int n) {
+    srand(42);
+    for (unsigned int i=0; i<n; i++) {
+        Vector<3,float> c, e;
+        for (int j=0; j<3; j++) {
+            c[j] = (rand() % 2000) / 2.0f - 500;
+            e[j] = (rand() % 100) / 4.0f;
+        }
+        boxes.Add(c, e);
+        list.push_back(Box(c, e));
+    }
+}
+
+void testFrustumBoxes() {
+    ViewingVolume volume;
+    Frustum frustum(volume);
+    volume.SetPosition(Vector<3,float>(10, 0, 20));
+    frustum.SignalRendering(0);
+
+    // a size not divisible by four exercises the scalar tail
+    const unsigned int n = 1003;
+    BoxArray boxes;
+    vector<Box> list;
+    randomBoxes(boxes, list, n);
+
+    vector<unsigned int> mask;
+    frustum.IsVisible(boxes, mask);
+    BOOST_CHECK(mask.size() == (n + 31) / 32);
+    unsigned int visible = 0, mismatches = 0;
+    for (unsigned int i=0; i<n; i++) {
+        bool v = frustum.IsVisible(list[i]);
+        if (v) visible++;
+        if (v != BoxArray::IsSet(mask, i)) mismatches++;
+    }
+    BOOST_CHECK(mismatches == 0);
+    BOOST_CHECK(visible > 0 && visible < n);
+    // bits past the last box are clear
+    BOOST_CHECK((mask.back() >> (n % 32)) == 0);
+}
+
+void benchFrustumBoxes() {
+    ViewingVolume volume;
+    Frustum frustum(volume);
+    frustum.SignalRendering(0);
+
+    const unsigned int n = 100000, rounds = 20;
+    BoxArray boxes;
+    vector<Box> list;
+    randomBoxes(boxes, list, n);
+
+    unsigned int count = 0;
+    double start = Timer::GetTime();
+    for (unsigned int r=0; r<rounds; r++)
+        for (unsigned int i=0; i<n; i++)
+            if (frustum.IsVisible(list[i])) count++;
+    double single = Timer::GetTime() - start;
+
+    vector<unsigned int> mask;
+    start = Timer::GetTime();
+    for (unsigned int r=0; r<rounds; r++)
+        frustum.IsVisible(boxes, mask);
+    double batch = Timer::GetTime() - start;
+
+    unsigned int visible = 0;
+    for (unsigned int i=0; i<n; i++)
+        if (BoxArray::IsSet(mask, i)) visible++;
+    BOOST_CHECK(visible * rounds == count);
+
+    // boxes per second, the times are in milliseconds
+    double tested = n * rounds * 1000.0;
+    logger.info << n << " boxes, " << visible << " visible: per box "
+                << tested / single << " boxes/s, batched "
+                << tested / batch << " boxes/s" << logger.end;
+}
+
+// fill a sphere array and a list with the same random spheres
+static void randomSpheres(SphereArray& spheres, vector<Sphere>& list, unsigned int n) {
+    srand(42);
+    for (unsigned int i=0; i<n; i++) {
+        Vector<3,float> c;
+        for (int j=0; j<3; j++)
+            c[j] = (rand() % 2000) / 2.0f - 500;
+        Sphere sphere(c, (rand() % 100) / 2.0f);
+        spheres.Add(sphere);
+        list.push_back(sphere);
+    }
+}
+
+void testFrustumSpheres() {
+    ViewingVolume volume;
+    Frustum frustum(volume);
+    volume.SetPosition(Vector<3,float>(10, 0, 20));
+    frustum.SignalRendering(0);
+
+    // a size not divisible by four exercises the scalar tail
+    const unsigned int n = 1003;
+    SphereArray spheres;
+    vector<Sphere> list;
+    randomSpheres(spheres, list, n);
+
+    vector<unsigned int> mask;
+    frustum.IsVisible(spheres, mask);
+    BOOST_CHECK(mask.size() == (n + 31) / 32);
+    unsigned int visible = 0, mismatches = 0;
+    for (unsigned int i=0; i<n; i++) {
+        bool v = frustum.IsVisible(list[i]);
+        if (v) visible++;
+        if (v != SphereArray::IsSet(mask, i)) mismatches++;
+        // a visible sphere has a visible bounding box
+        float r = list[i].GetRadius();
+        if (v && !frustum.IsVisible(Box(list[i].GetCenter(), Vector<3,float>(r, r, r))))
+            mismatches++;
+    }
+    BOOST_CHECK(mismatches == 0);
+    BOOST_CHECK(visible > 0 && visible < n);
+    BOOST_CHECK((mask.back() >> (n % 32)) == 0);
+}
+
+void benchFrustumSpheres() {
+    ViewingVolume volume;
+    Frustum frustum(volume);
+    frustum.SignalRendering(0);
+
+    const unsigned int n = 100000, rounds = 20;
+    SphereArray spheres;
+    vector<Sphere> list;
+    randomSpheres(spheres, list, n);
+    BoxArray boxes;
+    for (unsigned int i=0; i<n; i++)
+        boxes.Add(list[i].GetCenter(), Vector<3,float>(list[i].GetRadius()));
+
+    unsigned int count = 0;
+    double start = Timer::GetTime();
+    for (unsigned int r=0; r<rounds; r++)
+        for (unsigned int i=0; i<n; i++)
+            if (frustum.IsVisible(list[i])) count++;
+    double single = Timer::GetTime() - start;
+
+    vector<unsigned int> mask;
+    start = Timer::GetTime();
+    for (unsigned int r=0; r<rounds; r++)
+        frustum.IsVisible(spheres, mask);
+    double batch = Timer::GetTime() - start;
+    start = Timer::GetTime();
+    for (unsigned int r=0; r<rounds; r++)
+        frustum.IsVisible(boxes, mask);
+    double bounding = Timer::GetTime() - start;
+
+    frustum.IsVisible(spheres, mask);
+    unsigned int visible = 0;
+    for (unsigned int i=0; i<n; i++)
+        if (SphereArray::IsSet(mask, i)) visible++;
+    BOOST_CHECK(visible * rounds == count);
+
+    // spheres per second, the times are in milliseconds
+    double tested = n * rounds * 1000.0;
+    logger.info << n << " spheres, " << visible << " visible: per sphere "
+                << tested / single << " spheres/s, batched "
+                << tested / batch << " spheres/s, bounding boxes batched "
+                << tested / bounding << " boxes/s" << logger.end;
+}
+
 } // NS Tests
 } // NS OpenEngine
 
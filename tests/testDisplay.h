@@ -1,5 +1,9 @@
 namespace OpenEngine {
     namespace Tests {
         void testFrame();
+        void testFrustumBoxes();
+        void benchFrustumBoxes();
+        void testFrustumSpheres();
+        void benchFrustumSpheres();
     }
 }
@@ -13,6 +13,14 @@
 #include <Core/GameEngine.h>
 #include "GameTestFactory.h"
 #include <Core/IModule.h>
+#include <Core/ModuleGraph.h>
+#include <Core/Exceptions.h>
+#include <Utils/TaskScheduler.h>
+#include <Utils/Profiler.h>
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <math.h>
 
 namespace OpenEngine {
 namespace Tests {
@@ -140,5 +148,162 @@ void testGameEngineLookup() {
     delete m1;
 }
 
+static void count(int* counts, int index) {
+    counts[index]++;
+}
+
+// Test the engine task scheduler.
+void testGameEngineTasks() {
+    IGameEngine& engine = GameEngine::Instance();
+    Utils::TaskScheduler& scheduler = engine.GetTaskScheduler();
+    BOOST_CHECK(&scheduler == &engine.GetTaskScheduler());
+    BOOST_CHECK(&scheduler == &Utils::TaskScheduler::GetDefault());
+    BOOST_CHECK(scheduler.GetNumberOfWorkers() > 0);
+
+    int counts[100] = {0};
+    Utils::TaskGroup group;
+    for (int i=0; i<100; i++)
+        scheduler.Spawn(boost::bind(&count, counts, i), &group);
+    scheduler.Wait(group);
+    bool once = true;
+    for (int i=0; i<100; i++)
+        once &= counts[i] == 1;
+    BOOST_CHECK(once);
+}
+
+// records when and where it was processed
+class GraphModule : public IModule {
+public:
+    static boost::mutex mutex;
+    static int clock;
+    int begin, end, sleep;
+    bool fail;
+    boost::thread::id thread;
+    GraphModule(int sleep = 20) : begin(-1), end(-1), sleep(sleep), fail(false) {}
+    void Initialize() {}
+    void Process(const float deltaTime, const float percent) {
+        {
+            boost::mutex::scoped_lock lock(mutex);
+            begin = clock++;
+        }
+        thread = boost::this_thread::get_id();
+        boost::this_thread::sleep(boost::posix_time::milliseconds(sleep));
+        {
+            boost::mutex::scoped_lock lock(mutex);
+            end = clock++;
+        }
+        if (fail) throw Exception("failed");
+    }
+    void Deinitialize() {}
+    bool IsTypeOf(const std::type_info& inf) { return false; }
+};
+boost::mutex GraphModule::mutex;
+int GraphModule::clock = 0;
+
+// Test the ordering, placement and timing of module graphs.
+void testModuleGraph() {
+    // modules remove themselves from the engine when destroyed
+    GameEngine::Instance();
+    Utils::TaskScheduler scheduler(2);
+    boost::thread::id main = boost::this_thread::get_id();
+
+    // without dependencies the modules run in order on this thread
+    GraphModule s[3];
+    list<IModule*> modules;
+    map<IModule*, ModuleDependencies> deps;
+    for (int i=0; i<3; i++) modules.push_back(&s[i]);
+    ModuleGraph serial;
+    serial.Build(modules, deps);
+    BOOST_CHECK(!serial.IsParallel());
+    Utils::Profiler::Enable();
+    serial.Run(&scheduler, 1, 1);
+    Utils::Profiler::Disable();
+    vector<Utils::Profiler::ZoneStatistics> zones;
+    Utils::Profiler::GetStatistics(zones);
+    Utils::Profiler::Clear();
+    BOOST_REQUIRE(zones.size() == 1);
+    BOOST_CHECK(zones[0].category == "Process" && zones[0].total == 3);
+    BOOST_CHECK(zones[0].path.find("GraphModule") != string::npos);
+    for (int i=0; i<3; i++) {
+        BOOST_CHECK(s[i].thread == main);
+        if (i > 0) BOOST_CHECK(s[i-1].end < s[i].begin);
+    }
+    BOOST_CHECK(serial.GetCriticalPath() == serial.GetWork());
+    BOOST_CHECK(serial.GetWork() >= 55);
+
+    // diamond between two serial modules
+    GraphModule input, left, right, join, output;
+    modules.clear();
+    modules.push_back(&input);
+    modules.push_back(&left);
+    modules.push_back(&right);
+    modules.push_back(&join);
+    modules.push_back(&output);
+    deps[&left].Reads(input);
+    deps[&right].Reads(input);
+    deps[&join].Reads(left).Reads(right);
+    ModuleGraph diamond;
+    diamond.Build(modules, deps);
+    BOOST_CHECK(diamond.IsParallel());
+    BOOST_CHECK(diamond.Size() == 5);
+    for (int frame=0; frame<3; frame++) {
+        diamond.Run(&scheduler, 1, 1);
+        BOOST_CHECK(input.end < left.begin && input.end < right.begin);
+        BOOST_CHECK(left.end < join.begin && right.end < join.begin);
+        BOOST_CHECK(join.end < output.begin);
+        BOOST_CHECK(input.thread == main && output.thread == main);
+        // the critical path skips one of the branches
+        BOOST_CHECK(diamond.GetCriticalPath() >= 75);
+        BOOST_CHECK(diamond.GetCriticalPath() < diamond.GetWork() - 10);
+    }
+
+    // run after constraints may go against the add order, and writes
+    // order the modules in the add order
+    GraphModule first, second, writer;
+    modules.clear();
+    modules.push_back(&second);
+    modules.push_back(&writer);
+    modules.push_back(&first);
+    deps.clear();
+    deps[&second].After(first);
+    deps[&writer].Writes(second);
+    deps[&first];
+    ModuleGraph after;
+    after.Build(modules, deps);
+    after.Run(&scheduler, 1, 1);
+    BOOST_CHECK(first.end < second.begin);
+    BOOST_CHECK(second.end < writer.begin);
+
+    // a module failing in parallel does not stop the others
+    first.fail = true;
+    writer.begin = -1;
+    BOOST_CHECK_THROW(after.Run(&scheduler, 1, 1), Exception);
+    BOOST_CHECK(writer.begin != -1);
+    first.fail = false;
+
+    // cycles are rejected
+    deps[&first].After(writer);
+    BOOST_CHECK_THROW(after.Build(modules, deps), Exception);
+}
+
+// Test the frame pacing settings of the engine.
+void testGameEnginePacing() {
+    IGameEngine& engine = GameEngine::Instance();
+    BOOST_CHECK(engine.GetFrameRate() == 0);
+    engine.SetFrameRate(60);
+    BOOST_CHECK(fabs(engine.GetFrameRate() - 60) < 0.01);
+    engine.SetFrameRate(0);
+    BOOST_CHECK(engine.GetFrameRate() == 0);
+
+    // no frames before the engine has run
+    IGameEngine::FrameStatistics stats = engine.GetFrameStatistics();
+    BOOST_CHECK(stats.frames == 0 && stats.average == 0 && stats.jitter == 0);
+
+    // waking an engine that does not idle has no effect
+    engine.SetIdle(true, 10);
+    engine.Wake();
+    engine.SetIdle(false);
+}
+
 } // NS Tests
 } // NS OpenEngine
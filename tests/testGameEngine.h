@@ -4,5 +4,8 @@ namespace OpenEngine {
         void testInitDeinitModules();
         void testModuleProcess();
         void testGameEngineLookup();
+        void testGameEngineTasks();
+        void testModuleGraph();
+        void testGameEnginePacing();
     }
 }
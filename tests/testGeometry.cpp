@@ -14,8 +14,25 @@
 
 // include geometry lib
 #include <Geometry/FaceSet.h>
+#include <Geometry/Mesh.h>
+#include <Geometry/BoxArray.h>
+#include <Geometry/BVH.h>
+#include <Geometry/BSPTree.h>
+#include <Geometry/FaceArena.h>
+#include <Geometry/LooseOctree.h>
+#include <Geometry/SphereArray.h>
+#include <Geometry/Line.h>
+#include <Utils/Timer.h>
+#include <Utils/TaskScheduler.h>
+#include <Logging/Logger.h>
+#include <Resources/ITextureResource.h>
 
 #include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+#include <cfloat>
+#include <algorithm>
 
 using namespace OpenEngine::Geometry;
 
@@ -31,6 +48,133 @@ void OpenEngine::Tests::testFaceSet() {
     BOOST_CHECK( (result == Vector<3,int>(0,0,0)) );
 }
 
+// are two faces bitwise identical
+static bool sameFace(Face& a, Face& b) {
+    bool same = true;
+    for (int i=0; i<3; i++) {
+        same &= memcmp(&a.vert[i], &b.vert[i], sizeof(a.vert[i])) == 0;
+        same &= memcmp(&a.norm[i], &b.norm[i], sizeof(a.norm[i])) == 0;
+        same &= memcmp(&a.texc[i], &b.texc[i], sizeof(a.texc[i])) == 0;
+        same &= memcmp(&a.colr[i], &b.colr[i], sizeof(a.colr[i])) == 0;
+        same &= memcmp(&a.tang[i], &b.tang[i], sizeof(a.tang[i])) == 0;
+        same &= memcmp(&a.bino[i], &b.bino[i], sizeof(a.bino[i])) == 0;
+    }
+    same &= memcmp(&a.hardNorm, &b.hardNorm, sizeof(a.hardNorm)) == 0;
+    return same && a.texr == b.texr && a.shad == b.shad;
+}
+
+// a textured height field grid of n*n quads
+static FaceSet* createGrid(unsigned int n) {
+    FaceSet* faces = new FaceSet();
+    for (unsigned int y=0; y<n; y++)
+        for (unsigned int x=0; x<n; x++) {
+            Vector<3,float> p[4];
+            Vector<2,float> t[4];
+            for (int i=0; i<4; i++) {
+                float px = x + i%2, py = y + i/2;
+                p[i] = Vector<3,float>(px, (int(px*py) % 5) * 0.1f, py);
+                t[i] = Vector<2,float>(px / n, py / n);
+            }
+            int tri[2][3] = { {0, 2, 1}, {1, 2, 3} };
+            for (int k=0; k<2; k++) {
+                int* c = tri[k];
+                Vector<3,float> up(0,1,0);
+                FacePtr f(new Face(p[c[0]], p[c[1]], p[c[2]], up, up, up));
+                for (int i=0; i<3; i++) f->texc[i] = t[c[i]];
+                faces->Add(f);
+            }
+        }
+    return faces;
+}
+
+void OpenEngine::Tests::testMesh() {
+    using OpenEngine::Resources::ITextureResourcePtr;
+    using OpenEngine::Resources::IShaderResourcePtr;
+
+    // calculate the tangent space and color a single corner
+    FaceSet* faces = createGrid(4);
+    FaceList::iterator itr = faces->begin();
+    for (int i=0; itr != faces->end(); itr++, i++) {
+        (*itr)->CalcTangentSpace();
+        if (i == 3) (*itr)->colr[1] = Vector<4,float>(1,0,0,1);
+    }
+
+    Mesh mesh(*faces);
+    BOOST_CHECK(mesh.GetNumberOfTriangles() == 32);
+    // the tangent space is per face, so only corners of the same face
+    // and of neighbours with the same tangent space are shared
+    BOOST_CHECK(mesh.GetNumberOfVertices() < 3 * 32);
+    BOOST_CHECK(mesh.colors.size() == 4 * mesh.GetNumberOfVertices());
+    BOOST_CHECK(mesh.subMeshes.size() == 1);
+    BOOST_CHECK(mesh.GetMemoryCost() < faces->Size() * sizeof(Face));
+
+    // lossless round trip
+    FaceSet* copy = mesh.ToFaceSet();
+    BOOST_REQUIRE(copy->Size() == faces->Size());
+    bool same = true;
+    FaceList::iterator i = faces->begin(), j = copy->begin();
+    for (; i != faces->end(); i++, j++)
+        same &= sameFace(**i, **j);
+    BOOST_CHECK(same);
+    delete copy;
+
+    // a mesh without tangents and colors gets the face defaults
+    Mesh plain;
+    float v[] = { 0,0,0, 1,0,0, 0,0,1, 1,0,1 };
+    float t[] = { 0,0, 1,0, 0,1, 1,1 };
+    unsigned int idx[] = { 0,2,1, 1,2,3 };
+    plain.vertices.assign(v, v+12);
+    plain.normals.assign(12, 0);
+    plain.texcoords.assign(t, t+8);
+    plain.indices.assign(idx, idx+6);
+    plain.AddSubMesh(0, 3, ITextureResourcePtr(), IShaderResourcePtr());
+    plain.AddSubMesh(3, 3, ITextureResourcePtr(), IShaderResourcePtr());
+    BOOST_CHECK(plain.subMeshes.size() == 1);
+    FaceSet* fs = plain.ToFaceSet();
+    BOOST_REQUIRE(fs->Size() == 2);
+    Face& f = **fs->begin();
+    BOOST_CHECK( (f.colr[0] == Vector<4,float>(1)) );
+    BOOST_CHECK( (f.hardNorm == Vector<3,float>(0,1,0)) );
+    BOOST_CHECK( (f.tang[0] == Vector<3,float>(1,0,0)) );
+    delete fs;
+
+    delete faces;
+}
+
+void OpenEngine::Tests::benchMesh() {
+    using namespace OpenEngine::Logging;
+    using OpenEngine::Utils::Timer;
+
+    FaceSet* faces = createGrid(500);
+    Mesh mesh(*faces);
+    logger.info << "mesh of " << mesh.GetNumberOfTriangles() << " triangles, "
+                << mesh.GetNumberOfVertices() << " vertices: "
+                << mesh.GetMemoryCost() / 1024 << " KB, face set "
+                << faces->Size() * (sizeof(Face) + sizeof(FacePtr)) / 1024
+                << " KB" << logger.end;
+
+    // sum the vertex positions of both representations
+    double start = Timer::GetTime();
+    Vector<3,float> sum;
+    for (FaceList::iterator itr = faces->begin(); itr != faces->end(); itr++)
+        for (int i=0; i<3; i++)
+            sum += (*itr)->vert[i];
+    double tfaces = Timer::GetTime() - start;
+
+    start = Timer::GetTime();
+    float msum[3] = { 0, 0, 0 };
+    const float* v = &mesh.vertices[0];
+    const unsigned int* index = &mesh.indices[0];
+    for (unsigned int i=0; i<mesh.indices.size(); i++)
+        for (int k=0; k<3; k++)
+            msum[k] += v[3*index[i]+k];
+    double tmesh = Timer::GetTime() - start;
+    BOOST_CHECK( (sum == Vector<3,float>(msum)) );
+    logger.info << "vertex traversal: face set " << tfaces << " ms, mesh "
+                << tmesh << " ms" << logger.end;
+    delete faces;
+}
+
 void OpenEngine::Tests::testLine() {
     /*
     // from: http://mathforum.org/library/drmath/view/51996.html
@@ -49,3 +193,814 @@ void OpenEngine::Tests::testLine() {
     BOOST_CHECK( (p2 == ) );
 */
 }
+
+void OpenEngine::Tests::testBoxArray() {
+    // random planes, some with zero normal components, and boxes
+    srand(7);
+    Plane* planes[10];
+    for (int p=0; p<10; p++) {
+        Vector<3,float> n;
+        for (int j=0; j<3; j++)
+            n[j] = (p % 3 == j) ? 0 : (rand() % 200 - 100) / 100.0f;
+        planes[p] = new Plane(n, (rand() % 200 - 100) / 10.0f);
+    }
+    BoxArray boxes;
+    for (int i=0; i<999; i++) {
+        Vector<3,float> c, e;
+        for (int j=0; j<3; j++) {
+            c[j] = (rand() % 400 - 200) / 10.0f;
+            e[j] = (rand() % 50) / 10.0f;
+        }
+        boxes.Add(c, e);
+    }
+    BOOST_CHECK(boxes.Size() == 999);
+
+    // the vectorized and scalar masks are identical for any plane set,
+    // also for more planes than are set up on the stack
+    for (unsigned int count=0; count<=10; count++) {
+        vector<unsigned int> fast, slow;
+        boxes.Cull(planes, count, fast);
+        boxes.CullScalar(planes, count, slow);
+        BOOST_CHECK(fast == slow);
+    }
+
+    // a box is culled if its farthest corner is behind a plane
+    vector<unsigned int> mask;
+    boxes.Cull(planes, 10, mask);
+    unsigned int mismatches = 0;
+    for (unsigned int i=0; i<boxes.Size(); i++) {
+        Box box(Vector<3,float>(boxes.cx[i], boxes.cy[i], boxes.cz[i]),
+                Vector<3,float>(boxes.ex[i], boxes.ey[i], boxes.ez[i]));
+        bool v = true;
+        for (int p=0; p<10; p++) {
+            Vector<3,float> n = planes[p]->normal;
+            Vector<3,float> c = box.GetCorner(n[0] > 0, n[1] > 0, n[2] > 0);
+            if (c * n + planes[p]->distance < 0) v = false;
+        }
+        if (v != BoxArray::IsSet(mask, i)) mismatches++;
+    }
+    BOOST_CHECK(mismatches == 0);
+
+    boxes.Clear();
+    boxes.Cull(planes, 10, mask);
+    BOOST_CHECK(boxes.Size() == 0 && mask.empty());
+    for (int p=0; p<10; p++) delete planes[p];
+}
+
+// the face of a height field grid below a point, found by brute force
+static FacePtr faceBelow(FaceSet& faces, float x, float z) {
+    for (FaceList::iterator itr = faces.begin(); itr != faces.end(); itr++) {
+        Vector<3,float>* v = (*itr)->vert;
+        float d = (v[1][0]-v[0][0]) * (v[2][2]-v[0][2]) - (v[2][0]-v[0][0]) * (v[1][2]-v[0][2]);
+        float a = ((v[1][0]-x) * (v[2][2]-z) - (v[2][0]-x) * (v[1][2]-z)) / d;
+        float b = ((v[2][0]-x) * (v[0][2]-z) - (v[0][0]-x) * (v[2][2]-z)) / d;
+        if (a >= 0 && b >= 0 && a + b <= 1) return *itr;
+    }
+    return FacePtr();
+}
+
+static bool contains(const vector<FacePtr>& faces, FacePtr face) {
+    return std::find(faces.begin(), faces.end(), face) != faces.end();
+}
+
+void OpenEngine::Tests::testBVH() {
+    using OpenEngine::Utils::TaskScheduler;
+    BOOST_CHECK(sizeof(BVH::Node) == 32);
+
+    BVH empty;
+    BVH::RayHit hit;
+    empty.Build(*createGrid(0));
+    BOOST_CHECK(empty.GetNumberOfNodes() == 0);
+    BOOST_CHECK(!empty.Intersect(Vector<3,float>(0,1,0), Vector<3,float>(0,-1,0), hit));
+
+    // the parallel build gives the same tree as the sequential build
+    FaceSet* faces = createGrid(60);
+    BVH bvh, parallel;
+    bvh.Build(*faces);
+    TaskScheduler scheduler(2);
+    parallel.Build(*faces, scheduler);
+    BOOST_CHECK(bvh.GetNumberOfFaces() == 7200);
+    BOOST_REQUIRE(bvh.GetNumberOfNodes() == parallel.GetNumberOfNodes());
+    BOOST_CHECK(memcmp(&bvh.GetNodes()[0], &parallel.GetNodes()[0],
+                       bvh.GetNumberOfNodes() * sizeof(BVH::Node)) == 0);
+    BOOST_CHECK(bvh.GetDepth() < 32);
+
+    // vertical rays hit the face below them
+    srand(42);
+    unsigned int misses = 0;
+    for (int i=0; i<200; i++) {
+        float x = 60.0f * rand() / RAND_MAX, z = 60.0f * rand() / RAND_MAX;
+        FacePtr expected = faceBelow(*faces, x, z);
+        bool found = parallel.Intersect(Vector<3,float>(x,5,z),
+                                        Vector<3,float>(0,-1,0), hit);
+        if (!found || hit.face != expected ||
+            fabs(hit.point[1] + hit.distance - 5) > 1e-4) misses++;
+        BOOST_CHECK(parallel.IntersectsAny(Vector<3,float>(x,5,z),
+                                           Vector<3,float>(0,-1,0)));
+    }
+    BOOST_CHECK(misses == 0);
+    BOOST_CHECK(!bvh.Intersect(Vector<3,float>(-1,5,-1), Vector<3,float>(0,-1,0), hit));
+    BOOST_CHECK(!bvh.Intersect(Vector<3,float>(10,5,10), Vector<3,float>(0,1,0), hit));
+    BOOST_CHECK(!bvh.IntersectsAny(Vector<3,float>(10,5,10), Vector<3,float>(0,-1,0), 4.5f));
+    BOOST_CHECK(bvh.IntersectsAny(Vector<3,float>(10,5,10), Vector<3,float>(0,-1,0), 5.5f));
+
+    // any hit agrees with the nearest hit for slanted rays
+    unsigned int disagreements = 0;
+    for (int i=0; i<200; i++) {
+        Vector<3,float> o(70.0f * rand() / RAND_MAX - 5, 2, 70.0f * rand() / RAND_MAX - 5);
+        Vector<3,float> d(2.0f * rand() / RAND_MAX - 1, -0.1f, 2.0f * rand() / RAND_MAX - 1);
+        if (bvh.Intersect(o, d, hit) != bvh.IntersectsAny(o, d)) disagreements++;
+    }
+    BOOST_CHECK(disagreements == 0);
+
+    // a face overlapping a sphere or a box is reported if one of its
+    // vertices is inside, and never if its bounds are outside
+    unsigned int wrong = 0;
+    for (int i=0; i<50; i++) {
+        Vector<3,float> c(60.0f * rand() / RAND_MAX, 0.2f, 60.0f * rand() / RAND_MAX);
+        Sphere sphere(c, 6.0f * rand() / RAND_MAX);
+        Box box(c, Vector<3,float>(3.0f * rand() / RAND_MAX, 0.1f, 3.0f * rand() / RAND_MAX));
+        vector<FacePtr> inSphere, inBox;
+        bvh.Overlaps(sphere, inSphere);
+        bvh.Overlaps(box, inBox);
+        for (FaceList::iterator itr = faces->begin(); itr != faces->end(); itr++) {
+            Vector<3,float>* v = (*itr)->vert;
+            bool vs = false, vb = false, bs = true, bb = true;
+            for (int k=0; k<3; k++) {
+                Vector<3,float> d = v[k] - c, e = box.GetCorner();
+                vs |= d * d <= sphere.GetRadius() * sphere.GetRadius();
+                vb |= fabs(d[0]) <= e[0] && fabs(d[1]) <= e[1] && fabs(d[2]) <= e[2];
+            }
+            for (int k=0; k<3; k++) {
+                float mn = std::min(v[0][k], std::min(v[1][k], v[2][k]));
+                float mx = std::max(v[0][k], std::max(v[1][k], v[2][k]));
+                bs &= mn <= c[k] + sphere.GetRadius() && mx >= c[k] - sphere.GetRadius();
+                bb &= mn <= c[k] + box.GetCorner()[k] && mx >= c[k] - box.GetCorner()[k];
+            }
+            bool s = contains(inSphere, *itr), b = contains(inBox, *itr);
+            if ((vs && !s) || (s && !bs) || (vb && !b) || (b && !bb)) wrong++;
+        }
+    }
+    BOOST_CHECK(wrong == 0);
+    delete faces;
+
+    // overlaps of a large triangle without any vertex inside
+    FaceSet single;
+    single.Add(FacePtr(new Face(Vector<3,float>(0,0,0), Vector<3,float>(10,0,0),
+                                Vector<3,float>(0,0,10))));
+    BVH one;
+    one.Build(single);
+    vector<FacePtr> result;
+    one.Overlaps(Sphere(Vector<3,float>(2,1,2), 3.0f), result);
+    BOOST_CHECK(result.size() == 1);
+    one.Overlaps(Sphere(Vector<3,float>(2,1,2), 1.0f), result);
+    one.Overlaps(Sphere(Vector<3,float>(6,0,6), 1.0f), result);
+    BOOST_CHECK(result.size() == 1);
+    one.Overlaps(Box(Vector<3,float>(2,0.5f,2), Vector<3,float>(0.5f,0.6f,0.5f)), result);
+    BOOST_CHECK(result.size() == 2);
+    one.Overlaps(Box(Vector<3,float>(2,0.5f,2), Vector<3,float>(0.5f,0.4f,0.5f)), result);
+    one.Overlaps(Box(Vector<3,float>(6,0,6), Vector<3,float>(0.9f,0.5f,0.9f)), result);
+    BOOST_CHECK(result.size() == 2);
+}
+
+void OpenEngine::Tests::benchBVH() {
+    using namespace OpenEngine::Logging;
+    using OpenEngine::Utils::Timer;
+    using OpenEngine::Utils::TaskScheduler;
+
+    FaceSet* faces = createGrid(320);
+    BVH bvh;
+    double start = Timer::GetTime();
+    bvh.Build(*faces);
+    double tbuild = Timer::GetTime() - start;
+    TaskScheduler scheduler(4);
+    start = Timer::GetTime();
+    bvh.Build(*faces, scheduler);
+    double tparallel = Timer::GetTime() - start;
+    logger.info << "bvh of " << bvh.GetNumberOfFaces() << " faces, "
+                << bvh.GetNumberOfNodes() << " nodes, depth " << bvh.GetDepth()
+                << ": build " << tbuild << " ms, parallel build "
+                << tparallel << " ms" << logger.end;
+
+    // rays from above in random directions
+    const int rays = 200000;
+    vector<Vector<3,float> > origins(rays), directions(rays);
+    srand(7);
+    for (int i=0; i<rays; i++) {
+        origins[i] = Vector<3,float>(320.0f * rand() / RAND_MAX, 3,
+                                     320.0f * rand() / RAND_MAX);
+        directions[i] = Vector<3,float>(2.0f * rand() / RAND_MAX - 1, -1,
+                                        2.0f * rand() / RAND_MAX - 1);
+    }
+    BVH::RayHit hit;
+    unsigned int hits = 0;
+    start = Timer::GetTime();
+    for (int i=0; i<rays; i++)
+        hits += bvh.Intersect(origins[i], directions[i], hit);
+    double tnearest = Timer::GetTime() - start;
+    start = Timer::GetTime();
+    for (int i=0; i<rays; i++)
+        hits -= bvh.IntersectsAny(origins[i], directions[i]);
+    double tany = Timer::GetTime() - start;
+    BOOST_CHECK(hits == 0);
+
+    const int queries = 20000;
+    vector<FacePtr> result;
+    start = Timer::GetTime();
+    for (int i=0; i<queries; i++) {
+        result.clear();
+        bvh.Overlaps(Sphere(origins[i], 8), result);
+    }
+    double tsphere = Timer::GetTime() - start;
+    start = Timer::GetTime();
+    for (int i=0; i<queries; i++) {
+        result.clear();
+        bvh.Overlaps(Box(origins[i], Vector<3,float>(2,4,2)), result);
+    }
+    double tbox = Timer::GetTime() - start;
+
+    logger.info << "nearest hit: " << rays / tnearest * 1000 << " rays/s, any hit: "
+                << rays / tany * 1000 << " rays/s" << logger.end;
+    logger.info << "sphere overlap: " << queries / tsphere * 1000
+                << " queries/s, box overlap: " << queries / tbox * 1000
+                << " queries/s" << logger.end;
+    delete faces;
+}
+
+// adds the twelve faces of a box, facing outwards
+static void addBox(FaceSet* faces, Vector<3,float> min, Vector<3,float> max) {
+    Vector<3,float> c[8];
+    for (int i=0; i<8; i++)
+        c[i] = Vector<3,float>((i & 1) ? max[0] : min[0],
+                               (i & 2) ? max[1] : min[1],
+                               (i & 4) ? max[2] : min[2]);
+    int quads[6][4] = { {0,2,3,1}, {4,5,7,6}, {0,1,5,4},
+                        {2,6,7,3}, {0,4,6,2}, {1,3,7,5} };
+    for (int q=0; q<6; q++) {
+        int* v = quads[q];
+        faces->Add(FacePtr(new Face(c[v[0]], c[v[2]], c[v[1]])));
+        faces->Add(FacePtr(new Face(c[v[0]], c[v[3]], c[v[2]])));
+    }
+}
+
+static float area(const float v[3][3]) {
+    Vector<3,float> a(v[1][0]-v[0][0], v[1][1]-v[0][1], v[1][2]-v[0][2]);
+    Vector<3,float> b(v[2][0]-v[0][0], v[2][1]-v[0][1], v[2][2]-v[0][2]);
+    return (a % b).GetLength() / 2;
+}
+
+static double totalArea(const BSPTree& bsp) {
+    double sum = 0;
+    for (unsigned int i=0; i<bsp.GetNumberOfFragments(); i++)
+        sum += area(bsp.GetFragments()[i].vert);
+    return sum;
+}
+
+void OpenEngine::Tests::testBSPTree() {
+    using OpenEngine::Utils::TaskScheduler;
+
+    // a convex box is never split
+    FaceSet box;
+    addBox(&box, Vector<3,float>(-1), Vector<3,float>(1));
+    BSPTree bsp;
+    bsp.Build(box);
+    BOOST_CHECK(bsp.GetNumberOfFragments() == 12);
+    BOOST_CHECK(bsp.GetNumberOfNodes() <= 12);
+    BOOST_CHECK(bsp.GetFace(0) == *box.begin() ||
+                bsp.GetFace(0)->vert[0] == (*box.begin())->vert[0]);
+
+    FaceSet* faces = createGrid(40);
+    double expected = 0;
+    for (FaceList::iterator itr = faces->begin(); itr != faces->end(); itr++) {
+        float v[3][3];
+        for (int i=0; i<3; i++)
+            for (int k=0; k<3; k++) v[i][k] = (*itr)->vert[i][k];
+        expected += area(v);
+    }
+    bsp.Build(*faces, 0.001f);
+    BOOST_CHECK(bsp.GetNumberOfFragments() >= 3200);
+    BOOST_CHECK(fabs(totalArea(bsp) - expected) < expected * 1e-4);
+
+    // the parallel build gives a tree of the same shape
+    BSPTree parallel;
+    TaskScheduler scheduler(2);
+    parallel.Build(*faces, scheduler, 0.001f);
+    BOOST_CHECK(parallel.GetNumberOfNodes() == bsp.GetNumberOfNodes());
+    BOOST_CHECK(parallel.GetNumberOfFragments() == bsp.GetNumberOfFragments());
+    BOOST_CHECK(parallel.GetDepth() == bsp.GetDepth());
+
+    // the fragments of a subtree are on its side of the parent plane
+    const vector<BSPTree::Node>& nodes = parallel.GetNodes();
+    const vector<BSPTree::Fragment>& frags = parallel.GetFragments();
+    unsigned int wrong = 0;
+    for (unsigned int n=0; n<nodes.size(); n++) {
+        const BSPTree::Node& node = nodes[n];
+        for (int side=0; side<2; side++) {
+            vector<int> stack(1, side ? node.front : node.back);
+            while (!stack.empty()) {
+                int c = stack.back();
+                stack.pop_back();
+                if (c < 0) continue;
+                for (unsigned int f=0; f<nodes[c].count; f++)
+                    for (int i=0; i<3; i++) {
+                        const float* v = frags[nodes[c].first + f].vert[i];
+                        float d = node.normal[0]*v[0] + node.normal[1]*v[1] +
+                            node.normal[2]*v[2] + node.distance;
+                        if (side ? d < -0.002f : d > 0.002f) wrong++;
+                    }
+                stack.push_back(nodes[c].front);
+                stack.push_back(nodes[c].back);
+            }
+        }
+    }
+    BOOST_CHECK(wrong == 0);
+
+    // split faces get interpolated texture coordinates, which on the
+    // grid follow the position
+    FaceSet* split = parallel.ToFaceSet();
+    BOOST_CHECK(split->Size() == (int)parallel.GetNumberOfFragments());
+    float error = 0;
+    for (FaceList::iterator itr = split->begin(); itr != split->end(); itr++)
+        for (int i=0; i<3; i++) {
+            error = std::max(error, fabs((*itr)->texc[i][0] - (*itr)->vert[i][0] / 40));
+            error = std::max(error, fabs((*itr)->texc[i][1] - (*itr)->vert[i][2] / 40));
+        }
+    BOOST_CHECK(error < 1e-4);
+    delete split;
+
+    // the back to front order holds every fragment once
+    vector<unsigned int> order;
+    parallel.GetBackToFront(Vector<3,float>(20,10,20), order);
+    BOOST_REQUIRE(order.size() == parallel.GetNumberOfFragments());
+    std::sort(order.begin(), order.end());
+    bool once = true;
+    for (unsigned int i=0; i<order.size(); i++) once &= order[i] == i;
+    BOOST_CHECK(once);
+    delete faces;
+
+    bsp.Clear();
+    BOOST_CHECK(bsp.GetNumberOfNodes() == 0 && bsp.GetDepth() == 0);
+}
+
+void OpenEngine::Tests::benchBSPTree() {
+    using namespace OpenEngine::Logging;
+    using OpenEngine::Utils::Timer;
+    using OpenEngine::Utils::TaskScheduler;
+
+    // a level of 130 x 130 buildings on a grid of streets
+    FaceSet level;
+    srand(3);
+    for (int x=0; x<130; x++)
+        for (int z=0; z<130; z++) {
+            float w = 2 + rand() % 4, d = 2 + rand() % 4, h = 1 + rand() % 20;
+            addBox(&level, Vector<3,float>(x * 8, 0, z * 8),
+                   Vector<3,float>(x * 8 + w, h, z * 8 + d));
+        }
+
+    BSPTree bsp;
+    double start = Timer::GetTime();
+    bsp.Build(level, 0.001f);
+    double tbuild = Timer::GetTime() - start;
+    TaskScheduler scheduler(4);
+    start = Timer::GetTime();
+    bsp.Build(level, scheduler, 0.001f);
+    double tparallel = Timer::GetTime() - start;
+    logger.info << "bsp of " << level.Size() << " faces: "
+                << bsp.GetNumberOfNodes() << " nodes, "
+                << bsp.GetNumberOfFragments() << " fragments, depth "
+                << bsp.GetDepth() << logger.end;
+    logger.info << "build " << tbuild << " ms, parallel build "
+                << tparallel << " ms" << logger.end;
+}
+
+void OpenEngine::Tests::testFaceSplit() {
+    // intersections by value agree with the allocating variants
+    Face face(Vector<3,float>(0,0,0), Vector<3,float>(0,0,1), Vector<3,float>(1,0,0));
+    Vector<3,float> point;
+    BOOST_CHECK(face.PlaneIntersection(Vector<3,float>(0.2f,1,0.2f),
+                                       Vector<3,float>(0.2f,-1,0.2f), point));
+    BOOST_CHECK( (point == Vector<3,float>(0.2f,0,0.2f)) );
+    BOOST_CHECK(face.Intersection(Vector<3,float>(0.2f,1,0.2f),
+                                  Vector<3,float>(0.2f,-1,0.2f), point));
+    BOOST_CHECK(face.PlaneIntersection(Vector<3,float>(2,1,2),
+                                       Vector<3,float>(2,-1,2), point));
+    BOOST_CHECK(!face.Intersection(Vector<3,float>(2,1,2), Vector<3,float>(2,-1,2), point));
+    BOOST_CHECK(!face.PlaneIntersection(Vector<3,float>(0,1,0), Vector<3,float>(1,1,1), point));
+    Vector<3,float>* p = face.PlaneIntersection(Vector<3,float>(0.2f,1,0.2f),
+                                                Vector<3,float>(0.2f,-1,0.2f));
+    BOOST_REQUIRE(p != NULL);
+    BOOST_CHECK( (*p == Vector<3,float>(0.2f,0,0.2f)) );
+    delete p;
+    BOOST_CHECK(face.Intersection(Vector<3,float>(2,1,2), Vector<3,float>(2,-1,2)) == NULL);
+
+    // splitting into face sets and into arenas gives the same faces
+    FaceSet* faces = createGrid(10);
+    FacePtr planes[3] = {
+        FacePtr(new Face(Vector<3,float>(3.3f,0,0), Vector<3,float>(3.3f,1,0),
+                         Vector<3,float>(7.7f,0,10))),
+        FacePtr(new Face(Vector<3,float>(0,0.15f,0), Vector<3,float>(0,0.25f,10),
+                         Vector<3,float>(10,0.15f,0))),
+        FacePtr(new Face(Vector<3,float>(0,0,5), Vector<3,float>(0,1,5),
+                         Vector<3,float>(1,0,5)))
+    };
+    FaceArena front, span, back;
+    for (int i=0; i<3; i++) {
+        FaceSet sf, ss, sb, af, as, ab;
+        faces->Split(planes[i], sf, ss, sb);
+        front.Clear(); span.Clear(); back.Clear();
+        faces->Split(planes[i], front, span, back);
+        BOOST_CHECK((int)front.Size() == sf.Size());
+        BOOST_CHECK((int)span.Size() == ss.Size());
+        BOOST_CHECK((int)back.Size() == sb.Size());
+        front.ToFaceSet(af);
+        span.ToFaceSet(as);
+        back.ToFaceSet(ab);
+        bool same = true;
+        FaceSet* sets[3][2] = { {&sf, &af}, {&ss, &as}, {&sb, &ab} };
+        for (int k=0; k<3; k++) {
+            FaceList::iterator a = sets[k][0]->begin(), b = sets[k][1]->begin();
+            for (; a != sets[k][0]->end() && b != sets[k][1]->end(); a++, b++)
+                same &= sameFace(**a, **b);
+        }
+        BOOST_CHECK(same);
+        BOOST_CHECK(sf.Size() + sb.Size() > faces->Size() || i == 2);
+    }
+
+    // once the arenas have grown, splitting does not grow them again
+    front.Clear(); span.Clear(); back.Clear();
+    unsigned int growths = front.GetNumberOfGrowths() + span.GetNumberOfGrowths()
+        + back.GetNumberOfGrowths();
+    faces->Split(planes[0], front, span, back);
+    BOOST_CHECK(front.GetNumberOfGrowths() + span.GetNumberOfGrowths()
+                + back.GetNumberOfGrowths() == growths);
+    BOOST_CHECK(front.Size() > 0 && back.Size() > 0);
+    delete faces;
+}
+
+void OpenEngine::Tests::benchFaceSplit() {
+    using namespace OpenEngine::Logging;
+    using OpenEngine::Utils::Timer;
+
+    FaceSet* faces = createGrid(200);
+    const int count = 20;
+    vector<FacePtr> planes;
+    for (int i=0; i<count; i++) {
+        float x = 10 * i + 0.37f;
+        planes.push_back(FacePtr(new Face(Vector<3,float>(x,0,0), Vector<3,float>(x,1,0),
+                                          Vector<3,float>(x + 15,0,200))));
+    }
+
+    // faces actually cut by the planes
+    unsigned long cut = 0;
+    FaceFragment f[2], b[2];
+    unsigned int nf, nb;
+    for (int i=0; i<count; i++)
+        for (FaceList::iterator itr = faces->begin(); itr != faces->end(); itr++)
+            if (planes[i]->Split(**itr, f, nf, b, nb) == Face::SPLIT) cut++;
+
+    // every face added to a face set is allocated on its own
+    unsigned long setFaces = 0;
+    double start = Timer::GetTime();
+    for (int i=0; i<count; i++) {
+        FaceSet front, span, back;
+        faces->Split(planes[i], front, span, back);
+        setFaces += front.Size() + span.Size() + back.Size();
+    }
+    double tset = Timer::GetTime() - start;
+
+    FaceArena front, span, back;
+    faces->Split(planes[0], front, span, back);
+    unsigned int growths = front.GetNumberOfGrowths() + span.GetNumberOfGrowths()
+        + back.GetNumberOfGrowths();
+    start = Timer::GetTime();
+    for (int i=0; i<count; i++) {
+        front.Clear(); span.Clear(); back.Clear();
+        faces->Split(planes[i], front, span, back);
+    }
+    double tarena = Timer::GetTime() - start;
+    growths = front.GetNumberOfGrowths() + span.GetNumberOfGrowths()
+        + back.GetNumberOfGrowths() - growths;
+
+    logger.info << count << " splits of " << faces->Size() << " faces, "
+                << cut << " faces cut" << logger.end;
+    logger.info << "face sets: " << tset << " ms, "
+                << setFaces << " faces allocated" << logger.end;
+    logger.info << "arenas: " << tarena << " ms, "
+                << growths << " growths" << logger.end;
+    delete faces;
+}
+
+// random boxes for the octree tests, some outside the root cell
+static Box randomBox(float range, float size) {
+    Vector<3,float> c, e;
+    for (int j=0; j<3; j++) {
+        c[j] = range * (2.0f * rand() / RAND_MAX - 1);
+        e[j] = size * rand() / RAND_MAX;
+    }
+    return Box(c, e);
+}
+
+static void boxBounds(const Box& box, float min[3], float max[3]) {
+    for (int j=0; j<3; j++) {
+        min[j] = box.GetCenter().Get(j) - box.GetCorner().Get(j);
+        max[j] = box.GetCenter().Get(j) + box.GetCorner().Get(j);
+    }
+}
+
+// entry distance of a ray into a box by brute force, -1 on a miss
+static float rayEntry(Vector<3,float> o, Vector<3,float> d, const Box& box) {
+    float min[3], max[3];
+    boxBounds(box, min, max);
+    float t0 = 0, t1 = FLT_MAX;
+    for (int j=0; j<3; j++) {
+        float a = (min[j] - o[j]) / d[j], b = (max[j] - o[j]) / d[j];
+        t0 = std::max(t0, std::min(a, b));
+        t1 = std::min(t1, std::max(a, b));
+    }
+    return (t0 <= t1) ? t0 : -1;
+}
+
+void OpenEngine::Tests::testLooseOctree() {
+    srand(11);
+    LooseOctree octree(Vector<3,float>(0.0f), 100, 6);
+    const unsigned int count = 2000;
+    vector<Box> boxes;
+    vector<bool> live(count, true);
+    for (unsigned int i=0; i<count; i++) {
+        boxes.push_back(randomBox(120, (i % 10 == 0) ? 30 : 3));
+        BOOST_CHECK(octree.Add(boxes[i]) == i);
+    }
+    BOOST_CHECK(octree.Size() == count);
+
+    // move some boxes, remove others and reuse their ids
+    for (unsigned int i=0; i<count; i+=3) {
+        boxes[i] = randomBox(120, 3);
+        octree.Update(i, boxes[i]);
+    }
+    for (unsigned int i=1; i<count; i+=7) {
+        octree.Remove(i);
+        live[i] = false;
+    }
+    unsigned int reused = octree.Add(boxes[1]);
+    BOOST_CHECK(!live[reused]);
+    boxes[reused] = boxes[1];
+    live[reused] = true;
+    BOOST_CHECK(octree.Size() == count - (count + 5) / 7 + 1);
+
+    unsigned int mismatches = 0;
+    for (int q=0; q<50; q++) {
+        Box qbox = randomBox(100, 40);
+        Sphere qsphere(qbox.GetCenter(), 50);
+        Plane* planes[4];
+        for (int p=0; p<4; p++) {
+            Vector<3,float> n(2.0f * rand() / RAND_MAX - 1, 2.0f * rand() / RAND_MAX - 1,
+                              2.0f * rand() / RAND_MAX - 1);
+            planes[p] = new Plane(n, 50.0f * rand() / RAND_MAX);
+        }
+        Vector<3,float> origin = randomBox(150, 0).GetCenter();
+        Vector<3,float> dir = randomBox(1, 0).GetCenter();
+
+        vector<unsigned int> inBox, inSphere, inPlanes, onRay;
+        vector<unsigned int> rBox, rSphere, rPlanes, rRay;
+        octree.Query(qbox, inBox);
+        octree.Query(qsphere, inSphere);
+        octree.Query(planes, 4, inPlanes);
+        octree.Query(origin, dir, onRay);
+
+        float qmin[3], qmax[3];
+        boxBounds(qbox, qmin, qmax);
+        for (unsigned int i=0; i<count; i++) {
+            if (!live[i]) continue;
+            float min[3], max[3];
+            boxBounds(boxes[i], min, max);
+            bool overlap = true;
+            float dist = 0;
+            for (int j=0; j<3; j++) {
+                overlap &= min[j] <= qmax[j] && max[j] >= qmin[j];
+                float c = qsphere.GetCenter()[j];
+                float e = std::max(min[j] - c, std::max(c - max[j], 0.0f));
+                dist += e * e;
+            }
+            if (overlap) rBox.push_back(i);
+            if (dist <= qsphere.GetRadius() * qsphere.GetRadius()) rSphere.push_back(i);
+            bool visible = true;
+            for (int p=0; p<4; p++) {
+                Vector<3,float> n = planes[p]->normal;
+                Vector<3,float> c = boxes[i].GetCorner(n[0] > 0, n[1] > 0, n[2] > 0);
+                if (c * n + planes[p]->distance < 0) visible = false;
+            }
+            if (visible) rPlanes.push_back(i);
+            if (rayEntry(origin, dir, boxes[i]) >= 0) rRay.push_back(i);
+        }
+
+        // the ray hits come nearest first
+        for (unsigned int i=1; i<onRay.size(); i++)
+            if (rayEntry(origin, dir, boxes[onRay[i]]) <
+                rayEntry(origin, dir, boxes[onRay[i-1]]) - 1e-4) mismatches++;
+
+        std::sort(inBox.begin(), inBox.end());
+        std::sort(inSphere.begin(), inSphere.end());
+        std::sort(inPlanes.begin(), inPlanes.end());
+        std::sort(onRay.begin(), onRay.end());
+        if (inBox != rBox) mismatches++;
+        if (inSphere != rSphere) mismatches++;
+        if (inPlanes != rPlanes) mismatches++;
+        if (onRay != rRay) mismatches++;
+        for (int p=0; p<4; p++) delete planes[p];
+    }
+    BOOST_CHECK(mismatches == 0);
+
+    octree.Clear();
+    vector<unsigned int> result;
+    octree.Query(Sphere(Vector<3,float>(0.0f), 1000), result);
+    BOOST_CHECK(octree.Size() == 0 && result.empty() && octree.GetNumberOfNodes() == 1);
+
+    // small boxes sink deeper than big ones, and boxes outside the
+    // root cell stay in the root
+    unsigned int big = octree.Add(Box(Vector<3,float>(10.0f), Vector<3,float>(40.0f)));
+    unsigned int small = octree.Add(Box(Vector<3,float>(10.0f), Vector<3,float>(0.5f)));
+    unsigned int outside = octree.Add(Box(Vector<3,float>(500.0f), Vector<3,float>(0.5f)));
+    BOOST_CHECK(octree.GetDepth(big) == 1);
+    BOOST_CHECK(octree.GetDepth(small) == 6);
+    BOOST_CHECK(octree.GetDepth(outside) == 0);
+    octree.Update(small, Box(Vector<3,float>(10.0f), Vector<3,float>(40.0f)));
+    BOOST_CHECK(octree.GetDepth(small) == 1);
+}
+
+void OpenEngine::Tests::benchLooseOctree() {
+    using namespace OpenEngine::Logging;
+    using OpenEngine::Utils::Timer;
+
+    for (unsigned int count=10000; count<=1000000; count*=10) {
+        // objects of one to five units scattered in a cube so that
+        // a query volume holds about the same number at every size
+        float range = 100 * pow(count / 10000.0f, 1 / 3.0f);
+        srand(7);
+        LooseOctree octree(Vector<3,float>(0.0f), range);
+        vector<Box> boxes;
+        boxes.reserve(count);
+        for (unsigned int i=0; i<count; i++)
+            boxes.push_back(randomBox(range, 2.5f));
+        double start = Timer::GetTime();
+        for (unsigned int i=0; i<count; i++)
+            octree.Add(boxes[i]);
+        double tadd = Timer::GetTime() - start;
+
+        // a tenth of the objects move a little each frame
+        const unsigned int moves = count / 10;
+        vector<Box> moved;
+        moved.reserve(moves);
+        for (unsigned int i=0; i<moves; i++)
+            moved.push_back(Box(boxes[i * 10].GetCenter() + randomBox(1, 0).GetCenter(),
+                                boxes[i * 10].GetCorner()));
+        start = Timer::GetTime();
+        for (unsigned int i=0; i<moves; i++)
+            octree.Update(i * 10, moved[i]);
+        double tupdate = Timer::GetTime() - start;
+
+        const int queries = 10000;
+        vector<unsigned int> result;
+        unsigned int found = 0;
+        start = Timer::GetTime();
+        for (int i=0; i<queries; i++) {
+            result.clear();
+            octree.Query(Sphere(boxes[i].GetCenter(), 40), result);
+            found += result.size();
+        }
+        double tsphere = Timer::GetTime() - start;
+        start = Timer::GetTime();
+        for (int i=0; i<queries; i++) {
+            result.clear();
+            octree.Query(Box(boxes[i].GetCenter(), Vector<3,float>(15.0f)), result);
+        }
+        double tbox = Timer::GetTime() - start;
+        start = Timer::GetTime();
+        for (int i=0; i<queries; i++) {
+            result.clear();
+            octree.Query(boxes[i].GetCenter(), randomBox(1, 0).GetCenter(), result, 100);
+        }
+        double tray = Timer::GetTime() - start;
+
+        // a view frustum of 60 degrees looking down the z axis
+        Plane* planes[6];
+        planes[0] = new Plane(Vector<3,float>(0,0,1), 0);
+        planes[1] = new Plane(Vector<3,float>(0,0,-1), 100);
+        planes[2] = new Plane(Vector<3,float>(0.866f,0,0.5f), 0);
+        planes[3] = new Plane(Vector<3,float>(-0.866f,0,0.5f), 0);
+        planes[4] = new Plane(Vector<3,float>(0,0.866f,0.5f), 0);
+        planes[5] = new Plane(Vector<3,float>(0,-0.866f,0.5f), 0);
+        const int frusta = 100;
+        start = Timer::GetTime();
+        for (int i=0; i<frusta; i++) {
+            result.clear();
+            octree.Query(planes, 6, result);
+        }
+        double tfrustum = Timer::GetTime() - start;
+        for (int p=0; p<6; p++) delete planes[p];
+
+        logger.info << "loose octree of " << count << " objects, "
+                    << octree.GetNumberOfNodes() << " nodes: add "
+                    << tadd * 1000000 / count << " ns/object, update "
+                    << tupdate * 1000000 / moves << " ns/object" << logger.end;
+        logger.info << "  sphere " << tsphere * 1000 / queries << " us ("
+                    << found / queries << " found), box " << tbox * 1000 / queries
+                    << " us, ray " << tray * 1000 / queries << " us, frustum "
+                    << tfrustum * 1000 / frusta << " us (" << result.size()
+                    << " found)" << logger.end;
+    }
+}
+
+void OpenEngine::Tests::testSphere() {
+    Sphere s(Vector<3,float>(1,2,3), 4);
+    BOOST_CHECK(s.Intersects(Vector<3,float>(1,2,3)));
+    BOOST_CHECK(s.Intersects(Vector<3,float>(3,2,3)));
+    BOOST_CHECK(!s.Intersects(Vector<3,float>(3.1f,2,3)));
+
+    // segments pass by, end before or run through the sphere
+    BOOST_CHECK(s.Intersects(Line(Vector<3,float>(-5,3,3), Vector<3,float>(5,3,3))));
+    BOOST_CHECK(!s.Intersects(Line(Vector<3,float>(-5,4.5f,3), Vector<3,float>(5,4.5f,3))));
+    BOOST_CHECK(!s.Intersects(Line(Vector<3,float>(-5,2,3), Vector<3,float>(-2,2,3))));
+    BOOST_CHECK(s.Intersects(Line(Vector<3,float>(1,2,3), Vector<3,float>(1,2,3))));
+
+    BOOST_CHECK(s.Intersects(Plane(Vector<3,float>(0,1,0), -3.5f)));
+    BOOST_CHECK(!s.Intersects(Plane(Vector<3,float>(0,1,0), -4.5f)));
+    BOOST_CHECK(!s.Intersects(Plane(Vector<3,float>(0,-1,0), -0.5f)));
+
+    // corners of a box are farther than its faces
+    BOOST_CHECK(s.Intersects(Box(Vector<3,float>(4,2,3), Vector<3,float>(1.5f,1,1))));
+    BOOST_CHECK(!s.Intersects(Box(Vector<3,float>(4,5,3), Vector<3,float>(1.5f,1.5f,1))));
+    BOOST_CHECK(s.Intersects(Box(Vector<3,float>(1,2,3), Vector<3,float>(10,10,10))));
+
+    // outside only when entirely behind one plane
+    Plane* planes[2] = { new Plane(Vector<3,float>(1,0,0), 0),
+                         new Plane(Vector<3,float>(0,0,-1), 10) };
+    BOOST_CHECK(s.Intersects(planes, 2));
+    s.SetCenter(Vector<3,float>(-1.9f,0,0));
+    BOOST_CHECK(s.Intersects(planes, 2));
+    s.SetCenter(Vector<3,float>(-2.1f,0,0));
+    BOOST_CHECK(!s.Intersects(planes, 2));
+    s.SetCenter(Vector<3,float>(0,0,12.1f));
+    BOOST_CHECK(!s.Intersects(planes, 2));
+
+    // the bounding sphere holds all points and is not much larger
+    // than the smallest one
+    srand(5);
+    vector<Vector<3,float> > points;
+    for (int i=0; i<1000; i++) {
+        Vector<3,float> p(2.0f * rand() / RAND_MAX - 1, 2.0f * rand() / RAND_MAX - 1,
+                          2.0f * rand() / RAND_MAX - 1);
+        if (p * p > 1) continue;
+        points.push_back(p * 10 + Vector<3,float>(5,0,-5));
+    }
+    Sphere bound(points);
+    unsigned int outside = 0;
+    for (unsigned int i=0; i<points.size(); i++) {
+        Vector<3,float> d = points[i] - bound.GetCenter();
+        if (d.GetLength() > bound.GetRadius() * 1.0001f) outside++;
+    }
+    BOOST_CHECK(outside == 0);
+    BOOST_CHECK(bound.GetRadius() >= 9.5f && bound.GetRadius() < 11);
+
+    // the sphere of a face set holds its vertices
+    FaceSet* faces = createGrid(10);
+    Sphere grid(*faces);
+    Vector<3,float> min(0,0,0), max(10,0,10);
+    BOOST_CHECK(grid.Intersects(min * 0.999f + grid.GetCenter() * 0.001f));
+    BOOST_CHECK(grid.Intersects(max * 0.999f + grid.GetCenter() * 0.001f));
+    BOOST_CHECK(grid.GetRadius() < (max - min).GetLength() * 0.505f);
+    delete faces;
+    BOOST_CHECK(Sphere(vector<Vector<3,float> >()).GetRadius() == 0);
+
+    // the vectorized and scalar masks are identical and agree with
+    // the single sphere test
+    SphereArray spheres;
+    vector<Sphere> list;
+    for (int i=0; i<999; i++) {
+        Vector<3,float> c;
+        for (int j=0; j<3; j++) c[j] = (rand() % 400 - 200) / 10.0f;
+        list.push_back(Sphere(c, (rand() % 50) / 5.0f));
+        spheres.Add(list.back());
+    }
+    Plane* cull[10];
+    for (int p=0; p<10; p++) {
+        Vector<3,float> n(2.0f * rand() / RAND_MAX - 1, 2.0f * rand() / RAND_MAX - 1,
+                          2.0f * rand() / RAND_MAX - 1);
+        n.Normalize();
+        cull[p] = new Plane(n, (rand() % 200 - 50) / 10.0f);
+    }
+    unsigned int mismatches = 0;
+    for (unsigned int count=0; count<=10; count++) {
+        vector<unsigned int> fast, slow;
+        spheres.Cull(cull, count, fast);
+        spheres.CullScalar(cull, count, slow);
+        if (fast != slow) mismatches++;
+        for (unsigned int i=0; i<list.size(); i++)
+            if (list[i].Intersects(cull, count) != SphereArray::IsSet(fast, i))
+                mismatches++;
+    }
+    BOOST_CHECK(mismatches == 0);
+    spheres.Clear();
+    BOOST_CHECK(spheres.Size() == 0);
+    for (int p=0; p<10; p++) delete cull[p];
+    for (int p=0; p<2; p++) delete planes[p];
+}
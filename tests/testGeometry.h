@@ -2,5 +2,17 @@ namespace OpenEngine {
     namespace Tests {
         void testFaceSet();
         void testLine();
+        void testMesh();
+        void benchMesh();
+        void testBoxArray();
+        void testBVH();
+        void benchBVH();
+        void testBSPTree();
+        void benchBSPTree();
+        void testFaceSplit();
+        void benchFaceSplit();
+        void testLooseOctree();
+        void benchLooseOctree();
+        void testSphere();
     }
 }
@@ -16,10 +16,18 @@
 #include <Math/Vector.h>
 #include <Math/Matrix.h>
 #include <Math/Quaternion.h>
+#include <Math/Transform.h>
+#include <Logging/Logger.h>
+#include <Utils/Timer.h>
 
 #include <iostream>
+#include <vector>
+#include <cstdlib>
+#include <cstring>
+#include <new>
 
 using namespace OpenEngine::Math;
+using OpenEngine::Utils::Timer;
 
 void OpenEngine::Tests::testVector() {
     // zero vector
@@ -266,3 +274,132 @@ void OpenEngine::Tests::testQuaternion() {
     //Quaternion<float> qt = q1*q2;
     //std::cout << qt.ToString() << std::endl;
 }
+
+// random float in [-10, 10] with a few fraction bits
+static float randomFloat() {
+    return (rand() % 2001 - 1000) / 100.0f;
+}
+
+void OpenEngine::Tests::testMathKernels() {
+    srand(3);
+    // the specialized kernels give the results of the generic loops
+    for (int k=0; k<100; k++) {
+        float a[4], b[4], r[4], g[4];
+        for (int i=0; i<4; i++) { a[i] = randomFloat(); b[i] = randomFloat(); }
+        Vector<4,float> u(a), v(b);
+        (u + v).ToArray(r);
+        GenericVectorKernel<4,float>::Add(a, b, g);
+        BOOST_CHECK( r[0]==g[0] && r[1]==g[1] && r[2]==g[2] && r[3]==g[3] );
+        (u - v).ToArray(r);
+        GenericVectorKernel<4,float>::Sub(a, b, g);
+        BOOST_CHECK( r[0]==g[0] && r[1]==g[1] && r[2]==g[2] && r[3]==g[3] );
+        (u * b[0]).ToArray(r);
+        GenericVectorKernel<4,float>::Scale(a, b[0], g);
+        BOOST_CHECK( r[0]==g[0] && r[1]==g[1] && r[2]==g[2] && r[3]==g[3] );
+        BOOST_CHECK( (u * v == GenericVectorKernel<4,float>::Dot(a, b)) );
+        u += v;
+        BOOST_CHECK( (u == Vector<4,float>(a) + v) );
+
+        float ma[16], mb[16], mr[16];
+        for (int i=0; i<16; i++) { ma[i] = randomFloat(); mb[i] = randomFloat(); }
+        Matrix<4,4,float> m(ma), n(mb);
+        Matrix<4,4,float> p = m * n;
+        float ga[4][4], gb[4][4], gr[4][4];
+        m.ToArray(&ga[0][0]);
+        n.ToArray(&gb[0][0]);
+        GenericMatrixKernel<4,4,float>::Multiply(ga, gb, gr);
+        p.ToArray(mr);
+        bool same = true;
+        for (int i=0; i<16; i++) same = same && mr[i] == gr[i/4][i%4];
+        BOOST_CHECK( same );
+    }
+    // the kernels need no alignment
+    float unaligned[9];
+    Vector<4,float>* v4 = new (&unaligned[1]) Vector<4,float>(1, 2, 3, 4);
+    BOOST_CHECK( (*v4 + *v4 == Vector<4,float>(2, 4, 6, 8)) );
+    BOOST_CHECK( *v4 * *v4 == 30 );
+
+    // batch transformation of points, also in place
+    float ma[16];
+    for (int i=0; i<16; i++) ma[i] = randomFloat();
+    Matrix<4,4,float> m(ma);
+    std::vector< Vector<3,float> > in(37), out(37);
+    for (unsigned int i=0; i<in.size(); i++)
+        in[i] = Vector<3,float>(randomFloat(), randomFloat(), randomFloat());
+    TransformPoints(m, &in[0], &out[0], in.size());
+    bool same = true;
+    for (unsigned int i=0; i<in.size(); i++)
+        for (int j=0; j<3; j++) {
+            float s = in[i][0] * m(0,j);
+            s += in[i][1] * m(1,j);
+            s += in[i][2] * m(2,j);
+            same = same && out[i][j] == s + m(3,j);
+        }
+    BOOST_CHECK( same );
+    TransformPoints(m, &in[0], &in[0], in.size());
+    BOOST_CHECK( in == out );
+}
+
+// matrix elements for the generic kernel
+struct RawMatrix {
+    float e[4][4];
+};
+
+void OpenEngine::Tests::benchMathKernels() {
+    using namespace OpenEngine::Logging;
+    srand(5);
+    const int n = 1000, rounds = 1000;
+    std::vector< Matrix<4,4,float> > ms(n);
+    for (int k=0; k<n; k++)
+        for (int i=0; i<4; i++)
+            for (int j=0; j<4; j++)
+                ms[k](i,j) = randomFloat() / 10;
+
+    // matrix products, generic loops against the kernel
+    std::vector<RawMatrix> raw(n);
+    for (int k=0; k<n; k++)
+        ms[k].ToArray(&raw[k].e[0][0]);
+    float r[4][4], gsum = 0;
+    double start = Timer::GetTime();
+    for (int t=0; t<rounds; t++)
+        for (int k=0; k+1<n; k++) {
+            GenericMatrixKernel<4,4,float>::Multiply(raw[k].e, raw[k+1].e, r);
+            gsum += r[3][3];
+        }
+    double generic = Timer::GetTime() - start;
+
+    float ksum = 0;
+    start = Timer::GetTime();
+    for (int t=0; t<rounds; t++)
+        for (int k=0; k+1<n; k++) {
+            Matrix<4,4,float> p = ms[k] * ms[k+1];
+            ksum += p(3,3);
+        }
+    double kernel = Timer::GetTime() - start;
+    BOOST_CHECK( gsum == ksum );
+    logger.info << (n - 1) * rounds << " matrix products: generic " << generic
+                << " ms, kernel " << kernel << " ms" << logger.end;
+
+    // point transformation, one at a time against the batch
+    std::vector< Vector<3,float> > in(n * 100), out(n * 100);
+    for (unsigned int i=0; i<in.size(); i++)
+        in[i] = Vector<3,float>(randomFloat(), randomFloat(), randomFloat());
+    Matrix<4,4,float> m = ms[1];
+    Vector<3,float> rows[4];
+    for (int i=0; i<4; i++)
+        rows[i] = Vector<3,float>(m(i,0), m(i,1), m(i,2));
+    start = Timer::GetTime();
+    for (int t=0; t<10; t++)
+        for (unsigned int i=0; i<in.size(); i++) {
+            const Vector<3,float>& p = in[i];
+            out[i] = rows[0] * p.Get(0) + rows[1] * p.Get(1) +
+                     rows[2] * p.Get(2) + rows[3];
+        }
+    double single = Timer::GetTime() - start;
+    start = Timer::GetTime();
+    for (int t=0; t<10; t++)
+        TransformPoints(m, &in[0], &out[0], in.size());
+    double batch = Timer::GetTime() - start;
+    logger.info << in.size() * 10 << " point transformations: per point "
+                << single << " ms, batch " << batch << " ms" << logger.end;
+}
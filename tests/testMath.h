@@ -3,5 +3,7 @@ namespace OpenEngine {
         void testVector();
         void testMatrix();
         void testQuaternion();
+        void testMathKernels();
+        void benchMathKernels();
     }
 }
@@ -15,13 +15,26 @@
 #include <Core/IModule.h>
 #include <Resources/IModelResource.h>
 #include <Resources/ResourceManager.h>
+#include <Resources/OBJResource.h>
+#include <Resources/TGAResource.h>
+#include <Resources/MeshCache.h>
+#include <Resources/OBJParser.h>
+#include <Utils/Timer.h>
 #include <Geometry/FaceSet.h>
+#include <Scene/GeometryNode.h>
 #include "GameTestFactory.h"
 #include <Logging/Logger.h>
 
 // include display system
 #include <Display/IFrame.h>
 
+#include <boost/filesystem/operations.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/bind.hpp>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+
 
 namespace OpenEngine {
 namespace Tests {
@@ -33,6 +46,12 @@ using namespace OpenEngine::Resources;
 using OpenEngine::Geometry::FaceSet;
 using OpenEngine::Geometry::FaceList;
 using OpenEngine::Geometry::FacePtr;
+using OpenEngine::Geometry::MeshPtr;
+using OpenEngine::Scene::GeometryNode;
+using OpenEngine::Scene::ISceneNode;
+using OpenEngine::Math::Vector;
+using OpenEngine::Utils::Timer;
+namespace fs = boost::filesystem;
 
 float faceArray[] = {
     -0.5, -0.5, 0.5, 0.5, -0.5, 0.5, -0.5, 0.5, 0.5,
@@ -121,7 +140,7 @@ void testOBJModelResource() {
 
         void Process(const float dt, const float p) {
             // Set the path to our resources
-            ResourceManager::SetPath("tests/");
+            ResourceManager::AppendPath("tests/");
 
             // Pointer to model resource.
             IModelResourcePtr mod_res;
@@ -208,5 +227,456 @@ void testOBJModelResource() {
 
 }
 
+// compare two face sets face by face
+static bool equalFaceSets(FaceSet* a, FaceSet* b) {
+    if (a->Size() != b->Size()) return false;
+    FaceList::iterator i = a->begin(), j = b->begin();
+    for (; i != a->end(); i++, j++) {
+        for (int k=0; k<3; k++)
+            if (!((*i)->vert[k] == (*j)->vert[k] &&
+                  (*i)->norm[k] == (*j)->norm[k] &&
+                  (*i)->texc[k] == (*j)->texc[k]))
+                return false;
+        if ((*i)->texr != (*j)->texr || (*i)->shad != (*j)->shad)
+            return false;
+    }
+    return true;
+}
+
+static void copyFile(string from, string to) {
+    ifstream in(from.c_str(), ios::binary);
+    ofstream out(to.c_str(), ios::binary);
+    out << in.rdbuf();
+}
+
+static void writeMeshCache(string obj, const MeshData* mesh, int* written) {
+    for (int i=0; i<20; i++)
+        if (MeshCache::Write(obj, *mesh)) (*written)++;
+}
+
+// count the temporary cache files left next to a cache file
+static unsigned int countTemporaries(string cache) {
+    fs::path dir = fs::path(cache).parent_path();
+    string prefix = fs::path(cache).filename().string() + ".";
+    unsigned int count = 0;
+    for (fs::directory_iterator itr(dir); itr != fs::directory_iterator(); ++itr) {
+        string name = itr->path().filename().string();
+        if (name.compare(0, prefix.size(), prefix) == 0) count++;
+    }
+    return count;
+}
+
+void testOBJMeshCache() {
+    ResourceManager::AddTexturePlugin(new TGAPlugin());
+    // use a copy of the box, so we can change its time stamp
+    string obj = "tests/box_cache.obj";
+    string cache = MeshCache::GetCacheFile(obj);
+    copyFile("tests/box.obj", obj);
+    if (fs::exists(cache)) fs::remove(cache);
+
+    // the first load parses the file and writes the cache
+    OBJResource cold(obj);
+    cold.Load();
+    BOOST_CHECK(fs::exists(cache));
+
+    // the face set is only built when asked for
+    BOOST_REQUIRE(cold.GetMesh());
+    unsigned int meshCost = cold.GetMemoryCost();
+    BOOST_CHECK(meshCost == cold.GetMesh()->GetMemoryCost());
+    BOOST_REQUIRE(cold.GetFaceSet() != NULL);
+    BOOST_CHECK(cold.GetMemoryCost() > meshCost);
+    BOOST_CHECK(cold.GetFaceSet()->Size() == 12);
+
+    // the indexed mesh shares the corners of the box sides
+    MeshPtr indexed = cold.GetMesh();
+    BOOST_REQUIRE(indexed);
+    BOOST_CHECK(indexed->GetNumberOfTriangles() == 12);
+    BOOST_CHECK(indexed->GetNumberOfVertices() < 36);
+    BOOST_CHECK(indexed->subMeshes.size() == 2);
+
+    // the second load reads the cache
+    MeshData mesh;
+    BOOST_CHECK(MeshCache::Read(obj, mesh));
+    BOOST_CHECK(mesh.faceMaterials.size() == 12);
+    BOOST_CHECK(mesh.materials.size() == 1);
+    BOOST_CHECK(mesh.materials[0].texture == "textureFileName.tga");
+    OBJResource warm(obj);
+    warm.Load();
+    BOOST_REQUIRE(warm.GetFaceSet() != NULL);
+    BOOST_CHECK(equalFaceSets(cold.GetFaceSet(), warm.GetFaceSet()));
+
+    // concurrent loads publish one complete mesh
+    OBJResource shared(obj);
+    boost::thread_group loaders;
+    for (int t=0; t<4; t++)
+        loaders.create_thread(boost::bind(&OBJResource::Load, &shared));
+    MeshPtr first = shared.GetMesh();
+    BOOST_CHECK(!first || first->GetNumberOfTriangles() == 12);
+    loaders.join_all();
+    BOOST_REQUIRE(shared.GetMesh());
+    BOOST_CHECK(shared.GetMesh()->GetNumberOfTriangles() == 12);
+    BOOST_CHECK(!first || first == shared.GetMesh());
+
+    // concurrent writers each use their own temporary file
+    int written[4] = {0, 0, 0, 0};
+    boost::thread_group writers;
+    for (int t=0; t<4; t++)
+        writers.create_thread(boost::bind(&writeMeshCache, obj, &mesh, &written[t]));
+    writers.join_all();
+    BOOST_CHECK(written[0] + written[1] + written[2] + written[3] == 80);
+    BOOST_CHECK(countTemporaries(cache) == 0);
+    BOOST_CHECK(MeshCache::Read(obj, mesh));
+    BOOST_CHECK(mesh.faceMaterials.size() == 12);
+
+    // the cache is ignored when the source changes
+    fs::last_write_time(obj, fs::last_write_time(obj) + 10);
+    BOOST_CHECK(!MeshCache::Read(obj, mesh));
+    OBJResource changed(obj);
+    changed.Load();
+    BOOST_CHECK(equalFaceSets(cold.GetFaceSet(), changed.GetFaceSet()));
+    BOOST_CHECK(MeshCache::Read(obj, mesh));
+
+    // and when a material library changes
+    BOOST_REQUIRE(mesh.libraries.size() == 1);
+    string mtl = mesh.libraries[0];
+    std::time_t stamp = fs::last_write_time(mtl);
+    fs::last_write_time(mtl, stamp + 10);
+    BOOST_CHECK(!MeshCache::Read(obj, mesh));
+    fs::last_write_time(mtl, stamp);
+    BOOST_CHECK(MeshCache::Read(obj, mesh));
+
+    fs::remove(cache);
+    fs::remove(obj);
+    ResourceManager::Shutdown();
+}
+
+void testOBJEviction() {
+    ResourceManager::AddTexturePlugin(new TGAPlugin());
+    string obj = "tests/box_evict.obj";
+    string cache = MeshCache::GetCacheFile(obj);
+    copyFile("tests/box.obj", obj);
+
+    // a node keeps only the face set of the model
+    StringPool names;
+    ResourceCache<IModelResource> models;
+    IModelResourcePtr model(new OBJResource(obj));
+    models.Insert(names.Intern(obj), model);
+    model->Load();
+    GeometryNode* node = new GeometryNode(model->GetFaceSet());
+    model.reset();
+
+    // evicting the model leaves the face set to the node
+    models.SetBudget(1);
+    BOOST_CHECK(models.Evict() == 1);
+    FaceSet* faces = node->GetFaceSet();
+    BOOST_REQUIRE(faces != NULL);
+    BOOST_CHECK(faces->Size() == 12);
+    Vector<3,float> min, max;
+    ISceneNode::BoundsType bounds = node->GetBounds(min, max);
+    BOOST_CHECK(bounds == ISceneNode::FINITE_BOUNDS);
+    BOOST_CHECK((min == Vector<3,float>(-0.5) && max == Vector<3,float>(0.5)));
+
+    delete node;
+    delete faces;
+    if (fs::exists(cache)) fs::remove(cache);
+    fs::remove(obj);
+    ResourceManager::Shutdown();
+}
+
+// parse an obj string
+static void parseOBJ(string data, MeshData& mesh) {
+    OBJParser parser("test.obj");
+    parser.Parse(data.data(), data.data() + data.size(), mesh);
+}
+
+void testOBJParser() {
+    MeshData mesh;
+
+    // number formats, comments, crlf line endings and continuations
+    parseOBJ("# comment\r\n"
+             "v 1 -2.5 3e2 # trailing comment\r\n"
+             "v +0.125 .5 -1.5E-1\n"
+             "v 0.1 \\\n 0.2 0.3\n"
+             "vt 0.375 1.000000\n"
+             "vn 0.000000 0.000000 1.000000\n"
+             "g default\ns 1\no object\n", mesh);
+    BOOST_REQUIRE(mesh.vertices.size() == 9);
+    BOOST_CHECK(mesh.vertices[0] == 1.0f && mesh.vertices[1] == -2.5f && mesh.vertices[2] == 300.0f);
+    BOOST_CHECK(mesh.vertices[3] == 0.125f && mesh.vertices[4] == 0.5f && mesh.vertices[5] == -0.15f);
+    BOOST_CHECK(mesh.vertices[6] == 0.1f && mesh.vertices[7] == 0.2f && mesh.vertices[8] == 0.3f);
+    BOOST_CHECK(mesh.texcoords.size() == 2 && mesh.texcoords[0] == 0.375f);
+    BOOST_CHECK(mesh.normals.size() == 3 && mesh.normals[2] == 1.0f);
+
+    // floats are converted like sscanf("%f") does, the last number
+    // is rounded differently when rounded to a double first
+    string zeros(100, '0');
+    string numbers[] = { "0.1", "3.14159265358979", "-123456.789",
+                         "1e-7", "6.02214179e23", "0.30000000000000004441",
+                         "1.0000000", "16777217", "2.21713696646475e-6",
+                         "0." + zeros + "123456789e100" };
+    bool same = true;
+    for (int i=0; i<10; i++) {
+        mesh.Clear();
+        parseOBJ("vt " + numbers[i] + " 0\n", mesh);
+        same &= mesh.texcoords.size() == 2 &&
+            mesh.texcoords[0] == strtof(numbers[i].c_str(), NULL);
+    }
+    BOOST_CHECK(same);
+
+    // all face formats, negative indices and polygons
+    mesh.Clear();
+    parseOBJ("v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\nv 0 2 0\n"
+             "vt 0 0\nvt 1 0\nvt 1 1\n"
+             "vn 0 0 1\n"
+             "f 1 2 3\n"
+             "f 1/1 2/2 3/3\n"
+             "f 1//1 2//1 3//1\n"
+             "f 1/1/1 2/2/1 3/3/1\n"
+             "f -5/-3/-1 -4/-2/-1 -3/-1/-1\n"
+             "f 1 2 3 4 5\n", mesh);
+    BOOST_REQUIRE(mesh.faceMaterials.size() == 8);
+    const unsigned int N = MeshData::NONE;
+    unsigned int expected[8][9] = {
+        {0,N,N, 1,N,N, 2,N,N},
+        {0,0,N, 1,1,N, 2,2,N},
+        {0,N,0, 1,N,0, 2,N,0},
+        {0,0,0, 1,1,0, 2,2,0},
+        {0,0,0, 1,1,0, 2,2,0},
+        // fan triangulation of the pentagon
+        {0,N,N, 1,N,N, 2,N,N},
+        {0,N,N, 2,N,N, 3,N,N},
+        {0,N,N, 3,N,N, 4,N,N} };
+    same = true;
+    for (int i=0; i<8; i++)
+        for (int j=0; j<9; j++)
+            same &= mesh.indices[9*i+j] == expected[i][j];
+    BOOST_CHECK(same);
+
+    // invalid faces are skipped
+    mesh.Clear();
+    parseOBJ("v 0 0 0\nv 1 0 0\nv 1 1 0\n"
+             "f 1 2\nf 1 2 4\nf 1 1 2\nf 1 2 x\nf 0 1 2\nvx 1 2\n"
+             "f 1 2 4294967299\nf 1 2 -4294967293\n", mesh);
+    BOOST_CHECK(mesh.faceMaterials.size() == 0);
+
+    // lines longer than the old 255 character limit
+    mesh.Clear();
+    std::ostringstream big;
+    int n = 200;
+    for (int i=0; i<n; i++)
+        big << "v " << cos(i * 2 * PI / n) << " " << sin(i * 2 * PI / n) << " 0\n";
+    big << "f";
+    for (int i=1; i<=n; i++) big << " " << i;
+    big << "\n";
+    BOOST_REQUIRE(big.str().size() > 255 * 2);
+    parseOBJ(big.str(), mesh);
+    BOOST_CHECK(mesh.faceMaterials.size() == (unsigned int)n - 2);
+}
+
+// are two meshes byte for byte identical
+template <class T>
+static bool sameData(const vector<T>& a, const vector<T>& b) {
+    return a.size() == b.size() &&
+        (a.empty() || memcmp(&a[0], &b[0], a.size() * sizeof(T)) == 0);
+}
+
+static bool sameMesh(const MeshData& a, const MeshData& b) {
+    bool same = sameData(a.vertices, b.vertices) &&
+        sameData(a.normals, b.normals) &&
+        sameData(a.texcoords, b.texcoords) &&
+        sameData(a.indices, b.indices) &&
+        sameData(a.faceMaterials, b.faceMaterials) &&
+        a.materials.size() == b.materials.size();
+    for (unsigned int i=0; same && i<a.materials.size(); i++)
+        same = a.materials[i].texture == b.materials[i].texture;
+    return same;
+}
+
+void testOBJParallelParser() {
+    {
+        ofstream mtl("parallel.mtl");
+        mtl << "newmtl red\nshader red.glsl\nnewmtl blue\nshader blue.glsl\n";
+        ofstream mtl2("parallel2.mtl");
+        mtl2 << "newmtl green\nshader green.glsl\n";
+    }
+
+    // blocks of declarations using all the features that depend on
+    // preceding lines: relative indices, materials and continuations
+    std::ostringstream obj;
+    obj << "mtllib parallel.mtl\n";
+    for (int i=0; i<4000; i++) {
+        obj << "# block " << i << "\n"
+            << "v " << i << " 0 0\nv " << i << " 1 0\nv " << i << ".5 1 \\\n 0\n"
+            << "v " << i << " 2.25 0\r\n"
+            << "vt 0.5 " << i * 0.001 << "\nvn 0 0 1\n";
+        if (i % 7 == 0)   obj << "usemtl red\n";
+        if (i % 11 == 0)  obj << "usemtl blue\n";
+        if (i == 2000)    obj << "mtllib parallel2.mtl\n";
+        if (i % 13 == 0 && i > 2000) obj << "usemtl green\n";
+        obj << "f -4/-1/-1 -3/-1/-1 -2/-1/-1\n"
+            << "f " << 4*i+1 << " " << 4*i+2 << " \\\n"
+            << 4*i+3 << " " << 4*i+4 << "\n"
+            << "f " << 4*i+1 << "//" << i+1 << " " << 4*i+2 << "//" << i+1
+            << " " << 4*i+4 << "//" << i+1 << "\n"
+            << "g group" << i << "\n";
+    }
+    // a few invalid lines
+    obj << "usemtl undefined\nf 1 2 99999999\nf 1 1 2\nf 1 2\n";
+    string data = obj.str();
+    BOOST_REQUIRE(data.size() > 8 * 64 * 1024);
+
+    MeshData serial;
+    OBJParser parser("parallel.obj");
+    parser.Parse(data.data(), data.data() + data.size(), serial);
+    BOOST_CHECK(serial.faceMaterials.size() == 4000 * 4);
+    BOOST_CHECK(serial.materials.size() == 3);
+
+    // any number of chunks gives the same mesh
+    const unsigned int threads[] = { 2, 3, 5, 8 };
+    for (unsigned int i=0; i<4; i++) {
+        MeshData parallel;
+        OBJParser p("parallel.obj");
+        p.SetThreads(threads[i]);
+        p.Parse(data.data(), data.data() + data.size(), parallel);
+        BOOST_CHECK(sameMesh(serial, parallel));
+    }
+    fs::remove("parallel.mtl");
+    fs::remove("parallel2.mtl");
+}
+
+// parse a model the way the sscanf based loader did, used as the
+// base line of the parser benchmark
+static unsigned int legacyParse(string file) {
+    ifstream in(file.c_str());
+    char buffer[255];
+    float f1, f2, f3;
+    unsigned int lines = 0;
+    vector<float> vert, norm, texc;
+    vector<int> faces;
+    while (!in.eof()) {
+        in.getline(buffer, 255);
+        lines++;
+        if (in.gcount() <= 2 || buffer[0] == '#') continue;
+        else if (string(buffer,2) == "v ") {
+            if (sscanf(buffer, "v %f %f %f", &f1, &f2, &f3) == 3)
+                vert.push_back(f1), vert.push_back(f2), vert.push_back(f3);
+        } else if (string(buffer,2) == "vt") {
+            if (sscanf(buffer, "vt %f %f ", &f1, &f2) == 2)
+                texc.push_back(f1), texc.push_back(f2);
+        } else if (string(buffer,2) == "vn") {
+            if (sscanf(buffer, "vn %f %f %f", &f1, &f2, &f3) == 3)
+                norm.push_back(f1), norm.push_back(f2), norm.push_back(f3);
+        } else if (string(buffer,2) == "f ") {
+            int f[9];
+            char s1[255],s2[255],s3[255],s4[255];
+            if (sscanf(buffer, "f %s %s %s %s", s1,s2,s3,s4) == 3 &&
+                (sscanf(buffer, "f %d/%d/%d %d/%d/%d %d/%d/%d", &f[0],&f[1],&f[2],&f[3],&f[4],&f[5],&f[6],&f[7],&f[8]) == 9
+                 || sscanf(buffer, "f %d//%d %d//%d %d//%d", &f[0],&f[2],&f[3],&f[5],&f[6],&f[8]) == 6
+                 || sscanf(buffer, "f %d %d %d", &f[0],&f[3],&f[6]) == 3))
+                faces.insert(faces.end(), f, f+9);
+        }
+    }
+    return lines;
+}
+
+// write a grid model of about the given number of triangles
+static void writeGridModel(string file, unsigned int triangles) {
+    unsigned int n = 2;
+    while (2*(n-1)*(n-1) < triangles) n++;
+    ofstream out(file.c_str());
+    out << "# generated grid model" << endl;
+    for (unsigned int y=0; y<n; y++)
+        for (unsigned int x=0; x<n; x++)
+            out << "v " << x << " " << (x*y % 7) * 0.25 << " " << y << endl;
+    for (unsigned int y=0; y<n; y++)
+        for (unsigned int x=0; x<n; x++)
+            out << "vt " << x / float(n) << " " << y / float(n) << endl;
+    out << "vn 0.000000 1.000000 0.000000" << endl;
+    for (unsigned int y=0; y<n-1; y++)
+        for (unsigned int x=0; x<n-1; x++) {
+            unsigned int a = y*n + x + 1, b = a + 1, c = a + n, d = c + 1;
+            out << "f " << a << "/" << a << "/1 " << b << "/" << b << "/1 "
+                << c << "/" << c << "/1" << endl;
+            out << "f " << b << "/" << b << "/1 " << d << "/" << d << "/1 "
+                << c << "/" << c << "/1" << endl;
+        }
+}
+
+void benchOBJParser() {
+    string obj = "bench_parser.obj";
+    writeGridModel(obj, 1000000);
+
+    double start = Timer::GetTime();
+    unsigned int lines = legacyParse(obj);
+    double tlegacy = Timer::GetTime() - start;
+
+    start = Timer::GetTime();
+    MeshData mesh;
+    OBJParser parser(obj);
+    parser.Parse(mesh);
+    double tparser = Timer::GetTime() - start;
+
+    BOOST_CHECK(mesh.faceMaterials.size() >= 1000000);
+    logger.info << "obj parse of " << lines << " lines: sscanf "
+                << lines / tlegacy << " lines/ms, tokenizer "
+                << lines / tparser << " lines/ms" << logger.end;
+    fs::remove(obj);
+}
+
+void benchOBJParallelParser() {
+    string obj = "bench_parallel.obj";
+    writeGridModel(obj, 2000000);
+
+    MeshData serial;
+    double tserial = 0;
+    for (unsigned int threads=1; threads<=8; threads*=2) {
+        MeshData mesh;
+        OBJParser parser(obj);
+        parser.SetThreads(threads);
+        double start = Timer::GetTime();
+        parser.Parse(mesh);
+        double time = Timer::GetTime() - start;
+        if (threads == 1) {
+            tserial = time;
+            serial = mesh;
+        } else
+            BOOST_CHECK(sameMesh(serial, mesh));
+        logger.info << "obj parse of " << mesh.faceMaterials.size()
+                    << " triangles on " << threads << " threads: " << time
+                    << " ms, speedup " << tserial / time << logger.end;
+    }
+    fs::remove(obj);
+}
+
+void benchOBJMeshCache() {
+    string obj = "bench_mesh.obj";
+    string cache = MeshCache::GetCacheFile(obj);
+    writeGridModel(obj, 1000000);
+    if (fs::exists(cache)) fs::remove(cache);
+
+    double start = Timer::GetTime();
+    OBJResource cold(obj);
+    cold.Load();
+    double tcold = Timer::GetTime() - start;
+    FaceSet* coldFaces = cold.GetFaceSet();
+    int faces = coldFaces->Size();
+    cold.Unload();
+    delete coldFaces;
+
+    start = Timer::GetTime();
+    OBJResource warm(obj);
+    warm.Load();
+    double twarm = Timer::GetTime() - start;
+    FaceSet* warmFaces = warm.GetFaceSet();
+    BOOST_CHECK(warmFaces->Size() == faces);
+    warm.Unload();
+    delete warmFaces;
+
+    logger.info << "obj load of " << faces << " triangles: cold " << tcold
+                << " ms, warm " << twarm << " ms" << logger.end;
+    fs::remove(cache);
+    fs::remove(obj);
+}
+
 } // NS Tests
 } // NS OpenEngine
@@ -5,5 +5,12 @@
 namespace OpenEngine {
     namespace Tests {
         void testOBJModelResource();
+        void testOBJMeshCache();
+        void testOBJEviction();
+        void testOBJParser();
+        void benchOBJParser();
+        void testOBJParallelParser();
+        void benchOBJParallelParser();
+        void benchOBJMeshCache();
     }
 }
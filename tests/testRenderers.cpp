@@ -0,0 +1,424 @@
+// Test the renderer support classes.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS) 
+// 
+// This program is free software; It is covered by the GNU General 
+// Public License version 2 or any later version. 
+// See the GNU General Public License for more details (see LICENSE). 
+//--------------------------------------------------------------------
+
+// include boost unit test framework
+#include <boost/test/unit_test.hpp>
+
+#include "testRenderers.h"
+
+#include <Renderers/VertexBatch.h>
+#include <Renderers/RenderQueue.h>
+#include <Renderers/NullRenderer.h>
+#include <Renderers/RecordingRenderingView.h>
+#include <Renderers/IRenderNode.h>
+#include <Scene/SceneNode.h>
+#include <Scene/GeometryNode.h>
+#include <Scene/TransformationNode.h>
+#include <Display/Viewport.h>
+#include <Display/ViewingVolume.h>
+#include <Display/Frustum.h>
+#include <Core/GameEngine.h>
+#include <Logging/Logger.h>
+#include <Utils/Timer.h>
+#include <Geometry/FaceSet.h>
+#include <Resources/ITextureResource.h>
+#include <new>
+
+namespace OpenEngine {
+namespace Tests {
+
+using namespace OpenEngine::Renderers;
+using namespace OpenEngine::Geometry;
+using namespace OpenEngine::Resources;
+using namespace OpenEngine::Scene;
+using OpenEngine::Display::Viewport;
+using OpenEngine::Display::ViewingVolume;
+using OpenEngine::Display::Frustum;
+
+// texture resource without data, only used as a material identity
+class FakeTexture : public ITextureResource {
+    int id;
+public:
+    FakeTexture(int id) : id(id) {}
+    void Load() {}
+    void Unload() {}
+    int GetID() { return id; }
+    void SetID(int id) { this->id = id; }
+    int GetWidth() { return 0; }
+    int GetHeight() { return 0; }
+    int GetDepth() { return 0; }
+    unsigned char* GetData() { return NULL; }
+};
+
+// add a unit quad at height y as two faces
+static void addQuad(FaceSet& faces, float y, ITextureResourcePtr texr) {
+    Vector<3,float> p[4] = { Vector<3,float>(0,y,0), Vector<3,float>(1,y,0),
+                             Vector<3,float>(0,y,1), Vector<3,float>(1,y,1) };
+    Vector<3,float> up(0,1,0);
+    FacePtr a(new Face(p[0], p[2], p[1], up, up, up));
+    FacePtr b(new Face(p[1], p[2], p[3], up, up, up));
+    a->texr = b->texr = texr;
+    faces.Add(a);
+    faces.Add(b);
+}
+
+void testVertexBatch() {
+    ITextureResourcePtr t1(new FakeTexture(1));
+    ITextureResourcePtr t2(new FakeTexture(2));
+    FaceSet faces;
+    addQuad(faces, 0, t1);
+    addQuad(faces, 1, t1);
+    addQuad(faces, 2, t2);
+    addQuad(faces, 3, ITextureResourcePtr());
+    faces.Add(FacePtr(new Face(**faces.begin())));
+
+    VertexBatch batch;
+    batch.Build(faces);
+    BOOST_CHECK(batch.GetNumberOfTriangles() == 9);
+    BOOST_CHECK(batch.indices.size() == 27);
+    // the corners shared by the faces of a quad are welded
+    BOOST_CHECK(batch.GetNumberOfVertices() < 27);
+    BOOST_CHECK(batch.vertices.size() == batch.GetNumberOfVertices() * VertexBatch::STRIDE);
+
+    // material runs follow the face order
+    BOOST_REQUIRE(batch.runs.size() == 4);
+    BOOST_CHECK(batch.runs[0].first == 0  && batch.runs[0].count == 12 && batch.runs[0].texr == t1);
+    BOOST_CHECK(batch.runs[1].first == 12 && batch.runs[1].count == 6  && batch.runs[1].texr == t2);
+    BOOST_CHECK(batch.runs[2].first == 18 && batch.runs[2].count == 6  && batch.runs[2].texr == NULL);
+    BOOST_CHECK(batch.runs[3].first == 24 && batch.runs[3].count == 3  && batch.runs[3].texr == t1);
+
+    // the interleaved attributes match the faces
+    bool same = true;
+    unsigned int i = 0;
+    for (FaceList::iterator itr = faces.begin(); itr != faces.end(); itr++) {
+        for (int j=0; j<3; j++, i++) {
+            const float* v = &batch.vertices[batch.indices[i] * VertexBatch::STRIDE];
+            same &= Vector<3,float>(v + VertexBatch::POSITION) == (*itr)->vert[j];
+            same &= Vector<3,float>(v + VertexBatch::NORMAL)   == (*itr)->norm[j];
+            same &= Vector<2,float>(v + VertexBatch::TEXCOORD) == (*itr)->texc[j];
+            same &= Vector<4,float>(v + VertexBatch::COLOR)    == (*itr)->colr[j];
+        }
+    }
+    BOOST_CHECK(same);
+
+    batch.Clear();
+    BOOST_CHECK(batch.GetNumberOfVertices() == 0 && batch.runs.empty());
+}
+
+void testRenderQueue() {
+    // keys order on shader, texture, depth and transformation
+    BOOST_CHECK(RenderQueue::MakeKey(1,0,0,0) > RenderQueue::MakeKey(0,0xFFFF,0xFFFF,0xFFFF));
+    BOOST_CHECK(RenderQueue::MakeKey(0,1,0,0) > RenderQueue::MakeKey(0,0,0xFFFF,0xFFFF));
+    BOOST_CHECK(RenderQueue::MakeKey(0,0,1,0) > RenderQueue::MakeKey(0,0,0,0xFFFF));
+    BOOST_CHECK(RenderQueue::MakeKey(0,0,0,70000) == RenderQueue::MakeKey(0,0,0,0xFFFF));
+
+    RenderQueue queue;
+    queue.SetDepthRange(0, 100);
+    BOOST_CHECK(queue.GetDepthBucket(-5) == 0);
+    BOOST_CHECK(queue.GetDepthBucket(10) < queue.GetDepthBucket(20));
+    BOOST_CHECK(queue.GetDepthBucket(500) == 0xFFFF);
+
+    // interleave the materials of a number of objects
+    ITextureResourcePtr t1(new FakeTexture(1));
+    ITextureResourcePtr t2(new FakeTexture(2));
+    int geometry[8];
+    for (int i=0; i<8; i++) {
+        unsigned int m = queue.AddTransform(Matrix<4,4,float>());
+        queue.Add(IShaderResourcePtr(), t1, 80 - i, m, &geometry[i], 0, 6);
+        queue.Add(IShaderResourcePtr(), t2, 80 - i, m, &geometry[i], 6, 3);
+    }
+    BOOST_CHECK(queue.Size() == 16);
+    RenderStatistics before = queue.CountStateChanges();
+    BOOST_CHECK(before.drawCalls == 16 && before.triangles == 8 * 3);
+    BOOST_CHECK(before.textureChanges == 16);
+
+    queue.Sort();
+    RenderStatistics after = queue.CountStateChanges();
+    BOOST_CHECK(after.drawCalls == before.drawCalls);
+    BOOST_CHECK(after.triangles == before.triangles);
+    BOOST_CHECK(after.textureChanges == 2);
+    BOOST_CHECK(after.textureChanges < before.textureChanges);
+
+    // items of a texture are drawn front to back
+    const vector<RenderItem>& items = queue.GetItems();
+    bool ordered = true;
+    for (unsigned int i=1; i<items.size(); i++) {
+        ordered &= items[i-1].key <= items[i].key;
+        if (items[i-1].texr == items[i].texr)
+            ordered &= items[i-1].depth <= items[i].depth;
+    }
+    BOOST_CHECK(ordered);
+    BOOST_CHECK(items[0].texr == t1 && items[0].geometry == &geometry[7]);
+
+    // equal keys keep their insertion order
+    queue.Clear();
+    BOOST_CHECK(queue.Size() == 0);
+    for (int i=0; i<8; i++)
+        queue.Add(IShaderResourcePtr(), t1, 50, 0, &geometry[i], 0, 3);
+    queue.Sort();
+    bool stable = true;
+    for (int i=0; i<8; i++)
+        stable &= queue.GetItems()[i].geometry == &geometry[i];
+    BOOST_CHECK(stable);
+}
+
+// scene of objects in a row along the negative z-axis, each made of
+// a quad with each of the two textures
+class RowScene {
+public:
+    SceneNode root;
+    vector<ISceneNode*> nodes;
+    vector<FaceSet*> faces;
+    ITextureResourcePtr t1, t2;
+
+    RowScene(int n) : t1(new FakeTexture(1)), t2(new FakeTexture(2)) {
+        for (int i=0; i<n; i++) {
+            FaceSet* fs = new FaceSet();
+            addQuad(*fs, 0, t1);
+            addQuad(*fs, 1, t2);
+            TransformationNode* t = new TransformationNode();
+            t->Move(0, 0, -20 - i);
+            GeometryNode* g = new GeometryNode(fs);
+            t->AddNode(g);
+            root.AddNode(t);
+            faces.push_back(fs);
+            nodes.push_back(t);
+            nodes.push_back(g);
+        }
+    }
+    ~RowScene() {
+        for (unsigned int i=0; i<nodes.size(); i++) delete nodes[i];
+        for (unsigned int i=0; i<faces.size(); i++) delete faces[i];
+    }
+};
+
+void testRecordingRenderingView() {
+    // modules unregister from the engine on destruction
+    OpenEngine::Core::GameEngine::Instance();
+    const unsigned int n = 10;
+    RowScene scene(n);
+    Viewport viewport(0, 0, 100, 100);
+    RecordingRenderingView* view = new RecordingRenderingView(viewport);
+    NullRenderer renderer;
+    renderer.SetSceneRoot(&scene.root);
+    renderer.AddRenderingView(view);
+    renderer.Initialize();
+
+    // batched, one draw per material run grouped by texture
+    renderer.Process(0, 0);
+    BOOST_CHECK(renderer.GetNumberOfFrames() == 1);
+    RenderStatistics s = view->GetStatistics();
+    BOOST_CHECK(s.drawCalls == 2 * n);
+    BOOST_CHECK(s.triangles == 4 * n);
+    BOOST_CHECK(s.textureChanges == 2);
+    BOOST_CHECK(s.shaderChanges == 0);
+    BOOST_CHECK(s.transformChanges == 2 * n);
+    BOOST_CHECK(s.stateChanges == 0);
+    BOOST_CHECK(view->GetQueue().Size() == 2 * n);
+    // nearest object first
+    BOOST_CHECK(view->GetQueue().GetItems()[0].transform == 0);
+    BOOST_CHECK(view->GetQueue().GetItems()[0].texr == scene.t1);
+
+    // recording is deterministic across frames
+    renderer.Process(0, 0);
+    RenderStatistics again = view->GetStatistics();
+    BOOST_CHECK(again.drawCalls == s.drawCalls && again.textureChanges == s.textureChanges &&
+                again.transformChanges == s.transformChanges);
+
+    // immediate mode, one draw per face
+    view->SetBatching(false);
+    renderer.Process(0, 0);
+    s = view->GetStatistics();
+    BOOST_CHECK(s.drawCalls == 4 * n);
+    BOOST_CHECK(s.triangles == 4 * n);
+    BOOST_CHECK(s.textureChanges == 2 * n);
+    BOOST_CHECK(s.transformChanges == n);
+    BOOST_CHECK(s.stateChanges == n);
+    BOOST_CHECK(view->GetQueue().Size() == 0);
+
+    // debug lines are drawn through the renderer
+    RenderStateNode state;
+    state.AddOptions(RenderStateNode::RENDER_HARD_NORMAL);
+    state.AddNode(&scene.root);
+    renderer.SetSceneRoot(&state);
+    renderer.Process(0, 0);
+    BOOST_CHECK(renderer.GetNumberOfLines() == 4 * n);
+    BOOST_CHECK(renderer.GetNumberOfFrames() == 4);
+    renderer.Deinitialize();
+}
+
+void testRenderingViewBatches() {
+    OpenEngine::Core::GameEngine::Instance();
+    ITextureResourcePtr t1(new FakeTexture(1));
+    ITextureResourcePtr t2(new FakeTexture(2));
+    FaceSet faces;
+    addQuad(faces, 0, t1);
+    SceneNode root;
+    GeometryNode* node = new GeometryNode(&faces);
+    root.AddNode(node);
+    Viewport viewport(0, 0, 100, 100);
+    RecordingRenderingView* view = new RecordingRenderingView(viewport);
+    NullRenderer renderer;
+    renderer.SetSceneRoot(&root);
+    renderer.AddRenderingView(view);
+    renderer.Initialize();
+
+    renderer.Process(0, 0);
+    BOOST_CHECK(view->GetNumberOfBatches() == 1);
+    BOOST_REQUIRE(view->GetQueue().Size() == 1);
+    BOOST_CHECK(view->GetQueue().GetItems()[0].texr == t1);
+
+    // a new node at the address of a deleted one, with a face set at
+    // the same address and of the same size, gets a batch of its own
+    root.RemoveNode(node);
+    node->~GeometryNode();
+    faces.Empty();
+    addQuad(faces, 0, t2);
+    new (node) GeometryNode(&faces);
+    root.AddNode(node);
+    renderer.Process(0, 0);
+    BOOST_CHECK(view->GetNumberOfBatches() == 1);
+    BOOST_REQUIRE(view->GetQueue().Size() == 1);
+    BOOST_CHECK(view->GetQueue().GetItems()[0].texr == t2);
+
+    // faces changed in place are batched again once the node is told
+    for (FaceList::iterator itr = faces.begin(); itr != faces.end(); itr++)
+        (*itr)->texr = t1;
+    node->Changed();
+    renderer.Process(0, 0);
+    BOOST_CHECK(view->GetNumberOfBatches() == 1);
+    BOOST_REQUIRE(view->GetQueue().Size() == 1);
+    BOOST_CHECK(view->GetQueue().GetItems()[0].texr == t1);
+
+    // the batch of a node no longer drawn is deleted
+    root.RemoveNode(node);
+    for (unsigned int i=0; i<2*RecordingRenderingView::BATCH_LIFETIME; i++)
+        renderer.Process(0, 0);
+    BOOST_CHECK(view->GetNumberOfBatches() == 0);
+    renderer.Deinitialize();
+    delete node;
+}
+
+// render node counting how often it is applied
+class CountingRenderNode : public IRenderNode {
+public:
+    unsigned int applied;
+    CountingRenderNode() : applied(0) {}
+    void Apply(IRenderingView* view) { applied++; }
+};
+
+void testFrustumCulling() {
+    OpenEngine::Core::GameEngine::Instance();
+    const unsigned int n = 10;
+    RowScene scene(n);
+    // a second row behind the viewer
+    for (unsigned int i=0; i<n; i++) {
+        TransformationNode* t = new TransformationNode();
+        t->Move(0, 0, 20 + i);
+        GeometryNode* g = new GeometryNode(scene.faces[i]);
+        t->AddNode(g);
+        scene.root.AddNode(t);
+        scene.nodes.push_back(t);
+        scene.nodes.push_back(g);
+    }
+    // render nodes are never culled, nor are their ancestors
+    TransformationNode behind;
+    CountingRenderNode renderNode;
+    behind.Move(0, 0, 50);
+    behind.AddNode(&renderNode);
+    scene.root.AddNode(&behind);
+
+    ViewingVolume volume;
+    Frustum frustum(volume);
+    Viewport viewport(0, 0, 100, 100);
+    viewport.SetViewingVolume(&frustum);
+    RecordingRenderingView* view = new RecordingRenderingView(viewport);
+    NullRenderer renderer;
+    renderer.SetSceneRoot(&scene.root);
+    renderer.AddRenderingView(view);
+
+    // the row behind is culled one transformation node at a time
+    renderer.Process(0, 0);
+    RenderStatistics s = view->GetStatistics();
+    BOOST_CHECK(s.visibleNodes == n);
+    BOOST_CHECK(s.culledNodes == n);
+    BOOST_CHECK(s.drawCalls == 2 * n);
+    BOOST_CHECK(renderNode.applied == 1);
+
+    // the counts are the same in immediate mode
+    view->SetBatching(false);
+    renderer.Process(0, 0);
+    s = view->GetStatistics();
+    BOOST_CHECK(s.visibleNodes == n && s.culledNodes == n);
+    BOOST_CHECK(s.drawCalls == 4 * n);
+    view->SetBatching(true);
+
+    // moving the viewer brings both rows into view
+    volume.SetPosition(Vector<3,float>(0, 0, 60));
+    renderer.Process(0, 0);
+    s = view->GetStatistics();
+    BOOST_CHECK(s.visibleNodes == 2 * n && s.culledNodes == 0);
+    volume.SetPosition(Vector<3,float>(0, 0, 0));
+
+    // moving a node invalidates the bounds of its ancestors
+    TransformationNode* first = (TransformationNode*)scene.nodes[2 * n];
+    first->Move(0, 0, -100);
+    renderer.Process(0, 0);
+    s = view->GetStatistics();
+    BOOST_CHECK(s.visibleNodes == n + 1 && s.culledNodes == n - 1);
+
+    // everything is drawn with culling disabled
+    view->SetCulling(false);
+    renderer.Process(0, 0);
+    s = view->GetStatistics();
+    BOOST_CHECK(s.visibleNodes == 2 * n && s.culledNodes == 0);
+    BOOST_CHECK(renderNode.applied == 5);
+    scene.root.RemoveNode(&behind);
+}
+
+void benchSceneTraversal() {
+    using namespace OpenEngine::Logging;
+    using OpenEngine::Utils::Timer;
+
+    OpenEngine::Core::GameEngine::Instance();
+    const unsigned int n = 5000, frames = 20;
+    RowScene scene(n);
+    Viewport viewport(0, 0, 100, 100);
+    RecordingRenderingView* view = new RecordingRenderingView(viewport);
+    NullRenderer renderer;
+    renderer.SetSceneRoot(&scene.root);
+    renderer.AddRenderingView(view);
+
+    // the first frame builds the batches
+    double start = Timer::GetTime();
+    renderer.Process(0, 0);
+    double build = Timer::GetTime() - start;
+
+    start = Timer::GetTime();
+    for (unsigned int i=0; i<frames; i++)
+        renderer.Process(0, 0);
+    double batched = (Timer::GetTime() - start) / frames;
+    RenderStatistics s = view->GetStatistics();
+    BOOST_CHECK(s.drawCalls == 2 * n);
+
+    view->SetBatching(false);
+    start = Timer::GetTime();
+    for (unsigned int i=0; i<frames; i++)
+        renderer.Process(0, 0);
+    double immediate = (Timer::GetTime() - start) / frames;
+
+    logger.info << n << " objects: first frame " << build << " ms, queued frame "
+                << batched << " ms (" << s.drawCalls << " draws, "
+                << s.textureChanges << " texture changes), immediate frame "
+                << immediate << " ms (" << view->GetStatistics().drawCalls
+                << " draws)" << logger.end;
+}
+
+} // NS Tests
+} // NS OpenEngine
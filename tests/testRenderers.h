@@ -0,0 +1,10 @@
+namespace OpenEngine {
+    namespace Tests {
+        void testVertexBatch();
+        void testRenderQueue();
+        void testRecordingRenderingView();
+        void testRenderingViewBatches();
+        void testFrustumCulling();
+        void benchSceneTraversal();
+    }
+}
@@ -9,16 +9,27 @@
 
 // include boost unit test framework
 #include <boost/test/unit_test.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/bind.hpp>
 
 #include "testResources.h"
 
 // include resources lib
 #include <Resources/File.h>
+#include <Resources/ResourceManager.h>
+#include <Resources/Exceptions.h>
+#include <Utils/Convert.h>
+#include <Utils/Timer.h>
+#include <Utils/ConcurrentHashMap.h>
+#include <Utils/StringPool.h>
+#include <Logging/Logger.h>
+#include <map>
 
 namespace OpenEngine {
 namespace Tests {
 
 using namespace OpenEngine::Resources;
+using namespace OpenEngine::Utils;
 
 void testFile() {
 
@@ -37,5 +48,201 @@ void testFile() {
     BOOST_CHECK(File::Extension("")           == "");
 }
 
+// dummy model resource counting its loads
+class FakeModelResource : public IModelResource {
+public:
+    int loads;
+    bool loaded;
+    FakeModelResource() : loads(0), loaded(false) {}
+    void Load() { if (!loaded) loads++; loaded = true; }
+    void Unload() { loaded = false; }
+    unsigned int GetMemoryCost() { return loaded ? 100 : 0; }
+    FaceSet* GetFaceSet() { return NULL; }
+};
+
+class FakeModelPlugin : public IModelResourcePlugin {
+public:
+    FakeModelPlugin() { this->AddExtension("fake"); }
+    IModelResourcePtr CreateResource(string file) {
+        return IModelResourcePtr(new FakeModelResource());
+    }
+};
+
+void testAsyncResources() {
+    FakeModelPlugin plugin;
+    ResourceManager::AddModelPlugin(&plugin);
+
+    // unsupported formats fail immediately
+    BOOST_CHECK_THROW(ResourceManager::CreateModelAsync("a.unknown"), ResourceException);
+
+    IModelResourceFuturePtr f = ResourceManager::CreateModelAsync("a.fake");
+    IModelResourcePtr res = f->Get();
+    BOOST_CHECK(f->IsLoaded());
+    BOOST_CHECK(res != NULL);
+    BOOST_CHECK(((FakeModelResource*)res.get())->loads == 1);
+
+    // not available to the synchronous interface before publication
+    BOOST_CHECK(!f->IsReady());
+    BOOST_CHECK(ResourceManager::Publish() == 1);
+    BOOST_CHECK(f->IsReady());
+    BOOST_CHECK(ResourceManager::CreateModel("a.fake") == res);
+
+    // cached resources are published immediately
+    IModelResourceFuturePtr g = ResourceManager::CreateModelAsync("a.fake");
+    BOOST_CHECK(g->IsReady());
+    BOOST_CHECK(g->Get() == res);
+
+    // several loads in flight
+    IModelResourceFuturePtr h[8];
+    for (int i=0; i<8; i++)
+        h[i] = ResourceManager::CreateModelAsync("b" + Convert::ToString(i) + ".fake");
+    for (int i=0; i<8; i++)
+        h[i]->Wait();
+    BOOST_CHECK(ResourceManager::Publish() == 8);
+    for (int i=0; i<8; i++)
+        BOOST_CHECK(h[i]->IsReady());
+
+    // a resource created while loading in the background is
+    // replaced by the loaded one, without loading it on publication
+    IModelResourceFuturePtr u = ResourceManager::CreateModelAsync("c.fake");
+    IModelResourcePtr sync = ResourceManager::CreateModel("c.fake");
+    u->Wait();
+    BOOST_CHECK(ResourceManager::Publish() == 1);
+    BOOST_CHECK(u->Get() != sync);
+    BOOST_CHECK(((FakeModelResource*)u->Get().get())->loads == 1);
+    BOOST_CHECK(((FakeModelResource*)sync.get())->loads == 0);
+    BOOST_CHECK(ResourceManager::CreateModel("c.fake") == u->Get());
+
+    ResourceManager::Shutdown();
+}
+
+void testResourceCache() {
+    StringPool names;
+    ResourceCache<IModelResource> cache;
+    IModelResourcePtr res[4];
+    for (int i=0; i<4; i++) {
+        res[i] = IModelResourcePtr(new FakeModelResource());
+        res[i]->Load();
+        cache.Insert(names.Intern(Convert::int2string(i)), res[i]);
+    }
+    IModelResourcePtr found;
+    BOOST_CHECK(cache.Find(names.Intern("0"), found) && found == res[0]);
+    BOOST_CHECK(!cache.Find(names.Intern("4"), found));
+
+    // no budget, nothing is evicted
+    for (int i=1; i<4; i++) res[i].reset();
+    BOOST_CHECK(cache.Evict() == 0);
+    ResourceCacheStatistics stats = cache.GetStatistics();
+    BOOST_CHECK(stats.hits == 1);
+    BOOST_CHECK(stats.misses == 1);
+    BOOST_CHECK(stats.entries == 4);
+    BOOST_CHECK(stats.bytes == 400);
+
+    // resources in use are kept
+    cache.SetBudget(250);
+    BOOST_CHECK(cache.Evict() == 2);
+    stats = cache.GetStatistics();
+    BOOST_CHECK(stats.evictions == 2);
+    BOOST_CHECK(stats.entries == 2);
+    BOOST_CHECK(stats.bytes <= 250);
+    BOOST_CHECK(cache.Find(names.Intern("0"), found) && found == res[0]);
+
+    // the budget can not be met while the rest is in use
+    cache.SetBudget(50);
+    IModelResourcePtr kept;
+    for (int i=1; i<4; i++)
+        if (cache.Find(names.Intern(Convert::int2string(i)), kept)) break;
+    BOOST_CHECK(cache.Evict() == 0);
+    BOOST_CHECK(cache.GetStatistics().entries == 2);
+    kept.reset();
+    found.reset();
+    res[0].reset();
+    BOOST_CHECK(cache.Evict() == 2);
+    BOOST_CHECK(cache.GetStatistics().entries == 0);
+
+    // replaced resources keep their entry, and new names are inserted
+    cache.SetBudget(0);
+    IModelResourcePtr first(new FakeModelResource());
+    IModelResourcePtr second(new FakeModelResource());
+    second->Load();
+    cache.Insert(names.Intern("a"), first);
+    cache.Replace(names.Intern("a"), second);
+    cache.Replace(names.Intern("b"), first);
+    BOOST_CHECK(cache.Find(names.Intern("a"), found) && found == second);
+    BOOST_CHECK(cache.Find(names.Intern("b"), found) && found == first);
+    stats = cache.GetStatistics();
+    BOOST_CHECK(stats.entries == 2);
+    BOOST_CHECK(stats.bytes == 100);
+}
+
+// resource cache lookup benchmark
+
+static const unsigned int BENCH_KEYS    = 1000;
+static const unsigned int BENCH_LOOKUPS = 1600000;
+
+typedef std::map<string, IResourcePtr> ResourceMap;
+typedef ConcurrentHashMap<StringPool::Handle, IResourcePtr> ResourceHashMap;
+
+static void lookupMap(ResourceMap* cache, boost::mutex* mutex,
+                      vector<string>* keys, unsigned int lookups,
+                      unsigned int* found) {
+    unsigned int hits = 0;
+    for (unsigned int i=0; i<lookups; i++) {
+        boost::mutex::scoped_lock lock(*mutex);
+        if (cache->find((*keys)[i % keys->size()]) != cache->end()) hits++;
+    }
+    *found = hits;
+}
+
+// each lookup interns its name first, as the resource manager does
+static void lookupHashMap(ResourceHashMap* cache, StringPool* names,
+                          vector<string>* keys, unsigned int lookups,
+                          unsigned int* found) {
+    unsigned int hits = 0;
+    IResourcePtr res;
+    for (unsigned int i=0; i<lookups; i++) {
+        if (cache->Find(names->Intern((*keys)[i % keys->size()]), res)) hits++;
+    }
+    *found = hits;
+}
+
+// run a lookup job on a number of threads, returns the time in ms
+static double runLookups(boost::function<void (unsigned int, unsigned int*)> job,
+                         unsigned int threads) {
+    vector<unsigned int> found(threads);
+    boost::thread_group group;
+    double start = Timer::GetTime();
+    for (unsigned int t=0; t<threads; t++)
+        group.create_thread(boost::bind(job, BENCH_LOOKUPS / threads, &found[t]));
+    group.join_all();
+    double time = Timer::GetTime() - start;
+    unsigned int hits = 0;
+    for (unsigned int t=0; t<threads; t++) hits += found[t];
+    BOOST_CHECK(hits == BENCH_LOOKUPS / threads * threads);
+    return time;
+}
+
+void benchResourceCache() {
+    vector<string> keys;
+    ResourceMap map;
+    StringPool names;
+    ResourceHashMap hmap;
+    for (unsigned int i=0; i<BENCH_KEYS; i++) {
+        keys.push_back("data/models/object" + Convert::int2string(i) + "/mesh.obj");
+        map[keys.back()] = IResourcePtr();
+        hmap.Insert(names.Intern(keys.back()), IResourcePtr());
+    }
+    boost::mutex mutex;
+    const unsigned int threads[] = {1, 4, 16};
+    for (unsigned int i=0; i<3; i++) {
+        double tmap = runLookups(boost::bind(&lookupMap, &map, &mutex, &keys, _1, _2), threads[i]);
+        double thash = runLookups(boost::bind(&lookupHashMap, &hmap, &names, &keys, _1, _2), threads[i]);
+        logger.info << "cache lookups, " << threads[i] << " thread(s): "
+                    << "locked map " << BENCH_LOOKUPS / tmap << "/ms, "
+                    << "sharded hash map " << BENCH_LOOKUPS / thash << "/ms"
+                    << logger.end;
+    }
+}
+
 } // NS Tests
 } // NS OpenEngine
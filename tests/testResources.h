@@ -1,5 +1,8 @@
 namespace OpenEngine {
     namespace Tests {
         void testFile();
+        void testAsyncResources();
+        void testResourceCache();
+        void benchResourceCache();
     }
 }
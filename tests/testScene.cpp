@@ -0,0 +1,512 @@
+// Test the scene graph.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS) 
+// 
+// This program is free software; It is covered by the GNU General 
+// Public License version 2 or any later version. 
+// See the GNU General Public License for more details (see LICENSE). 
+//--------------------------------------------------------------------
+
+// include boost unit test framework
+#include <boost/test/unit_test.hpp>
+
+#include "testScene.h"
+
+#include <Scene/SceneNode.h>
+#include <Scene/TransformationNode.h>
+#include <Scene/GeometryNode.h>
+#include <Scene/TransformStore.h>
+#include <Scene/SceneOctree.h>
+#include <Utils/TaskScheduler.h>
+#include <Math/Math.h>
+#include <Logging/Logger.h>
+#include <Utils/Timer.h>
+#include <Geometry/FaceSet.h>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+namespace OpenEngine {
+namespace Tests {
+
+using namespace OpenEngine::Scene;
+using namespace OpenEngine::Geometry;
+using std::vector;
+
+// compare matrices with a tolerance
+static bool closeTo(Matrix<4,4,float> a, Matrix<4,4,float> b) {
+    for (int i=0; i<4; i++)
+        for (int j=0; j<4; j++)
+            if (fabs(a(i,j) - b(i,j)) > 1e-4) return false;
+    return true;
+}
+
+// compare vectors with a tolerance
+static bool closeTo(Vector<3,float> a, Vector<3,float> b) {
+    return (a - b).GetLength() < 1e-4;
+}
+
+void testTransformationNode() {
+    // A -> scene node -> B -> C
+    TransformationNode a, b, c;
+    SceneNode between;
+    a.AddNode(&between);
+    between.AddNode(&b);
+    b.AddNode(&c);
+    a.Move(1, 2, 3);
+    b.Rotate(0, 90, 0);
+    b.Move(0, 0, 5);
+    c.Move(2, 0, 0);
+    c.Scale(2, 2, 2);
+
+    Matrix<4,4,float> la = a.GetTransformationMatrix();
+    Matrix<4,4,float> lb = b.GetTransformationMatrix();
+    Matrix<4,4,float> lc = c.GetTransformationMatrix();
+    BOOST_CHECK( closeTo(a.GetWorldMatrix(), la) );
+    BOOST_CHECK( closeTo(b.GetWorldMatrix(), lb * la) );
+    BOOST_CHECK( closeTo(c.GetWorldMatrix(), lc * (lb * la)) );
+    BOOST_CHECK( !a.IsWorldDirty() && !b.IsWorldDirty() && !c.IsWorldDirty() );
+
+    // the accumulated position is the world position of the origin
+    Vector<3,float> p;
+    Quaternion<float> q;
+    c.GetAccumulatedTranformations(&p, &q);
+    Matrix<4,4,float> w = c.GetWorldMatrix();
+    BOOST_CHECK( (p - Vector<3,float>(w(3,0), w(3,1), w(3,2))).GetLength() < 1e-4 );
+
+    // changes propagate to the nodes below only
+    b.Move(1, 0, 0);
+    BOOST_CHECK( !a.IsWorldDirty() && b.IsWorldDirty() && c.IsWorldDirty() );
+    lb = b.GetTransformationMatrix();
+    BOOST_CHECK( closeTo(c.GetWorldMatrix(), lc * (lb * la)) );
+    BOOST_CHECK( !b.IsWorldDirty() );
+
+    a.SetPosition(Vector<3,float>(-4, 0, 0));
+    BOOST_CHECK( a.IsWorldDirty() && b.IsWorldDirty() && c.IsWorldDirty() );
+    la = a.GetTransformationMatrix();
+    BOOST_CHECK( closeTo(c.GetWorldMatrix(), lc * (lb * la)) );
+
+    // moving a sub tree invalidates it
+    TransformationNode d;
+    d.Move(0, 10, 0);
+    between.RemoveNode(&b);
+    d.AddNode(&b);
+    BOOST_CHECK( c.IsWorldDirty() );
+    BOOST_CHECK( closeTo(c.GetWorldMatrix(), lc * (lb * d.GetTransformationMatrix())) );
+
+    // a removed sub tree forgets its parent and its parenting
+    // transformations, and outlives the tree it was removed from
+    TransformationNode* e = new TransformationNode();
+    TransformationNode f;
+    e->Move(0, 0, 7);
+    e->AddNode(&f);
+    f.GetWorldMatrix();
+    e->RemoveNode(&f);
+    BOOST_CHECK( f.GetParent() == NULL );
+    BOOST_CHECK( f.IsWorldDirty() );
+    delete e;
+    f.Move(1, 0, 0);
+    BOOST_CHECK( closeTo(f.GetWorldMatrix(), f.GetTransformationMatrix()) );
+}
+
+// collects the world matrices of the transformation nodes in a scene
+class WorldCollector : public ISceneNodeVisitor {
+public:
+    Vector<3,float> sum;
+    void VisitTransformationNode(TransformationNode* node) {
+        Matrix<4,4,float> m = node->GetWorldMatrix();
+        sum += Vector<3,float>(m(3,0), m(3,1), m(3,2));
+        node->VisitSubNodes(*this);
+    }
+};
+
+// accumulates the world matrices during traversal from the rotation,
+// position and scale of each node, like the renderer did before the
+// matrices were cached
+class WorldAccumulator : public ISceneNodeVisitor {
+public:
+    Vector<3,float> sum;
+    vector<Matrix<4,4,float> > stack;
+    WorldAccumulator() { stack.push_back(Matrix<4,4,float>()); }
+    void VisitTransformationNode(TransformationNode* node) {
+        Matrix<4,4,float> m = node->GetRotation().GetMatrix().GetExpanded();
+        m.Transpose();
+        Vector<3,float> p = node->GetPosition();
+        m(3,0) = p[0];
+        m(3,1) = p[1];
+        m(3,2) = p[2];
+        Matrix<4,4,float> l = node->GetScale() * m;
+        Matrix<4,4,float> w = l * stack.back();
+        sum += Vector<3,float>(w(3,0), w(3,1), w(3,2));
+        stack.push_back(w);
+        node->VisitSubNodes(*this);
+        stack.pop_back();
+    }
+};
+
+void benchTransformationNode() {
+    using namespace OpenEngine::Logging;
+    using OpenEngine::Utils::Timer;
+
+    // ten chains of a thousand nodes
+    const int chains = 10, depth = 1000, frames = 20;
+    SceneNode root;
+    vector<TransformationNode*> nodes;
+    for (int i=0; i<chains; i++) {
+        ISceneNode* parent = &root;
+        for (int j=0; j<depth; j++) {
+            TransformationNode* t = new TransformationNode();
+            t->Move(0.1f, 0, 0);
+            t->Rotate(0, 0.01f, 0);
+            parent->AddNode(t);
+            nodes.push_back(t);
+            parent = t;
+        }
+    }
+
+    double start = Timer::GetTime();
+    for (int i=0; i<frames; i++) {
+        WorldAccumulator acc;
+        root.Accept(acc);
+    }
+    double recompute = (Timer::GetTime() - start) / frames;
+
+    WorldCollector first;
+    start = Timer::GetTime();
+    root.Accept(first);
+    double build = Timer::GetTime() - start;
+
+    start = Timer::GetTime();
+    for (int i=0; i<frames; i++) {
+        WorldCollector c;
+        root.Accept(c);
+    }
+    double cached = (Timer::GetTime() - start) / frames;
+
+    // move the root of one chain every frame
+    start = Timer::GetTime();
+    for (int i=0; i<frames; i++) {
+        nodes[0]->Move(0, 0.1f, 0);
+        WorldCollector c;
+        root.Accept(c);
+    }
+    double moved = (Timer::GetTime() - start) / frames;
+
+    // accumulated transformations of the deepest node
+    Vector<3,float> p;
+    Quaternion<float> q;
+    start = Timer::GetTime();
+    for (int i=0; i<frames; i++)
+        nodes[nodes.size()-1]->GetAccumulatedTranformations(&p, &q);
+    double accumulated = (Timer::GetTime() - start) / frames;
+
+    WorldAccumulator check;
+    root.Accept(check);
+    WorldCollector result;
+    root.Accept(result);
+    BOOST_CHECK( (check.sum - result.sum).GetLength() < 1e-2 * check.sum.GetLength() );
+
+    logger.info << nodes.size() << " transformation nodes, " << depth
+                << " deep: recomputed frame " << recompute << " ms, first cached frame "
+                << build << " ms, cached frame " << cached << " ms, frame with "
+                << depth << " moved nodes " << moved << " ms, accumulated leaf "
+                << accumulated << " ms" << logger.end;
+
+    for (unsigned int i=0; i<nodes.size(); i++)
+        delete nodes[i];
+}
+
+void testSceneBounds() {
+    Vector<3,float> min, max, up(0,1,0);
+    FaceSet* faces = new FaceSet();
+    faces->Add(FacePtr(new Face(Vector<3,float>(0,0,0), Vector<3,float>(1,0,0),
+                                Vector<3,float>(0,2,0), up, up, up)));
+
+    // a node without geometry below has no bounds
+    SceneNode root;
+    TransformationNode t;
+    GeometryNode g;
+    root.AddNode(&t);
+    t.AddNode(&g);
+    BOOST_CHECK( root.GetBounds(min, max) == ISceneNode::NO_BOUNDS );
+
+    // bounds are in the coordinate system of the parent
+    g.SetFaceSet(faces);
+    BOOST_CHECK( g.GetBounds(min, max) == ISceneNode::FINITE_BOUNDS );
+    BOOST_CHECK( closeTo(min, Vector<3,float>(0,0,0)) );
+    BOOST_CHECK( closeTo(max, Vector<3,float>(1,2,0)) );
+    t.Move(10, 0, 0);
+    BOOST_CHECK( root.GetBounds(min, max) == ISceneNode::FINITE_BOUNDS );
+    BOOST_CHECK( closeTo(min, Vector<3,float>(10,0,0)) );
+    BOOST_CHECK( closeTo(max, Vector<3,float>(11,2,0)) );
+
+    // rotated bounds enclose the rotated box
+    t.Rotate(0, 0, OpenEngine::Math::PI / 2);
+    root.GetBounds(min, max);
+    BOOST_CHECK( closeTo(max - min, Vector<3,float>(2,1,0)) );
+    Vector<3,float> rmin = min, rmax = max;
+
+    // bounds follow changes to the scene structure
+    TransformationNode s;
+    GeometryNode h(faces);
+    s.Move(0, 0, -5);
+    s.AddNode(&h);
+    root.AddNode(&s);
+    root.GetBounds(min, max);
+    BOOST_CHECK( closeTo(min, Vector<3,float>(0, std::min(rmin[1], 0.0f), -5)) );
+    BOOST_CHECK( closeTo(max, Vector<3,float>(rmax[0], std::max(rmax[1], 2.0f), 0)) );
+    root.RemoveNode(&s);
+    root.GetBounds(min, max);
+    BOOST_CHECK( closeTo(min, rmin) && closeTo(max, rmax) );
+
+    // faces edited in place need an explicit invalidation
+    faces->Add(FacePtr(new Face(Vector<3,float>(0,0,0), Vector<3,float>(0,0,3),
+                                Vector<3,float>(0,1,0), up, up, up)));
+    g.InvalidateBounds();
+    root.GetBounds(min, max);
+    BOOST_CHECK( closeTo(min, Vector<3,float>(rmin[0], rmin[1], 0)) );
+    BOOST_CHECK( closeTo(max, Vector<3,float>(rmax[0], rmax[1], 3)) );
+
+    g.SetFaceSet(NULL);
+    BOOST_CHECK( root.GetBounds(min, max) == ISceneNode::NO_BOUNDS );
+    delete faces;
+}
+
+void testSceneOctree() {
+    Vector<3,float> up(0,1,0);
+    FaceSet* faces = new FaceSet();
+    faces->Add(FacePtr(new Face(Vector<3,float>(0,0,0), Vector<3,float>(1,0,0),
+                                Vector<3,float>(0,1,1), up, up, up)));
+
+    // root -> g, root -> t -> a, t -> u -> b, root -> empty
+    SceneNode root;
+    TransformationNode t, u;
+    GeometryNode g(faces), a(faces), b(faces), empty;
+    root.AddNode(&g);
+    root.AddNode(&t);
+    root.AddNode(&empty);
+    t.AddNode(&a);
+    t.AddNode(&u);
+    u.AddNode(&b);
+    t.Move(10, 0, 0);
+    u.Move(0, 10, 0);
+
+    SceneOctree index(Vector<3,float>(0.0f), 100, 6);
+    index.Build(&root);
+    BOOST_CHECK( index.Size() == 3 );
+
+    vector<GeometryNode*> found;
+    index.Query(Sphere(Vector<3,float>(10.5,0.5,0.5), 2), found);
+    BOOST_CHECK( found.size() == 1 && found[0] == &a );
+    found.clear();
+    index.Query(Box(Vector<3,float>(10.5,10.5,0.5), Vector<3,float>(1.0f)), found);
+    BOOST_CHECK( found.size() == 1 && found[0] == &b );
+
+    // a ray along the x axis finds g and then a
+    found.clear();
+    index.Query(Vector<3,float>(-5,0.5,0.5), Vector<3,float>(1,0,0), found);
+    BOOST_CHECK( found.size() == 2 && found[0] == &g && found[1] == &a );
+    found.clear();
+    index.Query(Vector<3,float>(-5,0.5,0.5), Vector<3,float>(1,0,0), found, 10);
+    BOOST_CHECK( found.size() == 1 && found[0] == &g );
+
+    // only the nodes below moved transformations are relocated
+    BOOST_CHECK( index.Update() == 0 );
+    t.Move(0, 0, 50);
+    BOOST_CHECK( index.Update() == 2 );
+    found.clear();
+    index.Query(Sphere(Vector<3,float>(10.5,0.5,0.5), 2), found);
+    BOOST_CHECK( found.empty() );
+    index.Query(Sphere(Vector<3,float>(10.5,10.5,50.5), 2), found);
+    BOOST_CHECK( found.size() == 1 && found[0] == &b );
+    u.Move(-10, 0, 0);
+    BOOST_CHECK( index.Update() == 1 );
+    BOOST_CHECK( index.Update() == 0 );
+
+    // moves are noticed until the next update however often the
+    // world matrices are read in between
+    t.Move(0, 0, 1);
+    t.GetWorldMatrix();
+    u.GetWorldMatrix();
+    t.Move(0, 0, -1);
+    t.Move(0, 0, 1);
+    BOOST_CHECK( index.Update() == 2 );
+    t.Move(0, 0, -1);
+    BOOST_CHECK( index.Update() == 2 );
+
+    // a destroyed transformation node is forgotten by the index
+    {
+        TransformationNode v;
+        GeometryNode c(faces);
+        v.AddNode(&c);
+        root.AddNode(&v);
+        index.Build(&root);
+        BOOST_CHECK( index.Size() == 4 );
+        v.Move(1, 0, 0);
+        root.RemoveNode(&v);
+    }
+    index.Update();
+    index.Build(&root);
+    BOOST_CHECK( index.Size() == 3 );
+
+    // the planes of the half space z >= 25 holds a and b
+    Plane* planes[1] = { new Plane(Vector<3,float>(0,0,1), -25) };
+    found.clear();
+    index.Query(planes, 1, found);
+    std::sort(found.begin(), found.end());
+    vector<GeometryNode*> expected;
+    expected.push_back(&a);
+    expected.push_back(&b);
+    std::sort(expected.begin(), expected.end());
+    BOOST_CHECK( found == expected );
+    delete planes[0];
+
+    index.Clear();
+    BOOST_CHECK( index.Size() == 0 );
+    delete faces;
+}
+
+void testTransformStore() {
+    // root -> a -> scene node -> b -> c, root -> d
+    SceneNode root;
+    TransformationNode a, b, c, d;
+    SceneNode between;
+    root.AddNode(&a);
+    a.AddNode(&between);
+    between.AddNode(&b);
+    b.AddNode(&c);
+    root.AddNode(&d);
+    a.Move(1, 2, 3);
+    b.Rotate(0, 90, 0);
+    c.Move(2, 0, 0);
+    c.Scale(2, 2, 2);
+    d.Move(0, 0, -5);
+
+    // world matrices computed by the nodes themselves
+    Matrix<4,4,float> wa = a.GetWorldMatrix(), wb = b.GetWorldMatrix(),
+        wc = c.GetWorldMatrix(), wd = d.GetWorldMatrix();
+
+    TransformStore store;
+    store.Build(&root);
+    BOOST_CHECK( store.Size() == 4 );
+    BOOST_CHECK( store.IsSorted() );
+    BOOST_CHECK( a.GetTransformStore() == &store );
+    store.Update();
+    BOOST_CHECK( closeTo(a.GetWorldMatrix(), wa) );
+    BOOST_CHECK( closeTo(b.GetWorldMatrix(), wb) );
+    BOOST_CHECK( closeTo(c.GetWorldMatrix(), wc) );
+    BOOST_CHECK( closeTo(d.GetWorldMatrix(), wd) );
+
+    // changes to bound nodes are written to the store
+    b.Move(0, 1, 0);
+    Matrix<4,4,float> lb = b.GetTransformationMatrix();
+    BOOST_CHECK( closeTo(store.GetLocal(1), lb) );
+    BOOST_CHECK( closeTo(c.GetWorldMatrix(),
+                         c.GetTransformationMatrix() * (lb * wa)) );
+
+    // handles survive sorting, parents come before children
+    TransformStore raw;
+    unsigned int r = raw.Add(-1, a.GetTransformationMatrix());
+    unsigned int s1 = raw.Add(r, b.GetTransformationMatrix());
+    unsigned int s2 = raw.Add(s1, c.GetTransformationMatrix());
+    unsigned int r2 = raw.Add(-1, d.GetTransformationMatrix());
+    BOOST_CHECK( !raw.IsSorted() );
+    raw.Update();
+    Matrix<4,4,float> before = raw.GetWorld(s2);
+    raw.Sort();
+    BOOST_CHECK( raw.IsSorted() );
+    BOOST_CHECK( raw.GetParent(s2) == (int)s1 && raw.GetParent(r2) == -1 );
+    BOOST_CHECK( closeTo(raw.GetWorld(s2), before) );
+
+    // parallel update matches the serial one
+    raw.SetLocal(r, d.GetTransformationMatrix());
+    Utils::TaskScheduler scheduler(2);
+    raw.Update(scheduler);
+    Matrix<4,4,float> ws2 = raw.GetWorld(s2);
+    BOOST_CHECK( closeTo(ws2, (c.GetTransformationMatrix() * (lb * d.GetTransformationMatrix()))) );
+
+    // destroyed nodes are released
+    {
+        TransformationNode e;
+        root.AddNode(&e);
+        store.Build(&root);
+        BOOST_CHECK( store.Size() == 5 );
+        root.RemoveNode(&e);
+    }
+    store.Clear();
+    BOOST_CHECK( a.GetTransformStore() == NULL );
+    BOOST_CHECK( closeTo(c.GetWorldMatrix(),
+                         c.GetTransformationMatrix() * (lb * wa)) );
+}
+
+void benchTransformStore() {
+    using namespace OpenEngine::Logging;
+    using OpenEngine::Utils::Timer;
+    using OpenEngine::Utils::TaskScheduler;
+
+    // a thousand trees of a hundred nodes, ten children per node
+    const int trees = 1000, size = 100, frames = 10;
+    SceneNode root;
+    vector<TransformationNode*> nodes;
+    for (int i=0; i<trees; i++) {
+        int first = nodes.size();
+        for (int j=0; j<size; j++) {
+            TransformationNode* t = new TransformationNode();
+            t->Move(0.1f, 0, 0);
+            t->Rotate(0, 0.01f, 0);
+            if (j == 0) root.AddNode(t);
+            else nodes[first + (j-1) / 10]->AddNode(t);
+            nodes.push_back(t);
+        }
+    }
+
+    // change every node each frame, traversing the scene
+    double start = Timer::GetTime();
+    for (int f=0; f<frames; f++) {
+        for (unsigned int i=0; i<nodes.size(); i++)
+            nodes[i]->Move(0, 0.001f, 0);
+        WorldCollector c;
+        root.Accept(c);
+    }
+    double graph = (Timer::GetTime() - start) / frames;
+
+    TransformStore store;
+    start = Timer::GetTime();
+    store.Build(&root);
+    double build = Timer::GetTime() - start;
+
+    // full update in a single pass and on a scheduler
+    start = Timer::GetTime();
+    for (int f=0; f<frames; f++) {
+        for (unsigned int i=0; i<store.Size(); i++)
+            store.SetLocal(i, store.GetLocal(i));
+        store.Update();
+    }
+    double serial = (Timer::GetTime() - start) / frames;
+
+    TaskScheduler scheduler(4);
+    start = Timer::GetTime();
+    for (int f=0; f<frames; f++) {
+        for (unsigned int i=0; i<store.Size(); i++)
+            store.SetLocal(i, store.GetLocal(i));
+        store.Update(scheduler);
+    }
+    double parallel = (Timer::GetTime() - start) / frames;
+
+    WorldCollector check;
+    root.Accept(check);
+    store.Clear();
+    WorldCollector result;
+    root.Accept(result);
+    BOOST_CHECK( (check.sum - result.sum).GetLength() < 1e-2 * result.sum.GetLength() );
+
+    logger.info << nodes.size() << " transformation nodes: scene traversal "
+                << graph << " ms, store build " << build << " ms, store update "
+                << serial << " ms, on 4 threads " << parallel << " ms" << logger.end;
+
+    for (unsigned int i=0; i<nodes.size(); i++)
+        delete nodes[i];
+}
+
+} // NS Tests
+} // NS OpenEngine
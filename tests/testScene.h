@@ -0,0 +1,10 @@
+namespace OpenEngine {
+    namespace Tests {
+        void testTransformationNode();
+        void benchTransformationNode();
+        void testSceneBounds();
+        void testSceneOctree();
+        void testTransformStore();
+        void benchTransformStore();
+    }
+}
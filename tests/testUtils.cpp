@@ -0,0 +1,464 @@
+// Test the utilities.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS) 
+// 
+// This program is free software; It is covered by the GNU General 
+// Public License version 2 or any later version. 
+// See the GNU General Public License for more details (see LICENSE). 
+//--------------------------------------------------------------------
+
+// include boost unit test framework
+#include <boost/test/unit_test.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/bind.hpp>
+
+#include "testUtils.h"
+
+#include <Utils/ConcurrentHashMap.h>
+#include <Utils/StringPool.h>
+#include <Utils/Convert.h>
+#include <Utils/TaskScheduler.h>
+#include <Utils/Profiler.h>
+#include <Utils/Timer.h>
+#include <Logging/Logger.h>
+#include <stdexcept>
+#include <fstream>
+#include <sstream>
+#include <stdio.h>
+#include <math.h>
+#include <algorithm>
+
+namespace OpenEngine {
+namespace Tests {
+
+using namespace OpenEngine::Utils;
+
+// insert the keys [from,to) twice, the second time with another value
+static bool isEven(const int& value) {
+    return value % 2 == 0;
+}
+
+static void insertRange(ConcurrentHashMap<unsigned int, unsigned int>* map,
+                        unsigned int from, unsigned int to) {
+    for (unsigned int i=from; i<to; i++)
+        map->Insert(i, i*2);
+    for (unsigned int i=from; i<to; i++)
+        map->Insert(i, 0);
+}
+
+void testConcurrentHashMap() {
+    ConcurrentHashMap<string, int> map;
+    int value = 0;
+    BOOST_CHECK(!map.Find("a", value));
+    BOOST_CHECK(map.Insert("a", 1) == 1);
+    BOOST_CHECK(map.Insert("a", 2) == 1);
+    BOOST_CHECK(map.Find("a", value) && value == 1);
+    map.Set("a", 3);
+    BOOST_CHECK(map.Find("a", value) && value == 3);
+    BOOST_CHECK(map.Size() == 1);
+    BOOST_CHECK(map.Erase("a"));
+    BOOST_CHECK(!map.Erase("a"));
+    BOOST_CHECK(map.Size() == 0);
+    map.Insert("b", 3);
+    BOOST_CHECK(!map.EraseIf("b", &isEven));
+    map.Set("b", 4);
+    BOOST_CHECK(map.EraseIf("b", &isEven));
+    BOOST_CHECK(!map.EraseIf("b", &isEven));
+    BOOST_CHECK(map.Size() == 0);
+
+    // grow well beyond the initial bucket count
+    for (int i=0; i<10000; i++)
+        map.Insert(Convert::ToString(i), i);
+    BOOST_CHECK(map.Size() == 10000);
+    bool found = true;
+    for (int i=0; i<10000; i++)
+        found &= map.Find(Convert::ToString(i), value) && value == i;
+    BOOST_CHECK(found);
+    vector<int> values;
+    map.Values(values);
+    BOOST_CHECK(values.size() == 10000);
+    map.Clear();
+    BOOST_CHECK(map.Size() == 0);
+
+    // overlapping concurrent inserts keep the first value
+    ConcurrentHashMap<unsigned int, unsigned int> imap;
+    boost::thread_group threads;
+    for (unsigned int t=0; t<4; t++)
+        threads.create_thread(boost::bind(&insertRange, &imap, t*500, t*500+1000));
+    threads.join_all();
+    BOOST_CHECK(imap.Size() == 2500);
+    found = true;
+    unsigned int v = 0;
+    for (unsigned int i=0; i<2500; i++)
+        found &= imap.Find(i, v) && v == i*2;
+    BOOST_CHECK(found);
+}
+
+void testStringPool() {
+    StringPool pool;
+    StringPool::Handle a = pool.Intern("box.obj");
+    StringPool::Handle b = pool.Intern(string("box") + ".obj");
+    StringPool::Handle c = pool.Intern("ball.obj");
+    BOOST_CHECK(a == b);
+    BOOST_CHECK(a != c);
+    BOOST_CHECK(*a == "box.obj");
+    BOOST_CHECK(*c == "ball.obj");
+    BOOST_CHECK(pool.Size() == 2);
+}
+
+static void setSlot(vector<int>* slots, unsigned int index) {
+    (*slots)[index] = index;
+}
+
+static void addSlots(vector<int>* slots, int* sum) {
+    for (unsigned int i=0; i<slots->size(); i++)
+        *sum += (*slots)[i];
+}
+
+static void appendStep(vector<int>* steps, int step) {
+    steps->push_back(step);
+}
+
+// sums the integers [from,to) by splitting the range into tasks and
+// waiting for them inside a task
+static void sumRange(TaskScheduler* scheduler, long from, long to, long* sum) {
+    if (to - from <= 64) {
+        long s = 0;
+        for (long i=from; i<to; i++) s += i;
+        *sum = s;
+        return;
+    }
+    long middle = (from + to) / 2, left = 0, right = 0;
+    TaskGroup group;
+    scheduler->Spawn(boost::bind(&sumRange, scheduler, from, middle, &left), &group);
+    scheduler->Spawn(boost::bind(&sumRange, scheduler, middle, to, &right), &group);
+    scheduler->Wait(group);
+    *sum = left + right;
+}
+
+static void fail() {
+    throw std::runtime_error("task failure");
+}
+
+static void pause(int ms) {
+    boost::this_thread::sleep(boost::posix_time::milliseconds(ms));
+}
+
+void testTaskScheduler() {
+    TaskScheduler scheduler(3);
+    BOOST_CHECK(scheduler.GetNumberOfWorkers() == 3);
+
+    // independent tasks spawned from outside the workers
+    vector<int> slots(10000, -1);
+    TaskGroup fill;
+    for (unsigned int i=0; i<slots.size(); i++)
+        scheduler.Spawn(boost::bind(&setSlot, &slots, i), &fill);
+    int sum = 0;
+    TaskGroup total;
+    scheduler.Spawn(boost::bind(&addSlots, &slots, &sum), &total, &fill);
+    scheduler.Wait(total);
+    BOOST_CHECK(fill.IsDone());
+    BOOST_CHECK(sum == 10000 * 9999 / 2);
+
+    // a chain of groups runs in order
+    vector<int> steps;
+    TaskGroup chain[20];
+    scheduler.Spawn(boost::bind(&appendStep, &steps, 0), &chain[0]);
+    for (int i=1; i<20; i++)
+        scheduler.Spawn(boost::bind(&appendStep, &steps, i), &chain[i], &chain[i-1]);
+    scheduler.Wait(chain[19]);
+    bool ordered = steps.size() == 20;
+    for (unsigned int i=0; i<steps.size(); i++)
+        ordered &= steps[i] == (int)i;
+    BOOST_CHECK(ordered);
+
+    // tasks waiting for their own tasks help instead of blocking
+    long result = 0;
+    TaskGroup split;
+    scheduler.Spawn(boost::bind(&sumRange, &scheduler, 0L, 1000000L, &result), &split);
+    scheduler.Wait(split);
+    BOOST_CHECK(result == 1000000L * 999999L / 2);
+
+    // a failing task is logged and counts as done
+    TaskGroup failing;
+    scheduler.Spawn(&fail, &failing);
+    scheduler.Wait(failing);
+    BOOST_CHECK(failing.IsDone());
+
+    // waiting for an empty group returns at once
+    TaskGroup empty;
+    scheduler.Wait(empty);
+
+    // a waiter without tasks to run sleeps until the group is done
+    TaskGroup slow;
+    scheduler.Spawn(boost::bind(&pause, 100), &slow);
+    pause(10);
+    scheduler.Wait(slow);
+    BOOST_CHECK(slow.IsDone());
+
+    // the default scheduler is shared
+    BOOST_CHECK(&TaskScheduler::GetDefault() == &TaskScheduler::GetDefault());
+    BOOST_CHECK(TaskScheduler::GetDefault().GetNumberOfWorkers() > 0);
+}
+
+// busy work of about the given number of spin iterations
+static void spin(unsigned int iterations) {
+    volatile unsigned int x = 0;
+    for (unsigned int i=0; i<iterations; i++) x = x * 7 + i;
+}
+
+static void noop() {}
+
+void benchTaskScheduler() {
+    using namespace OpenEngine::Logging;
+
+    // calibrate the spin loop to one microsecond
+    double start = Timer::GetTime();
+    spin(10000000);
+    unsigned int micro = (unsigned int)(10000 / (Timer::GetTime() - start));
+
+    unsigned int hardware = boost::thread::hardware_concurrency();
+    if (hardware == 0) hardware = 1;
+    for (unsigned int workers=1; workers<=2*hardware && workers<=8; workers*=2) {
+        TaskScheduler scheduler(workers);
+
+        // spawn overhead of empty tasks from outside the workers and
+        // of recursively split tasks inside them
+        const unsigned int empty = 1000000;
+        TaskGroup group;
+        start = Timer::GetTime();
+        for (unsigned int i=0; i<empty; i++)
+            scheduler.Spawn(&noop, &group);
+        scheduler.Wait(group);
+        double texternal = Timer::GetTime() - start;
+        long sum = 0;
+        start = Timer::GetTime();
+        scheduler.Spawn(boost::bind(&sumRange, &scheduler, 0L, 64L * 65536, &sum), &group);
+        scheduler.Wait(group);
+        double tsplit = Timer::GetTime() - start;
+        BOOST_CHECK(sum == 64L * 65536 * (64L * 65536 - 1) / 2);
+
+        // fine and coarse grained work of equal total size
+        const unsigned int fine = 200000, coarse = 200;
+        start = Timer::GetTime();
+        for (unsigned int i=0; i<fine; i++)
+            scheduler.Spawn(boost::bind(&spin, micro), &group);
+        scheduler.Wait(group);
+        double tfine = Timer::GetTime() - start;
+        start = Timer::GetTime();
+        for (unsigned int i=0; i<coarse; i++)
+            scheduler.Spawn(boost::bind(&spin, micro * 1000), &group);
+        scheduler.Wait(group);
+        double tcoarse = Timer::GetTime() - start;
+
+        // ideal times are 200 ms over the number of workers
+        logger.info << workers << " workers: spawn " << texternal * 1000000 / empty
+                    << " ns/task, split " << tsplit * 1000000 / 131071
+                    << " ns/task" << logger.end;
+        logger.info << "  1 us tasks " << tfine << " ms, 1 ms tasks " << tcoarse
+                    << " ms, ideal " << 200.0 / workers << " ms" << logger.end;
+    }
+}
+
+static void zone(const char* name) {
+    ProfileScope scope(name);
+}
+
+// Test zone statistics, nesting and trace export of the profiler.
+void testProfiler() {
+    // nothing is recorded while disabled
+    Profiler::Clear();
+    zone("off");
+    vector<Profiler::ZoneStatistics> zones;
+    Profiler::GetStatistics(zones);
+    BOOST_CHECK(zones.empty());
+
+    Profiler::Enable(4, 100);
+    for (int i=0; i<10; i++) {
+        ProfileScope outer("outer");
+        spin(1000);
+        ProfileScope inner("inner", "test");
+        spin(1000);
+    }
+    boost::thread thread(boost::bind(&zone, "thread"));
+    thread.join();
+    Profiler::Disable();
+    zone("off");
+
+    Profiler::GetStatistics(zones);
+    BOOST_REQUIRE(zones.size() == 3);
+    BOOST_CHECK(zones[0].path == "outer" && zones[0].category == "zone");
+    BOOST_CHECK(zones[1].path == "outer/inner" && zones[1].category == "test");
+    BOOST_CHECK(zones[2].path == "thread" && zones[2].total == 1);
+    for (int i=0; i<2; i++) {
+        BOOST_CHECK(zones[i].count == 4);
+        BOOST_CHECK(zones[i].total == 10);
+        BOOST_CHECK(zones[i].min <= zones[i].average);
+        BOOST_CHECK(zones[i].average <= zones[i].p95);
+        BOOST_CHECK(zones[i].p95 <= zones[i].max);
+    }
+
+    // one trace event per recorded zone
+    const char* file = "profiler_trace.json";
+    Profiler::WriteTrace(file);
+    std::ifstream in(file);
+    std::stringstream trace;
+    trace << in.rdbuf();
+    in.close();
+    remove(file);
+    string json = trace.str();
+    BOOST_CHECK(json.find("{\"traceEvents\":[") == 0);
+    unsigned int events = 0;
+    for (string::size_type pos = json.find("\"ph\":\"X\""); pos != string::npos;
+         pos = json.find("\"ph\":\"X\"", pos + 1))
+        events++;
+    BOOST_CHECK(events == 21);
+    BOOST_CHECK(json.find("\"path\":\"outer/inner\"") != string::npos);
+
+    BOOST_CHECK(Profiler::GetTypeName(typeid(TaskScheduler)).find("TaskScheduler")
+                != string::npos);
+    Profiler::Clear();
+}
+
+// Measure the cost of a profiler zone when disabled and enabled.
+void benchProfiler() {
+    using namespace OpenEngine::Logging;
+    const unsigned int n = 10000000;
+
+    Profiler::Disable();
+    double start = Timer::GetTime();
+    for (unsigned int i=0; i<n; i++)
+        zone("bench");
+    double disabled = Timer::GetTime() - start;
+
+    Profiler::Enable(120, 0);
+    start = Timer::GetTime();
+    for (unsigned int i=0; i<n / 10; i++)
+        zone("bench");
+    double enabled = Timer::GetTime() - start;
+    Profiler::Disable();
+    Profiler::Clear();
+
+    logger.info << "profiler zone: disabled " << disabled * 1000000 / n
+                << " ns, enabled " << enabled * 10000000 / n
+                << " ns" << logger.end;
+}
+
+// Test the monotonic clock and the cycle counter.
+void testTimer() {
+    // the clock never goes back
+    Timer::Nanoseconds last = Timer::GetNanoseconds();
+    bool monotonic = true;
+    for (int i=0; i<100000; i++) {
+        Timer::Nanoseconds now = Timer::GetNanoseconds();
+        monotonic &= now >= last;
+        last = now;
+    }
+    BOOST_CHECK(monotonic);
+
+    // a sleep of 20 ms is measured as such by all clocks
+    double ms = Timer::GetTime();
+    Timer::Nanoseconds ns = Timer::GetNanoseconds();
+    Timer::Cycles cycles = 0;
+    {
+        ScopeTimer timer(cycles);
+        boost::this_thread::sleep(boost::posix_time::milliseconds(20));
+    }
+    ns = Timer::GetNanoseconds() - ns;
+    ms = Timer::GetTime() - ms;
+    BOOST_CHECK(ns >= 19000000 && ns < 1000000000);
+    BOOST_CHECK(ms >= 19 && ms < 1000);
+    BOOST_CHECK(Timer::GetCyclesPerNanosecond() > 0);
+    Timer::Nanoseconds scope = Timer::ToNanoseconds(cycles);
+    BOOST_CHECK(scope >= 15000000 && scope <= ns * 1.25);
+}
+
+// Test that waits end on time.
+void testTimerWait() {
+    Timer::Nanoseconds early = 0, late = 0;
+    for (int i=0; i<50; i++) {
+        Timer::Nanoseconds deadline = Timer::GetNanoseconds() + 2000000;
+        Timer::WaitUntil(deadline);
+        Timer::Nanoseconds error = Timer::GetNanoseconds() - deadline;
+        early = std::min(early, error);
+        late += error;
+    }
+    BOOST_CHECK(early >= 0);
+    // generous, the test may share the processor
+    BOOST_CHECK(late / 50 < 2000000);
+}
+
+// Measure the cost of reading the clocks.
+void benchTimer() {
+    using namespace OpenEngine::Logging;
+    const unsigned int n = 10000000;
+
+    volatile double time = 0;
+    double start = Timer::GetTime();
+    for (unsigned int i=0; i<n; i++)
+        time = Timer::GetTime();
+    double tms = Timer::GetTime() - start;
+
+    volatile Timer::Nanoseconds ns = 0;
+    start = Timer::GetTime();
+    for (unsigned int i=0; i<n; i++)
+        ns = Timer::GetNanoseconds();
+    double tns = Timer::GetTime() - start;
+
+    volatile Timer::Cycles cycles = 0;
+    start = Timer::GetTime();
+    for (unsigned int i=0; i<n; i++)
+        cycles = Timer::GetCycles();
+    double tcycles = Timer::GetTime() - start;
+
+    Timer::Cycles total = 0;
+    start = Timer::GetTime();
+    for (unsigned int i=0; i<n; i++)
+        ScopeTimer timer(total);
+    double tscope = Timer::GetTime() - start;
+    BOOST_CHECK(time > 0 && ns > 0 && cycles > 0 && total > 0);
+
+    logger.info << "GetTime " << tms * 1000000 / n
+                << " ns, GetNanoseconds " << tns * 1000000 / n
+                << " ns, GetCycles " << tcycles * 1000000 / n
+                << " ns, ScopeTimer " << tscope * 1000000 / n
+                << " ns, " << Timer::GetCyclesPerNanosecond()
+                << " cycles/ns" << logger.end;
+}
+
+// Compare the jitter of a loop paced to 60 frames per second by
+// sleeping and by waiting.
+void benchFramePacing() {
+    using namespace OpenEngine::Logging;
+    const int frames = 120;
+    const Timer::Nanoseconds period = 1000000000LL / 60;
+    for (int mode=0; mode<2; mode++) {
+        double sum = 0, squares = 0, worst = 0;
+        Timer::Nanoseconds frame = Timer::GetNanoseconds();
+        Timer::Nanoseconds last = frame;
+        for (int i=0; i<frames; i++) {
+            spin(100000);
+            frame += period;
+            if (mode == 0) {
+                Timer::Nanoseconds wait = frame - Timer::GetNanoseconds();
+                if (wait > 0)
+                    boost::this_thread::sleep(boost::posix_time::microseconds(wait / 1000));
+            }
+            else Timer::WaitUntil(frame);
+            Timer::Nanoseconds now = Timer::GetNanoseconds();
+            double error = (now - last - period) / 1000000.0;
+            sum += error;
+            squares += error * error;
+            worst = std::max(worst, fabs(error));
+            last = now;
+        }
+        double mean = sum / frames;
+        logger.info << (mode == 0 ? "sleep" : "WaitUntil")
+                    << " paced 60 fps: frame time error mean " << mean
+                    << " ms, jitter " << sqrt(squares / frames - mean * mean)
+                    << " ms, worst " << worst << " ms" << logger.end;
+    }
+}
+
+} // NS Tests
+} // NS OpenEngine
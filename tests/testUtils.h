@@ -0,0 +1,14 @@
+namespace OpenEngine {
+    namespace Tests {
+        void testConcurrentHashMap();
+        void testStringPool();
+        void testTaskScheduler();
+        void benchTaskScheduler();
+        void testProfiler();
+        void benchProfiler();
+        void testTimer();
+        void benchTimer();
+        void testTimerWait();
+        void benchFramePacing();
+    }
+}
@@ -45,6 +45,7 @@ using namespace OpenEngine::Logging;
 
 const int AUTO_TESTS = 1;
 const int MANUAL_TESTS = 2;
+const int BENCHMARKS = 4;
 
 test_suite* init_unit_test_suite( int argc, char* argv[] ) {
 
@@ -55,6 +56,7 @@ test_suite* init_unit_test_suite( int argc, char* argv[] ) {
     if (argc > 1) {
         if (string(argv[1])=="auto")   type = AUTO_TESTS;
         if (string(argv[1])=="manual") type = MANUAL_TESTS;
+        if (string(argv[1])=="bench")  type = BENCHMARKS;
     }
     test_suite* test = BOOST_TEST_SUITE( "engine test suite" );
     if (type & AUTO_TESTS) {
@@ -64,28 +66,87 @@ test_suite* init_unit_test_suite( int argc, char* argv[] ) {
         test->add( BOOST_TEST_CASE(&testVector) );
         test->add( BOOST_TEST_CASE(&testMatrix) );
         test->add( BOOST_TEST_CASE(&testQuaternion) );
+        test->add( BOOST_TEST_CASE(&testMathKernels) );
         // geometry tests
         test->add( BOOST_TEST_CASE(&testFaceSet) );
         test->add( BOOST_TEST_CASE(&testLine) );
+        test->add( BOOST_TEST_CASE(&testMesh) );
+        test->add( BOOST_TEST_CASE(&testBoxArray) );
+        test->add( BOOST_TEST_CASE(&testBVH) );
+        test->add( BOOST_TEST_CASE(&testBSPTree) );
+        test->add( BOOST_TEST_CASE(&testFaceSplit) );
+        test->add( BOOST_TEST_CASE(&testLooseOctree) );
+        test->add( BOOST_TEST_CASE(&testSphere) );
+        // scene tests
+        test->add( BOOST_TEST_CASE(&testTransformationNode) );
+        test->add( BOOST_TEST_CASE(&testSceneBounds) );
+        test->add( BOOST_TEST_CASE(&testSceneOctree) );
+        test->add( BOOST_TEST_CASE(&testTransformStore) );
         // Test GameEngine
         test->add( BOOST_TEST_CASE(&testAddRemoveModules) );
         test->add( BOOST_TEST_CASE(&testInitDeinitModules) );
         test->add( BOOST_TEST_CASE(&testGameEngineLookup) );
+        test->add( BOOST_TEST_CASE(&testGameEngineTasks) );
+        test->add( BOOST_TEST_CASE(&testModuleGraph) );
+        test->add( BOOST_TEST_CASE(&testGameEnginePacing) );
         // Test Events and Listeners
         test->add( BOOST_TEST_CASE(&testEventListeners) );
         test->add( BOOST_TEST_CASE(&testQueuedEventListeners) );
         // Test Display
         test->add( BOOST_TEST_CASE(&testFrame) );
+        test->add( BOOST_TEST_CASE(&testFrustumBoxes) );
+        test->add( BOOST_TEST_CASE(&testFrustumSpheres) );
+        // Test utilities
+        test->add( BOOST_TEST_CASE(&testConcurrentHashMap) );
+        test->add( BOOST_TEST_CASE(&testStringPool) );
+        test->add( BOOST_TEST_CASE(&testTaskScheduler) );
+        test->add( BOOST_TEST_CASE(&testProfiler) );
+        test->add( BOOST_TEST_CASE(&testTimer) );
+        test->add( BOOST_TEST_CASE(&testTimerWait) );
         // Test resource system
         test->add( BOOST_TEST_CASE(&testFile) );
+        test->add( BOOST_TEST_CASE(&testAsyncResources) );
+        test->add( BOOST_TEST_CASE(&testResourceCache) );
         // Test OBJ loader 
         test->add( BOOST_TEST_CASE(&testOBJModelResource) );
+        test->add( BOOST_TEST_CASE(&testOBJMeshCache) );
+        test->add( BOOST_TEST_CASE(&testOBJEviction) );
+        test->add( BOOST_TEST_CASE(&testOBJParser) );
+        test->add( BOOST_TEST_CASE(&testOBJParallelParser) );
+        // Test renderer support
+        test->add( BOOST_TEST_CASE(&testVertexBatch) );
+        test->add( BOOST_TEST_CASE(&testRenderQueue) );
+        test->add( BOOST_TEST_CASE(&testRecordingRenderingView) );
+        test->add( BOOST_TEST_CASE(&testRenderingViewBatches) );
+        test->add( BOOST_TEST_CASE(&testFrustumCulling) );
     }
     if (type & MANUAL_TESTS) {
         // add manual tests here
         test->add( BOOST_TEST_CASE(&testKeyboard) );
         test->add( BOOST_TEST_CASE(&testMouse) );
     }
+    if (type & BENCHMARKS) {
+        // add benchmarks here, they only run when asked for
+        test->add( BOOST_TEST_CASE(&benchMathKernels) );
+        test->add( BOOST_TEST_CASE(&benchMesh) );
+        test->add( BOOST_TEST_CASE(&benchBVH) );
+        test->add( BOOST_TEST_CASE(&benchBSPTree) );
+        test->add( BOOST_TEST_CASE(&benchFaceSplit) );
+        test->add( BOOST_TEST_CASE(&benchLooseOctree) );
+        test->add( BOOST_TEST_CASE(&benchTransformationNode) );
+        test->add( BOOST_TEST_CASE(&benchTransformStore) );
+        test->add( BOOST_TEST_CASE(&benchTaskScheduler) );
+        test->add( BOOST_TEST_CASE(&benchProfiler) );
+        test->add( BOOST_TEST_CASE(&benchTimer) );
+        test->add( BOOST_TEST_CASE(&benchFramePacing) );
+        test->add( BOOST_TEST_CASE(&benchResourceCache) );
+        test->add( BOOST_TEST_CASE(&benchOBJParser) );
+        test->add( BOOST_TEST_CASE(&benchOBJParallelParser) );
+        test->add( BOOST_TEST_CASE(&benchOBJMeshCache) );
+        test->add( BOOST_TEST_CASE(&benchSceneTraversal) );
+        test->add( BOOST_TEST_CASE(&benchFrustumBoxes) );
+        test->add( BOOST_TEST_CASE(&benchFrustumSpheres) );
+    }
     return test;
 }
 
@@ -22,12 +22,15 @@ namespace OpenEngine {
 #include "testExample.h"
 #include "testMath.h"
 #include "testGeometry.h"
+#include "testScene.h"
 #include "testGameEngine.h"
 #include "testEventSystem.h"
 #include "testDisplay.h"
 #include "testDevices.h"
+#include "testUtils.h"
 #include "testResources.h"
 #include "testOBJModelResource.h"
+#include "testRenderers.h"
 
 
 #endif